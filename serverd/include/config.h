@@ -62,4 +62,151 @@
 #define EPOLL_MAX_EVENTS (10)
 #endif
 
+/**
+ * @def PIPE_POOL_CAPACITY
+ * @brief Maximum idle kernel pipes kept per worker.
+ *
+ * @details Each idle pipe holds two file descriptors, and
+ * only transfers that cannot use sendfile(2) need one, so
+ * a small pool is enough.
+ *
+ */
+#ifndef PIPE_POOL_CAPACITY
+#define PIPE_POOL_CAPACITY (16)
+#endif
+
+/**
+ * @def CONTENT_REGION_MIN_BLOCK_SHIFT
+ * @brief log2 of the smallest block in the content region.
+ *
+ * @details Cached file contents are allocated in power of
+ * two blocks no smaller than this, so a small file wastes at
+ * most half its block, and a tiny one at most 256 bytes.
+ *
+ */
+#ifndef CONTENT_REGION_MIN_BLOCK_SHIFT
+#define CONTENT_REGION_MIN_BLOCK_SHIFT (8)
+#endif
+
+/**
+ * @def KERNEL_PIPE_SIZE
+ * @brief Requested capacity of pooled pipes, in bytes.
+ *
+ * @details The default pipe capacity is 64 KiB. Larger pipes
+ * let splice(2) move more data per system call. Requests
+ * above /proc/sys/fs/pipe-max-size are silently ignored.
+ *
+ */
+#ifndef KERNEL_PIPE_SIZE
+#define KERNEL_PIPE_SIZE (1 << 20)
+#endif
+
+/**
+ * @def CONNECTION_SLAB_SIZE
+ * @brief Number of connection objects allocated at a time.
+ *
+ */
+#ifndef CONNECTION_SLAB_SIZE
+#define CONNECTION_SLAB_SIZE (64)
+#endif
+
+/**
+ * @def ARENA_CHUNK_SIZE
+ * @brief Size of the chunks request arenas allocate from.
+ *
+ * @details A static file request, with its path buffers,
+ * fits comfortably in one chunk, so a request normally
+ * costs a single pooled chunk and no allocator calls.
+ *
+ */
+#ifndef ARENA_CHUNK_SIZE
+#define ARENA_CHUNK_SIZE (16 * 1024)
+#endif
+
+/**
+ * @def ARENA_CHUNK_POOL_CAPACITY
+ * @brief Maximum idle arena chunks kept per worker.
+ *
+ */
+#ifndef ARENA_CHUNK_POOL_CAPACITY
+#define ARENA_CHUNK_POOL_CAPACITY (256)
+#endif
+
+/**
+ * @def REQUEST_BUFFER_SIZE
+ * @brief Size of the I/O buffer a request is read into.
+ *
+ */
+#ifndef REQUEST_BUFFER_SIZE
+#define REQUEST_BUFFER_SIZE (4 * 1024)
+#endif
+
+/**
+ * @def IO_BUFFER_MAGAZINE_SIZE
+ * @brief Number of idle I/O buffers per magazine.
+ *
+ */
+#ifndef IO_BUFFER_MAGAZINE_SIZE
+#define IO_BUFFER_MAGAZINE_SIZE (16)
+#endif
+
+/**
+ * @def IO_BUFFER_DEPOT_CAPACITY
+ * @brief Maximum full magazines kept in the global depot,
+ * per size class.
+ *
+ */
+#ifndef IO_BUFFER_DEPOT_CAPACITY
+#define IO_BUFFER_DEPOT_CAPACITY (8)
+#endif
+
+/**
+ * @def DIRECT_IO_ALIGNMENT
+ * @brief Alignment of O_DIRECT buffers, offsets and lengths.
+ *
+ * @details O_DIRECT transfers must be aligned to the logical
+ * block size of the underlying device, which is at most the
+ * page size on any device we are likely to see.
+ *
+ */
+#ifndef DIRECT_IO_ALIGNMENT
+#define DIRECT_IO_ALIGNMENT (4096)
+#endif
+
+/**
+ * @def DIRECT_BUFFER_POOL_CAPACITY
+ * @brief Maximum idle streaming buffers kept per worker.
+ *
+ * @details Every large file being streamed holds two
+ * buffers, so this covers a handful of concurrent bulk
+ * downloads without going back to the allocator.
+ *
+ */
+#ifndef DIRECT_BUFFER_POOL_CAPACITY
+#define DIRECT_BUFFER_POOL_CAPACITY (8)
+#endif
+
+/**
+ * @def CONFIGURATION_MAX_READERS
+ * @brief Maximum threads registered to read the published
+ * configuration.
+ *
+ */
+#ifndef CONFIGURATION_MAX_READERS
+#define CONFIGURATION_MAX_READERS (64)
+#endif
+
+/**
+ * @def REWRITE_MAX_DFA_STATES
+ * @brief Maximum states the rewrite rules may compile to.
+ *
+ * @details Literal rules cost about one state per byte,
+ * but wildcards can multiply states, so a configuration
+ * that would need more than this is refused instead.
+ *
+ */
+#ifndef REWRITE_MAX_DFA_STATES
+#define REWRITE_MAX_DFA_STATES (262144)
+#endif
+
 #endif /** PROJECT_INCLUDES_CONFIG_H */
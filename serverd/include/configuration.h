@@ -24,6 +24,164 @@
 #ifndef PROJECT_INCLUDES_CONFIGURATION_H
 #define PROJECT_INCLUDES_CONFIGURATION_H
 
+#include <stddef.h>
+#include <stdint.h>
+
+struct configuration_block_t;
+struct virtual_host_router_t;
+struct location_tree_t;
+struct rewrite_engine_t;
+
+/**
+ * A user-defined file extension to MIME type mapping.
+ *
+ * @details Each MimeType directive in the configuration
+ * file produces one of these. They are merged into the
+ * built-in MIME type table at startup.
+ *
+ */
+struct mime_type_override_t {
+    const char* extension;
+    const char* content_type;
+    struct mime_type_override_t* next;
+};
+
+/**
+ * A name-based virtual host.
+ *
+ * @details Each VirtualHost block in the configuration file
+ * produces one of these, with its own document root, its
+ * own caches and its own limits. Options a block does not
+ * set are inherited from the global configuration.
+ *
+ * The first virtual host of every configuration is the
+ * default one, which has no names, takes all of its options
+ * from the global configuration, and serves every request
+ * whose Host header matches no other virtual host.
+ *
+ */
+struct virtual_host_t {
+    /**
+     * The host names this virtual host answers to, in lower
+     * case. A name of the form *.example.com matches any
+     * name below example.com, but not example.com itself.
+     *
+     */
+    const char** names;
+    size_t name_count;
+
+    const char* document_root_directory;
+    int directory_listing_enabled;
+    size_t directory_listing_cache_entries;
+    size_t file_cache_entries;
+    size_t file_cache_validity;
+    size_t negative_cache_entries;
+    uint64_t content_cache_max_file_size;
+    uint64_t streaming_threshold;
+
+    /**
+     * The next VirtualHost block, while the configuration
+     * file is being parsed.
+     *
+     */
+    struct virtual_host_t* next;
+};
+
+/**
+ * What a location does with the requests it matches.
+ *
+ * @details LOCATION_STATIC_FILES serves them from the
+ * document root, LOCATION_REDIRECT redirects them, and
+ * LOCATION_RETURN answers them with a bare status code.
+ *
+ */
+enum location_handler_t {
+    LOCATION_STATIC_FILES,
+    LOCATION_REDIRECT,
+    LOCATION_RETURN
+};
+
+/**
+ * A location.
+ *
+ * @details Each Location block in the configuration file
+ * produces one of these. Locations apply to every virtual
+ * host, and match the request path once it has been decoded
+ * and normalized.
+ *
+ */
+struct location_t {
+    /**
+     * The path the location matches. An exact location
+     * only matches this path; any other matches every path
+     * that starts with it.
+     *
+     */
+    const char* path;
+    size_t path_length;
+    int exact;
+
+    enum location_handler_t handler;
+
+    /**
+     * For LOCATION_STATIC_FILES, the document root to serve
+     * from instead of the virtual host's, or NULL, and
+     * whether to list directories, or -1 to go by the
+     * virtual host. The document root takes the place of the
+     * location's path, so only the rest of the request path
+     * is appended to it.
+     *
+     */
+    const char* document_root_directory;
+    int directory_listing_enabled;
+
+    /**
+     * For LOCATION_REDIRECT and LOCATION_RETURN, the status
+     * code, and for LOCATION_REDIRECT, where to redirect to.
+     * If a prefix location's target ends with a slash, the
+     * rest of the request path after the location's path is
+     * appended to it.
+     *
+     */
+    int status;
+    const char* target;
+
+    /**
+     * The next Location block, while the configuration file
+     * is being parsed.
+     *
+     */
+    struct location_t* next;
+};
+
+/**
+ * A rewrite or redirect rule.
+ *
+ * @details Each Rewrite and RedirectMatch directive in the
+ * configuration file produces one of these. The pattern is
+ * matched against the whole request path, once it has been
+ * decoded and normalized, with each * matching any run of
+ * bytes. The target may refer to what the wildcards matched
+ * as $1 through $9, and to the whole path as $0.
+ *
+ * A rule with a status of zero rewrites the request path
+ * before the locations see it; any other rule redirects the
+ * request with that status.
+ *
+ */
+struct rewrite_rule_t {
+    const char* pattern;
+    const char* target;
+    int status;
+
+    /**
+     * The next rule, while the configuration file is being
+     * parsed.
+     *
+     */
+    struct rewrite_rule_t* next;
+};
+
 /**
  * This object contains all valid server configuration
  * options.
@@ -46,8 +204,8 @@ struct configuration_options_t {
     /**
      * The hostname for the server.
      *
-     * @todo The user should be able to configure the
-     * hostname for the server on a per-virtual host basis.
+     * This is the address the server listens on. The names
+     * it answers to are configured per virtual host.
      * 
      */
     const char* hostname;
@@ -60,6 +218,249 @@ struct configuration_options_t {
     const char* port;
 
     const char* document_root_directory;
+
+    /**
+     * MIME type mappings added or overridden by the user.
+     *
+     */
+    struct mime_type_override_t* mime_type_overrides;
+
+    /**
+     * The least important syslog(3) priority that is logged.
+     *
+     * @details Messages below it are discarded before they
+     * are formatted. The C library allocates for every
+     * message it does format, so logging every connection
+     * costs an allocation per request.
+     *
+     */
+    int log_level;
+
+    /**
+     * The number of threads in the file I/O pool.
+     *
+     * Blocking file system calls, such as open(2) and
+     * statx(2), are handed off to this pool so that slow
+     * storage never stalls the event loop. A value of zero
+     * runs them inline on the event loop instead.
+     *
+     */
+    size_t file_io_thread_count;
+
+    /**
+     * Whether every worker thread, i.e. the event loop and
+     * each file I/O thread, allocates from a jemalloc arena
+     * of its own.
+     *
+     */
+    int memory_arena_per_thread;
+
+    /**
+     * Whether jemalloc's per-thread cache is enabled.
+     *
+     */
+    int memory_thread_cache;
+
+    /**
+     * How long, in milliseconds, jemalloc keeps unused dirty
+     * and muzzy pages before returning them to the kernel.
+     *
+     */
+    size_t memory_dirty_decay;
+    size_t memory_muzzy_decay;
+
+    /**
+     * The memory budgets, in bytes, or zero for none. Past
+     * the soft limit, caches are shrunk and no connections
+     * are accepted; past the hard limit, requests are turned
+     * away with a 503.
+     *
+     */
+    size_t memory_soft_limit;
+    size_t memory_hard_limit;
+
+    /**
+     * Whether to generate listings for directories that
+     * have no index.html.
+     *
+     */
+    int directory_listing_enabled;
+
+    /**
+     * The number of rendered directory listings to cache.
+     *
+     */
+    size_t directory_listing_cache_entries;
+
+    /**
+     * The maximum number of open files kept in the static
+     * file cache.
+     *
+     */
+    size_t file_cache_entries;
+
+    /**
+     * How long, in seconds, a cached file is served before
+     * it is looked up on the file system again.
+     *
+     */
+    size_t file_cache_validity;
+
+    /**
+     * The number of nonexistent request paths to remember,
+     * so repeated requests for them are answered without
+     * touching the file system. Zero disables the negative
+     * cache.
+     *
+     */
+    size_t negative_cache_entries;
+
+    /**
+     * Whether to put a Bloom filter in front of the negative
+     * cache.
+     *
+     */
+    int negative_cache_bloom_filter;
+
+    /**
+     * The size of the memory region holding the contents of
+     * small cached files. Zero keeps every cached file on
+     * disk, served with sendfile(2).
+     *
+     */
+    uint64_t content_cache_size;
+
+    /**
+     * The page size to back the content cache with. Anything
+     * above the system page size requests huge pages.
+     *
+     */
+    uint64_t content_cache_page_size;
+
+    /**
+     * The largest file whose contents are kept in the
+     * content cache.
+     *
+     */
+    uint64_t content_cache_max_file_size;
+
+    /**
+     * The smallest file that is streamed with O_DIRECT,
+     * bypassing the page cache, instead of being sent with
+     * sendfile(2). Zero disables streaming.
+     *
+     */
+    uint64_t streaming_threshold;
+
+    /**
+     * How much of a file that is not in the page cache to
+     * read ahead, on the file I/O pool, before sending it.
+     * Zero disables the readahead hints.
+     *
+     */
+    uint64_t readahead_window;
+
+    /**
+     * The size of each of the two buffers a streamed file
+     * is read through.
+     *
+     */
+    uint64_t streaming_buffer_size;
+
+    /**
+     * Whether to drop a streamed file's pages from the page
+     * cache where O_DIRECT is not supported.
+     *
+     */
+    int streaming_drop_cache;
+
+    /**
+     * The number of bytes of file content to preload at
+     * startup. Zero disables the warm-up phase.
+     *
+     */
+    uint64_t warmup_budget;
+
+    /**
+     * An optional list of request paths, in priority order,
+     * to preload first during the warm-up phase.
+     *
+     */
+    const char* warmup_manifest;
+
+    /**
+     * Where to persist the file cache's hit counts, so the
+     * warm-up phase after a restart can preload the files
+     * that were actually popular. NULL disables snapshots.
+     *
+     */
+    const char* popularity_snapshot;
+
+    /**
+     * How often, in seconds, the popularity snapshot is
+     * rewritten.
+     *
+     */
+    size_t popularity_snapshot_interval;
+
+    /**
+     * How often, in seconds, the page cache, I/O buffer and
+     * memory statistics are logged. Zero disables them.
+     *
+     */
+    size_t statistics_interval;
+
+    /**
+     * A site pack built with serverd-pack to serve instead
+     * of the document root. NULL serves the document root.
+     *
+     */
+    const char* site_pack;
+
+    /**
+     * The virtual hosts, starting with the default one, and
+     * the table that routes a Host header to one of them.
+     *
+     * @details Only the default virtual host is served from
+     * the site pack, if there is one.
+     *
+     */
+    struct virtual_host_t* virtual_hosts;
+    size_t virtual_host_count;
+    struct virtual_host_router_t* virtual_host_router;
+
+    /**
+     * The locations, and the tree that matches a request
+     * path to one of them.
+     *
+     */
+    struct location_t* locations;
+    size_t location_count;
+    struct location_tree_t* location_tree;
+
+    /**
+     * The rewrite and redirect rules, in the order they were
+     * given, and the automaton they are compiled into.
+     *
+     */
+    struct rewrite_rule_t* rewrite_rules;
+    size_t rewrite_rule_count;
+    struct rewrite_engine_t* rewrite_engine;
+
+    /**
+     * The publication number of this configuration, which
+     * increases with every reload.
+     *
+     */
+    uint64_t epoch;
+
+    /**
+     * Every block of memory the configuration owns, so that
+     * it can be released in one go once no worker can still
+     * be reading it.
+     *
+     */
+    struct configuration_block_t* blocks;
 };
 
 /**
@@ -67,7 +468,57 @@ struct configuration_options_t {
  * module, which handles all of the necessary configuration
  * parsing required to configure the server.
  *
+ * @details The configuration it returns is also published
+ * as the first current configuration.
+ *
  */
 struct configuration_options_t* initialize_server_configuration(int argc, char *argv[]);
 
+/**
+ * Parse the configuration again and publish the result.
+ *
+ * @details The command line given at startup is parsed
+ * again, followed by the configuration file. Options that
+ * only take effect at startup, such as the port, the size
+ * of the caches or the set of virtual hosts, keep their
+ * current values, with a warning if the file changed them. The configuration it
+ * replaces is freed once every registered reader has
+ * moved on from it.
+ *
+ * Configuration errors are logged rather than fatal. If
+ * there are any, nothing is published and this returns
+ * NULL, leaving the current configuration in place.
+ *
+ */
+const struct configuration_options_t* reload_server_configuration(void);
+
+/**
+ * Return the current configuration.
+ *
+ */
+const struct configuration_options_t* current_server_configuration(void);
+
+/**
+ * Register a thread that reads the configuration, and
+ * return its reader number.
+ *
+ * @details Once a reader is registered, a configuration
+ * that has been replaced is only freed after the reader
+ * has reported, by calling configuration_quiescent_state(),
+ * that it is done with it.
+ *
+ */
+size_t register_configuration_reader(void);
+
+/**
+ * Report that a reader holds no references into any
+ * configuration older than the one given.
+ *
+ * @details Event loops call this between passes, with the
+ * configuration they will use for the next one.
+ *
+ */
+__attribute__((nonnull(2)))
+void configuration_quiescent_state(size_t reader, const struct configuration_options_t* configuration_options);
+
 #endif /** PROJECT_INCLUDES_CONFIGURATION_H */
@@ -0,0 +1,142 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PROJECT_INCLUDES_CONNECTION_H
+#define PROJECT_INCLUDES_CONNECTION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <sys/socket.h>
+
+/**
+ * A client connection.
+ *
+ * @details Connections are cache-line aligned, and their
+ * fields are split by how often they are touched: the hot
+ * fields every event needs share the first cache line, and
+ * the cold ones, only looked at when the connection is
+ * accepted or logged, start on the next.
+ *
+ */
+struct connection_t {
+    /** Hot */
+    int fd;
+    uint32_t generation;
+    struct connection_t* next_free;
+
+    /** Cold */
+    _Alignas(64) time_t accepted_at;
+    socklen_t address_length;
+    struct sockaddr_storage address;
+};
+
+/**
+ * A per-worker pool of connections, and the registry that
+ * maps file descriptors back to them.
+ *
+ * @details Connections are carved out of slabs of
+ * CONNECTION_SLAB_SIZE objects, and recycled through an
+ * intrusive free list, so accepting a connection does not
+ * allocate once the slabs have grown to the peak number of
+ * open connections. Slabs are never returned.
+ *
+ * The registry is an array indexed by file descriptor.
+ * Events carry a token with both the descriptor and the
+ * connection's generation, so an event that was already
+ * queued for a connection that has since been closed, and
+ * whose descriptor may already be reused, is recognized as
+ * stale instead of being delivered to the wrong client.
+ * Generations come from a single counter for the whole
+ * pool, rather than from each connection object, since a
+ * descriptor may be reused by a different object whose own
+ * count happens to match; this way a descriptor and
+ * generation pair is only ever handed out once, until the
+ * counter wraps after 2^32 connections.
+ *
+ * The pool is not thread-safe; each event loop owns its own.
+ *
+ */
+struct connection_slab_t {
+    struct connection_t* free_list;
+    struct connection_t** registry;
+    size_t registry_size;
+    size_t open_count;
+    uint32_t next_generation;
+};
+
+/**
+ * Create an empty connection pool.
+ *
+ */
+__attribute__((returns_nonnull))
+struct connection_slab_t* create_connection_slab(void);
+
+/**
+ * Take a connection for a newly accepted socket, and
+ * register it under the socket's descriptor.
+ *
+ */
+__attribute__((nonnull(1),returns_nonnull))
+struct connection_t* open_connection(struct connection_slab_t* slab, int fd);
+
+/**
+ * Close a connection's socket and return the connection to
+ * the pool.
+ *
+ * @details Closing the socket also removes it from any
+ * epoll interest list, and the registry forgets it, so any
+ * events still queued for it are stale; whatever connection
+ * reuses the descriptor gets a new generation.
+ *
+ */
+__attribute__((nonnull(1,2)))
+void close_connection(struct connection_slab_t* slab, struct connection_t* connection);
+
+/**
+ * Find the connection an event token refers to.
+ *
+ * @details Returns NULL if the token is stale, i.e. its
+ * connection has been closed since the token was made.
+ *
+ */
+__attribute__((nonnull(1)))
+struct connection_t* lookup_connection(const struct connection_slab_t* slab, uint64_t token);
+
+/**
+ * Return the token to put in epoll_event.data.u64 for a
+ * connection.
+ *
+ * @details The descriptor is in the low 32 bits, where
+ * epoll_event.data.fd would be, so a token never compares
+ * equal to the descriptor of the listening socket or any
+ * other non-connection descriptor on the same epoll set.
+ *
+ */
+__attribute__((nonnull(1)))
+static inline uint64_t connection_token(const struct connection_t* connection) {
+    return ((uint64_t) connection->generation << 32) | (uint32_t) connection->fd;
+}
+
+#endif /** PROJECT_INCLUDES_CONNECTION_H */
@@ -0,0 +1,106 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PROJECT_INCLUDES_CONTENT_REGION_H
+#define PROJECT_INCLUDES_CONTENT_REGION_H
+
+#include <stddef.h>
+
+/**
+ * How the content region's memory is backed.
+ *
+ * @details CONTENT_REGION_HUGETLB is a MAP_HUGETLB mapping
+ * from the reserved huge page pool, which is what we ask for
+ * first. If no huge pages are reserved, the region falls
+ * back to an ordinary anonymous mapping with transparent
+ * huge pages requested through madvise(2), and, if the
+ * kernel does not support those either, to small pages.
+ *
+ */
+enum content_region_backing_t {
+    CONTENT_REGION_DISABLED,
+    CONTENT_REGION_HUGETLB,
+    CONTENT_REGION_TRANSPARENT_HUGEPAGES,
+    CONTENT_REGION_SMALL_PAGES
+};
+
+/**
+ * Opaque handle to a content region.
+ *
+ */
+struct content_region_t;
+
+/**
+ * Map a region for cached file contents.
+ *
+ * @details The region is one mapping of capacity bytes,
+ * rounded up to a whole number of pages of page_size bytes,
+ * kept apart from the allocate_memory() heap so that the
+ * working set of cached files is covered by as few TLB
+ * entries as possible. Blocks are handed out of it by a
+ * buddy allocator.
+ *
+ * A region with a capacity of zero is valid and simply
+ * never has room for anything.
+ *
+ */
+__attribute__((returns_nonnull))
+struct content_region_t* create_content_region(size_t capacity, size_t page_size);
+
+/**
+ * Allocate a block of the content region.
+ *
+ * @details Unlike allocate_memory(), running out of room is
+ * not an error: NULL is returned, and the caller is expected
+ * to serve the file from disk instead.
+ *
+ */
+__attribute__((nonnull(1)))
+void* allocate_content(struct content_region_t* region, size_t size);
+
+/**
+ * Return a block to the content region.
+ *
+ */
+__attribute__((nonnull(1)))
+void free_content(struct content_region_t* region, void* block);
+
+/**
+ * Return how the region's memory is backed.
+ *
+ */
+__attribute__((nonnull(1)))
+enum content_region_backing_t content_region_backing(const struct content_region_t* region);
+
+/**
+ * Return the bytes allocated from the region, and its
+ * capacity.
+ *
+ * @details Block sizes are rounded up to powers of two, so
+ * the bytes allocated include that rounding.
+ *
+ */
+__attribute__((nonnull(1,2,3)))
+void content_region_usage(const struct content_region_t* region, size_t* used, size_t* capacity);
+
+#endif /** PROJECT_INCLUDES_CONTENT_REGION_H */
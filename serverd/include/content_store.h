@@ -0,0 +1,111 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PROJECT_INCLUDES_CONTENT_STORE_H
+#define PROJECT_INCLUDES_CONTENT_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct content_region_t;
+
+/**
+ * A distinct file body held in the content region.
+ *
+ * @details Bodies are shared between every cached path whose
+ * file has exactly the same bytes, and released back to the
+ * region once the last of them is evicted.
+ *
+ */
+struct content_body_t {
+    void* data;
+    size_t length;
+    uint64_t hash;
+    size_t references;
+    struct content_body_t* hash_next;
+};
+
+/**
+ * A content-addressed store of file bodies.
+ *
+ * @details Bodies are found by a hash of their bytes, and a
+ * match is always confirmed with memcmp(3), so two different
+ * bodies are never merged, however unlikely a collision.
+ *
+ */
+struct content_store_t {
+    struct content_region_t* region;
+    struct content_body_t** buckets;
+    size_t bucket_mask;
+
+    size_t body_count;
+    uint64_t stored_bytes;
+    uint64_t referenced_bytes;
+};
+
+/**
+ * Create a store for bodies allocated from a content region.
+ *
+ * @details The hash table is sized for expected_bodies, but
+ * holds any number of them.
+ *
+ */
+__attribute__((returns_nonnull,nonnull(1)))
+struct content_store_t* create_content_store(struct content_region_t* region, size_t expected_bodies);
+
+/**
+ * Add a body to the store.
+ *
+ * @details The data is a block of the store's region, filled
+ * with length bytes, and hash is its hash_content(), which
+ * callers compute on the file I/O pool along with the read
+ * rather than on the event loop. If the store already holds
+ * a body with
+ * the same bytes, the block is returned to the region and
+ * the existing body is shared instead; either way, the
+ * caller gets one reference to the returned body.
+ *
+ */
+__attribute__((returns_nonnull,nonnull(1,2)))
+struct content_body_t* intern_content(struct content_store_t* store, void* data, size_t length, uint64_t hash);
+
+/**
+ * Drop one reference to a body.
+ *
+ */
+__attribute__((nonnull(1)))
+void release_content(struct content_store_t* store, struct content_body_t* body);
+
+/**
+ * Hash a body.
+ *
+ * @details This is a four-lane multiply-rotate hash in the
+ * style of XXH64, which consumes 32 bytes per round and
+ * keeps the lanes independent, so it runs at memory speed
+ * on large bodies.
+ *
+ */
+__attribute__((nonnull(1)))
+uint64_t hash_content(const void* data, size_t length);
+
+#endif /** PROJECT_INCLUDES_CONTENT_STORE_H */
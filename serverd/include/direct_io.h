@@ -0,0 +1,105 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PROJECT_INCLUDES_DIRECT_IO_H
+#define PROJECT_INCLUDES_DIRECT_IO_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/**
+ * A per-worker pool of buffers suitable for O_DIRECT reads.
+ *
+ * @details Very large files are streamed through a pair of
+ * these buffers instead of going through sendfile(2), so
+ * that a bulk download does not push the hot set out of the
+ * page cache. Every buffer is aligned to, and a multiple of,
+ * DIRECT_IO_ALIGNMENT, as O_DIRECT requires.
+ *
+ * Buffers are allocated lazily and recycled, and at most
+ * capacity idle buffers are kept. The pool is not
+ * thread-safe; each event loop owns its own.
+ *
+ */
+struct direct_buffer_pool_t {
+    void* free_list;
+    size_t free_count;
+    size_t capacity;
+    size_t buffer_size;
+};
+
+/**
+ * Create a pool of up to capacity idle buffers.
+ *
+ * @details The buffer size is rounded up to a multiple of
+ * DIRECT_IO_ALIGNMENT.
+ *
+ */
+__attribute__((returns_nonnull))
+struct direct_buffer_pool_t* create_direct_buffer_pool(size_t capacity, size_t buffer_size);
+
+/**
+ * Take a buffer from the pool, allocating one if necessary.
+ *
+ */
+__attribute__((nonnull(1),returns_nonnull))
+void* acquire_direct_buffer(struct direct_buffer_pool_t* pool);
+
+/**
+ * Return a buffer to the pool.
+ *
+ * @details Releasing NULL does nothing, and a buffer that
+ * would exceed the pool's capacity is freed instead.
+ *
+ */
+__attribute__((nonnull(1)))
+void release_direct_buffer(struct direct_buffer_pool_t* pool, void* buffer);
+
+/**
+ * Switch an open file to direct I/O.
+ *
+ * @details Returns FALSE if the file system does not
+ * support O_DIRECT, e.g. tmpfs, in which case the file is
+ * left as it was.
+ *
+ */
+int enable_direct_io(int fd);
+
+/**
+ * Read a chunk of a file that bypasses the page cache.
+ *
+ * @details For a file in direct I/O mode, the offset must
+ * be aligned and the length a multiple of the alignment;
+ * the read stops at end of file. Otherwise the file is read
+ * through the page cache, and if drop_cache is set the
+ * pages just read are dropped from it again with
+ * POSIX_FADV_DONTNEED.
+ *
+ * Returns the number of bytes read, which is only short at
+ * end of file, or -1 on error.
+ *
+ */
+__attribute__((nonnull(2)))
+ssize_t read_file_chunk(int fd, void* buffer, off_t offset, size_t length, int direct, int drop_cache);
+
+#endif /** PROJECT_INCLUDES_DIRECT_IO_H */
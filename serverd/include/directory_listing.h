@@ -0,0 +1,124 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PROJECT_INCLUDES_DIRECTORY_LISTING_H
+#define PROJECT_INCLUDES_DIRECTORY_LISTING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Output formats for generated directory listings.
+ *
+ */
+enum directory_listing_format_t {
+    DIRECTORY_LISTING_HTML,
+    DIRECTORY_LISTING_JSON
+};
+
+/**
+ * Identity of a rendered directory listing.
+ *
+ * @details A cached listing is only valid for the exact
+ * directory, modification time, format and request path it
+ * was rendered for. Any change to the directory's entries
+ * updates its mtime, which is what invalidates the cache.
+ *
+ */
+struct directory_listing_key_t {
+    uint64_t device;
+    uint64_t inode;
+    int64_t mtime_seconds;
+    uint32_t mtime_nanoseconds;
+    enum directory_listing_format_t format;
+    const char* request_path;
+};
+
+/**
+ * Render a complete directory listing response.
+ *
+ * @details The directory is read in a single pass with
+ * getdents64(2), the entries are sorted (subdirectories
+ * first, then by name), and the result is rendered into a
+ * heap buffer holding the full HTTP response, headers
+ * included. Hidden entries, i.e. names that begin with a
+ * dot, are skipped.
+ *
+ * This function blocks on the file system, so the server
+ * runs it on the file I/O pool. It returns NULL, with errno
+ * set, if the directory could not be read.
+ *
+ */
+__attribute__((nonnull(2,4)))
+char* render_directory_listing(int directory_fd, const char* request_path, enum directory_listing_format_t format, size_t* length);
+
+/**
+ * Opaque handle to a rendered directory listing cache.
+ *
+ */
+struct directory_listing_cache_t;
+
+/**
+ * Create a directory listing cache with room for the given
+ * number of rendered listings.
+ *
+ */
+__attribute__((returns_nonnull))
+struct directory_listing_cache_t* create_directory_listing_cache(size_t capacity);
+
+/**
+ * Look up a rendered listing.
+ *
+ * @details On a hit, the rendered response is returned and
+ * its length stored in *length. The pointer remains valid
+ * until the next call to insert_directory_listing() on the
+ * same cache. Returns NULL on a miss.
+ *
+ */
+__attribute__((nonnull(1,2,3)))
+const char* lookup_directory_listing(struct directory_listing_cache_t* cache, const struct directory_listing_key_t* key, size_t* length);
+
+/**
+ * Store a rendered listing in the cache.
+ *
+ * @details The cache takes ownership of the rendered buffer,
+ * which must have been returned by render_directory_listing().
+ * A stale listing of the same directory is replaced, and if
+ * the cache is full the least recently used listing in the
+ * same set is evicted.
+ *
+ */
+__attribute__((nonnull(1,2,3)))
+void insert_directory_listing(struct directory_listing_cache_t* cache, const struct directory_listing_key_t* key, char* rendered, size_t length);
+
+/**
+ * Drop every cached listing.
+ *
+ * @details Like insert_directory_listing(), this invalidates
+ * any pointer returned by lookup_directory_listing().
+ *
+ */
+__attribute__((nonnull(1)))
+void clear_directory_listing_cache(struct directory_listing_cache_t* cache);
+
+#endif /** PROJECT_INCLUDES_DIRECTORY_LISTING_H */
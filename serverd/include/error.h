@@ -24,6 +24,8 @@
 #ifndef PROJECT_INCLUDES_ERROR_H
 #define PROJECT_INCLUDES_ERROR_H
 
+#include <stdarg.h>
+
 /**
  * Exit with an error status and message.
  *
@@ -36,4 +38,12 @@
 __attribute__((noreturn,format(printf,1,2)))
 void fatal_error(const char* format, ...);
 
+/**
+ * Exit with an error status and message, taking the format
+ * arguments as a va_list.
+ *
+ */
+__attribute__((noreturn,format(printf,1,0)))
+void vfatal_error(const char* format, va_list ap);
+
 #endif /** PROJECT_INCLUDES_ERROR_H */
\ No newline at end of file
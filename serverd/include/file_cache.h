@@ -0,0 +1,200 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PROJECT_INCLUDES_FILE_CACHE_H
+#define PROJECT_INCLUDES_FILE_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <sys/stat.h>
+
+/**
+ * A cached static file.
+ *
+ * @details An entry holds everything needed to answer a
+ * request for its path without touching the file system:
+ * an open file descriptor for sendfile(2), the file's size
+ * and identity, and the fully formatted response headers.
+ *
+ * Small files may also have their contents held in the
+ * cache's content store, in which case the response is
+ * sent straight from memory and the entry holds no file
+ * descriptor at all. Paths whose files are byte-identical
+ * share a single copy of the contents.
+ *
+ * Entries are keyed by the normalized request path rather
+ * than the file name, so a directory request such as
+ * "/docs/" maps straight onto the cached index.html.
+ *
+ */
+struct file_cache_entry_t {
+    char* path;
+    size_t path_length;
+    uint64_t path_hash;
+
+    int fd;
+    struct content_body_t* content;
+    uint64_t size;
+    uint64_t device;
+    uint64_t inode;
+    struct statx_timestamp mtime;
+
+    char* header;
+    size_t header_length;
+
+    uint64_t hits;
+    time_t validated_at;
+    uint8_t frequency;
+    uint8_t queue;
+
+    struct file_cache_entry_t* hash_next;
+    struct file_cache_entry_t* queue_prev;
+    struct file_cache_entry_t* queue_next;
+};
+
+/**
+ * Opaque handle to a static file cache.
+ *
+ */
+struct file_cache_t;
+
+struct content_store_t;
+struct content_body_t;
+
+/**
+ * Create a static file cache.
+ *
+ * @details The cache holds at most max_entries open files.
+ * Entries are trusted for validity seconds after they were
+ * opened; after that, the next request for the path goes
+ * back to the file system and replaces the entry, which is
+ * how changes to the document root are picked up.
+ *
+ * File contents handed to the cache are bodies of
+ * content_store, and their references are dropped on
+ * eviction.
+ *
+ * A cache with max_entries of zero is valid and simply
+ * never holds anything.
+ *
+ */
+__attribute__((returns_nonnull,nonnull(3)))
+struct file_cache_t* create_file_cache(size_t max_entries, time_t validity, struct content_store_t* content_store);
+
+/**
+ * Format the response headers for a regular file.
+ *
+ * @details Returns the length of the headers, which is
+ * always less than the buffer size, or 0 if they do not fit.
+ *
+ */
+__attribute__((nonnull(1,3)))
+size_t build_file_response_header(char* buffer, size_t buffer_size, const char* filename, uint64_t size);
+
+/**
+ * Look up a request path.
+ *
+ * @details Returns NULL on a miss, including when an entry
+ * exists but is older than the cache's validity period, or
+ * is sent from a file descriptor whose file has since been
+ * changed in place. Such entries are dropped. Every lookup, hit or miss, is recorded by the admission
+ * filter, and a hit counts towards the entry's popularity.
+ *
+ */
+__attribute__((nonnull(1,2)))
+struct file_cache_entry_t* lookup_file_cache(struct file_cache_t* cache, const char* path, size_t path_length);
+
+/**
+ * Add an open file to the cache.
+ *
+ * @details The cache takes ownership of the file descriptor
+ * and will close it when the entry is evicted or replaced.
+ * The filename is only used to pick the Content-Type.
+ *
+ * Once the cache is full, the file is only admitted if it
+ * has been requested more often, recently, than the entry
+ * it would evict; see file_cache_admits().
+ *
+ * If content is not NULL, it is the whole file, interned in
+ * the cache's content store. The cache takes over the
+ * caller's reference to it, and closes the descriptor right
+ * away.
+ *
+ * If the cache is disabled, the file is not admitted, or
+ * the headers cannot be built, the descriptor and the
+ * content are left with the caller and NULL is returned.
+ *
+ */
+__attribute__((nonnull(1,2,4,6)))
+struct file_cache_entry_t* insert_file_cache(struct file_cache_t* cache, const char* path, size_t path_length, const char* filename, int fd, const struct statx* status, struct content_body_t* content);
+
+/**
+ * Check whether the cache would admit a request path.
+ *
+ * @details Callers about to do work just to cache a file,
+ * such as reading it into the content region, can ask first
+ * and skip that work for files that would be turned away.
+ *
+ */
+__attribute__((nonnull(1,2)))
+int file_cache_admits(const struct file_cache_t* cache, const char* path, size_t path_length);
+
+/**
+ * Credit a request path with past requests.
+ *
+ * @details This feeds the admission filter with popularity
+ * known from elsewhere, such as the previous run's
+ * popularity snapshot, so that a restart does not start the
+ * filter from nothing.
+ *
+ */
+__attribute__((nonnull(1,2)))
+void seed_file_cache_frequency(struct file_cache_t* cache, const char* path, size_t path_length, uint64_t requests);
+
+/**
+ * Return the number of entries and the total file size
+ * currently cached.
+ *
+ */
+__attribute__((nonnull(1)))
+void file_cache_usage(const struct file_cache_t* cache, size_t* entries, uint64_t* bytes);
+
+/**
+ * Evict entries until at most max_entries remain.
+ *
+ */
+__attribute__((nonnull(1)))
+void shrink_file_cache(struct file_cache_t* cache, size_t max_entries);
+
+/**
+ * Call a function on every cached entry, main queue first.
+ *
+ * @details The visitor must not modify the cache.
+ *
+ */
+__attribute__((nonnull(1,2)))
+void visit_file_cache_entries(const struct file_cache_t* cache, void (*visitor)(const struct file_cache_entry_t* entry, void* context), void* context);
+
+#endif /** PROJECT_INCLUDES_FILE_CACHE_H */
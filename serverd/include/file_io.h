@@ -0,0 +1,160 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PROJECT_INCLUDES_FILE_IO_H
+#define PROJECT_INCLUDES_FILE_IO_H
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/**
+ * Blocking file operations the I/O pool can perform.
+ *
+ * @details FILE_IO_OPEN opens the job's path and, if that
+ * succeeds, also fills in the job's status with statx(2),
+ * since every static response needs both. FILE_IO_STATX
+ * only retrieves the status of the path, FILE_IO_READAHEAD
+ * populates the page cache for a range of an open file, and
+ * FILE_IO_READ reads a range of an open file into the job's
+ * buffer. FILE_IO_CALL runs the job's function on the pool,
+ * for blocking work that is more than a single system call.
+ *
+ */
+enum file_io_operation_t {
+    FILE_IO_OPEN,
+    FILE_IO_STATX,
+    FILE_IO_READAHEAD,
+    FILE_IO_READ,
+    FILE_IO_CALL
+};
+
+/**
+ * A single unit of blocking work for the file I/O pool.
+ *
+ * @details The submitter owns the job object, which must
+ * remain valid until its completion callback has run.
+ * Callers typically embed the job in a larger structure
+ * holding their own request state, and recover it in the
+ * callback through the context pointer.
+ *
+ * The completion callback always runs on the thread that
+ * calls complete_file_io_jobs(), i.e. the owning event loop,
+ * never on one of the pool's worker threads.
+ *
+ */
+struct file_io_job_t {
+    enum file_io_operation_t operation;
+
+    /** Inputs */
+    const char* path;
+    int flags;
+    int fd;
+    off_t offset;
+    size_t length;
+    void* buffer;
+    void (*function)(struct file_io_job_t* job);
+
+    /** Outputs */
+    ssize_t result;
+    int error;
+    struct statx status;
+
+    /** Completion */
+    void (*completion)(struct file_io_job_t* job);
+    void* context;
+
+    /** Queue linkage, owned by the pool */
+    struct file_io_job_t* next;
+};
+
+/**
+ * Opaque handle to a file I/O thread pool.
+ *
+ */
+struct file_io_pool_t;
+
+/**
+ * Create a file I/O pool with the given number of threads.
+ *
+ * @details A thread count of zero creates a pool with no
+ * worker threads, in which case jobs are executed inline at
+ * submission time, and their completions are still delivered
+ * through the eventfd like any other.
+ *
+ */
+__attribute__((returns_nonnull))
+struct file_io_pool_t* create_file_io_pool(size_t thread_count);
+
+/**
+ * Return the eventfd the pool signals completions through.
+ *
+ * @details The owning event loop should register this file
+ * descriptor for EPOLLIN and call complete_file_io_jobs()
+ * whenever it becomes readable.
+ *
+ */
+__attribute__((nonnull(1)))
+int file_io_pool_eventfd(const struct file_io_pool_t* pool);
+
+/**
+ * Queue a job for execution on the pool.
+ *
+ */
+__attribute__((nonnull(1,2)))
+void submit_file_io_job(struct file_io_pool_t* pool, struct file_io_job_t* job);
+
+/**
+ * Run the completion callbacks of all finished jobs.
+ *
+ */
+__attribute__((nonnull(1)))
+void complete_file_io_jobs(struct file_io_pool_t* pool);
+
+/**
+ * Read a range of an open file, blocking.
+ *
+ * @details This is what FILE_IO_READ runs. Unlike a single
+ * pread(2), it keeps reading until the whole range is in,
+ * so a short result always means end of file. It is exposed
+ * for FILE_IO_CALL functions that read and then process
+ * the data on the pool.
+ *
+ */
+__attribute__((nonnull(2)))
+ssize_t read_file_range(int fd, void* buffer, off_t offset, size_t length);
+
+/**
+ * Check whether the page at an offset of an open file is in
+ * the page cache.
+ *
+ * @details This is a one-byte preadv2(2) with RWF_NOWAIT,
+ * which never blocks on the disk, so it is safe to call on
+ * the event loop before deciding whether sending the file
+ * right away would stall it. Where RWF_NOWAIT is not
+ * supported, the page is assumed to be cached.
+ *
+ */
+int file_page_is_cached(int fd, off_t offset);
+
+#endif /** PROJECT_INCLUDES_FILE_IO_H */
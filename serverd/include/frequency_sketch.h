@@ -0,0 +1,76 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PROJECT_INCLUDES_FREQUENCY_SKETCH_H
+#define PROJECT_INCLUDES_FREQUENCY_SKETCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * An approximate access frequency counter.
+ *
+ * @details This is a count-min sketch of four-bit counters,
+ * four per key, which estimates how often a key has been
+ * seen recently in a small, fixed amount of memory. All four
+ * counters of a key live in the same 64-byte block, so
+ * recording or estimating a key touches a single cache line.
+ *
+ * Counters saturate at 15, and once the number of recorded
+ * accesses reaches ten times the sketch's nominal capacity,
+ * every counter is halved. That ageing is what lets keys
+ * that used to be popular make way for new ones.
+ *
+ */
+struct frequency_sketch_t {
+    uint64_t* table;
+    size_t block_mask;
+    size_t additions;
+    size_t sample_size;
+};
+
+/**
+ * Create a sketch sized for the given number of keys.
+ *
+ */
+__attribute__((returns_nonnull))
+struct frequency_sketch_t* create_frequency_sketch(size_t capacity);
+
+/**
+ * Record one access to a key.
+ *
+ * @details The key is a well-mixed 64-bit hash, such as one
+ * from perfect_hash_string().
+ *
+ */
+__attribute__((nonnull(1)))
+void record_frequency(struct frequency_sketch_t* sketch, uint64_t key);
+
+/**
+ * Estimate how often a key has been seen, from 0 to 15.
+ *
+ */
+__attribute__((nonnull(1)))
+unsigned estimate_frequency(const struct frequency_sketch_t* sketch, uint64_t key);
+
+#endif /** PROJECT_INCLUDES_FREQUENCY_SKETCH_H */
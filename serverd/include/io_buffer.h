@@ -0,0 +1,88 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PROJECT_INCLUDES_IO_BUFFER_H
+#define PROJECT_INCLUDES_IO_BUFFER_H
+
+#include <stddef.h>
+
+/**
+ * @def IO_BUFFER_CLASS_COUNT
+ * @brief Number of I/O buffer size classes.
+ *
+ * @details The classes are 4 KiB, for request and header
+ * buffers, 16 KiB and 64 KiB, for body chunks and directory
+ * reads.
+ *
+ */
+#define IO_BUFFER_CLASS_COUNT (3)
+
+/**
+ * @def IO_BUFFER_MAX_SIZE
+ * @brief Capacity of the largest I/O buffer size class.
+ *
+ */
+#define IO_BUFFER_MAX_SIZE (64 * 1024)
+
+/**
+ * Take an I/O buffer of at least size bytes.
+ *
+ * @details Buffers come in a few fixed size classes, and are
+ * page aligned. Each thread keeps a small cache of idle
+ * buffers per class, in magazines, so that taking and
+ * returning a buffer normally touches no shared state at
+ * all. Threads only go to the global depot, under a lock, to
+ * trade a whole magazine at a time.
+ *
+ * Requests larger than IO_BUFFER_MAX_SIZE are passed
+ * straight through to the allocator.
+ *
+ */
+__attribute__((returns_nonnull))
+void* acquire_io_buffer(size_t size);
+
+/**
+ * Return an I/O buffer.
+ *
+ * @details The size must be the one the buffer was taken
+ * with. Buffers may be released on any thread, not just the
+ * one that took them. Releasing NULL does nothing.
+ *
+ */
+void release_io_buffer(void* buffer, size_t size);
+
+/**
+ * Return the capacity of the buffer that acquire_io_buffer()
+ * hands out for a given size.
+ *
+ */
+size_t io_buffer_capacity(size_t size);
+
+/**
+ * Log how many buffers of each size class are in use and
+ * how many are sitting idle in thread caches and the depot.
+ *
+ */
+void log_io_buffer_statistics(void);
+
+#endif /** PROJECT_INCLUDES_IO_BUFFER_H */
@@ -0,0 +1,76 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PROJECT_INCLUDES_LOCATION_H
+#define PROJECT_INCLUDES_LOCATION_H
+
+#include <stddef.h>
+
+struct location_t;
+
+/**
+ * Opaque handle to a location tree.
+ *
+ * @details Maps a request path onto the Location block that
+ * handles it. The paths of all the Location blocks are laid
+ * out in a compressed radix tree, so matching a request
+ * path walks it once, one edge per step, and takes time
+ * proportional to the length of the path however many
+ * locations there are.
+ *
+ * An exact location matches only its own path, and wins
+ * over any prefix location. Otherwise the longest prefix
+ * location that the path starts with wins.
+ *
+ * Like the virtual host router, a location tree never
+ * changes once built, belongs to the configuration it was
+ * built from, and refers to that configuration's locations.
+ *
+ */
+struct location_tree_t;
+
+/**
+ * Build the location tree for a set of locations.
+ *
+ * @details Returns NULL if two locations of the same kind
+ * have the same path, pointing duplicate at it.
+ *
+ */
+__attribute__((nonnull(3)))
+struct location_tree_t* build_location_tree(const struct location_t* locations, size_t count, const char** duplicate);
+
+/**
+ * Release a location tree.
+ *
+ */
+void free_location_tree(struct location_tree_t* tree);
+
+/**
+ * Find the location that handles a normalized request
+ * path, or NULL if there is none.
+ *
+ */
+__attribute__((nonnull(1,2)))
+const struct location_t* match_location(const struct location_tree_t* tree, const char* path, size_t length);
+
+#endif /** PROJECT_INCLUDES_LOCATION_H */
@@ -24,6 +24,41 @@
 #ifndef PROJECT_INCLUDES_MEMORY_H
 #define PROJECT_INCLUDES_MEMORY_H
 
+#include <stddef.h>
+
+/**
+ * The subsystems that memory is accounted to.
+ *
+ * @details Every allocation made through this module is
+ * charged to one of these tags, so that the statistics can
+ * show where the memory went, and so that the budgets can
+ * tell how much of it could be given back.
+ *
+ */
+enum memory_tag_t {
+    MEMORY_TAG_OTHER,
+    MEMORY_TAG_CONNECTIONS,
+    MEMORY_TAG_BUFFERS,
+    MEMORY_TAG_CACHES,
+    MEMORY_TAG_CONFIGURATION,
+    MEMORY_TAG_COUNT
+};
+
+/**
+ * How close the process is to its memory budget.
+ *
+ * @details Under soft pressure, serverd shrinks its caches
+ * and stops accepting connections until usage drops again.
+ * Under hard pressure, new requests are turned away with a
+ * 503 rather than risking an allocation failure.
+ *
+ */
+enum memory_pressure_t {
+    MEMORY_PRESSURE_NONE,
+    MEMORY_PRESSURE_SOFT,
+    MEMORY_PRESSURE_HARD
+};
+
 /**
  * Allocate number of bytes specified by size argument.
  *
@@ -41,6 +76,74 @@
 __attribute__((malloc,returns_nonnull))
 void* allocate_memory(size_t size);
 
+/**
+ * Allocate memory charged to the given tag.
+ *
+ * @details Like allocate_memory(), failure is fatal, so this
+ * is meant for memory serverd cannot run without, such as
+ * its caches' tables and the configuration.
+ *
+ */
+__attribute__((malloc,returns_nonnull))
+void* allocate_tagged_memory(enum memory_tag_t tag, size_t size);
+
+/**
+ * Allocate memory charged to the given tag, or return NULL.
+ *
+ * @details This fails, rather than terminating the process,
+ * when malloc(3) does or when the allocation would take
+ * usage past the hard budget. It is meant for memory whose
+ * absence can be handled by turning a request away.
+ *
+ */
+__attribute__((malloc))
+void* try_allocate_memory(enum memory_tag_t tag, size_t size);
+
+/**
+ * Charge (or, with a negative delta, refund) memory that
+ * was not allocated by this module.
+ *
+ * @details This is for memory obtained directly from
+ * posix_memalign(3) or mmap(2), so that it still counts
+ * towards its tag and the budgets.
+ *
+ */
+void account_memory(enum memory_tag_t tag, long long delta);
+
+/**
+ * The number of bytes currently charged to a tag.
+ *
+ */
+size_t memory_usage(enum memory_tag_t tag);
+
+/**
+ * Set the soft and hard memory budgets, in bytes.
+ *
+ * @details A budget of zero is unlimited.
+ *
+ */
+void set_memory_budget(size_t soft_limit, size_t hard_limit);
+
+/**
+ * Compare the total usage across all tags to the budgets.
+ *
+ */
+enum memory_pressure_t memory_pressure(void);
+
+/**
+ * Return the name of the memory allocator backend serverd
+ * was built with: glibc, jemalloc, mimalloc or pool.
+ *
+ * @details The backend is chosen at build time with the
+ * Makefile's ALLOCATOR variable. Every block handed out by
+ * this module comes from it; the pool backend serves them
+ * from serverd's own size-classed pools, with no general
+ * purpose allocator behind it.
+ *
+ */
+__attribute__((returns_nonnull))
+const char* memory_allocator_name(void);
+
 /**
  * Prevent double-free errors
  *
@@ -70,4 +173,153 @@ void safe_free(void** ptr);
 #define FREE(ptr) safe_free((void **) &ptr)
 #endif
 
+/**
+ * Allocator tuning, applied to every thread that calls
+ * initialize_thread_memory().
+ *
+ * @details These only take effect when serverd is built
+ * with the jemalloc backend. Decay times are in milliseconds; dirty
+ * pages are unused pages jemalloc still holds, and muzzy
+ * pages are ones it has already told the kernel it may
+ * reclaim lazily.
+ *
+ */
+struct memory_tuning_t {
+    int per_thread_arenas;
+    int thread_cache;
+    long dirty_decay_ms;
+    long muzzy_decay_ms;
+};
+
+/**
+ * Set the allocator tuning.
+ *
+ * @details This must be called before any thread calls
+ * initialize_thread_memory().
+ *
+ */
+__attribute__((nonnull(1)))
+void configure_memory_allocator(const struct memory_tuning_t* tuning);
+
+/**
+ * Set up the calling thread's allocator state.
+ *
+ * @details With per-thread arenas enabled, the thread gets
+ * a jemalloc arena of its own, so that long-running workers
+ * do not fragment each other's memory and their usage shows
+ * up separately in the statistics. The thread cache is
+ * switched on or off as configured.
+ *
+ */
+void initialize_thread_memory(void);
+
+/**
+ * Log the allocator's statistics.
+ *
+ * @details This logs the bytes charged to each tag, and
+ * what the backend reports: with jemalloc, the totals of
+ * allocated, active, resident and retained memory, and the
+ * same figures for every arena created by
+ * initialize_thread_memory(); with mimalloc, the resident
+ * and committed memory; and with the pool backend, the
+ * memory mapped for slabs and for large blocks.
+ *
+ */
+void log_memory_statistics(void);
+
+/**
+ * A chunk of memory that arenas allocate from.
+ *
+ */
+struct arena_chunk_t {
+    struct arena_chunk_t* next;
+    size_t size;
+    size_t used;
+    max_align_t data[];
+};
+
+/**
+ * A per-worker pool of arena chunks.
+ *
+ * @details Chunks of the pool's chunk size are recycled
+ * rather than returned to the allocator, so once the pool
+ * has warmed up, creating and releasing arenas costs no
+ * calls to malloc(3) or free(3) at all. At most capacity
+ * idle chunks are kept. The pool is not thread-safe; each
+ * event loop owns its own.
+ *
+ */
+struct arena_chunk_pool_t {
+    struct arena_chunk_t* free_list;
+    size_t free_count;
+    size_t capacity;
+    size_t chunk_size;
+};
+
+/**
+ * A region-based allocator for memory that lives exactly as
+ * long as a request or a connection.
+ *
+ * @details Allocations bump a pointer through the current
+ * chunk, and when it runs out, a new chunk is taken from the
+ * pool. Nothing is freed individually; releasing the arena
+ * hands every chunk back to the pool at once. The arena
+ * itself lives at the start of its first chunk.
+ *
+ */
+struct memory_arena_t {
+    struct arena_chunk_t* chunks;
+    struct arena_chunk_pool_t* pool;
+};
+
+/**
+ * Create a pool of up to capacity idle arena chunks.
+ *
+ * @details The chunk size includes the chunk's own header,
+ * and should be large enough that a typical arena fits in
+ * a single chunk.
+ *
+ */
+__attribute__((returns_nonnull))
+struct arena_chunk_pool_t* create_arena_chunk_pool(size_t chunk_size, size_t capacity);
+
+/**
+ * Return every idle chunk in the pool to the allocator.
+ *
+ */
+__attribute__((nonnull(1)))
+void trim_arena_chunk_pool(struct arena_chunk_pool_t* pool);
+
+/**
+ * Create an arena on a chunk from the pool.
+ *
+ * @details Chunks are charged to the connections tag, and
+ * this returns NULL if a new one could not be allocated
+ * within the hard budget.
+ *
+ */
+__attribute__((nonnull(1)))
+struct memory_arena_t* create_memory_arena(struct arena_chunk_pool_t* pool);
+
+/**
+ * Allocate memory from an arena.
+ *
+ * @details The memory is suitably aligned for any type, and
+ * remains valid until the arena is released. Allocations
+ * too large for a pooled chunk get a chunk of their own,
+ * which goes back to the allocator on release. Like
+ * create_memory_arena(), this returns NULL if it needs a
+ * new chunk and cannot have one.
+ *
+ */
+__attribute__((malloc,nonnull(1)))
+void* arena_allocate(struct memory_arena_t* arena, size_t size);
+
+/**
+ * Release an arena and everything allocated from it.
+ *
+ */
+__attribute__((nonnull(1)))
+void release_memory_arena(struct memory_arena_t* arena);
+
 #endif /** PROJECT_INCLUDES_MEMORY */
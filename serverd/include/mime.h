@@ -0,0 +1,138 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PROJECT_INCLUDES_MIME_H
+#define PROJECT_INCLUDES_MIME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef PROJECT_INCLUDES_PERFECT_HASH_H
+#include "perfect_hash.h"
+#endif
+
+struct configuration_options_t;
+
+/**
+ * @def MIME_EXTENSION_MAX_LENGTH
+ * @brief Longest file extension the MIME table can hold.
+ *
+ * @details Extensions are stored packed into two machine
+ * words, so that comparing the key in a table slot against
+ * the requested extension is two integer comparisons rather
+ * than a call to strcasecmp(3).
+ *
+ */
+#ifndef MIME_EXTENSION_MAX_LENGTH
+#define MIME_EXTENSION_MAX_LENGTH (16)
+#endif
+
+/**
+ * @def MIME_CONTENT_TYPE_MAX_LENGTH
+ * @brief Longest media type accepted from the configuration.
+ *
+ * @details This keeps the prebuilt header lines small
+ * enough to be copied into the fixed-size response header
+ * buffer without any further length checks.
+ *
+ */
+#ifndef MIME_CONTENT_TYPE_MAX_LENGTH
+#define MIME_CONTENT_TYPE_MAX_LENGTH (128)
+#endif
+
+/**
+ * A single entry in the MIME type table.
+ *
+ * @details The Content-Type header line is built ahead of
+ * time, including its trailing CRLF, so the response path
+ * only has to copy it.
+ *
+ */
+struct mime_type_t {
+    uint64_t extension[2];
+    const char* content_type_header;
+    size_t content_type_header_length;
+};
+
+/**
+ * Pack a file extension into its two-word table key.
+ *
+ * @details ASCII letters are folded to lower case and the
+ * key is padded with NUL bytes. The caller must ensure the
+ * length does not exceed MIME_EXTENSION_MAX_LENGTH.
+ *
+ */
+static inline void pack_mime_extension(const char* extension, size_t length, uint64_t packed[2]) {
+    unsigned char bytes[MIME_EXTENSION_MAX_LENGTH] = { 0 };
+
+    for (size_t i = 0; i < length; ++i) {
+        unsigned char c = (unsigned char) extension[i];
+        bytes[i] = c | ((unsigned char) ((unsigned char) (c - 'A') < 26u) << 5);
+    }
+
+    packed[0] = 0;
+    packed[1] = 0;
+
+    for (size_t i = 0; i < 8; ++i) {
+        packed[0] |= (uint64_t) bytes[i] << (8 * i);
+        packed[1] |= (uint64_t) bytes[i + 8] << (8 * i);
+    }
+}
+
+/**
+ * Reduce a packed extension to its perfect hash fingerprint.
+ *
+ */
+static inline uint64_t mime_extension_fingerprint(const uint64_t packed[2]) {
+    return packed[0] ^ perfect_hash_mix(packed[1] + 0x9E3779B97F4A7C15ULL);
+}
+
+/**
+ * Merge the user's MIME type overrides into the table.
+ *
+ * @details The built-in table is generated at build time
+ * from data/mime.types. If the configuration contains any
+ * MimeType directives, the perfect hash is rebuilt over the
+ * combined set of extensions, at startup and whenever the
+ * configuration is reloaded. Otherwise the generated table
+ * is used as-is.
+ *
+ * This returns FALSE, leaving the current table in place,
+ * if the perfect hash cannot be built.
+ *
+ */
+__attribute__((nonnull(1)))
+int initialize_mime_types(const struct configuration_options_t* configuration_options);
+
+/**
+ * Look up the MIME type of a file by its extension.
+ *
+ * @details This function never returns NULL. Files with no
+ * extension, or an unknown one, are reported as
+ * application/octet-stream.
+ *
+ */
+__attribute__((nonnull(1),returns_nonnull))
+const struct mime_type_t* lookup_mime_type(const char* filename);
+
+#endif /** PROJECT_INCLUDES_MIME_H */
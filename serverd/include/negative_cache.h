@@ -0,0 +1,152 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PROJECT_INCLUDES_NEGATIVE_CACHE_H
+#define PROJECT_INCLUDES_NEGATIVE_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * Opaque handle to a negative lookup cache.
+ *
+ * @details The negative cache remembers request paths that
+ * recently turned out not to exist, so that scanners and
+ * broken links are answered with the prebuilt 404 without
+ * any file system calls at all. A Bloom filter in front of
+ * it answers most lookups for paths that were never missing
+ * without touching the table.
+ *
+ * Entries stay valid until something is created or moved
+ * into one of the directories on the way to them, which
+ * the cache learns about through inotify(7). Entries whose
+ * directories could not be watched are only trusted for the
+ * cache's validity period instead.
+ *
+ */
+struct negative_cache_t;
+
+/**
+ * Create a negative cache.
+ *
+ * @details The cache holds at most max_entries paths, and
+ * forgets the oldest one to make room for a new one. A
+ * cache with max_entries of zero is valid and simply never
+ * holds anything.
+ *
+ * Caches for different document roots can share one
+ * inotify(7) instance, of which a user only gets a handful,
+ * by passing in the descriptor of an existing cache. With
+ * an inotify_fd of -1, the cache gets an instance of its
+ * own.
+ *
+ */
+__attribute__((returns_nonnull))
+struct negative_cache_t* create_negative_cache(size_t max_entries, int bloom_filter_enabled, time_t validity, int inotify_fd);
+
+/**
+ * Check whether a request path is known not to exist.
+ *
+ */
+__attribute__((nonnull(1,2)))
+int lookup_negative_cache(const struct negative_cache_t* cache, const char* path, size_t path_length);
+
+/**
+ * Return the cache's current generation.
+ *
+ * @details The generation changes every time the cache is
+ * invalidated. A caller that is about to look for a file
+ * notes the generation first, and passes it back to
+ * insert_negative_cache(), so that a miss that raced with
+ * the file being created is never cached.
+ *
+ */
+__attribute__((nonnull(1)))
+uint64_t negative_cache_generation(const struct negative_cache_t* cache);
+
+/**
+ * Watch the directories leading to a missing file.
+ *
+ * @details This adds an inotify watch to the deepest
+ * directory of the file name that does exist, and to every
+ * directory above it up to the document root, whose length
+ * within the file name is root_length. Once the watches are
+ * in place, the file is looked for again, to catch it being
+ * created in the meantime.
+ *
+ * Returns FALSE if the file exists after all, and TRUE
+ * otherwise, with watched set to whether the watches could
+ * be added. This makes blocking file system calls, so it is
+ * meant to run on the file I/O pool; it only reads state
+ * that never changes after the cache is created.
+ *
+ */
+__attribute__((nonnull(1,2,4)))
+int watch_missing_file(const struct negative_cache_t* cache, const char* filename, size_t root_length, int* watched);
+
+/**
+ * Remember that a request path does not exist.
+ *
+ * @details Nothing is cached if the cache has been
+ * invalidated since the given generation.
+ *
+ */
+__attribute__((nonnull(1,2)))
+void insert_negative_cache(struct negative_cache_t* cache, const char* path, size_t path_length, int watched, uint64_t generation);
+
+/**
+ * Return the cache's inotify descriptor, or -1 if it has
+ * none.
+ *
+ * @details The event loop polls this descriptor and calls
+ * process_negative_cache_events() whenever it is readable.
+ *
+ */
+__attribute__((nonnull(1)))
+int negative_cache_inotify_fd(const struct negative_cache_t* cache);
+
+/**
+ * Forget every cached path.
+ *
+ * @details This also bumps the generation, so lookups that
+ * were already in flight are not remembered either.
+ *
+ */
+__attribute__((nonnull(1)))
+void clear_negative_cache(struct negative_cache_t* cache);
+
+/**
+ * Drain the inotify descriptor, and invalidate the cache if
+ * any watched directory changed.
+ *
+ * @details Returns whether anything changed, in which case
+ * every other cache sharing the descriptor has to be
+ * cleared too, since events do not say whose watch they
+ * came from.
+ *
+ */
+__attribute__((nonnull(1)))
+int process_negative_cache_events(struct negative_cache_t* cache);
+
+#endif /** PROJECT_INCLUDES_NEGATIVE_CACHE_H */
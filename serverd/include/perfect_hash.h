@@ -0,0 +1,140 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PROJECT_INCLUDES_PERFECT_HASH_H
+#define PROJECT_INCLUDES_PERFECT_HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Minimal perfect hash over 64-bit key fingerprints.
+ *
+ * @details The construction is a simple hash-and-displace
+ * scheme: every key is first assigned to a bucket, and each
+ * bucket is then given a displacement value that moves all
+ * of its keys into distinct, otherwise unused slots. A
+ * lookup is therefore one load from the displacement array,
+ * one load from the caller's slot array, and one comparison
+ * against the key stored in that slot.
+ *
+ * Both the bucket and slot counts are powers of two, so
+ * neither step needs a division.
+ *
+ */
+struct perfect_hash_t {
+    const uint32_t* displacements;
+    uint32_t bucket_mask;
+    uint32_t slot_mask;
+};
+
+/**
+ * Finalize a 64-bit value into a well-mixed hash.
+ *
+ * @details This is the 64-bit finalizer from MurmurHash3.
+ * It is cheap enough to run twice per lookup and mixes the
+ * low-entropy packed keys we feed it (file extensions, for
+ * instance) well enough for the displacement search to
+ * converge quickly.
+ *
+ */
+static inline uint64_t perfect_hash_mix(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+/**
+ * Return the bucket a key fingerprint belongs to.
+ *
+ */
+static inline uint32_t perfect_hash_bucket(uint32_t bucket_mask, uint64_t key) {
+    return (uint32_t) (perfect_hash_mix(key) >> 32) & bucket_mask;
+}
+
+/**
+ * Return the slot of a key given its bucket displacement.
+ *
+ */
+static inline uint32_t perfect_hash_slot_with(uint32_t displacement, uint32_t slot_mask, uint64_t key) {
+    return (uint32_t) perfect_hash_mix(key ^ ((uint64_t) displacement * 0x9E3779B97F4A7C15ULL)) & slot_mask;
+}
+
+/**
+ * Return the slot index a key fingerprint maps to.
+ *
+ * @note The perfect hash only guarantees distinct slots for
+ * the keys it was built from. Callers must compare the key
+ * stored in the returned slot to detect misses.
+ *
+ */
+static inline uint32_t perfect_hash_slot(const struct perfect_hash_t* hash, uint64_t key) {
+    uint32_t displacement = hash->displacements[perfect_hash_bucket(hash->bucket_mask, key)];
+    return perfect_hash_slot_with(displacement, hash->slot_mask, key);
+}
+
+/**
+ * Hash an arbitrary byte string into a 64-bit fingerprint.
+ *
+ * @details This is FNV-1a followed by the mixing step
+ * above. It is used for keys that do not fit into a single
+ * machine word, such as request paths.
+ *
+ */
+static inline uint64_t perfect_hash_string(const char* data, size_t length) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= (unsigned char) data[i];
+        hash *= 0x100000001B3ULL;
+    }
+
+    return perfect_hash_mix(hash);
+}
+
+/**
+ * Build a perfect hash for the given set of fingerprints.
+ *
+ * @details On success the displacement array is allocated
+ * with allocate_memory() and owned by the caller, who may
+ * release it with free_perfect_hash(). If slots is not
+ * NULL, slots[i] receives the slot assigned to keys[i].
+ *
+ * This function returns FALSE if two keys share the same
+ * fingerprint, as no displacement can ever separate them.
+ *
+ */
+__attribute__((nonnull(3)))
+int build_perfect_hash(const uint64_t* keys, size_t key_count, struct perfect_hash_t* hash, uint32_t* slots);
+
+/**
+ * Release the displacement array of a perfect hash.
+ *
+ */
+__attribute__((nonnull(1)))
+void free_perfect_hash(struct perfect_hash_t* hash);
+
+#endif /** PROJECT_INCLUDES_PERFECT_HASH_H */
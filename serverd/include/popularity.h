@@ -0,0 +1,110 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PROJECT_INCLUDES_POPULARITY_H
+#define PROJECT_INCLUDES_POPULARITY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct worker_t;
+
+/**
+ * @def POPULARITY_SNAPSHOT_MAGIC
+ * @brief Magic bytes at the start of a popularity snapshot.
+ *
+ * @details The last byte doubles as the format version.
+ *
+ */
+#ifndef POPULARITY_SNAPSHOT_MAGIC
+#define POPULARITY_SNAPSHOT_MAGIC "SRVDPOP1"
+#endif
+
+/**
+ * The hit count of one request path.
+ *
+ */
+struct popularity_record_t {
+    char* path;
+    uint64_t hits;
+};
+
+/**
+ * A popularity snapshot loaded from disk.
+ *
+ * @details The snapshot file is a compact binary format in
+ * native byte order, since it is only ever read back by the
+ * same machine that wrote it:
+ *
+ *  - 8 bytes of magic, POPULARITY_SNAPSHOT_MAGIC
+ *  - a 32-bit record count
+ *  - a 64-bit wall-clock timestamp of when it was written
+ *  - per record, a 64-bit hit count, a 16-bit path length,
+ *    and the path bytes without a terminator
+ *  - a 64-bit hash of everything before it
+ *
+ * Records are sorted by path once loaded, so lookups are a
+ * binary search.
+ *
+ */
+struct popularity_snapshot_t {
+    struct popularity_record_t* records;
+    size_t count;
+    uint64_t timestamp;
+};
+
+/**
+ * Load a popularity snapshot.
+ *
+ * @details Returns NULL if the file does not exist, which is
+ * normal on first start, or if it is truncated or corrupt,
+ * in which case a warning is logged and the snapshot is
+ * simply ignored.
+ *
+ */
+__attribute__((nonnull(1)))
+struct popularity_snapshot_t* load_popularity_snapshot(const char* filename);
+
+/**
+ * Return the hit count recorded for a request path, or 0.
+ *
+ */
+__attribute__((nonnull(2)))
+uint64_t lookup_popularity(const struct popularity_snapshot_t* snapshot, const char* path);
+
+/**
+ * Write a snapshot of the worker's hit counts.
+ *
+ * @details The hit counts of the worker's cached files are
+ * serialized on the calling thread, which only touches
+ * memory, and the resulting buffer is written out on the
+ * file I/O pool. The file is written to a temporary name and
+ * renamed into place, so a crash mid-write never leaves a
+ * truncated snapshot behind. If the previous snapshot is
+ * still being written, this call does nothing.
+ *
+ */
+__attribute__((nonnull(1)))
+void save_popularity_snapshot(struct worker_t* worker);
+
+#endif /** PROJECT_INCLUDES_POPULARITY_H */
@@ -0,0 +1,138 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PROJECT_INCLUDES_REWRITE_H
+#define PROJECT_INCLUDES_REWRITE_H
+
+#include <stddef.h>
+
+struct rewrite_rule_t;
+
+/**
+ * @def REWRITE_MAX_CAPTURES
+ * @brief The most wildcards a rewrite pattern may have.
+ *
+ * @details Each wildcard is a capture, referred to in the
+ * target as $1 through $9, so there can be no more than
+ * nine of them.
+ *
+ */
+#define REWRITE_MAX_CAPTURES (9)
+
+/**
+ * @def REWRITE_MAX_PATH_LENGTH
+ * @brief The longest request path rewrite rules apply to.
+ *
+ */
+#ifndef REWRITE_MAX_PATH_LENGTH
+#define REWRITE_MAX_PATH_LENGTH (1024)
+#endif
+
+/**
+ * What each wildcard of a pattern matched, as the start and
+ * end offsets into the path.
+ *
+ */
+struct rewrite_captures_t {
+    size_t spans[REWRITE_MAX_CAPTURES + 1][2];
+};
+
+/**
+ * Opaque handle to a compiled set of rewrite rules.
+ *
+ * @details A rewrite pattern is a request path in which
+ * each * matches any run of bytes, slashes included, and
+ * the pattern has to match the whole path. Every pattern is
+ * compiled into a single deterministic automaton over
+ * classes of bytes, so finding the first rule, in the order
+ * they were given, that matches a path takes one pass over
+ * the path, one table lookup per byte, however many rules
+ * there are.
+ *
+ * Captures are only worked out afterwards, and only for the
+ * rule that matched.
+ *
+ * Like the location tree, the engine never changes once
+ * built, belongs to the configuration it was built from,
+ * and refers to that configuration's rules.
+ *
+ */
+struct rewrite_engine_t;
+
+/**
+ * Count the wildcards in a rewrite pattern.
+ *
+ * @details A run of several * is a single wildcard.
+ *
+ */
+__attribute__((nonnull(1)))
+size_t count_rewrite_wildcards(const char* pattern);
+
+/**
+ * Compile a set of rewrite rules.
+ *
+ * @details Returns NULL if the automaton would need more
+ * than REWRITE_MAX_DFA_STATES states.
+ *
+ */
+struct rewrite_engine_t* build_rewrite_engine(const struct rewrite_rule_t* rules, size_t count);
+
+/**
+ * Release a compiled set of rewrite rules.
+ *
+ */
+void free_rewrite_engine(struct rewrite_engine_t* engine);
+
+/**
+ * Find the first rule whose pattern matches a normalized
+ * request path, or NULL if there is none.
+ *
+ */
+__attribute__((nonnull(1,2)))
+const struct rewrite_rule_t* match_rewrite_rule(const struct rewrite_engine_t* engine, const char* path, size_t length);
+
+/**
+ * Work out what each wildcard of a rule's pattern captured.
+ *
+ * @details The path must be one the rule matched. Earlier
+ * wildcards take as much as they can. Capture zero is the
+ * whole path.
+ *
+ */
+__attribute__((nonnull(1,2,4)))
+void capture_rewrite_rule(const struct rewrite_rule_t* rule, const char* path, size_t length, struct rewrite_captures_t* captures);
+
+/**
+ * Substitute the captures into a rule's target.
+ *
+ * @details With encode set, captured bytes that may not
+ * appear as they are in a URI are percent-encoded. Like
+ * snprintf(3), this writes at most size bytes, including
+ * the terminating NUL, and returns the length the whole
+ * result would have had.
+ *
+ */
+__attribute__((nonnull(1,2,3)))
+size_t expand_rewrite_target(const struct rewrite_rule_t* rule, const char* path, const struct rewrite_captures_t* captures, int encode, char* output, size_t size);
+
+#endif /** PROJECT_INCLUDES_REWRITE_H */
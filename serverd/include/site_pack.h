@@ -0,0 +1,213 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PROJECT_INCLUDES_SITE_PACK_H
+#define PROJECT_INCLUDES_SITE_PACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "perfect_hash.h"
+
+/**
+ * @def SITE_PACK_MAGIC
+ * @brief Magic bytes at the start of a site pack.
+ *
+ * @details The last byte doubles as the format version.
+ *
+ */
+#ifndef SITE_PACK_MAGIC
+#define SITE_PACK_MAGIC "SRVDPAK1"
+#endif
+
+/**
+ * @def SITE_PACK_BODY_ALIGNMENT
+ * @brief Alignment of every response body in a site pack.
+ *
+ * @details Bodies start on a page boundary, so sendfile(2)
+ * from the pack never shares a page between two files and
+ * a pack can be laid out for huge pages later on.
+ *
+ */
+#ifndef SITE_PACK_BODY_ALIGNMENT
+#define SITE_PACK_BODY_ALIGNMENT (4096)
+#endif
+
+/**
+ * @def SITE_PACK_EMPTY_SLOT
+ * @brief Marks a perfect hash slot with no entry.
+ *
+ */
+#ifndef SITE_PACK_EMPTY_SLOT
+#define SITE_PACK_EMPTY_SLOT (UINT32_MAX)
+#endif
+
+/**
+ * The fixed header at the start of a site pack.
+ *
+ * @details A site pack is a compiled document root: a
+ * single file holding a perfect hash index of every request
+ * path, the complete response headers for each path, and
+ * the response bodies themselves. Its layout is
+ *
+ *  - this header
+ *  - the perfect hash displacements, one uint32_t per bucket
+ *  - the slot table, one uint32_t entry index per slot
+ *  - the entry table
+ *  - the request paths and response headers, back to back
+ *  - the response bodies, each page-aligned
+ *
+ * All offsets are from the start of the file, and all
+ * integers are in the byte order of the machine that built
+ * the pack, since packs are built as part of a release for
+ * the machines that serve it.
+ *
+ */
+struct site_pack_header_t {
+    char magic[8];
+    uint32_t entry_count;
+    uint32_t bucket_count;
+    uint32_t slot_count;
+    uint32_t reserved;
+    uint64_t displacements_offset;
+    uint64_t slots_offset;
+    uint64_t entries_offset;
+    uint64_t file_size;
+};
+
+/**
+ * One encoding of a response in a site pack.
+ *
+ * @details The headers are the complete response headers,
+ * status line included, so serving a response is one send(2)
+ * of the headers and one sendfile(2) of the body.
+ *
+ */
+struct site_pack_variant_t {
+    uint64_t header_offset;
+    uint64_t body_offset;
+    uint64_t body_length;
+    uint32_t header_length;
+    uint32_t reserved;
+};
+
+/**
+ * @def SITE_PACK_ENTRY_GZIP
+ * @brief The entry has a precompressed gzip variant.
+ *
+ */
+#ifndef SITE_PACK_ENTRY_GZIP
+#define SITE_PACK_ENTRY_GZIP (1U << 0)
+#endif
+
+/**
+ * A request path in a site pack.
+ *
+ * @details Directory requests without a trailing slash are
+ * stored as entries of their own, whose headers are the
+ * complete redirect response and whose body is empty.
+ *
+ */
+struct site_pack_entry_t {
+    uint64_t path_hash;
+    uint64_t path_offset;
+    uint32_t path_length;
+    uint32_t flags;
+    struct site_pack_variant_t identity;
+    struct site_pack_variant_t gzip;
+};
+
+/**
+ * A site pack mapped into memory.
+ *
+ * @details The index, headers and paths are read straight
+ * from the mapping. The bodies are sent from the pack's file
+ * descriptor with sendfile(2), so they are only ever paged
+ * into the page cache, never copied.
+ *
+ */
+struct site_pack_t {
+    int fd;
+    const unsigned char* base;
+    size_t size;
+
+    struct perfect_hash_t hash;
+    const uint32_t* slots;
+    const struct site_pack_entry_t* entries;
+    uint32_t entry_count;
+
+    uint64_t device;
+    uint64_t inode;
+    int64_t mtime_seconds;
+    int64_t mtime_nanoseconds;
+};
+
+/**
+ * Map a site pack into memory.
+ *
+ * @details Every offset in the pack is validated here, once,
+ * so that lookups can trust the index. Returns NULL, after
+ * logging why, if the pack cannot be opened or is invalid.
+ *
+ */
+__attribute__((nonnull(1)))
+struct site_pack_t* load_site_pack(const char* filename);
+
+/**
+ * Unmap a site pack and close its file descriptor.
+ *
+ */
+void free_site_pack(struct site_pack_t* pack);
+
+/**
+ * Swap in a new site pack if the file has been replaced.
+ *
+ * @details Releases are deployed by writing the new pack
+ * next to the old one and rename(2)-ing it into place. This
+ * function notices the new file by its identity, maps it,
+ * and only then releases the old one, so every request is
+ * answered entirely from one release or the other. If the
+ * new pack is invalid, the old one stays in service.
+ *
+ */
+__attribute__((nonnull(1,2)))
+struct site_pack_t* reload_site_pack_if_changed(struct site_pack_t* pack, const char* filename);
+
+/**
+ * Look up a request path in a site pack.
+ *
+ * @details Returns NULL if the path is not in the pack.
+ *
+ */
+__attribute__((nonnull(1,2)))
+const struct site_pack_entry_t* lookup_site_pack(const struct site_pack_t* pack, const char* path, size_t path_length);
+
+/**
+ * Return a pointer into the pack at the given offset.
+ *
+ */
+static inline const char* site_pack_data(const struct site_pack_t* pack, uint64_t offset) {
+    return (const char *) pack->base + offset;
+}
+
+#endif /** PROJECT_INCLUDES_SITE_PACK_H */
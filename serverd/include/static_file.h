@@ -0,0 +1,100 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PROJECT_INCLUDES_STATIC_FILE_H
+#define PROJECT_INCLUDES_STATIC_FILE_H
+
+#include <stddef.h>
+
+struct worker_t;
+struct connection_t;
+
+/**
+ * Check whether a request accepts gzip content coding.
+ *
+ * @details The request is the raw request text, whose
+ * Accept-Encoding header, if any, is searched for gzip.
+ *
+ */
+__attribute__((nonnull(1)))
+int request_accepts_gzip(const char* request);
+
+/**
+ * Find the Host header of a request.
+ *
+ * @details Returns the header's value, without surrounding
+ * whitespace, and its length, or NULL if the request has no
+ * Host header.
+ *
+ */
+__attribute__((nonnull(1,2)))
+const char* request_host(const char* request, size_t* length);
+
+/**
+ * Serve a request.
+ *
+ * @details The request URI is decoded and normalized, and
+ * the first matching rewrite or redirect rule, if any, is
+ * applied to the request path, which is then matched
+ * against the locations. A redirect rule, or a redirect or
+ * return location, answers right away. Anything else is
+ * served from the given virtual host's document root, or
+ * the location's own, by way of the virtual host's caches.
+ *
+ * If the request is for the default virtual host's
+ * document root and the worker has a site pack, the
+ * response is served from the pack, using its precompressed
+ * variant if the client accepts gzip. Otherwise the request
+ * path is mapped onto the document root, and requests for a
+ * directory are served its index.html or, if that does not
+ * exist and directory listings are enabled, a generated
+ * listing.
+ *
+ * All blocking file system work is done on the worker's
+ * file I/O pool, so this function returns as soon as the
+ * first job has been submitted. The response is finished,
+ * and the connection closed, from the job completions.
+ *
+ */
+__attribute__((nonnull(1,3,4)))
+void serve_request(struct worker_t* worker, size_t virtual_host, struct connection_t* connection, const char* request_uri, int accepts_gzip);
+
+/**
+ * Turn a request away with a 503, and close its connection.
+ *
+ * @details This is what a request gets when serverd is past
+ * its hard memory budget. The response is prebuilt, so
+ * sending it allocates nothing.
+ *
+ */
+__attribute__((nonnull(1,2)))
+void send_service_unavailable_response(struct worker_t* worker, struct connection_t* connection);
+
+/**
+ * Log the worker's page cache statistics.
+ *
+ */
+__attribute__((nonnull(1)))
+void log_page_cache_statistics(const struct worker_t* worker);
+
+#endif /** PROJECT_INCLUDES_STATIC_FILE_H */
@@ -0,0 +1,90 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PROJECT_INCLUDES_VIRTUAL_HOST_H
+#define PROJECT_INCLUDES_VIRTUAL_HOST_H
+
+#include <stddef.h>
+
+struct virtual_host_t;
+
+/**
+ * @def VIRTUAL_HOST_NAME_MAX_LENGTH
+ * @brief The longest host name that can be routed.
+ *
+ * @details This is the limit DNS puts on a domain name.
+ * Longer Host headers go to the default virtual host.
+ *
+ */
+#ifndef VIRTUAL_HOST_NAME_MAX_LENGTH
+#define VIRTUAL_HOST_NAME_MAX_LENGTH (253)
+#endif
+
+/**
+ * Opaque handle to a virtual host router.
+ *
+ * @details Routes a Host header to a virtual host. Exact
+ * names live in a perfect hash table, so a request for one
+ * of them costs a single probe however many virtual hosts
+ * there are. Wildcard names live in a suffix trie over the
+ * names' labels, whose edges are themselves a perfect hash
+ * keyed by the parent node and the label, so walking it
+ * costs one probe per label of the Host header. The most
+ * specific wildcard wins.
+ *
+ * A router never changes once built. It belongs to the
+ * configuration it was built from, and refers to that
+ * configuration's names rather than copying them.
+ *
+ */
+struct virtual_host_router_t;
+
+/**
+ * Build the router for a set of virtual hosts.
+ *
+ * @details The first virtual host is the default one, and
+ * has no names. Returns NULL if any name is given to more
+ * than one virtual host, pointing duplicate at it.
+ *
+ */
+__attribute__((nonnull(1,3)))
+struct virtual_host_router_t* build_virtual_host_router(const struct virtual_host_t* virtual_hosts, size_t count, const char** duplicate);
+
+/**
+ * Release a router.
+ *
+ */
+void free_virtual_host_router(struct virtual_host_router_t* router);
+
+/**
+ * Find the virtual host for a Host header value.
+ *
+ * @details The value may carry a port and a trailing dot,
+ * and is matched without regard to case. Returns zero, the
+ * default virtual host, if nothing matches.
+ *
+ */
+__attribute__((nonnull(1)))
+size_t route_virtual_host(const struct virtual_host_router_t* router, const char* host, size_t length);
+
+#endif /** PROJECT_INCLUDES_VIRTUAL_HOST_H */
@@ -0,0 +1,52 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PROJECT_INCLUDES_WARMUP_H
+#define PROJECT_INCLUDES_WARMUP_H
+
+struct worker_t;
+
+/**
+ * Preload the file cache before serving any requests.
+ *
+ * @details The document root is walked in parallel to find
+ * every regular file and its size. The files are then
+ * ranked, highest priority first and smallest first within
+ * the same priority, and preloaded in that order until the
+ * configured byte budget or the file cache's capacity is
+ * exhausted.
+ *
+ * Priorities come from the warm-up manifest, if one is
+ * configured. Preloading a file opens it, builds its cache
+ * entry with prebuilt headers, and reads it into the page
+ * cache with readahead(2), all on the file I/O pool.
+ *
+ * Only the default virtual host's document root and file
+ * cache are warmed up. This function does nothing if the
+ * warm-up budget is zero.
+ *
+ */
+__attribute__((nonnull(1)))
+void warm_up_file_cache(struct worker_t* worker);
+
+#endif /** PROJECT_INCLUDES_WARMUP_H */
@@ -0,0 +1,103 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PROJECT_INCLUDES_WORKER_H
+#define PROJECT_INCLUDES_WORKER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct configuration_options_t;
+struct file_io_pool_t;
+struct pipe_pool_t;
+struct connection_slab_t;
+struct arena_chunk_pool_t;
+struct direct_buffer_pool_t;
+struct directory_listing_cache_t;
+struct file_cache_t;
+struct negative_cache_t;
+struct content_region_t;
+struct content_store_t;
+struct popularity_snapshot_t;
+struct site_pack_t;
+
+/**
+ * Page cache statistics for files sent from their
+ * descriptors.
+ *
+ * @details A hit is a file whose first page was already
+ * cached when its response was ready to go out. A miss had
+ * its first readahead window read in on the file I/O pool
+ * first, and readahead_bytes counts those windows.
+ *
+ */
+struct page_cache_statistics_t {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t readahead_bytes;
+};
+
+/**
+ * Per-virtual host state.
+ *
+ * @details Every virtual host has caches of its own, so
+ * that paths, which are only unique within a document root,
+ * can key them as they are, and so that one busy site
+ * cannot evict another's files.
+ *
+ */
+struct worker_host_t {
+    struct directory_listing_cache_t* directory_listing_cache;
+    struct file_cache_t* file_cache;
+    struct negative_cache_t* negative_cache;
+};
+
+/**
+ * Per-event-loop state.
+ *
+ * @details Everything in here is owned by a single event
+ * loop and must never be touched from any other thread.
+ * Request state that outlives one pass through the loop,
+ * such as a response waiting on the file I/O pool, keeps a
+ * pointer back to its worker.
+ *
+ */
+struct worker_t {
+    const struct configuration_options_t* configuration_options;
+    size_t configuration_reader;
+    struct file_io_pool_t* file_io_pool;
+    struct connection_slab_t* connection_slab;
+    struct pipe_pool_t* pipe_pool;
+    struct arena_chunk_pool_t* arena_chunk_pool;
+    struct direct_buffer_pool_t* direct_buffer_pool;
+    struct worker_host_t* hosts;
+    size_t host_count;
+    struct content_region_t* content_region;
+    struct content_store_t* content_store;
+    struct popularity_snapshot_t* popularity_snapshot;
+    int popularity_snapshot_pending;
+    struct site_pack_t* site_pack;
+    struct page_cache_statistics_t page_cache_statistics;
+};
+
+#endif /** PROJECT_INCLUDES_WORKER_H */
@@ -0,0 +1,139 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PROJECT_INCLUDES_ZERO_COPY_H
+#define PROJECT_INCLUDES_ZERO_COPY_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/**
+ * A kernel pipe used as the intermediate buffer for splice(2).
+ *
+ * @details The buffered field tracks how many bytes are
+ * currently sitting in the pipe, i.e. have been spliced in
+ * but not yet out. A pipe may only go back to its pool once
+ * it has been fully drained.
+ *
+ */
+struct kernel_pipe_t {
+    int read_fd;
+    int write_fd;
+    size_t buffered;
+    struct kernel_pipe_t* next;
+};
+
+/**
+ * A per-worker pool of kernel pipes.
+ *
+ * @details Creating a pipe costs two system calls, plus a
+ * third to resize it, so pipes are recycled rather than
+ * created per transfer. The pool is not thread-safe; each
+ * event loop owns its own.
+ *
+ */
+struct pipe_pool_t {
+    struct kernel_pipe_t* free_list;
+    size_t free_count;
+    size_t capacity;
+    size_t pipe_size;
+};
+
+/**
+ * Create a pool of up to capacity idle pipes.
+ *
+ * @details Pipes are created lazily. The pipe_size argument
+ * is passed to F_SETPIPE_SZ for each new pipe; if the kernel
+ * refuses it, the pipe keeps the default size.
+ *
+ */
+__attribute__((returns_nonnull))
+struct pipe_pool_t* create_pipe_pool(size_t capacity, size_t pipe_size);
+
+/**
+ * Take a pipe from the pool, creating one if necessary.
+ *
+ * @details Returns NULL only if a new pipe could not be
+ * created, e.g. because the process ran out of file
+ * descriptors.
+ *
+ */
+__attribute__((nonnull(1)))
+struct kernel_pipe_t* acquire_kernel_pipe(struct pipe_pool_t* pool);
+
+/**
+ * Return a pipe to the pool.
+ *
+ * @details A pipe that still holds data, or that would
+ * exceed the pool's capacity, is closed instead.
+ *
+ */
+__attribute__((nonnull(1,2)))
+void release_kernel_pipe(struct pipe_pool_t* pool, struct kernel_pipe_t* pipe);
+
+/**
+ * Move bytes between two file descriptors through a pipe.
+ *
+ * @details This is the general zero-copy mover. Either end
+ * may be a socket or a file, so the same call relays a
+ * socket to another socket when proxying, stores a socket
+ * to a file for uploads, or sends a file to a socket when
+ * sendfile(2) does not apply. The offsets follow the same
+ * rules as splice(2): NULL for sockets and pipes, or a
+ * pointer to the file offset, which is advanced.
+ *
+ * Bytes left in the pipe by a previous call that hit
+ * EAGAIN on the output side are flushed first. The function
+ * returns the number of bytes written to out_fd, which is
+ * less than length if the input reached end-of-file or
+ * either side would block, or -1 on error.
+ *
+ */
+__attribute__((nonnull(1)))
+ssize_t splice_transfer(struct kernel_pipe_t* pipe, int in_fd, off_t* in_offset, int out_fd, off_t* out_offset, size_t length);
+
+/**
+ * Duplicate the data buffered in one pipe into another.
+ *
+ * @details This uses tee(2), so the source pipe keeps its
+ * contents. It allows, for instance, a proxied response to
+ * be spliced to the client and to a cache file at once.
+ *
+ */
+__attribute__((nonnull(1,2)))
+ssize_t splice_tee(struct kernel_pipe_t* source, struct kernel_pipe_t* destination, size_t length);
+
+/**
+ * Send a range of a file to a socket without copying.
+ *
+ * @details This is the body write path for static files. It
+ * uses sendfile(2) where it can, and falls back to
+ * splice_transfer() through a pooled pipe for files that
+ * sendfile(2) rejects, such as pipes, character devices, or
+ * files on some special file systems.
+ *
+ */
+__attribute__((nonnull(1)))
+ssize_t send_file_range(struct pipe_pool_t* pool, int socket, int fd, off_t* offset, size_t length);
+
+#endif /** PROJECT_INCLUDES_ZERO_COPY_H */
@@ -0,0 +1,537 @@
+/**
+ * Generated by tools/generate_mime_table from data/mime.types.
+ * Do not edit this file by hand.
+ *
+ */
+
+#ifndef PROJECT_GENERATED_MIME_TABLE_H
+#define PROJECT_GENERATED_MIME_TABLE_H
+
+#define MIME_TABLE_ENTRIES (495)
+#define MIME_TABLE_BUCKET_MASK (255u)
+#define MIME_TABLE_SLOT_MASK (1023u)
+
+static const uint32_t mime_table_displacements[MIME_TABLE_BUCKET_MASK + 1] = {
+    1, 0, 2, 1, 0, 0, 1, 2, 0, 1, 0, 0,
+    0, 2, 2, 0, 0, 1, 0, 1, 0, 0, 0, 1,
+    0, 1, 2, 2, 0, 0, 1, 1, 0, 0, 0, 3,
+    1, 0, 1, 0, 0, 1, 0, 1, 1, 0, 0, 3,
+    0, 0, 1, 0, 1, 1, 3, 0, 1, 1, 4, 0,
+    3, 0, 0, 1, 0, 0, 0, 1, 0, 1, 0, 1,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 1, 0, 0, 3, 1, 0, 1, 0, 0, 1, 0,
+    1, 0, 2, 1, 0, 0, 0, 3, 0, 2, 0, 0,
+    3, 0, 0, 0, 0, 1, 0, 0, 0, 0, 2, 1,
+    0, 1, 1, 0, 0, 0, 0, 1, 0, 1, 0, 1,
+    0, 1, 1, 5, 0, 0, 3, 0, 0, 0, 1, 1,
+    0, 0, 1, 0, 0, 5, 0, 0, 0, 0, 1, 0,
+    0, 5, 0, 0, 4, 0, 0, 0, 0, 0, 0, 0,
+    0, 1, 0, 1, 0, 0, 0, 0, 1, 0, 0, 1,
+    0, 1, 0, 0, 1, 0, 6, 0, 1, 6, 1, 2,
+    2, 0, 2, 1, 2, 0, 0, 0, 0, 2, 0, 0,
+    0, 0, 0, 5, 1, 0, 0, 5, 0, 0, 0, 0,
+    1, 0, 0, 0, 0, 4, 8, 0, 0, 0, 1, 1,
+    2, 1, 0, 0, 1, 1, 0, 3, 0, 3, 1, 1,
+    2, 0, 5, 0, 0, 1, 0, 4, 0, 0, 0, 0,
+    0, 1, 0, 4,
+};
+
+static const struct mime_type_t mime_table_entries[MIME_TABLE_SLOT_MASK + 1] = {
+    [190] = { { 0x000000006C6D7468ULL, 0x0000000000000000ULL }, "Content-Type: text/html\r\n", 25 }, /* html */
+    [137] = { { 0x00000000006D7468ULL, 0x0000000000000000ULL }, "Content-Type: text/html\r\n", 25 }, /* htm */
+    [935] = { { 0x0000006C6D746873ULL, 0x0000000000000000ULL }, "Content-Type: text/html\r\n", 25 }, /* shtml */
+    [889] = { { 0x0000006C6D746878ULL, 0x0000000000000000ULL }, "Content-Type: text/html\r\n", 25 }, /* xhtml */
+    [32] = { { 0x0000000000737363ULL, 0x0000000000000000ULL }, "Content-Type: text/css\r\n", 24 }, /* css */
+    [54] = { { 0x0000000000767363ULL, 0x0000000000000000ULL }, "Content-Type: text/csv\r\n", 24 }, /* csv */
+    [101] = { { 0x0000000000767374ULL, 0x0000000000000000ULL }, "Content-Type: text/tab-separated-values\r\n", 41 }, /* tsv */
+    [180] = { { 0x0000000000747874ULL, 0x0000000000000000ULL }, "Content-Type: text/plain\r\n", 26 }, /* txt */
+    [184] = { { 0x0000000074786574ULL, 0x0000000000000000ULL }, "Content-Type: text/plain\r\n", 26 }, /* text */
+    [264] = { { 0x00000000666E6F63ULL, 0x0000000000000000ULL }, "Content-Type: text/plain\r\n", 26 }, /* conf */
+    [467] = { { 0x0000000000666564ULL, 0x0000000000000000ULL }, "Content-Type: text/plain\r\n", 26 }, /* def */
+    [421] = { { 0x000000007473696CULL, 0x0000000000000000ULL }, "Content-Type: text/plain\r\n", 26 }, /* list */
+    [245] = { { 0x0000000000676F6CULL, 0x0000000000000000ULL }, "Content-Type: text/plain\r\n", 26 }, /* log */
+    [212] = { { 0x0000000000006E69ULL, 0x0000000000000000ULL }, "Content-Type: text/plain\r\n", 26 }, /* in */
+    [791] = { { 0x0000000000696E69ULL, 0x0000000000000000ULL }, "Content-Type: text/plain\r\n", 26 }, /* ini */
+    [571] = { { 0x000000000000646DULL, 0x0000000000000000ULL }, "Content-Type: text/markdown\r\n", 29 }, /* md */
+    [261] = { { 0x6E776F646B72616DULL, 0x0000000000000000ULL }, "Content-Type: text/markdown\r\n", 29 }, /* markdown */
+    [703] = { { 0x0000000000736369ULL, 0x0000000000000000ULL }, "Content-Type: text/calendar\r\n", 29 }, /* ics */
+    [698] = { { 0x0000000000626669ULL, 0x0000000000000000ULL }, "Content-Type: text/calendar\r\n", 29 }, /* ifb */
+    [269] = { { 0x0000000000666376ULL, 0x0000000000000000ULL }, "Content-Type: text/vcard\r\n", 26 }, /* vcf */
+    [687] = { { 0x0000006472616376ULL, 0x0000000000000000ULL }, "Content-Type: text/vcard\r\n", 26 }, /* vcard */
+    [31] = { { 0x00000000006C6D78ULL, 0x0000000000000000ULL }, "Content-Type: text/xml\r\n", 24 }, /* xml */
+    [892] = { { 0x00000000006C7378ULL, 0x0000000000000000ULL }, "Content-Type: text/xml\r\n", 24 }, /* xsl */
+    [797] = { { 0x000000000000736AULL, 0x0000000000000000ULL }, "Content-Type: text/javascript\r\n", 31 }, /* js */
+    [6] = { { 0x0000000000736A6DULL, 0x0000000000000000ULL }, "Content-Type: text/javascript\r\n", 31 }, /* mjs */
+    [172] = { { 0x0000000000736A63ULL, 0x0000000000000000ULL }, "Content-Type: text/javascript\r\n", 31 }, /* cjs */
+    [426] = { { 0x0000000000000073ULL, 0x0000000000000000ULL }, "Content-Type: text/x-asm\r\n", 26 }, /* s */
+    [397] = { { 0x00000000006D7361ULL, 0x0000000000000000ULL }, "Content-Type: text/x-asm\r\n", 26 }, /* asm */
+    [804] = { { 0x0000000000000063ULL, 0x0000000000000000ULL }, "Content-Type: text/x-c\r\n", 24 }, /* c */
+    [616] = { { 0x0000000000006363ULL, 0x0000000000000000ULL }, "Content-Type: text/x-c\r\n", 24 }, /* cc */
+    [1016] = { { 0x0000000000787863ULL, 0x0000000000000000ULL }, "Content-Type: text/x-c\r\n", 24 }, /* cxx */
+    [126] = { { 0x0000000000707063ULL, 0x0000000000000000ULL }, "Content-Type: text/x-c\r\n", 24 }, /* cpp */
+    [413] = { { 0x0000000000000068ULL, 0x0000000000000000ULL }, "Content-Type: text/x-c\r\n", 24 }, /* h */
+    [754] = { { 0x0000000000006868ULL, 0x0000000000000000ULL }, "Content-Type: text/x-c\r\n", 24 }, /* hh */
+    [287] = { { 0x0000000000707068ULL, 0x0000000000000000ULL }, "Content-Type: text/x-c\r\n", 24 }, /* hpp */
+    [999] = { { 0x0000000000636964ULL, 0x0000000000000000ULL }, "Content-Type: text/x-c\r\n", 24 }, /* dic */
+    [509] = { { 0x000000006176616AULL, 0x0000000000000000ULL }, "Content-Type: text/x-java-source\r\n", 34 }, /* java */
+    [489] = { { 0x0000000000007970ULL, 0x0000000000000000ULL }, "Content-Type: text/x-python\r\n", 29 }, /* py */
+    [95] = { { 0x0000000000777970ULL, 0x0000000000000000ULL }, "Content-Type: text/x-python\r\n", 29 }, /* pyw */
+    [586] = { { 0x0000000000007372ULL, 0x0000000000000000ULL }, "Content-Type: text/x-rust\r\n", 27 }, /* rs */
+    [205] = { { 0x0000000000006F67ULL, 0x0000000000000000ULL }, "Content-Type: text/x-go\r\n", 25 }, /* go */
+    [898] = { { 0x0000000000006873ULL, 0x0000000000000000ULL }, "Content-Type: text/x-shellscript\r\n", 34 }, /* sh */
+    [737] = { { 0x0000000068736162ULL, 0x0000000000000000ULL }, "Content-Type: text/x-shellscript\r\n", 34 }, /* bash */
+    [699] = { { 0x000000000068737AULL, 0x0000000000000000ULL }, "Content-Type: text/x-shellscript\r\n", 34 }, /* zsh */
+    [410] = { { 0x0000000000006C70ULL, 0x0000000000000000ULL }, "Content-Type: text/x-perl\r\n", 27 }, /* pl */
+    [236] = { { 0x0000000000006D70ULL, 0x0000000000000000ULL }, "Content-Type: text/x-perl\r\n", 27 }, /* pm */
+    [255] = { { 0x0000000000006272ULL, 0x0000000000000000ULL }, "Content-Type: text/x-ruby\r\n", 27 }, /* rb */
+    [480] = { { 0x000000000061756CULL, 0x0000000000000000ULL }, "Content-Type: text/x-lua\r\n", 26 }, /* lua */
+    [932] = { { 0x0000000066666964ULL, 0x0000000000000000ULL }, "Content-Type: text/x-diff\r\n", 27 }, /* diff */
+    [258] = { { 0x0000006863746170ULL, 0x0000000000000000ULL }, "Content-Type: text/x-diff\r\n", 27 }, /* patch */
+    [739] = { { 0x0000000073736173ULL, 0x0000000000000000ULL }, "Content-Type: text/x-sass\r\n", 27 }, /* sass */
+    [597] = { { 0x0000000073736373ULL, 0x0000000000000000ULL }, "Content-Type: text/x-scss\r\n", 27 }, /* scss */
+    [869] = { { 0x000000007373656CULL, 0x0000000000000000ULL }, "Content-Type: text/x-less\r\n", 27 }, /* less */
+    [928] = { { 0x000000006C6D6179ULL, 0x0000000000000000ULL }, "Content-Type: text/x-yaml\r\n", 27 }, /* yaml */
+    [745] = { { 0x00000000006C6D79ULL, 0x0000000000000000ULL }, "Content-Type: text/x-yaml\r\n", 27 }, /* yml */
+    [979] = { { 0x000000006C6D6F74ULL, 0x0000000000000000ULL }, "Content-Type: text/x-toml\r\n", 27 }, /* toml */
+    [306] = { { 0x0000000000706870ULL, 0x0000000000000000ULL }, "Content-Type: text/x-php\r\n", 26 }, /* php */
+    [820] = { { 0x0000000000786574ULL, 0x0000000000000000ULL }, "Content-Type: text/x-tex\r\n", 26 }, /* tex */
+    [342] = { { 0x000000000078746CULL, 0x0000000000000000ULL }, "Content-Type: text/x-tex\r\n", 26 }, /* ltx */
+    [267] = { { 0x0000000000797473ULL, 0x0000000000000000ULL }, "Content-Type: text/x-tex\r\n", 26 }, /* sty */
+    [727] = { { 0x0000000000736C63ULL, 0x0000000000000000ULL }, "Content-Type: text/x-tex\r\n", 26 }, /* cls */
+    [390] = { { 0x00000000006F666EULL, 0x0000000000000000ULL }, "Content-Type: text/x-nfo\r\n", 26 }, /* nfo */
+    [810] = { { 0x000000006C6D706FULL, 0x0000000000000000ULL }, "Content-Type: text/x-opml\r\n", 27 }, /* opml */
+    [231] = { { 0x0000000000787465ULL, 0x0000000000000000ULL }, "Content-Type: text/x-setext\r\n", 29 }, /* etx */
+    [500] = { { 0x0000000000766673ULL, 0x0000000000000000ULL }, "Content-Type: text/x-sfv\r\n", 26 }, /* sfv */
+    [884] = { { 0x0000000000007575ULL, 0x0000000000000000ULL }, "Content-Type: text/x-uuencode\r\n", 31 }, /* uu */
+    [646] = { { 0x0000000000736376ULL, 0x0000000000000000ULL }, "Content-Type: text/x-vcalendar\r\n", 32 }, /* vcs */
+    [110] = { { 0x0000000000000074ULL, 0x0000000000000000ULL }, "Content-Type: text/troff\r\n", 26 }, /* t */
+    [352] = { { 0x0000000000007274ULL, 0x0000000000000000ULL }, "Content-Type: text/troff\r\n", 26 }, /* tr */
+    [533] = { { 0x0000000066666F72ULL, 0x0000000000000000ULL }, "Content-Type: text/troff\r\n", 26 }, /* roff */
+    [710] = { { 0x00000000006E616DULL, 0x0000000000000000ULL }, "Content-Type: text/troff\r\n", 26 }, /* man */
+    [182] = { { 0x000000000000656DULL, 0x0000000000000000ULL }, "Content-Type: text/troff\r\n", 26 }, /* me */
+    [153] = { { 0x000000000000736DULL, 0x0000000000000000ULL }, "Content-Type: text/troff\r\n", 26 }, /* ms */
+    [414] = { { 0x0000000000697275ULL, 0x0000000000000000ULL }, "Content-Type: text/uri-list\r\n", 29 }, /* uri */
+    [478] = { { 0x0000000073697275ULL, 0x0000000000000000ULL }, "Content-Type: text/uri-list\r\n", 29 }, /* uris */
+    [625] = { { 0x00000000736C7275ULL, 0x0000000000000000ULL }, "Content-Type: text/uri-list\r\n", 29 }, /* urls */
+    [149] = { { 0x0000000000787472ULL, 0x0000000000000000ULL }, "Content-Type: text/richtext\r\n", 29 }, /* rtx */
+    [130] = { { 0x000000006C6D6773ULL, 0x0000000000000000ULL }, "Content-Type: text/sgml\r\n", 25 }, /* sgml */
+    [374] = { { 0x00000000006D6773ULL, 0x0000000000000000ULL }, "Content-Type: text/sgml\r\n", 25 }, /* sgm */
+    [648] = { { 0x000000000000336EULL, 0x0000000000000000ULL }, "Content-Type: text/n3\r\n", 23 }, /* n3 */
+    [858] = { { 0x00000000006C7474ULL, 0x0000000000000000ULL }, "Content-Type: text/turtle\r\n", 27 }, /* ttl */
+    [102] = { { 0x0000000000747476ULL, 0x0000000000000000ULL }, "Content-Type: text/vtt\r\n", 24 }, /* vtt */
+    [399] = { { 0x6568636163707061ULL, 0x0000000000000000ULL }, "Content-Type: text/cache-manifest\r\n", 35 }, /* appcache */
+    [154] = { { 0x0000000000637468ULL, 0x0000000000000000ULL }, "Content-Type: text/x-component\r\n", 32 }, /* htc */
+    [676] = { { 0x00000000006C6D6DULL, 0x0000000000000000ULL }, "Content-Type: text/mathml\r\n", 27 }, /* mml */
+    [835] = { { 0x0000000078647073ULL, 0x0000000000000000ULL }, "Content-Type: text/spdx\r\n", 25 }, /* spdx */
+    [588] = { { 0x00000000676E7061ULL, 0x0000000000000000ULL }, "Content-Type: image/apng\r\n", 26 }, /* apng */
+    [940] = { { 0x0000000066697661ULL, 0x0000000000000000ULL }, "Content-Type: image/avif\r\n", 26 }, /* avif */
+    [251] = { { 0x0000000000706D62ULL, 0x0000000000000000ULL }, "Content-Type: image/bmp\r\n", 25 }, /* bmp */
+    [798] = { { 0x0000000000626964ULL, 0x0000000000000000ULL }, "Content-Type: image/bmp\r\n", 25 }, /* dib */
+    [319] = { { 0x0000000000666967ULL, 0x0000000000000000ULL }, "Content-Type: image/gif\r\n", 25 }, /* gif */
+    [330] = { { 0x0000000063696568ULL, 0x0000000000000000ULL }, "Content-Type: image/heic\r\n", 26 }, /* heic */
+    [320] = { { 0x0000000066696568ULL, 0x0000000000000000ULL }, "Content-Type: image/heif\r\n", 26 }, /* heif */
+    [216] = { { 0x000000000067706AULL, 0x0000000000000000ULL }, "Content-Type: image/jpeg\r\n", 26 }, /* jpg */
+    [923] = { { 0x000000006765706AULL, 0x0000000000000000ULL }, "Content-Type: image/jpeg\r\n", 26 }, /* jpeg */
+    [185] = { { 0x000000000065706AULL, 0x0000000000000000ULL }, "Content-Type: image/jpeg\r\n", 26 }, /* jpe */
+    [113] = { { 0x000000006669666AULL, 0x0000000000000000ULL }, "Content-Type: image/jpeg\r\n", 26 }, /* jfif */
+    [398] = { { 0x0000006765706A70ULL, 0x0000000000000000ULL }, "Content-Type: image/jpeg\r\n", 26 }, /* pjpeg */
+    [907] = { { 0x0000000000706A70ULL, 0x0000000000000000ULL }, "Content-Type: image/jpeg\r\n", 26 }, /* pjp */
+    [623] = { { 0x00000000006C786AULL, 0x0000000000000000ULL }, "Content-Type: image/jxl\r\n", 25 }, /* jxl */
+    [671] = { { 0x0000000000676E70ULL, 0x0000000000000000ULL }, "Content-Type: image/png\r\n", 25 }, /* png */
+    [24] = { { 0x0000000000677673ULL, 0x0000000000000000ULL }, "Content-Type: image/svg+xml\r\n", 29 }, /* svg */
+    [15] = { { 0x000000007A677673ULL, 0x0000000000000000ULL }, "Content-Type: image/svg+xml\r\n", 29 }, /* svgz */
+    [631] = { { 0x0000000000666974ULL, 0x0000000000000000ULL }, "Content-Type: image/tiff\r\n", 26 }, /* tif */
+    [487] = { { 0x0000000066666974ULL, 0x0000000000000000ULL }, "Content-Type: image/tiff\r\n", 26 }, /* tiff */
+    [228] = { { 0x0000000070626577ULL, 0x0000000000000000ULL }, "Content-Type: image/webp\r\n", 26 }, /* webp */
+    [959] = { { 0x00000000006F6369ULL, 0x0000000000000000ULL }, "Content-Type: image/x-icon\r\n", 28 }, /* ico */
+    [912] = { { 0x0000000000727563ULL, 0x0000000000000000ULL }, "Content-Type: image/x-icon\r\n", 28 }, /* cur */
+    [606] = { { 0x000000000032706AULL, 0x0000000000000000ULL }, "Content-Type: image/jp2\r\n", 25 }, /* jp2 */
+    [242] = { { 0x000000003267706AULL, 0x0000000000000000ULL }, "Content-Type: image/jp2\r\n", 25 }, /* jpg2 */
+    [984] = { { 0x000000000066706AULL, 0x0000000000000000ULL }, "Content-Type: image/jpx\r\n", 25 }, /* jpf */
+    [111] = { { 0x000000000078706AULL, 0x0000000000000000ULL }, "Content-Type: image/jpx\r\n", 25 }, /* jpx */
+    [400] = { { 0x000000000078746BULL, 0x0000000000000000ULL }, "Content-Type: image/ktx\r\n", 25 }, /* ktx */
+    [131] = { { 0x000000003278746BULL, 0x0000000000000000ULL }, "Content-Type: image/ktx2\r\n", 26 }, /* ktx2 */
+    [822] = { { 0x00000000006D6E70ULL, 0x0000000000000000ULL }, "Content-Type: image/x-portable-anymap\r\n", 39 }, /* pnm */
+    [976] = { { 0x00000000006D6270ULL, 0x0000000000000000ULL }, "Content-Type: image/x-portable-bitmap\r\n", 39 }, /* pbm */
+    [351] = { { 0x00000000006D6770ULL, 0x0000000000000000ULL }, "Content-Type: image/x-portable-graymap\r\n", 40 }, /* pgm */
+    [805] = { { 0x00000000006D7070ULL, 0x0000000000000000ULL }, "Content-Type: image/x-portable-pixmap\r\n", 39 }, /* ppm */
+    [548] = { { 0x0000000000626772ULL, 0x0000000000000000ULL }, "Content-Type: image/x-rgb\r\n", 27 }, /* rgb */
+    [672] = { { 0x00000000006D6278ULL, 0x0000000000000000ULL }, "Content-Type: image/x-xbitmap\r\n", 31 }, /* xbm */
+    [983] = { { 0x00000000006D7078ULL, 0x0000000000000000ULL }, "Content-Type: image/x-xpixmap\r\n", 31 }, /* xpm */
+    [165] = { { 0x0000000000647778ULL, 0x0000000000000000ULL }, "Content-Type: image/x-xwindowdump\r\n", 35 }, /* xwd */
+    [118] = { { 0x0000000000616774ULL, 0x0000000000000000ULL }, "Content-Type: image/x-tga\r\n", 27 }, /* tga */
+    [45] = { { 0x0000000000786370ULL, 0x0000000000000000ULL }, "Content-Type: image/x-pcx\r\n", 27 }, /* pcx */
+    [433] = { { 0x0000000000636970ULL, 0x0000000000000000ULL }, "Content-Type: image/x-pict\r\n", 28 }, /* pic */
+    [497] = { { 0x0000000000746370ULL, 0x0000000000000000ULL }, "Content-Type: image/x-pict\r\n", 28 }, /* pct */
+    [813] = { { 0x0000000000736172ULL, 0x0000000000000000ULL }, "Content-Type: image/x-cmu-raster\r\n", 34 }, /* ras */
+    [477] = { { 0x0000000000006866ULL, 0x0000000000000000ULL }, "Content-Type: image/x-freehand\r\n", 32 }, /* fh */
+    [846] = { { 0x0000000000636866ULL, 0x0000000000000000ULL }, "Content-Type: image/x-freehand\r\n", 32 }, /* fhc */
+    [861] = { { 0x0000000000346866ULL, 0x0000000000000000ULL }, "Content-Type: image/x-freehand\r\n", 32 }, /* fh4 */
+    [1005] = { { 0x0000000000356866ULL, 0x0000000000000000ULL }, "Content-Type: image/x-freehand\r\n", 32 }, /* fh5 */
+    [120] = { { 0x0000000000376866ULL, 0x0000000000000000ULL }, "Content-Type: image/x-freehand\r\n", 32 }, /* fh7 */
+    [107] = { { 0x0000000000647370ULL, 0x0000000000000000ULL }, "Content-Type: image/vnd.adobe.photoshop\r\n", 41 }, /* psd */
+    [1003] = { { 0x00000000736E6369ULL, 0x0000000000000000ULL }, "Content-Type: image/vnd.microsoft.icon\r\n", 40 }, /* icns */
+    [331] = { { 0x0000000075766A64ULL, 0x0000000000000000ULL }, "Content-Type: image/vnd.djvu\r\n", 30 }, /* djvu */
+    [112] = { { 0x0000000000766A64ULL, 0x0000000000000000ULL }, "Content-Type: image/vnd.djvu\r\n", 30 }, /* djv */
+    [272] = { { 0x0000000000667864ULL, 0x0000000000000000ULL }, "Content-Type: image/vnd.dxf\r\n", 29 }, /* dxf */
+    [358] = { { 0x0000000000677764ULL, 0x0000000000000000ULL }, "Content-Type: image/vnd.dwg\r\n", 29 }, /* dwg */
+    [741] = { { 0x00000000706D6277ULL, 0x0000000000000000ULL }, "Content-Type: image/vnd.wap.wbmp\r\n", 34 }, /* wbmp */
+    [82] = { { 0x0000000000776172ULL, 0x0000000000000000ULL }, "Content-Type: image/x-dcraw\r\n", 29 }, /* raw */
+    [408] = { { 0x0000000000327263ULL, 0x0000000000000000ULL }, "Content-Type: image/x-dcraw\r\n", 29 }, /* cr2 */
+    [278] = { { 0x000000000066656EULL, 0x0000000000000000ULL }, "Content-Type: image/x-dcraw\r\n", 29 }, /* nef */
+    [230] = { { 0x000000000066726FULL, 0x0000000000000000ULL }, "Content-Type: image/x-dcraw\r\n", 29 }, /* orf */
+    [145] = { { 0x0000000000327273ULL, 0x0000000000000000ULL }, "Content-Type: image/x-dcraw\r\n", 29 }, /* sr2 */
+    [949] = { { 0x0000000000777261ULL, 0x0000000000000000ULL }, "Content-Type: image/x-dcraw\r\n", 29 }, /* arw */
+    [176] = { { 0x0000000000676E64ULL, 0x0000000000000000ULL }, "Content-Type: image/x-dcraw\r\n", 29 }, /* dng */
+    [108] = { { 0x0000000000727865ULL, 0x0000000000000000ULL }, "Content-Type: image/x-exr\r\n", 27 }, /* exr */
+    [617] = { { 0x0000000000666378ULL, 0x0000000000000000ULL }, "Content-Type: image/x-xcf\r\n", 27 }, /* xcf */
+    [1004] = { { 0x00000000006D6763ULL, 0x0000000000000000ULL }, "Content-Type: image/cgm\r\n", 25 }, /* cgm */
+    [577] = { { 0x0000000000003367ULL, 0x0000000000000000ULL }, "Content-Type: image/g3fax\r\n", 27 }, /* g3 */
+    [294] = { { 0x0000000000666569ULL, 0x0000000000000000ULL }, "Content-Type: image/ief\r\n", 25 }, /* ief */
+    [633] = { { 0x0000000000636161ULL, 0x0000000000000000ULL }, "Content-Type: audio/aac\r\n", 25 }, /* aac */
+    [767] = { { 0x0000000063616C66ULL, 0x0000000000000000ULL }, "Content-Type: audio/flac\r\n", 26 }, /* flac */
+    [483] = { { 0x000000000064696DULL, 0x0000000000000000ULL }, "Content-Type: audio/midi\r\n", 26 }, /* mid */
+    [836] = { { 0x000000006964696DULL, 0x0000000000000000ULL }, "Content-Type: audio/midi\r\n", 26 }, /* midi */
+    [738] = { { 0x000000000072616BULL, 0x0000000000000000ULL }, "Content-Type: audio/midi\r\n", 26 }, /* kar */
+    [609] = { { 0x0000000000696D72ULL, 0x0000000000000000ULL }, "Content-Type: audio/midi\r\n", 26 }, /* rmi */
+    [845] = { { 0x000000000061346DULL, 0x0000000000000000ULL }, "Content-Type: audio/mp4\r\n", 25 }, /* m4a */
+    [364] = { { 0x000000006134706DULL, 0x0000000000000000ULL }, "Content-Type: audio/mp4\r\n", 25 }, /* mp4a */
+    [321] = { { 0x000000000033706DULL, 0x0000000000000000ULL }, "Content-Type: audio/mpeg\r\n", 26 }, /* mp3 */
+    [27] = { { 0x000000006167706DULL, 0x0000000000000000ULL }, "Content-Type: audio/mpeg\r\n", 26 }, /* mpga */
+    [1014] = { { 0x000000000032706DULL, 0x0000000000000000ULL }, "Content-Type: audio/mpeg\r\n", 26 }, /* mp2 */
+    [702] = { { 0x000000006132706DULL, 0x0000000000000000ULL }, "Content-Type: audio/mpeg\r\n", 26 }, /* mp2a */
+    [743] = { { 0x000000000061326DULL, 0x0000000000000000ULL }, "Content-Type: audio/mpeg\r\n", 26 }, /* m2a */
+    [381] = { { 0x000000000061336DULL, 0x0000000000000000ULL }, "Content-Type: audio/mpeg\r\n", 26 }, /* m3a */
+    [143] = { { 0x000000000061676FULL, 0x0000000000000000ULL }, "Content-Type: audio/ogg\r\n", 25 }, /* oga */
+    [488] = { { 0x000000000067676FULL, 0x0000000000000000ULL }, "Content-Type: audio/ogg\r\n", 25 }, /* ogg */
+    [638] = { { 0x0000000000787073ULL, 0x0000000000000000ULL }, "Content-Type: audio/ogg\r\n", 25 }, /* spx */
+    [570] = { { 0x000000007375706FULL, 0x0000000000000000ULL }, "Content-Type: audio/ogg\r\n", 25 }, /* opus */
+    [183] = { { 0x0000000000766177ULL, 0x0000000000000000ULL }, "Content-Type: audio/wav\r\n", 25 }, /* wav */
+    [148] = { { 0x0000000061626577ULL, 0x0000000000000000ULL }, "Content-Type: audio/webm\r\n", 26 }, /* weba */
+    [257] = { { 0x0000000000666961ULL, 0x0000000000000000ULL }, "Content-Type: audio/x-aiff\r\n", 28 }, /* aif */
+    [980] = { { 0x0000000066666961ULL, 0x0000000000000000ULL }, "Content-Type: audio/x-aiff\r\n", 28 }, /* aiff */
+    [74] = { { 0x0000000063666961ULL, 0x0000000000000000ULL }, "Content-Type: audio/x-aiff\r\n", 28 }, /* aifc */
+    [594] = { { 0x0000000000616B6DULL, 0x0000000000000000ULL }, "Content-Type: audio/x-matroska\r\n", 32 }, /* mka */
+    [378] = { { 0x000000000075336DULL, 0x0000000000000000ULL }, "Content-Type: audio/x-mpegurl\r\n", 31 }, /* m3u */
+    [862] = { { 0x0000000000616D77ULL, 0x0000000000000000ULL }, "Content-Type: audio/x-ms-wma\r\n", 30 }, /* wma */
+    [168] = { { 0x0000000000786177ULL, 0x0000000000000000ULL }, "Content-Type: audio/x-ms-wax\r\n", 30 }, /* wax */
+    [493] = { { 0x00000000006D6172ULL, 0x0000000000000000ULL }, "Content-Type: audio/x-pn-realaudio\r\n", 36 }, /* ram */
+    [839] = { { 0x0000000000006172ULL, 0x0000000000000000ULL }, "Content-Type: audio/x-pn-realaudio\r\n", 36 }, /* ra */
+    [856] = { { 0x0000000000666163ULL, 0x0000000000000000ULL }, "Content-Type: audio/x-caf\r\n", 27 }, /* caf */
+    [659] = { { 0x0000000000726D61ULL, 0x0000000000000000ULL }, "Content-Type: audio/amr\r\n", 25 }, /* amr */
+    [837] = { { 0x0000000000007561ULL, 0x0000000000000000ULL }, "Content-Type: audio/basic\r\n", 27 }, /* au */
+    [761] = { { 0x0000000000646E73ULL, 0x0000000000000000ULL }, "Content-Type: audio/basic\r\n", 27 }, /* snd */
+    [92] = { { 0x00000000006D3373ULL, 0x0000000000000000ULL }, "Content-Type: audio/s3m\r\n", 25 }, /* s3m */
+    [463] = { { 0x0000000000006D78ULL, 0x0000000000000000ULL }, "Content-Type: audio/xm\r\n", 24 }, /* xm */
+    [696] = { { 0x0000000000007677ULL, 0x0000000000000000ULL }, "Content-Type: audio/x-wavpack\r\n", 31 }, /* wv */
+    [706] = { { 0x0000000000657061ULL, 0x0000000000000000ULL }, "Content-Type: audio/x-ape\r\n", 27 }, /* ape */
+    [7] = { { 0x0000000000616733ULL, 0x0000000000000000ULL }, "Content-Type: audio/3gpp\r\n", 26 }, /* 3ga */
+    [948] = { { 0x0000000000706733ULL, 0x0000000000000000ULL }, "Content-Type: video/3gpp\r\n", 26 }, /* 3gp */
+    [840] = { { 0x0000000070706733ULL, 0x0000000000000000ULL }, "Content-Type: video/3gpp\r\n", 26 }, /* 3gpp */
+    [520] = { { 0x0000000000326733ULL, 0x0000000000000000ULL }, "Content-Type: video/3gpp2\r\n", 27 }, /* 3g2 */
+    [794] = { { 0x0000000000007374ULL, 0x0000000000000000ULL }, "Content-Type: video/mp2t\r\n", 26 }, /* ts */
+    [196] = { { 0x000000007374326DULL, 0x0000000000000000ULL }, "Content-Type: video/mp2t\r\n", 26 }, /* m2ts */
+    [161] = { { 0x000000000073746DULL, 0x0000000000000000ULL }, "Content-Type: video/mp2t\r\n", 26 }, /* mts */
+    [943] = { { 0x000000000034706DULL, 0x0000000000000000ULL }, "Content-Type: video/mp4\r\n", 25 }, /* mp4 */
+    [863] = { { 0x000000007634706DULL, 0x0000000000000000ULL }, "Content-Type: video/mp4\r\n", 25 }, /* mp4v */
+    [832] = { { 0x000000003467706DULL, 0x0000000000000000ULL }, "Content-Type: video/mp4\r\n", 25 }, /* mpg4 */
+    [628] = { { 0x000000000076346DULL, 0x0000000000000000ULL }, "Content-Type: video/mp4\r\n", 25 }, /* m4v */
+    [965] = { { 0x000000006765706DULL, 0x0000000000000000ULL }, "Content-Type: video/mpeg\r\n", 26 }, /* mpeg */
+    [237] = { { 0x000000000067706DULL, 0x0000000000000000ULL }, "Content-Type: video/mpeg\r\n", 26 }, /* mpg */
+    [683] = { { 0x000000000065706DULL, 0x0000000000000000ULL }, "Content-Type: video/mpeg\r\n", 26 }, /* mpe */
+    [248] = { { 0x000000000076316DULL, 0x0000000000000000ULL }, "Content-Type: video/mpeg\r\n", 26 }, /* m1v */
+    [128] = { { 0x000000000076326DULL, 0x0000000000000000ULL }, "Content-Type: video/mpeg\r\n", 26 }, /* m2v */
+    [951] = { { 0x000000000076676FULL, 0x0000000000000000ULL }, "Content-Type: video/ogg\r\n", 25 }, /* ogv */
+    [826] = { { 0x0000000000766F6DULL, 0x0000000000000000ULL }, "Content-Type: video/quicktime\r\n", 31 }, /* mov */
+    [167] = { { 0x0000000000007471ULL, 0x0000000000000000ULL }, "Content-Type: video/quicktime\r\n", 31 }, /* qt */
+    [394] = { { 0x000000006D626577ULL, 0x0000000000000000ULL }, "Content-Type: video/webm\r\n", 26 }, /* webm */
+    [474] = { { 0x0000000000766C66ULL, 0x0000000000000000ULL }, "Content-Type: video/x-flv\r\n", 27 }, /* flv */
+    [279] = { { 0x0000000000766B6DULL, 0x0000000000000000ULL }, "Content-Type: video/x-matroska\r\n", 32 }, /* mkv */
+    [749] = { { 0x0000000064336B6DULL, 0x0000000000000000ULL }, "Content-Type: video/x-matroska\r\n", 32 }, /* mk3d */
+    [560] = { { 0x0000000000736B6DULL, 0x0000000000000000ULL }, "Content-Type: video/x-matroska\r\n", 32 }, /* mks */
+    [746] = { { 0x0000000000667361ULL, 0x0000000000000000ULL }, "Content-Type: video/x-ms-asf\r\n", 30 }, /* asf */
+    [96] = { { 0x0000000000787361ULL, 0x0000000000000000ULL }, "Content-Type: video/x-ms-asf\r\n", 30 }, /* asx */
+    [511] = { { 0x0000000000766D77ULL, 0x0000000000000000ULL }, "Content-Type: video/x-ms-wmv\r\n", 30 }, /* wmv */
+    [800] = { { 0x0000000000786D77ULL, 0x0000000000000000ULL }, "Content-Type: video/x-ms-wmx\r\n", 30 }, /* wmx */
+    [819] = { { 0x0000000000787677ULL, 0x0000000000000000ULL }, "Content-Type: video/x-ms-wvx\r\n", 30 }, /* wvx */
+    [20] = { { 0x0000000000697661ULL, 0x0000000000000000ULL }, "Content-Type: video/x-msvideo\r\n", 31 }, /* avi */
+    [639] = { { 0x0000000000676E6DULL, 0x0000000000000000ULL }, "Content-Type: video/x-mng\r\n", 27 }, /* mng */
+    [895] = { { 0x0000006569766F6DULL, 0x0000000000000000ULL }, "Content-Type: video/x-sgi-movie\r\n", 33 }, /* movie */
+    [524] = { { 0x0000000000763466ULL, 0x0000000000000000ULL }, "Content-Type: video/x-f4v\r\n", 27 }, /* f4v */
+    [704] = { { 0x0000000034363268ULL, 0x0000000000000000ULL }, "Content-Type: video/h264\r\n", 26 }, /* h264 */
+    [170] = { { 0x0000000035363268ULL, 0x0000000000000000ULL }, "Content-Type: video/h265\r\n", 26 }, /* h265 */
+    [256] = { { 0x00000000006D706AULL, 0x0000000000000000ULL }, "Content-Type: video/jpm\r\n", 25 }, /* jpm */
+    [430] = { { 0x000000006D67706AULL, 0x0000000000000000ULL }, "Content-Type: video/jpm\r\n", 25 }, /* jpgm */
+    [720] = { { 0x0000000000627664ULL, 0x0000000000000000ULL }, "Content-Type: video/vnd.dvb.file\r\n", 34 }, /* dvb */
+    [174] = { { 0x0000000000637474ULL, 0x0000000000000000ULL }, "Content-Type: font/collection\r\n", 31 }, /* ttc */
+    [718] = { { 0x000000000066746FULL, 0x0000000000000000ULL }, "Content-Type: font/otf\r\n", 24 }, /* otf */
+    [921] = { { 0x0000000000667474ULL, 0x0000000000000000ULL }, "Content-Type: font/ttf\r\n", 24 }, /* ttf */
+    [688] = { { 0x0000000066666F77ULL, 0x0000000000000000ULL }, "Content-Type: font/woff\r\n", 25 }, /* woff */
+    [849] = { { 0x0000003266666F77ULL, 0x0000000000000000ULL }, "Content-Type: font/woff2\r\n", 26 }, /* woff2 */
+    [171] = { { 0x0000000000746F65ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.ms-fontobject\r\n", 45 }, /* eot */
+    [875] = { { 0x0000000000666462ULL, 0x0000000000000000ULL }, "Content-Type: application/x-font-bdf\r\n", 38 }, /* bdf */
+    [99] = { { 0x0000000000666370ULL, 0x0000000000000000ULL }, "Content-Type: application/x-font-pcf\r\n", 38 }, /* pcf */
+    [662] = { { 0x0000000000666E73ULL, 0x0000000000000000ULL }, "Content-Type: application/x-font-snf\r\n", 38 }, /* snf */
+    [115] = { { 0x0000000000616670ULL, 0x0000000000000000ULL }, "Content-Type: application/x-font-type1\r\n", 40 }, /* pfa */
+    [885] = { { 0x0000000000626670ULL, 0x0000000000000000ULL }, "Content-Type: application/x-font-type1\r\n", 40 }, /* pfb */
+    [729] = { { 0x00000000006D6670ULL, 0x0000000000000000ULL }, "Content-Type: application/x-font-type1\r\n", 40 }, /* pfm */
+    [210] = { { 0x00000000006D6661ULL, 0x0000000000000000ULL }, "Content-Type: application/x-font-type1\r\n", 40 }, /* afm */
+    [913] = { { 0x0000000000007A67ULL, 0x0000000000000000ULL }, "Content-Type: application/gzip\r\n", 32 }, /* gz */
+    [429] = { { 0x00000000007A6774ULL, 0x0000000000000000ULL }, "Content-Type: application/gzip\r\n", 32 }, /* tgz */
+    [280] = { { 0x0000000000007A62ULL, 0x0000000000000000ULL }, "Content-Type: application/x-bzip\r\n", 34 }, /* bz */
+    [470] = { { 0x0000000000327A62ULL, 0x0000000000000000ULL }, "Content-Type: application/x-bzip2\r\n", 35 }, /* bz2 */
+    [336] = { { 0x00000000327A6274ULL, 0x0000000000000000ULL }, "Content-Type: application/x-bzip2\r\n", 35 }, /* tbz2 */
+    [953] = { { 0x00000000007A6F62ULL, 0x0000000000000000ULL }, "Content-Type: application/x-bzip2\r\n", 35 }, /* boz */
+    [350] = { { 0x0000000000007A78ULL, 0x0000000000000000ULL }, "Content-Type: application/x-xz\r\n", 32 }, /* xz */
+    [448] = { { 0x00000000007A7874ULL, 0x0000000000000000ULL }, "Content-Type: application/x-xz\r\n", 32 }, /* txz */
+    [37] = { { 0x000000000074737AULL, 0x0000000000000000ULL }, "Content-Type: application/zstd\r\n", 32 }, /* zst */
+    [66] = { { 0x0000000000007A6CULL, 0x0000000000000000ULL }, "Content-Type: application/x-lzip\r\n", 34 }, /* lz */
+    [427] = { { 0x00000000616D7A6CULL, 0x0000000000000000ULL }, "Content-Type: application/x-lzma\r\n", 34 }, /* lzma */
+    [90] = { { 0x0000000000347A6CULL, 0x0000000000000000ULL }, "Content-Type: application/x-lz4\r\n", 33 }, /* lz4 */
+    [312] = { { 0x0000000000007262ULL, 0x0000000000000000ULL }, "Content-Type: application/x-brotli\r\n", 36 }, /* br */
+    [919] = { { 0x000000000000007AULL, 0x0000000000000000ULL }, "Content-Type: application/x-compress\r\n", 38 }, /* z */
+    [504] = { { 0x0000000000726174ULL, 0x0000000000000000ULL }, "Content-Type: application/x-tar\r\n", 33 }, /* tar */
+    [140] = { { 0x000000006F697063ULL, 0x0000000000000000ULL }, "Content-Type: application/x-cpio\r\n", 34 }, /* cpio */
+    [163] = { { 0x0000000072616873ULL, 0x0000000000000000ULL }, "Content-Type: application/x-shar\r\n", 34 }, /* shar */
+    [438] = { { 0x0000000000007A37ULL, 0x0000000000000000ULL }, "Content-Type: application/x-7z-compressed\r\n", 43 }, /* 7z */
+    [782] = { { 0x0000000000726172ULL, 0x0000000000000000ULL }, "Content-Type: application/x-rar-compressed\r\n", 44 }, /* rar */
+    [545] = { { 0x000000000070697AULL, 0x0000000000000000ULL }, "Content-Type: application/zip\r\n", 31 }, /* zip */
+    [63] = { { 0x0000000000656361ULL, 0x0000000000000000ULL }, "Content-Type: application/x-ace-compressed\r\n", 44 }, /* ace */
+    [985] = { { 0x0000000000676D64ULL, 0x0000000000000000ULL }, "Content-Type: application/x-apple-diskimage\r\n", 45 }, /* dmg */
+    [817] = { { 0x00000000006F7369ULL, 0x0000000000000000ULL }, "Content-Type: application/x-iso9660-image\r\n", 43 }, /* iso */
+    [191] = { { 0x0000000000000061ULL, 0x0000000000000000ULL }, "Content-Type: application/x-archive\r\n", 37 }, /* a */
+    [456] = { { 0x0000000000007261ULL, 0x0000000000000000ULL }, "Content-Type: application/x-archive\r\n", 37 }, /* ar */
+    [769] = { { 0x000000000072616AULL, 0x0000000000000000ULL }, "Content-Type: application/java-archive\r\n", 40 }, /* jar */
+    [490] = { { 0x0000000000726177ULL, 0x0000000000000000ULL }, "Content-Type: application/java-archive\r\n", 40 }, /* war */
+    [69] = { { 0x0000000000726165ULL, 0x0000000000000000ULL }, "Content-Type: application/java-archive\r\n", 40 }, /* ear */
+    [461] = { { 0x0000000000626564ULL, 0x0000000000000000ULL }, "Content-Type: application/x-debian-package\r\n", 44 }, /* deb */
+    [971] = { { 0x0000000062656475ULL, 0x0000000000000000ULL }, "Content-Type: application/x-debian-package\r\n", 44 }, /* udeb */
+    [335] = { { 0x00000000006D7072ULL, 0x0000000000000000ULL }, "Content-Type: application/x-redhat-package-manager\r\n", 52 }, /* rpm */
+    [39] = { { 0x0000000000697078ULL, 0x0000000000000000ULL }, "Content-Type: application/x-xpinstall\r\n", 39 }, /* xpi */
+    [781] = { { 0x00000000006B7061ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.android.package-archive\r\n", 55 }, /* apk */
+    [789] = { { 0x6F63656C69626F6DULL, 0x000000006769666EULL }, "Content-Type: application/x-apple-aspen-config\r\n", 48 }, /* mobileconfig */
+    [537] = { { 0x0000000070616E73ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.snap\r\n", 36 }, /* snap */
+    [641] = { { 0x006B617074616C66ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.flatpak\r\n", 39 }, /* flatpak */
+    [902] = { { 0x000000000069736DULL, 0x0000000000000000ULL }, "Content-Type: application/x-msi\r\n", 33 }, /* msi */
+    [303] = { { 0x000000000070736DULL, 0x0000000000000000ULL }, "Content-Type: application/x-ms-installer\r\n", 42 }, /* msp */
+    [395] = { { 0x00000000006D736DULL, 0x0000000000000000ULL }, "Content-Type: application/x-ms-installer\r\n", 42 }, /* msm */
+    [360] = { { 0x6567616D69707061ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.appimage\r\n", 40 }, /* appimage */
+    [384] = { { 0x0000000068737173ULL, 0x0000000000000000ULL }, "Content-Type: application/x-squashfs\r\n", 38 }, /* sqsh */
+    [978] = { { 0x7366687361757173ULL, 0x0000000000000000ULL }, "Content-Type: application/x-squashfs\r\n", 38 }, /* squashfs */
+    [632] = { { 0x00000032776F6371ULL, 0x0000000000000000ULL }, "Content-Type: application/x-qemu-disk\r\n", 39 }, /* qcow2 */
+    [202] = { { 0x0000000000696476ULL, 0x0000000000000000ULL }, "Content-Type: application/x-virtualbox-vdi\r\n", 44 }, /* vdi */
+    [669] = { { 0x000000006B646D76ULL, 0x0000000000000000ULL }, "Content-Type: application/x-virtualbox-vmdk\r\n", 45 }, /* vmdk */
+    [666] = { { 0x0000000000646876ULL, 0x0000000000000000ULL }, "Content-Type: application/x-virtualbox-vhd\r\n", 44 }, /* vhd */
+    [309] = { { 0x0000000078646876ULL, 0x0000000000000000ULL }, "Content-Type: application/x-virtualbox-vhd\r\n", 44 }, /* vhdx */
+    [292] = { { 0x0000000000676D69ULL, 0x0000000000000000ULL }, "Content-Type: application/x-raw-disk-image\r\n", 44 }, /* img */
+    [44] = { { 0x0000000000666470ULL, 0x0000000000000000ULL }, "Content-Type: application/pdf\r\n", 31 }, /* pdf */
+    [302] = { { 0x0000000000007370ULL, 0x0000000000000000ULL }, "Content-Type: application/postscript\r\n", 38 }, /* ps */
+    [645] = { { 0x0000000000737065ULL, 0x0000000000000000ULL }, "Content-Type: application/postscript\r\n", 38 }, /* eps */
+    [225] = { { 0x0000000000006961ULL, 0x0000000000000000ULL }, "Content-Type: application/postscript\r\n", 38 }, /* ai */
+    [418] = { { 0x0000000000667472ULL, 0x0000000000000000ULL }, "Content-Type: application/rtf\r\n", 31 }, /* rtf */
+    [58] = { { 0x0000000000636F64ULL, 0x0000000000000000ULL }, "Content-Type: application/msword\r\n", 34 }, /* doc */
+    [539] = { { 0x0000000000746F64ULL, 0x0000000000000000ULL }, "Content-Type: application/msword\r\n", 34 }, /* dot */
+    [341] = { { 0x0000000078636F64ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.openxmlformats-officedocument.wordprocessingml.document\r\n", 87 }, /* docx */
+    [296] = { { 0x0000000078746F64ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.openxmlformats-officedocument.wordprocessingml.template\r\n", 87 }, /* dotx */
+    [508] = { { 0x0000000000736C78ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.ms-excel\r\n", 40 }, /* xls */
+    [1000] = { { 0x00000000006D6C78ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.ms-excel\r\n", 40 }, /* xlm */
+    [189] = { { 0x0000000000616C78ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.ms-excel\r\n", 40 }, /* xla */
+    [431] = { { 0x0000000000636C78ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.ms-excel\r\n", 40 }, /* xlc */
+    [318] = { { 0x0000000000746C78ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.ms-excel\r\n", 40 }, /* xlt */
+    [391] = { { 0x0000000000776C78ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.ms-excel\r\n", 40 }, /* xlw */
+    [346] = { { 0x0000000078736C78ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.openxmlformats-officedocument.spreadsheetml.sheet\r\n", 81 }, /* xlsx */
+    [501] = { { 0x0000000078746C78ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.openxmlformats-officedocument.spreadsheetml.template\r\n", 84 }, /* xltx */
+    [43] = { { 0x0000000000747070ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.ms-powerpoint\r\n", 45 }, /* ppt */
+    [663] = { { 0x0000000000737070ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.ms-powerpoint\r\n", 45 }, /* pps */
+    [529] = { { 0x0000000000746F70ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.ms-powerpoint\r\n", 45 }, /* pot */
+    [89] = { { 0x0000000078747070ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.openxmlformats-officedocument.presentationml.presentation\r\n", 89 }, /* pptx */
+    [621] = { { 0x0000000078737070ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.openxmlformats-officedocument.presentationml.slideshow\r\n", 86 }, /* ppsx */
+    [21] = { { 0x0000000078746F70ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.openxmlformats-officedocument.presentationml.template\r\n", 85 }, /* potx */
+    [933] = { { 0x000000000074646FULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.oasis.opendocument.text\r\n", 55 }, /* odt */
+    [492] = { { 0x000000000073646FULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.oasis.opendocument.spreadsheet\r\n", 62 }, /* ods */
+    [26] = { { 0x000000000070646FULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.oasis.opendocument.presentation\r\n", 63 }, /* odp */
+    [610] = { { 0x000000000067646FULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.oasis.opendocument.graphics\r\n", 59 }, /* odg */
+    [770] = { { 0x000000000066646FULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.oasis.opendocument.formula\r\n", 58 }, /* odf */
+    [873] = { { 0x000000000062646FULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.oasis.opendocument.database\r\n", 59 }, /* odb */
+    [144] = { { 0x0000000000647376ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.visio\r\n", 37 }, /* vsd */
+    [722] = { { 0x0000000000747376ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.visio\r\n", 37 }, /* vst */
+    [634] = { { 0x0000000000737376ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.visio\r\n", 37 }, /* vss */
+    [338] = { { 0x0000000000777376ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.visio\r\n", 37 }, /* vsw */
+    [660] = { { 0x000000000070706DULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.ms-project\r\n", 42 }, /* mpp */
+    [146] = { { 0x000000000074706DULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.ms-project\r\n", 42 }, /* mpt */
+    [19] = { { 0x000000000067736DULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.ms-outlook\r\n", 42 }, /* msg */
+    [655] = { { 0x00000000006D6863ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.ms-htmlhelp\r\n", 43 }, /* chm */
+    [422] = { { 0x0000000000777A61ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.amazon.ebook\r\n", 44 }, /* azw */
+    [340] = { { 0x0000000000637270ULL, 0x0000000000000000ULL }, "Content-Type: application/x-mobipocket-ebook\r\n", 46 }, /* prc */
+    [443] = { { 0x0000000069626F6DULL, 0x0000000000000000ULL }, "Content-Type: application/x-mobipocket-ebook\r\n", 46 }, /* mobi */
+    [519] = { { 0x0000000062757065ULL, 0x0000000000000000ULL }, "Content-Type: application/epub+zip\r\n", 36 }, /* epub */
+    [667] = { { 0x000000786574616CULL, 0x0000000000000000ULL }, "Content-Type: application/x-latex\r\n", 35 }, /* latex */
+    [42] = { { 0x0000000000697664ULL, 0x0000000000000000ULL }, "Content-Type: application/x-dvi\r\n", 33 }, /* dvi */
+    [491] = { { 0x006F666E69786574ULL, 0x0000000000000000ULL }, "Content-Type: application/x-texinfo\r\n", 37 }, /* texinfo */
+    [731] = { { 0x0000000069786574ULL, 0x0000000000000000ULL }, "Content-Type: application/x-texinfo\r\n", 37 }, /* texi */
+    [865] = { { 0x0000000000000031ULL, 0x0000000000000000ULL }, "Content-Type: application/x-troff-man\r\n", 39 }, /* 1 */
+    [475] = { { 0x0000000000000032ULL, 0x0000000000000000ULL }, "Content-Type: application/x-troff-man\r\n", 39 }, /* 2 */
+    [385] = { { 0x0000000000000033ULL, 0x0000000000000000ULL }, "Content-Type: application/x-troff-man\r\n", 39 }, /* 3 */
+    [899] = { { 0x0000000000000034ULL, 0x0000000000000000ULL }, "Content-Type: application/x-troff-man\r\n", 39 }, /* 4 */
+    [345] = { { 0x0000000000000035ULL, 0x0000000000000000ULL }, "Content-Type: application/x-troff-man\r\n", 39 }, /* 5 */
+    [553] = { { 0x0000000000000036ULL, 0x0000000000000000ULL }, "Content-Type: application/x-troff-man\r\n", 39 }, /* 6 */
+    [49] = { { 0x0000000000000037ULL, 0x0000000000000000ULL }, "Content-Type: application/x-troff-man\r\n", 39 }, /* 7 */
+    [526] = { { 0x0000000000000038ULL, 0x0000000000000000ULL }, "Content-Type: application/x-troff-man\r\n", 39 }, /* 8 */
+    [369] = { { 0x0000007365676170ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.apple.pages\r\n", 43 }, /* pages */
+    [915] = { { 0x00737265626D756EULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.apple.numbers\r\n", 45 }, /* numbers */
+    [305] = { { 0x000000000079656BULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.apple.keynote\r\n", 45 }, /* key */
+    [72] = { { 0x0000000000776261ULL, 0x0000000000000000ULL }, "Content-Type: application/x-abiword\r\n", 37 }, /* abw */
+    [359] = { { 0x0000000000736972ULL, 0x0000000000000000ULL }, "Content-Type: application/x-research-info-systems\r\n", 51 }, /* ris */
+    [897] = { { 0x0000000000626962ULL, 0x0000000000000000ULL }, "Content-Type: application/x-bibtex\r\n", 36 }, /* bib */
+    [674] = { { 0x000000006E6F736AULL, 0x0000000000000000ULL }, "Content-Type: application/json\r\n", 32 }, /* json */
+    [141] = { { 0x000000000070616DULL, 0x0000000000000000ULL }, "Content-Type: application/json\r\n", 32 }, /* map */
+    [549] = { { 0x0000646C6E6F736AULL, 0x0000000000000000ULL }, "Content-Type: application/ld+json\r\n", 35 }, /* jsonld */
+    [823] = { { 0x66696E616D626577ULL, 0x0000000000747365ULL }, "Content-Type: application/manifest+json\r\n", 41 }, /* webmanifest */
+    [339] = { { 0x006E6F736A6F6567ULL, 0x0000000000000000ULL }, "Content-Type: application/geo+json\r\n", 36 }, /* geojson */
+    [290] = { { 0x0000616D65686373ULL, 0x0000000000000000ULL }, "Content-Type: application/schema+json\r\n", 39 }, /* schema */
+    [917] = { { 0x0000000000647378ULL, 0x0000000000000000ULL }, "Content-Type: application/xml\r\n", 31 }, /* xsd */
+    [911] = { { 0x0000000000676E72ULL, 0x0000000000000000ULL }, "Content-Type: application/xml\r\n", 31 }, /* rng */
+    [462] = { { 0x0000000000746878ULL, 0x0000000000000000ULL }, "Content-Type: application/xhtml+xml\r\n", 37 }, /* xht */
+    [709] = { { 0x000000006D6F7461ULL, 0x0000000000000000ULL }, "Content-Type: application/atom+xml\r\n", 36 }, /* atom */
+    [792] = { { 0x0000000000737372ULL, 0x0000000000000000ULL }, "Content-Type: application/rss+xml\r\n", 35 }, /* rss */
+    [600] = { { 0x0000000000666472ULL, 0x0000000000000000ULL }, "Content-Type: application/rdf+xml\r\n", 35 }, /* rdf */
+    [289] = { { 0x00000000006C776FULL, 0x0000000000000000ULL }, "Content-Type: application/rdf+xml\r\n", 35 }, /* owl */
+    [451] = { { 0x00000000746C7378ULL, 0x0000000000000000ULL }, "Content-Type: application/xslt+xml\r\n", 36 }, /* xslt */
+    [954] = { { 0x0000000066707378ULL, 0x0000000000000000ULL }, "Content-Type: application/xspf+xml\r\n", 36 }, /* xspf */
+    [592] = { { 0x00006C6D6874616DULL, 0x0000000000000000ULL }, "Content-Type: application/mathml+xml\r\n", 38 }, /* mathml */
+    [541] = { { 0x000000006D736177ULL, 0x0000000000000000ULL }, "Content-Type: application/wasm\r\n", 32 }, /* wasm */
+    [304] = { { 0x00000000006D736AULL, 0x0000000000000000ULL }, "Content-Type: application/javascript\r\n", 38 }, /* jsm */
+    [583] = { { 0x00006E6F736A646EULL, 0x0000000000000000ULL }, "Content-Type: application/x-ndjson\r\n", 36 }, /* ndjson */
+    [799] = { { 0x0000006C6E6F736AULL, 0x0000000000000000ULL }, "Content-Type: application/x-ndjson\r\n", 36 }, /* jsonl */
+    [213] = { { 0x00000000726F6263ULL, 0x0000000000000000ULL }, "Content-Type: application/cbor\r\n", 32 }, /* cbor */
+    [989] = { { 0x006B63617067736DULL, 0x0000000000000000ULL }, "Content-Type: application/msgpack\r\n", 35 }, /* msgpack */
+    [708] = { { 0x0000006F746F7270ULL, 0x0000000000000000ULL }, "Content-Type: application/x-protobuf\r\n", 38 }, /* proto */
+    [499] = { { 0x0000000000006270ULL, 0x0000000000000000ULL }, "Content-Type: application/x-protobuf\r\n", 38 }, /* pb */
+    [372] = { { 0x000000006F727661ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.apache.avro\r\n", 43 }, /* avro */
+    [757] = { { 0x0074657571726170ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.apache.parquet\r\n", 46 }, /* parquet */
+    [503] = { { 0x000000776F727261ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.apache.arrow.file\r\n", 49 }, /* arrow */
+    [758] = { { 0x0072656874616566ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.apache.arrow.file\r\n", 49 }, /* feather */
+    [2] = { { 0x0000000000003568ULL, 0x0000000000000000ULL }, "Content-Type: application/x-hdf5\r\n", 34 }, /* h5 */
+    [516] = { { 0x0000000035666468ULL, 0x0000000000000000ULL }, "Content-Type: application/x-hdf5\r\n", 34 }, /* hdf5 */
+    [71] = { { 0x000000000000636EULL, 0x0000000000000000ULL }, "Content-Type: application/x-netcdf\r\n", 36 }, /* nc */
+    [900] = { { 0x0000000000666463ULL, 0x0000000000000000ULL }, "Content-Type: application/x-netcdf\r\n", 36 }, /* cdf */
+    [188] = { { 0x00006574696C7173ULL, 0x0000000000000000ULL }, "Content-Type: application/x-sqlite3\r\n", 37 }, /* sqlite */
+    [152] = { { 0x00336574696C7173ULL, 0x0000000000000000ULL }, "Content-Type: application/x-sqlite3\r\n", 37 }, /* sqlite3 */
+    [498] = { { 0x0000000000006264ULL, 0x0000000000000000ULL }, "Content-Type: application/x-sqlite3\r\n", 37 }, /* db */
+    [981] = { { 0x00000000006C7173ULL, 0x0000000000000000ULL }, "Content-Type: application/sql\r\n", 31 }, /* sql */
+    [619] = { { 0x006C716870617267ULL, 0x0000000000000000ULL }, "Content-Type: application/graphql\r\n", 35 }, /* graphql */
+    [635] = { { 0x00000000006C7167ULL, 0x0000000000000000ULL }, "Content-Type: application/graphql\r\n", 35 }, /* gql */
+    [1009] = { { 0x00000000006C6D74ULL, 0x0000000000000000ULL }, "Content-Type: application/toml\r\n", 32 }, /* tml */
+    [1002] = { { 0x0000006C6D617965ULL, 0x0000000000000000ULL }, "Content-Type: application/x-yaml\r\n", 34 }, /* eyaml */
+    [605] = { { 0x000000626E797069ULL, 0x0000000000000000ULL }, "Content-Type: application/x-ipynb+json\r\n", 40 }, /* ipynb */
+    [587] = { { 0x0000006C6D746870ULL, 0x0000000000000000ULL }, "Content-Type: application/x-httpd-php\r\n", 39 }, /* phtml */
+    [403] = { { 0x0000707061626577ULL, 0x0000000000000000ULL }, "Content-Type: application/x-web-app-manifest+json\r\n", 51 }, /* webapp */
+    [775] = { { 0x0000000000787263ULL, 0x0000000000000000ULL }, "Content-Type: application/x-chrome-extension\r\n", 46 }, /* crx */
+    [744] = { { 0x0000000000667773ULL, 0x0000000000000000ULL }, "Content-Type: application/x-shockwave-flash\r\n", 45 }, /* swf */
+    [977] = { { 0x0000000000706178ULL, 0x0000000000000000ULL }, "Content-Type: application/x-silverlight-app\r\n", 45 }, /* xap */
+    [232] = { { 0x00000000706C6E6AULL, 0x0000000000000000ULL }, "Content-Type: application/x-java-jnlp-file\r\n", 44 }, /* jnlp */
+    [827] = { { 0x0000007373616C63ULL, 0x0000000000000000ULL }, "Content-Type: application/java-vm\r\n", 35 }, /* class */
+    [1021] = { { 0x0000000000726573ULL, 0x0000000000000000ULL }, "Content-Type: application/x-java-serialized-object\r\n", 52 }, /* ser */
+    [730] = { { 0x00000000006C6D6BULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.google-earth.kml+xml\r\n", 52 }, /* kml */
+    [481] = { { 0x00000000007A6D6BULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.google-earth.kmz\r\n", 48 }, /* kmz */
+    [916] = { { 0x0000000000787067ULL, 0x0000000000000000ULL }, "Content-Type: application/gpx+xml\r\n", 35 }, /* gpx */
+    [308] = { { 0x00000000006C7578ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.mozilla.xul+xml\r\n", 47 }, /* xul */
+    [496] = { { 0x0000000000303170ULL, 0x0000000000000000ULL }, "Content-Type: application/pkcs10\r\n", 34 }, /* p10 */
+    [658] = { { 0x00000000006D3770ULL, 0x0000000000000000ULL }, "Content-Type: application/pkcs7-mime\r\n", 38 }, /* p7m */
+    [404] = { { 0x0000000000633770ULL, 0x0000000000000000ULL }, "Content-Type: application/pkcs7-mime\r\n", 38 }, /* p7c */
+    [883] = { { 0x0000000000733770ULL, 0x0000000000000000ULL }, "Content-Type: application/pkcs7-signature\r\n", 43 }, /* p7s */
+    [918] = { { 0x0000000000003870ULL, 0x0000000000000000ULL }, "Content-Type: application/pkcs8\r\n", 33 }, /* p8 */
+    [317] = { { 0x0000000000726563ULL, 0x0000000000000000ULL }, "Content-Type: application/pkix-cert\r\n", 37 }, /* cer */
+    [243] = { { 0x00000000006C7263ULL, 0x0000000000000000ULL }, "Content-Type: application/pkix-crl\r\n", 36 }, /* crl */
+    [712] = { { 0x0068746170696B70ULL, 0x0000000000000000ULL }, "Content-Type: application/pkix-pkipath\r\n", 40 }, /* pkipath */
+    [997] = { { 0x0000000000323170ULL, 0x0000000000000000ULL }, "Content-Type: application/x-pkcs12\r\n", 36 }, /* p12 */
+    [85] = { { 0x0000000000786670ULL, 0x0000000000000000ULL }, "Content-Type: application/x-pkcs12\r\n", 36 }, /* pfx */
+    [874] = { { 0x0000000000623770ULL, 0x0000000000000000ULL }, "Content-Type: application/x-pkcs7-certificates\r\n", 48 }, /* p7b */
+    [969] = { { 0x0000000000637073ULL, 0x0000000000000000ULL }, "Content-Type: application/x-pkcs7-certificates\r\n", 48 }, /* spc */
+    [17] = { { 0x0000000000723770ULL, 0x0000000000000000ULL }, "Content-Type: application/x-pkcs7-certreqresp\r\n", 47 }, /* p7r */
+    [402] = { { 0x0000000000747263ULL, 0x0000000000000000ULL }, "Content-Type: application/x-x509-ca-cert\r\n", 42 }, /* crt */
+    [100] = { { 0x0000000000726564ULL, 0x0000000000000000ULL }, "Content-Type: application/x-x509-ca-cert\r\n", 42 }, /* der */
+    [815] = { { 0x00000000006D6570ULL, 0x0000000000000000ULL }, "Content-Type: application/x-x509-ca-cert\r\n", 42 }, /* pem */
+    [994] = { { 0x0000000000706770ULL, 0x0000000000000000ULL }, "Content-Type: application/pgp-encrypted\r\n", 41 }, /* pgp */
+    [50] = { { 0x0000000000677067ULL, 0x0000000000000000ULL }, "Content-Type: application/pgp-encrypted\r\n", 41 }, /* gpg */
+    [930] = { { 0x0000000000637361ULL, 0x0000000000000000ULL }, "Content-Type: application/pgp-signature\r\n", 41 }, /* asc */
+    [735] = { { 0x0000000000676973ULL, 0x0000000000000000ULL }, "Content-Type: application/pgp-signature\r\n", 41 }, /* sig */
+    [409] = { { 0x0000000000627570ULL, 0x0000000000000000ULL }, "Content-Type: application/x-ssh-key\r\n", 37 }, /* pub */
+    [371] = { { 0x00000000006E6962ULL, 0x0000000000000000ULL }, "Content-Type: application/octet-stream\r\n", 40 }, /* bin */
+    [273] = { { 0x0000000000736D64ULL, 0x0000000000000000ULL }, "Content-Type: application/octet-stream\r\n", 40 }, /* dms */
+    [842] = { { 0x000000000066726CULL, 0x0000000000000000ULL }, "Content-Type: application/octet-stream\r\n", 40 }, /* lrf */
+    [590] = { { 0x000000000072616DULL, 0x0000000000000000ULL }, "Content-Type: application/octet-stream\r\n", 40 }, /* mar */
+    [566] = { { 0x0000000000006F73ULL, 0x0000000000000000ULL }, "Content-Type: application/octet-stream\r\n", 40 }, /* so */
+    [266] = { { 0x0000000074736964ULL, 0x0000000000000000ULL }, "Content-Type: application/octet-stream\r\n", 40 }, /* dist */
+    [573] = { { 0x0000007A74736964ULL, 0x0000000000000000ULL }, "Content-Type: application/octet-stream\r\n", 40 }, /* distz */
+    [441] = { { 0x0000000000676B70ULL, 0x0000000000000000ULL }, "Content-Type: application/octet-stream\r\n", 40 }, /* pkg */
+    [973] = { { 0x00000000006B7062ULL, 0x0000000000000000ULL }, "Content-Type: application/octet-stream\r\n", 40 }, /* bpk */
+    [47] = { { 0x00000000706D7564ULL, 0x0000000000000000ULL }, "Content-Type: application/octet-stream\r\n", 40 }, /* dump */
+    [324] = { { 0x0000000000636C65ULL, 0x0000000000000000ULL }, "Content-Type: application/octet-stream\r\n", 40 }, /* elc */
+    [376] = { { 0x0000796F6C706564ULL, 0x0000000000000000ULL }, "Content-Type: application/octet-stream\r\n", 40 }, /* deploy */
+    [711] = { { 0x0000000000657865ULL, 0x0000000000000000ULL }, "Content-Type: application/octet-stream\r\n", 40 }, /* exe */
+    [952] = { { 0x00000000006C6C64ULL, 0x0000000000000000ULL }, "Content-Type: application/octet-stream\r\n", 40 }, /* dll */
+    [534] = { { 0x000000000075736DULL, 0x0000000000000000ULL }, "Content-Type: application/octet-stream\r\n", 40 }, /* msu */
+    [748] = { { 0x0000000000666C65ULL, 0x0000000000000000ULL }, "Content-Type: application/x-executable\r\n", 40 }, /* elf */
+    [363] = { { 0x00000062696C7964ULL, 0x0000000000000000ULL }, "Content-Type: application/x-sharedlib\r\n", 39 }, /* dylib */
+    [301] = { { 0x000000000000006FULL, 0x0000000000000000ULL }, "Content-Type: application/x-object\r\n", 36 }, /* o */
+    [962] = { { 0x00000000006A626FULL, 0x0000000000000000ULL }, "Content-Type: application/x-object\r\n", 36 }, /* obj */
+    [192] = { { 0x00000000006D6F63ULL, 0x0000000000000000ULL }, "Content-Type: application/x-msdownload\r\n", 40 }, /* com */
+    [801] = { { 0x0000000000746162ULL, 0x0000000000000000ULL }, "Content-Type: application/x-msdownload\r\n", 40 }, /* bat */
+    [281] = { { 0x00000000006B6E6CULL, 0x0000000000000000ULL }, "Content-Type: application/x-ms-shortcut\r\n", 41 }, /* lnk */
+    [114] = { { 0x00000000006E7572ULL, 0x0000000000000000ULL }, "Content-Type: application/x-sh\r\n", 32 }, /* run */
+    [966] = { { 0x0000000000687363ULL, 0x0000000000000000ULL }, "Content-Type: application/x-csh\r\n", 33 }, /* csh */
+    [852] = { { 0x00746E6572726F74ULL, 0x0000000000000000ULL }, "Content-Type: application/x-bittorrent\r\n", 40 }, /* torrent */
+    [436] = { { 0x0000000000627A6EULL, 0x0000000000000000ULL }, "Content-Type: application/x-nzb\r\n", 33 }, /* nzb */
+    [411] = { { 0x0000000000706D64ULL, 0x0000000000000000ULL }, "Content-Type: application/x-sql\r\n", 33 }, /* dmp */
+    [796] = { { 0x746163696C707061ULL, 0x00000000006E6F69ULL }, "Content-Type: application/x-ms-application\r\n", 44 }, /* application */
+    [440] = { { 0x0000000000646D77ULL, 0x0000000000000000ULL }, "Content-Type: application/x-ms-wmd\r\n", 36 }, /* wmd */
+    [300] = { { 0x00000000007A6D77ULL, 0x0000000000000000ULL }, "Content-Type: application/x-ms-wmz\r\n", 36 }, /* wmz */
+    [476] = { { 0x000000000062646DULL, 0x0000000000000000ULL }, "Content-Type: application/x-msaccess\r\n", 38 }, /* mdb */
+    [455] = { { 0x0000000000647263ULL, 0x0000000000000000ULL }, "Content-Type: application/x-mscardfile\r\n", 40 }, /* crd */
+    [957] = { { 0x0000000000706C63ULL, 0x0000000000000000ULL }, "Content-Type: application/x-msclip\r\n", 36 }, /* clp */
+    [35] = { { 0x0000000000666D77ULL, 0x0000000000000000ULL }, "Content-Type: application/x-msmetafile\r\n", 40 }, /* wmf */
+    [694] = { { 0x0000000000666D65ULL, 0x0000000000000000ULL }, "Content-Type: application/x-msmetafile\r\n", 40 }, /* emf */
+    [806] = { { 0x00000000007A6D65ULL, 0x0000000000000000ULL }, "Content-Type: application/x-msmetafile\r\n", 40 }, /* emz */
+    [464] = { { 0x00000000006D7274ULL, 0x0000000000000000ULL }, "Content-Type: application/x-msterminal\r\n", 40 }, /* trm */
+    [116] = { { 0x0000000000697277ULL, 0x0000000000000000ULL }, "Content-Type: application/x-mswrite\r\n", 37 }, /* wri */
+    [547] = { { 0x0000000000616D70ULL, 0x0000000000000000ULL }, "Content-Type: application/x-perfmon\r\n", 37 }, /* pma */
+    [150] = { { 0x0000000000636D70ULL, 0x0000000000000000ULL }, "Content-Type: application/x-perfmon\r\n", 37 }, /* pmc */
+    [572] = { { 0x00000000006C6D70ULL, 0x0000000000000000ULL }, "Content-Type: application/x-perfmon\r\n", 37 }, /* pml */
+    [86] = { { 0x0000000000726D70ULL, 0x0000000000000000ULL }, "Content-Type: application/x-perfmon\r\n", 37 }, /* pmr */
+    [48] = { { 0x0000000000776D70ULL, 0x0000000000000000ULL }, "Content-Type: application/x-perfmon\r\n", 37 }, /* pmw */
+    [546] = { { 0x636972656D756E67ULL, 0x0000000000000000ULL }, "Content-Type: application/x-gnumeric\r\n", 38 }, /* gnumeric */
+    [894] = { { 0x0000000000667367ULL, 0x0000000000000000ULL }, "Content-Type: application/x-font-ghostscript\r\n", 46 }, /* gsf */
+    [556] = { { 0x0000000000666468ULL, 0x0000000000000000ULL }, "Content-Type: application/x-hdf\r\n", 33 }, /* hdf */
+    [439] = { { 0x000000646E656C62ULL, 0x0000000000000000ULL }, "Content-Type: application/x-blender\r\n", 37 }, /* blend */
+    [446] = { { 0x0000000000626163ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.ms-cab-compressed\r\n", 49 }, /* cab */
+    [260] = { { 0x62646574696C7173ULL, 0x0000000000000000ULL }, "Content-Type: application/vnd.sqlite3\r\n", 39 }, /* sqlitedb */
+    [0] = { { 0x000000006361756CULL, 0x0000000000000000ULL }, "Content-Type: application/x-lua-bytecode\r\n", 42 }, /* luac */
+    [995] = { { 0x0000000000637970ULL, 0x0000000000000000ULL }, "Content-Type: application/x-python-code\r\n", 41 }, /* pyc */
+    [818] = { { 0x00000000006F7970ULL, 0x0000000000000000ULL }, "Content-Type: application/x-python-code\r\n", 41 }, /* pyo */
+    [585] = { { 0x00000000006C6877ULL, 0x0000000000000000ULL }, "Content-Type: application/x-wheel+zip\r\n", 39 }, /* whl */
+    [904] = { { 0x0000006574617263ULL, 0x0000000000000000ULL }, "Content-Type: application/x-rust-crate\r\n", 40 }, /* crate */
+    [679] = { { 0x000000676B70756EULL, 0x0000000000000000ULL }, "Content-Type: application/x-nuget\r\n", 35 }, /* nupkg */
+    [715] = { { 0x00000000006D6567ULL, 0x0000000000000000ULL }, "Content-Type: application/x-gem\r\n", 33 }, /* gem */
+    [10] = { { 0x0000000066746C67ULL, 0x0000000000000000ULL }, "Content-Type: model/gltf+json\r\n", 31 }, /* gltf */
+    [955] = { { 0x0000000000626C67ULL, 0x0000000000000000ULL }, "Content-Type: model/gltf-binary\r\n", 33 }, /* glb */
+    [692] = { { 0x6C65646F6D6A626FULL, 0x0000000000000000ULL }, "Content-Type: model/obj\r\n", 25 }, /* objmodel */
+    [244] = { { 0x00000000006C7473ULL, 0x0000000000000000ULL }, "Content-Type: model/stl\r\n", 25 }, /* stl */
+    [271] = { { 0x0000000000656164ULL, 0x0000000000000000ULL }, "Content-Type: model/vnd.collada+xml\r\n", 37 }, /* dae */
+    [166] = { { 0x0000000000736769ULL, 0x0000000000000000ULL }, "Content-Type: model/iges\r\n", 26 }, /* igs */
+    [637] = { { 0x0000000073656769ULL, 0x0000000000000000ULL }, "Content-Type: model/iges\r\n", 26 }, /* iges */
+    [479] = { { 0x000000000068736DULL, 0x0000000000000000ULL }, "Content-Type: model/mesh\r\n", 26 }, /* msh */
+    [76] = { { 0x000000006873656DULL, 0x0000000000000000ULL }, "Content-Type: model/mesh\r\n", 26 }, /* mesh */
+    [142] = { { 0x000000006F6C6973ULL, 0x0000000000000000ULL }, "Content-Type: model/mesh\r\n", 26 }, /* silo */
+    [604] = { { 0x00000000006C7277ULL, 0x0000000000000000ULL }, "Content-Type: model/vrml\r\n", 26 }, /* wrl */
+    [123] = { { 0x000000006C6D7276ULL, 0x0000000000000000ULL }, "Content-Type: model/vrml\r\n", 26 }, /* vrml */
+    [127] = { { 0x0000000000643378ULL, 0x0000000000000000ULL }, "Content-Type: model/x3d+xml\r\n", 29 }, /* x3d */
+    [944] = { { 0x000000007A643378ULL, 0x0000000000000000ULL }, "Content-Type: model/x3d+xml\r\n", 29 }, /* x3dz */
+    [73] = { { 0x0000000000666D33ULL, 0x0000000000000000ULL }, "Content-Type: model/3mf\r\n", 25 }, /* 3mf */
+    [880] = { { 0x0000000070657473ULL, 0x0000000000000000ULL }, "Content-Type: model/step\r\n", 26 }, /* step */
+    [334] = { { 0x0000000000707473ULL, 0x0000000000000000ULL }, "Content-Type: model/step\r\n", 26 }, /* stp */
+    [903] = { { 0x0000000078626470ULL, 0x0000000000000000ULL }, "Content-Type: chemical/x-pdb\r\n", 30 }, /* pdbx */
+    [375] = { { 0x00000000007A7978ULL, 0x0000000000000000ULL }, "Content-Type: chemical/x-xyz\r\n", 30 }, /* xyz */
+};
+
+#endif /** PROJECT_GENERATED_MIME_TABLE_H */
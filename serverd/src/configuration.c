@@ -23,15 +23,26 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <string.h>
+#include <strings.h>
+#include <ctype.h>
 #include <errno.h>
 #include <unistd.h>
 #include <getopt.h>
+#include <pthread.h>
+#include <syslog.h>
 
 #include "serverd.h"
 #include "configuration.h"
 #include "error.h"
 #include "memory.h"
+#include "location.h"
+#include "mime.h"
+#include "rewrite.h"
+#include "virtual_host.h"
 
 /**
  * @def DEFAULT_CONFIGURATION_FILENAME
@@ -75,6 +86,131 @@
 #define DEFAULT_PORT "8080"
 #endif
 
+/**
+ * @def DEFAULT_FILE_IO_THREAD_COUNT
+ * @brief The default number of file I/O pool threads.
+ *
+ * @details These threads spend nearly all of their time
+ * blocked in the kernel waiting on storage, so a small
+ * handful is plenty even on large machines.
+ *
+ */
+#ifndef DEFAULT_FILE_IO_THREAD_COUNT
+#define DEFAULT_FILE_IO_THREAD_COUNT (4)
+#endif
+
+/**
+ * @def DEFAULT_MEMORY_DIRTY_DECAY
+ * @brief The default dirty page decay time, in milliseconds.
+ *
+ */
+#ifndef DEFAULT_MEMORY_DIRTY_DECAY
+#define DEFAULT_MEMORY_DIRTY_DECAY (10000)
+#endif
+
+/**
+ * @def DEFAULT_MEMORY_MUZZY_DECAY
+ * @brief The default muzzy page decay time, in milliseconds.
+ *
+ */
+#ifndef DEFAULT_MEMORY_MUZZY_DECAY
+#define DEFAULT_MEMORY_MUZZY_DECAY (0)
+#endif
+
+/**
+ * @def DEFAULT_DIRECTORY_LISTING_CACHE_ENTRIES
+ * @brief The default number of cached directory listings.
+ *
+ */
+#ifndef DEFAULT_DIRECTORY_LISTING_CACHE_ENTRIES
+#define DEFAULT_DIRECTORY_LISTING_CACHE_ENTRIES (64)
+#endif
+
+/**
+ * @def DEFAULT_FILE_CACHE_ENTRIES
+ * @brief The default number of files held open in the cache.
+ *
+ * @details Every cache entry holds a file descriptor, so
+ * this should stay comfortably below RLIMIT_NOFILE.
+ *
+ */
+#ifndef DEFAULT_FILE_CACHE_ENTRIES
+#define DEFAULT_FILE_CACHE_ENTRIES (1024)
+#endif
+
+/**
+ * @def DEFAULT_FILE_CACHE_VALIDITY
+ * @brief The default file cache validity period, in seconds.
+ *
+ */
+#ifndef DEFAULT_FILE_CACHE_VALIDITY
+#define DEFAULT_FILE_CACHE_VALIDITY (5)
+#endif
+
+/**
+ * @def DEFAULT_NEGATIVE_CACHE_ENTRIES
+ * @brief The default number of remembered missing paths.
+ *
+ */
+#ifndef DEFAULT_NEGATIVE_CACHE_ENTRIES
+#define DEFAULT_NEGATIVE_CACHE_ENTRIES (4096)
+#endif
+
+/**
+ * @def DEFAULT_STREAMING_THRESHOLD
+ * @brief The default size above which files are streamed.
+ *
+ */
+#ifndef DEFAULT_STREAMING_THRESHOLD
+#define DEFAULT_STREAMING_THRESHOLD (64 * 1024 * 1024)
+#endif
+
+/**
+ * @def DEFAULT_READAHEAD_WINDOW
+ * @brief The default readahead window for cold files.
+ *
+ */
+#ifndef DEFAULT_READAHEAD_WINDOW
+#define DEFAULT_READAHEAD_WINDOW (2 * 1024 * 1024)
+#endif
+
+/**
+ * @def DEFAULT_STREAMING_BUFFER_SIZE
+ * @brief The default size of each streaming buffer.
+ *
+ */
+#ifndef DEFAULT_STREAMING_BUFFER_SIZE
+#define DEFAULT_STREAMING_BUFFER_SIZE (1024 * 1024)
+#endif
+
+/**
+ * @def DEFAULT_CONTENT_CACHE_PAGE_SIZE
+ * @brief The default content cache page size, in bytes.
+ *
+ */
+#ifndef DEFAULT_CONTENT_CACHE_PAGE_SIZE
+#define DEFAULT_CONTENT_CACHE_PAGE_SIZE (2 * 1024 * 1024)
+#endif
+
+/**
+ * @def DEFAULT_CONTENT_CACHE_MAX_FILE_SIZE
+ * @brief The default size limit of files held in memory.
+ *
+ */
+#ifndef DEFAULT_CONTENT_CACHE_MAX_FILE_SIZE
+#define DEFAULT_CONTENT_CACHE_MAX_FILE_SIZE (1024 * 1024)
+#endif
+
+/**
+ * @def DEFAULT_POPULARITY_SNAPSHOT_INTERVAL
+ * @brief The default interval between popularity snapshots,
+ * in seconds.
+ *
+ */
+#ifndef DEFAULT_POPULARITY_SNAPSHOT_INTERVAL
+#define DEFAULT_POPULARITY_SNAPSHOT_INTERVAL (60)
+#endif
+
 /**
  * Program Options
  *
@@ -125,6 +261,197 @@ static const char* help_menu =
     "      --version                         Display server version information\n"
     "\n";
 
+/**
+ * The command line the server was started with, which is
+ * parsed again whenever the configuration is reloaded.
+ *
+ */
+static int command_line_argc = 0;
+static char** command_line_argv = NULL;
+
+/**
+ * Whether the configuration is being reloaded, in which case
+ * configuration errors are logged and counted instead of
+ * being fatal.
+ *
+ */
+static int reloading_configuration = FALSE;
+static size_t configuration_error_count = 0;
+
+/**
+ * The published configuration.
+ *
+ * @details Workers only ever see a configuration through
+ * this pointer, and a published configuration is never
+ * modified. A reload builds a complete new configuration
+ * and swaps the pointer. The old configuration goes on the
+ * retired list, and is freed once every registered reader
+ * has reported a quiescent state with a newer one.
+ *
+ */
+static _Atomic(struct configuration_options_t*) published_configuration = NULL;
+
+/**
+ * A configuration that has been replaced, but may still be
+ * in use.
+ *
+ */
+struct retired_configuration_t {
+    struct configuration_options_t* configuration_options;
+    struct retired_configuration_t* next;
+};
+
+/**
+ * The reader and retired list state. The lock is only ever
+ * taken on a reload, or when a reader moves on to a new
+ * configuration, never on the request path.
+ *
+ */
+static pthread_mutex_t configuration_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t configuration_epoch = 0;
+static struct retired_configuration_t* retired_configurations = NULL;
+static _Atomic uint64_t configuration_reader_epochs[CONFIGURATION_MAX_READERS];
+static size_t configuration_reader_count = 0;
+
+/**
+ * A block of memory owned by a configuration.
+ *
+ */
+struct configuration_block_t {
+    struct configuration_block_t* next;
+    max_align_t data[];
+};
+
+/**
+ * Allocate memory that lives exactly as long as the
+ * configuration does.
+ *
+ */
+__attribute__((nonnull(1)))
+static void* allocate_configuration_memory(struct configuration_options_t* configuration_options, size_t size) {
+    struct configuration_block_t* block = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (struct configuration_block_t) + size);
+    block->next = configuration_options->blocks;
+    configuration_options->blocks = block;
+
+    return block->data;
+}
+
+/**
+ * Copy a string into memory owned by the configuration.
+ *
+ */
+__attribute__((nonnull(1)))
+static const char* copy_configuration_string(struct configuration_options_t* configuration_options, const char* string) {
+    if (string == NULL) {
+        return NULL;
+    }
+
+    char* copy = allocate_configuration_memory(configuration_options, strlen(string) + 1);
+    strcpy(copy, string);
+
+    return copy;
+}
+
+/**
+ * Free a configuration and everything it owns.
+ *
+ */
+static void free_configuration(struct configuration_options_t* configuration_options) {
+    free_virtual_host_router(configuration_options->virtual_host_router);
+    free_location_tree(configuration_options->location_tree);
+    free_rewrite_engine(configuration_options->rewrite_engine);
+
+    while (configuration_options->blocks) {
+        struct configuration_block_t* block = configuration_options->blocks;
+        configuration_options->blocks = block->next;
+        FREE(block);
+    }
+
+    FREE(configuration_options);
+}
+
+/**
+ * Report a configuration error.
+ *
+ * @details At startup, this is fatal. While reloading, the
+ * error is logged and counted, and the caller carries on
+ * with some placeholder value; the whole configuration is
+ * thrown away at the end.
+ *
+ */
+__attribute__((format(printf,1,2)))
+static void configuration_error(const char* format, ...) {
+    va_list ap;
+    va_start(ap, format);
+
+    if (!reloading_configuration) {
+        vfatal_error(format, ap);
+    }
+
+    vsyslog(LOG_ERR, format, ap);
+    va_end(ap);
+
+    ++configuration_error_count;
+}
+
+/**
+ * Free every retired configuration that no reader can still
+ * be using, i.e. that is older than the configuration every
+ * reader last reported a quiescent state with.
+ *
+ * @note The configuration lock must be held.
+ *
+ */
+static void reclaim_retired_configurations(void) {
+    uint64_t oldest_epoch = UINT64_MAX;
+
+    for (size_t i = 0; i < configuration_reader_count; ++i) {
+        uint64_t epoch = atomic_load_explicit(&configuration_reader_epochs[i], memory_order_acquire);
+
+        if (epoch < oldest_epoch) {
+            oldest_epoch = epoch;
+        }
+    }
+
+    struct retired_configuration_t** link = &retired_configurations;
+
+    while (*link) {
+        struct retired_configuration_t* retired = *link;
+
+        if (retired->configuration_options->epoch < oldest_epoch) {
+            *link = retired->next;
+            free_configuration(retired->configuration_options);
+            FREE(retired);
+        } else {
+            link = &retired->next;
+        }
+    }
+}
+
+/**
+ * Make a configuration the current one, and retire the one
+ * it replaces.
+ *
+ */
+static void publish_configuration(struct configuration_options_t* configuration_options) {
+    pthread_mutex_lock(&configuration_lock);
+
+    configuration_options->epoch = ++configuration_epoch;
+
+    struct configuration_options_t* replaced = atomic_exchange_explicit(&published_configuration, configuration_options, memory_order_acq_rel);
+
+    if (replaced) {
+        struct retired_configuration_t* retired = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (struct retired_configuration_t));
+        retired->configuration_options = replaced;
+        retired->next = retired_configurations;
+        retired_configurations = retired;
+    }
+
+    reclaim_retired_configurations();
+
+    pthread_mutex_unlock(&configuration_lock);
+}
+
 /**
  * Allocate memory required by the configuration options.
  *
@@ -150,7 +477,11 @@ static struct configuration_options_t* allocate_configuration_options_object(voi
      * error-checking and bookkeeping behind the scenes.
      *
      */
-    return allocate_memory(sizeof (struct configuration_options_t));
+    struct configuration_options_t* configuration_options = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (struct configuration_options_t));
+    configuration_options->epoch = 0;
+    configuration_options->blocks = NULL;
+
+    return configuration_options;
 }
 
 /**
@@ -188,9 +519,6 @@ static struct configuration_options_t* initialize_default_configuration(void) {
 
     /**
      * @brief The hostname the server will use.
-     *
-     * @todo The user should be able to configure the
-     * hostname for the server on a per-virtual host basis.
      * 
      */
     configuration_options->hostname = DEFAULT_HOSTNAME;
@@ -201,6 +529,130 @@ static struct configuration_options_t* initialize_default_configuration(void) {
      * 
      */
     configuration_options->port = DEFAULT_PORT;
+
+    /**
+     * @brief There are no MIME type overrides by default.
+     *
+     */
+    configuration_options->mime_type_overrides = NULL;
+
+    /**
+     * @brief Everything is logged by default.
+     *
+     */
+    configuration_options->log_level = LOG_DEBUG;
+
+    /**
+     * @brief The number of threads in the file I/O pool.
+     *
+     */
+    configuration_options->file_io_thread_count = DEFAULT_FILE_IO_THREAD_COUNT;
+
+    /**
+     * @brief Each worker thread gets its own jemalloc arena,
+     * with jemalloc's usual cache and decay settings.
+     *
+     */
+    configuration_options->memory_arena_per_thread = TRUE;
+    configuration_options->memory_thread_cache = TRUE;
+    configuration_options->memory_dirty_decay = DEFAULT_MEMORY_DIRTY_DECAY;
+    configuration_options->memory_muzzy_decay = DEFAULT_MEMORY_MUZZY_DECAY;
+
+    /**
+     * @brief Memory is not budgeted by default.
+     *
+     */
+    configuration_options->memory_soft_limit = 0;
+    configuration_options->memory_hard_limit = 0;
+
+    /**
+     * @brief Directory listings are disabled by default.
+     *
+     */
+    configuration_options->directory_listing_enabled = FALSE;
+    configuration_options->directory_listing_cache_entries = DEFAULT_DIRECTORY_LISTING_CACHE_ENTRIES;
+
+    /**
+     * @brief The static file cache and its warm-up phase,
+     * which is disabled by default.
+     *
+     */
+    configuration_options->file_cache_entries = DEFAULT_FILE_CACHE_ENTRIES;
+    configuration_options->file_cache_validity = DEFAULT_FILE_CACHE_VALIDITY;
+
+    /**
+     * @brief The negative cache, with its Bloom filter.
+     *
+     */
+    configuration_options->negative_cache_entries = DEFAULT_NEGATIVE_CACHE_ENTRIES;
+    configuration_options->negative_cache_bloom_filter = TRUE;
+
+    /**
+     * @brief The in-memory content cache is disabled by
+     * default.
+     *
+     */
+    configuration_options->content_cache_size = 0;
+    configuration_options->content_cache_page_size = DEFAULT_CONTENT_CACHE_PAGE_SIZE;
+    configuration_options->content_cache_max_file_size = DEFAULT_CONTENT_CACHE_MAX_FILE_SIZE;
+
+    /**
+     * @brief Very large files are streamed past the page
+     * cache.
+     *
+     */
+    configuration_options->streaming_threshold = DEFAULT_STREAMING_THRESHOLD;
+    configuration_options->streaming_buffer_size = DEFAULT_STREAMING_BUFFER_SIZE;
+    configuration_options->streaming_drop_cache = TRUE;
+    configuration_options->readahead_window = DEFAULT_READAHEAD_WINDOW;
+
+    configuration_options->warmup_budget = 0;
+    configuration_options->warmup_manifest = NULL;
+
+    /**
+     * @brief Popularity snapshots are disabled by default.
+     *
+     */
+    configuration_options->popularity_snapshot = NULL;
+    configuration_options->popularity_snapshot_interval = DEFAULT_POPULARITY_SNAPSHOT_INTERVAL;
+
+    /**
+     * @brief Statistics are not logged by default.
+     *
+     */
+    configuration_options->statistics_interval = 0;
+
+    /**
+     * @brief Serve the document root, not a site pack, by
+     * default.
+     *
+     */
+    configuration_options->site_pack = NULL;
+
+    /**
+     * @brief No virtual hosts until the configuration file
+     * declares some.
+     *
+     */
+    configuration_options->virtual_hosts = NULL;
+    configuration_options->virtual_host_count = 0;
+    configuration_options->virtual_host_router = NULL;
+
+    /**
+     * @brief Nor any locations.
+     *
+     */
+    configuration_options->locations = NULL;
+    configuration_options->location_count = 0;
+    configuration_options->location_tree = NULL;
+
+    /**
+     * @brief Nor any rewrite rules.
+     *
+     */
+    configuration_options->rewrite_rules = NULL;
+    configuration_options->rewrite_rule_count = 0;
+    configuration_options->rewrite_engine = NULL;
     
     /**
      * Return the initialized configuration options object.
@@ -236,103 +688,674 @@ static void parse_command_line_configuration_options(struct configuration_option
      * will be followed by two colons.
      *
      */
-    while (TRUE) {
+    while (TRUE) {
+
+        /**
+         * @details This variable is set by getopt_long(3)
+         * on each iteration of the option-parsing loop. It
+         * is used as the index to the long options array
+         * when a long option is detected in the input.
+         *
+         */
+        int option_index = 0;
+
+        /**
+         * Option Char
+         *
+         * @details Each call to getopt_long(3) returns a
+         * sentinel character that either uniquely identifies
+         * a command-line option or can be used to do so in
+         * the case where the return value is zero (0).
+         *
+         * This latter case is useful because it allows for
+         * the use of both long and short option forms, both
+         * of which this server uses.
+         *
+         */
+        int c = getopt_long(argc, argv, "hvH:p:", long_options, &option_index);
+
+        /**
+         * When getopt(3), et. al, are done parsing all of
+         * the passed-in command-line arguments, they return
+         * a value of -1. We can therefore simply and safely
+         * break out of this loop if we detect this here.
+         *
+         */
+        if (c == -1) {
+            /**
+             * Any additional command-line arguments that
+             * were not deemed to be valid command-line
+             * options are considered to be positional
+             * arguments, and they can be iterated over
+             * using the optind variable provided by the
+             * getopt*(3) function(s).
+             *
+             * All of these positional arguments, if they
+             * exist, will be located at argv[optind] until
+             * argv[argc - 1].
+             *
+             */
+            break;
+        }
+
+        switch (c) {
+            case 0: {
+                if (strcmp(long_options[option_index].name, "version") == 0) {
+                    /** @todo Configure project versioning info */
+                    printf("Version Info\n");
+                    exit(EXIT_SUCCESS);
+                }
+
+                /** @todo What happens if we've gotten to this point? */
+            } break;
+
+            case 'f': {
+                configuration_options->configuration_filename = optarg;
+            } break;
+
+            /**
+             * Configure Server Hostname
+             */
+            case 'H': {
+                configuration_options->hostname = optarg;
+            } break;
+
+            /**
+             * Display Help Menu
+             */
+            case 'h': {
+                printf("%s", help_menu);
+                exit(EXIT_SUCCESS);
+            } break;
+
+            /**
+             * Configure Server Port
+             */
+            case 'p': {
+                configuration_options->port = optarg;
+            } break;
+
+            /** @todo What conditions cause this case, and how likely are they? */
+            case '?': {
+                break;
+            } break;
+
+            /** @todo What conditions trigger this case, and how likely are they? */
+            default: {
+                fatal_error("?? getopt returned character code 0%o ?? \n", c);
+            } break;
+        }
+    }
+}
+
+/**
+ * Parse a non-negative integer configuration value.
+ *
+ * @details Numeric configuration options must consist of
+ * nothing but decimal digits. Anything else, including an
+ * out-of-range value, is a fatal configuration error.
+ *
+ */
+__attribute__((nonnull(1,2)))
+static size_t parse_size_option(const char* option, const char* value) {
+    char* end = NULL;
+
+    errno = 0;
+    unsigned long long result = strtoull(value, &end, 10);
+
+    if ((errno != 0) || (end == value) || (*end != '\0') || (*value == '-')) {
+        configuration_error("[Error] Invalid numeric value for option %s: %s\n", option, value);
+        return 0;
+    }
+
+    return (size_t) result;
+}
+
+/**
+ * Parse a byte size configuration value.
+ *
+ * @details Byte sizes are a non-negative integer optionally
+ * followed by one of the binary unit suffixes K, M or G,
+ * e.g. "512M".
+ *
+ */
+__attribute__((nonnull(1,2)))
+static uint64_t parse_byte_size_option(const char* option, const char* value) {
+    char* end = NULL;
+
+    errno = 0;
+    unsigned long long result = strtoull(value, &end, 10);
+
+    if ((errno != 0) || (end == value) || (*value == '-')) {
+        configuration_error("[Error] Invalid byte size for option %s: %s\n", option, value);
+        return 0;
+    }
+
+    unsigned shift = 0;
+
+    switch (*end) {
+        case '\0': shift = 0; break;
+        case 'k': case 'K': shift = 10; ++end; break;
+        case 'm': case 'M': shift = 20; ++end; break;
+        case 'g': case 'G': shift = 30; ++end; break;
+        default: {
+            configuration_error("[Error] Invalid byte size for option %s: %s\n", option, value);
+            return 0;
+        }
+    }
+
+    if ((*end != '\0') || (result > (UINT64_MAX >> shift))) {
+        configuration_error("[Error] Invalid byte size for option %s: %s\n", option, value);
+        return 0;
+    }
+
+    return (uint64_t) result << shift;
+}
+
+/**
+ * Parse a boolean configuration value.
+ *
+ * @details Boolean options accept On/Off, Yes/No, True/False
+ * and 1/0, in any case.
+ *
+ */
+__attribute__((nonnull(1,2)))
+static int parse_boolean_option(const char* option, const char* value) {
+    if ((strcasecmp(value, "on") == 0) || (strcasecmp(value, "yes") == 0) || (strcasecmp(value, "true") == 0) || (strcmp(value, "1") == 0)) {
+        return TRUE;
+    }
+
+    if ((strcasecmp(value, "off") == 0) || (strcasecmp(value, "no") == 0) || (strcasecmp(value, "false") == 0) || (strcmp(value, "0") == 0)) {
+        return FALSE;
+    }
+
+    configuration_error("[Error] Invalid boolean value for option %s: %s\n", option, value);
+
+    return FALSE;
+}
+
+/**
+ * Parse a syslog(3) priority name.
+ *
+ * @details The names are those of the LOG_ constants,
+ * without the prefix, in any case, with err and warn also
+ * accepted as error and warning.
+ *
+ */
+__attribute__((nonnull(1,2)))
+static int parse_log_level_option(const char* option, const char* value) {
+    static const struct {
+        const char* name;
+        int priority;
+    } log_levels[] = {
+        { "emerg", LOG_EMERG },
+        { "alert", LOG_ALERT },
+        { "crit", LOG_CRIT },
+        { "err", LOG_ERR },
+        { "error", LOG_ERR },
+        { "warning", LOG_WARNING },
+        { "warn", LOG_WARNING },
+        { "notice", LOG_NOTICE },
+        { "info", LOG_INFO },
+        { "debug", LOG_DEBUG }
+    };
+
+    for (size_t i = 0; i < sizeof (log_levels) / sizeof (log_levels[0]); ++i) {
+        if (strcasecmp(value, log_levels[i].name) == 0) {
+            return log_levels[i].priority;
+        }
+    }
+
+    configuration_error("[Error] Invalid log level for option %s: %s\n", option, value);
+
+    return LOG_DEBUG;
+}
+
+/**
+ * Parse a MimeType directive value.
+ *
+ * @details The value consists of a file extension, with or
+ * without its leading dot, followed by the media type it
+ * should map to, e.g. "wasm application/wasm".
+ *
+ */
+__attribute__((nonnull(1,2)))
+static void parse_mime_type_override(struct configuration_options_t* configuration_options, char* value) {
+    char* extension = strtok(value, " \t");
+    char* content_type = strtok(NULL, " \t");
+
+    if ((extension == NULL) || (content_type == NULL)) {
+        configuration_error("[Error] %s: %s\n", "Invalid MimeType directive", value);
+        return;
+    }
+
+    if (*extension == '.') {
+        ++extension;
+    }
+
+    if ((*extension == '\0') || (strlen(extension) > MIME_EXTENSION_MAX_LENGTH)) {
+        configuration_error("[Error] %s: %s\n", "Invalid MimeType extension", extension);
+        return;
+    }
+
+    if (strlen(content_type) > MIME_CONTENT_TYPE_MAX_LENGTH) {
+        configuration_error("[Error] %s: %s\n", "MimeType media type is too long", content_type);
+        return;
+    }
+
+    struct mime_type_override_t* mime_type_override = allocate_configuration_memory(configuration_options, sizeof (struct mime_type_override_t));
+    mime_type_override->extension = extension;
+    mime_type_override->content_type = content_type;
+    mime_type_override->next = NULL;
+
+    /**
+     * Append the override so that, when the same extension
+     * is mapped more than once, the last directive wins.
+     *
+     */
+    struct mime_type_override_t** tail = &configuration_options->mime_type_overrides;
+
+    while (*tail) {
+        tail = &(*tail)->next;
+    }
+
+    *tail = mime_type_override;
+}
+
+/**
+ * Parse a VirtualHost directive value, which opens a block.
+ *
+ * @details The value is the whitespace-separated list of
+ * names the virtual host answers to. Options the block does
+ * not set are marked as such, to be inherited from the
+ * global configuration once the whole file has been read.
+ *
+ */
+__attribute__((nonnull(1,2)))
+static struct virtual_host_t* parse_virtual_host(struct configuration_options_t* configuration_options, char* value) {
+    struct virtual_host_t* virtual_host = allocate_configuration_memory(configuration_options, sizeof (struct virtual_host_t));
+    virtual_host->name_count = 0;
+    virtual_host->document_root_directory = NULL;
+    virtual_host->directory_listing_enabled = -1;
+    virtual_host->directory_listing_cache_entries = SIZE_MAX;
+    virtual_host->file_cache_entries = SIZE_MAX;
+    virtual_host->file_cache_validity = SIZE_MAX;
+    virtual_host->negative_cache_entries = SIZE_MAX;
+    virtual_host->content_cache_max_file_size = UINT64_MAX;
+    virtual_host->streaming_threshold = UINT64_MAX;
+    virtual_host->next = NULL;
+
+    size_t name_count = 1;
+
+    for (const char* c = value; *c; ++c) {
+        name_count += ((*c == ' ') || (*c == '\t'));
+    }
+
+    const char** names = allocate_configuration_memory(configuration_options, sizeof (const char*) * name_count);
+
+    for (char* name = strtok(value, " \t"); name; name = strtok(NULL, " \t")) {
+        size_t length = strlen(name);
+
+        if ((length > VIRTUAL_HOST_NAME_MAX_LENGTH) || (strspn(name, "*.-0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz") != length) || (strchr(name + 1, '*') != NULL) || ((name[0] == '*') && (strncmp(name, "*.", 2) != 0 || length == 2))) {
+            configuration_error("[Error] %s: %s\n", "Invalid VirtualHost name", name);
+            continue;
+        }
+
+        for (char* c = name; *c; ++c) {
+            *c = (char) tolower((unsigned char) *c);
+        }
+
+        names[virtual_host->name_count++] = name;
+    }
+
+    if (virtual_host->name_count == 0) {
+        configuration_error("[Error] %s\n", "VirtualHost needs at least one name");
+    }
+
+    virtual_host->names = names;
+
+    /**
+     * Append the block, so that virtual hosts are numbered
+     * in the order they appear in the file.
+     *
+     */
+    struct virtual_host_t** tail = &configuration_options->virtual_hosts;
+
+    while (*tail) {
+        tail = &(*tail)->next;
+    }
+
+    *tail = virtual_host;
+
+    return virtual_host;
+}
+
+/**
+ * Parse an option inside a VirtualHost block.
+ *
+ * @details Only the options that make sense per virtual
+ * host are allowed here; everything else is global.
+ *
+ */
+__attribute__((nonnull(1,2,3)))
+static void parse_virtual_host_option(struct virtual_host_t* virtual_host, const char* option, char* value) {
+    if (strcmp(option, "DocumentRoot") == 0) {
+        virtual_host->document_root_directory = value;
+    } else if (strcmp(option, "DirectoryListing") == 0) {
+        virtual_host->directory_listing_enabled = parse_boolean_option(option, value);
+    } else if (strcmp(option, "DirectoryListingCacheEntries") == 0) {
+        virtual_host->directory_listing_cache_entries = parse_size_option(option, value);
+    } else if (strcmp(option, "FileCacheEntries") == 0) {
+        virtual_host->file_cache_entries = parse_size_option(option, value);
+    } else if (strcmp(option, "FileCacheValidity") == 0) {
+        virtual_host->file_cache_validity = parse_size_option(option, value);
+    } else if (strcmp(option, "NegativeCacheEntries") == 0) {
+        virtual_host->negative_cache_entries = parse_size_option(option, value);
+    } else if (strcmp(option, "ContentCacheMaxFileSize") == 0) {
+        virtual_host->content_cache_max_file_size = parse_byte_size_option(option, value);
+    } else if (strcmp(option, "StreamingThreshold") == 0) {
+        virtual_host->streaming_threshold = parse_byte_size_option(option, value);
+    } else {
+        configuration_error("[Error] %s: %s\n", "Option not allowed in a VirtualHost block", option);
+    }
+}
+
+/**
+ * Fill in the default virtual host from the global options.
+ *
+ */
+__attribute__((nonnull(1,2)))
+static void default_virtual_host(const struct configuration_options_t* configuration_options, struct virtual_host_t* virtual_host) {
+    virtual_host->names = NULL;
+    virtual_host->name_count = 0;
+    virtual_host->document_root_directory = configuration_options->document_root_directory;
+    virtual_host->directory_listing_enabled = configuration_options->directory_listing_enabled;
+    virtual_host->directory_listing_cache_entries = configuration_options->directory_listing_cache_entries;
+    virtual_host->file_cache_entries = configuration_options->file_cache_entries;
+    virtual_host->file_cache_validity = configuration_options->file_cache_validity;
+    virtual_host->negative_cache_entries = configuration_options->negative_cache_entries;
+    virtual_host->content_cache_max_file_size = configuration_options->content_cache_max_file_size;
+    virtual_host->streaming_threshold = configuration_options->streaming_threshold;
+    virtual_host->next = NULL;
+}
+
+/**
+ * Turn the parsed VirtualHost blocks into an array, behind
+ * the default virtual host, and build the router for them.
+ *
+ */
+__attribute__((nonnull(1)))
+static void finalize_virtual_hosts(struct configuration_options_t* configuration_options) {
+    size_t count = 1;
+
+    for (const struct virtual_host_t* block = configuration_options->virtual_hosts; block; block = block->next) {
+        ++count;
+    }
+
+    struct virtual_host_t* virtual_hosts = allocate_configuration_memory(configuration_options, sizeof (struct virtual_host_t) * count);
+    default_virtual_host(configuration_options, &virtual_hosts[0]);
+
+    size_t i = 1;
+
+    for (const struct virtual_host_t* block = configuration_options->virtual_hosts; block; block = block->next, ++i) {
+        struct virtual_host_t* virtual_host = &virtual_hosts[i];
+        *virtual_host = *block;
+        virtual_host->next = NULL;
+
+        if (virtual_host->document_root_directory == NULL) {
+            configuration_error("[Error] %s: %s\n", "VirtualHost has no DocumentRoot", (virtual_host->name_count > 0) ? virtual_host->names[0] : "(unnamed)");
+        }
+
+        if (virtual_host->directory_listing_enabled == -1) {
+            virtual_host->directory_listing_enabled = virtual_hosts[0].directory_listing_enabled;
+        }
+
+        if (virtual_host->directory_listing_cache_entries == SIZE_MAX) {
+            virtual_host->directory_listing_cache_entries = virtual_hosts[0].directory_listing_cache_entries;
+        }
+
+        if (virtual_host->file_cache_entries == SIZE_MAX) {
+            virtual_host->file_cache_entries = virtual_hosts[0].file_cache_entries;
+        }
+
+        if (virtual_host->file_cache_validity == SIZE_MAX) {
+            virtual_host->file_cache_validity = virtual_hosts[0].file_cache_validity;
+        }
+
+        if (virtual_host->negative_cache_entries == SIZE_MAX) {
+            virtual_host->negative_cache_entries = virtual_hosts[0].negative_cache_entries;
+        }
+
+        if (virtual_host->content_cache_max_file_size == UINT64_MAX) {
+            virtual_host->content_cache_max_file_size = virtual_hosts[0].content_cache_max_file_size;
+        }
+
+        if (virtual_host->streaming_threshold == UINT64_MAX) {
+            virtual_host->streaming_threshold = virtual_hosts[0].streaming_threshold;
+        }
+    }
+
+    configuration_options->virtual_hosts = virtual_hosts;
+    configuration_options->virtual_host_count = count;
+
+    const char* duplicate = NULL;
+    configuration_options->virtual_host_router = build_virtual_host_router(virtual_hosts, count, &duplicate);
+
+    if (configuration_options->virtual_host_router == NULL) {
+        configuration_error("[Error] %s: %s\n", "VirtualHost name is used more than once", duplicate);
+    }
+}
+
+/**
+ * Parse a Location directive value, which opens a block.
+ *
+ * @details The value is the path to match, optionally
+ * preceded by the word "exact".
+ *
+ */
+__attribute__((nonnull(1,2)))
+static struct location_t* parse_location(struct configuration_options_t* configuration_options, char* value) {
+    struct location_t* location = allocate_configuration_memory(configuration_options, sizeof (struct location_t));
+    location->exact = FALSE;
+    location->handler = LOCATION_STATIC_FILES;
+    location->document_root_directory = NULL;
+    location->directory_listing_enabled = -1;
+    location->status = 0;
+    location->target = NULL;
+    location->next = NULL;
+
+    char* path = strtok(value, " \t");
+
+    if (path && (strcmp(path, "exact") == 0)) {
+        location->exact = TRUE;
+        path = strtok(NULL, " \t");
+    }
+
+    if ((path == NULL) || (path[0] != '/') || (strtok(NULL, " \t") != NULL)) {
+        configuration_error("[Error] %s: %s\n", "Invalid Location directive", value);
+        path = "/";
+    }
+
+    location->path = path;
+    location->path_length = strlen(path);
+
+    struct location_t** tail = &configuration_options->locations;
+
+    while (*tail) {
+        tail = &(*tail)->next;
+    }
+
+    *tail = location;
+
+    return location;
+}
+
+/**
+ * Parse a status code for a Redirect or Return directive.
+ *
+ */
+__attribute__((nonnull(1,2)))
+static int parse_status_option(const char* option, const char* value, int redirect) {
+    char* end = NULL;
+    long status = strtol(value, &end, 10);
+
+    if ((end == value) || ((*end != '\0') && (*end != ' ') && (*end != '\t'))) {
+        status = 0;
+    }
+
+    if (redirect ? ((status != 301) && (status != 302) && (status != 303) && (status != 307) && (status != 308)) : ((status < 200) || (status > 599))) {
+        configuration_error("[Error] Invalid status code for option %s: %s\n", option, value);
+        return redirect ? 302 : 404;
+    }
+
+    return (int) status;
+}
+
+/**
+ * Parse an option inside a Location block.
+ *
+ */
+__attribute__((nonnull(1,2,3)))
+static void parse_location_option(struct location_t* location, const char* option, char* value) {
+    if (strcmp(option, "DocumentRoot") == 0) {
+        location->document_root_directory = value;
+    } else if (strcmp(option, "DirectoryListing") == 0) {
+        location->directory_listing_enabled = parse_boolean_option(option, value);
+    } else if (strcmp(option, "Redirect") == 0) {
+        location->handler = LOCATION_REDIRECT;
+        location->status = parse_status_option(option, value, TRUE);
+        strtok(value, " \t");
+        location->target = strtok(NULL, " \t");
+
+        if ((location->target == NULL) || (strpbrk(location->target, "\r\n") != NULL)) {
+            configuration_error("[Error] %s: %s\n", "Redirect needs a target", value);
+            location->target = "/";
+        }
+    } else if (strcmp(option, "Return") == 0) {
+        location->handler = LOCATION_RETURN;
+        location->status = parse_status_option(option, value, FALSE);
+    } else {
+        configuration_error("[Error] %s: %s\n", "Option not allowed in a Location block", option);
+    }
+}
+
+/**
+ * Turn the parsed Location blocks into an array, and build
+ * the tree that matches request paths against them.
+ *
+ */
+__attribute__((nonnull(1)))
+static void finalize_locations(struct configuration_options_t* configuration_options) {
+    size_t count = 0;
+
+    for (const struct location_t* block = configuration_options->locations; block; block = block->next) {
+        ++count;
+    }
+
+    struct location_t* locations = allocate_configuration_memory(configuration_options, sizeof (struct location_t) * (count ? count : 1));
+    size_t i = 0;
+
+    for (const struct location_t* block = configuration_options->locations; block; block = block->next, ++i) {
+        locations[i] = *block;
+        locations[i].next = NULL;
+    }
+
+    configuration_options->locations = locations;
+    configuration_options->location_count = count;
+
+    const char* duplicate = NULL;
+    configuration_options->location_tree = build_location_tree(locations, count, &duplicate);
+
+    if (configuration_options->location_tree == NULL) {
+        configuration_error("[Error] %s: %s\n", "Location path is used more than once", duplicate);
+    }
+}
+
+/**
+ * Parse a Rewrite or RedirectMatch directive value.
+ *
+ * @details A Rewrite value is a pattern and the path to
+ * rewrite matching requests to. A RedirectMatch value is a
+ * status code, a pattern and the target to redirect
+ * matching requests to.
+ *
+ */
+__attribute__((nonnull(1,2,3)))
+static void parse_rewrite_rule(struct configuration_options_t* configuration_options, const char* option, char* value, int redirect) {
+    struct rewrite_rule_t* rule = allocate_configuration_memory(configuration_options, sizeof (struct rewrite_rule_t));
+    rule->status = redirect ? parse_status_option(option, value, TRUE) : 0;
+    rule->next = NULL;
+
+    /**
+     * Skip over the status code, which has been parsed
+     * already.
+     *
+     */
+    if (redirect) {
+        strtok(value, " \t");
+    }
 
-        /**
-         * @details This variable is set by getopt_long(3)
-         * on each iteration of the option-parsing loop. It
-         * is used as the index to the long options array
-         * when a long option is detected in the input.
-         *
-         */
-        int option_index = 0;
+    char* pattern = strtok(redirect ? NULL : value, " \t");
+    char* target = strtok(NULL, " \t");
 
-        /**
-         * Option Char
-         *
-         * @details Each call to getopt_long(3) returns a
-         * sentinel character that either uniquely identifies
-         * a command-line option or can be used to do so in
-         * the case where the return value is zero (0).
-         *
-         * This latter case is useful because it allows for
-         * the use of both long and short option forms, both
-         * of which this server uses.
-         *
-         */
-        int c = getopt_long(argc, argv, "hvH:p:", long_options, &option_index);
+    if ((pattern == NULL) || (target == NULL) || (strtok(NULL, " \t") != NULL) || (pattern[0] != '/') || (!redirect && (target[0] != '/'))) {
+        configuration_error("[Error] %s: %s\n", "Invalid rule for option", option);
+        return;
+    }
 
-        /**
-         * When getopt(3), et. al, are done parsing all of
-         * the passed-in command-line arguments, they return
-         * a value of -1. We can therefore simply and safely
-         * break out of this loop if we detect this here.
-         *
-         */
-        if (c == -1) {
-            /**
-             * Any additional command-line arguments that
-             * were not deemed to be valid command-line
-             * options are considered to be positional
-             * arguments, and they can be iterated over
-             * using the optind variable provided by the
-             * getopt*(3) function(s).
-             *
-             * All of these positional arguments, if they
-             * exist, will be located at argv[optind] until
-             * argv[argc - 1].
-             *
-             */
-            break;
+    size_t wildcards = count_rewrite_wildcards(pattern);
+
+    if (wildcards > REWRITE_MAX_CAPTURES) {
+        configuration_error("[Error] %s: %s\n", "Too many wildcards in pattern", pattern);
+        return;
+    }
+
+    for (const char* c = target; *c; ++c) {
+        if ((c[0] == '$') && (c[1] >= '0') && (c[1] <= '9') && ((size_t) (c[1] - '0') > wildcards)) {
+            configuration_error("[Error] %s: %s\n", "Target refers to a wildcard its pattern does not have", target);
+            return;
         }
+    }
 
-        switch (c) {
-            case 0: {
-                if (strcmp(long_options[option_index].name, "version") == 0) {
-                    /** @todo Configure project versioning info */
-                    printf("Version Info\n");
-                    exit(EXIT_SUCCESS);
-                }
+    rule->pattern = pattern;
+    rule->target = target;
 
-                /** @todo What happens if we've gotten to this point? */
-            } break;
+    struct rewrite_rule_t** tail = &configuration_options->rewrite_rules;
 
-            case 'f': {
-                configuration_options->configuration_filename = optarg;
-            } break;
+    while (*tail) {
+        tail = &(*tail)->next;
+    }
 
-            /**
-             * Configure Server Hostname
-             */
-            case 'H': {
-                configuration_options->hostname = optarg;
-            } break;
+    *tail = rule;
+}
 
-            /**
-             * Display Help Menu
-             */
-            case 'h': {
-                printf("%s", help_menu);
-                exit(EXIT_SUCCESS);
-            } break;
+/**
+ * Turn the parsed rewrite rules into an array, and compile
+ * them.
+ *
+ */
+__attribute__((nonnull(1)))
+static void finalize_rewrite_rules(struct configuration_options_t* configuration_options) {
+    size_t count = 0;
 
-            /**
-             * Configure Server Port
-             */
-            case 'p': {
-                configuration_options->port = optarg;
-            } break;
+    for (const struct rewrite_rule_t* rule = configuration_options->rewrite_rules; rule; rule = rule->next) {
+        ++count;
+    }
 
-            /** @todo What conditions cause this case, and how likely are they? */
-            case '?': {
-                break;
-            } break;
+    struct rewrite_rule_t* rules = allocate_configuration_memory(configuration_options, sizeof (struct rewrite_rule_t) * (count ? count : 1));
+    size_t i = 0;
 
-            /** @todo What conditions trigger this case, and how likely are they? */
-            default: {
-                fatal_error("?? getopt returned character code 0%o ?? \n", c);
-            } break;
-        }
+    for (const struct rewrite_rule_t* rule = configuration_options->rewrite_rules; rule; rule = rule->next, ++i) {
+        rules[i] = *rule;
+        rules[i].next = NULL;
+    }
+
+    configuration_options->rewrite_rules = rules;
+    configuration_options->rewrite_rule_count = count;
+    configuration_options->rewrite_engine = build_rewrite_engine(rules, count);
+
+    if (configuration_options->rewrite_engine == NULL) {
+        configuration_error("[Error] %s\n", "Rewrite rules compile to too many states");
     }
 }
 
@@ -390,7 +1413,8 @@ static void parse_configuration_file_options(struct configuration_options_t* con
          * execution should be carried out.
          *
          */
-        fatal_error("[Error] %s: %s (%s)\n", "Could not open configuration file", configuration_options->configuration_filename, strerror(errno));
+        configuration_error("[Error] %s: %s (%s)\n", "Could not open configuration file", configuration_options->configuration_filename, strerror(errno));
+        return;
     }
 
     /**
@@ -414,16 +1438,34 @@ static void parse_configuration_file_options(struct configuration_options_t* con
      *
      * The getline(3) function that we are using specifically
      * requires that the line buffer argument to be
-     * heap-allocated.
+     * heap-allocated, and grows it with realloc(3), so it has
+     * to come straight from malloc(3); blocks returned by
+     * allocate_memory() carry an accounting header.
      *
      */
-    char* line_buffer = allocate_memory(sizeof(char) * buffer_size);
+    char* line_buffer = malloc(sizeof(char) * buffer_size);
+
+    if (line_buffer == NULL) {
+        fatal_error("[Error] %s: %s\n", "Memory allocation failure in call to malloc()", strerror(errno));
+    }
 
     /**
      * Iterate over the configuration file stream, reading
      * each line into the line buffer.
      *
      */
+    /**
+     * The VirtualHost block being parsed, if any.
+     *
+     */
+    struct virtual_host_t* virtual_host = NULL;
+
+    /**
+     * Likewise the Location block being parsed.
+     *
+     */
+    struct location_t* location = NULL;
+
     while ((getline(&line_buffer, &buffer_size, configuration_file)) > 0) {
         /**
          * In other to use a more simplistic, hand-made
@@ -509,7 +1551,24 @@ static void parse_configuration_file_options(struct configuration_options_t* con
          * just move on.
          *
          */
-        if ((option != NULL) && (strcmp(option, "") != 0)) {
+        if ((option != NULL) && (strcmp(option, "EndVirtualHost") == 0)) {
+            /**
+             * The one option that takes no value closes the
+             * current VirtualHost block.
+             *
+             */
+            if (virtual_host == NULL) {
+                configuration_error("[Error] %s\n", "EndVirtualHost without VirtualHost");
+            }
+
+            virtual_host = NULL;
+        } else if ((option != NULL) && (strcmp(option, "EndLocation") == 0)) {
+            if (location == NULL) {
+                configuration_error("[Error] %s\n", "EndLocation without Location");
+            }
+
+            location = NULL;
+        } else if ((option != NULL) && (strcmp(option, "") != 0)) {
             /** Get value */
             char* value = strtok(NULL, "\r\n");
 
@@ -526,14 +1585,31 @@ static void parse_configuration_file_options(struct configuration_options_t* con
                  * the problem.
                  *
                  */
-                fatal_error("[Error] Invalid configuration setting for option: %s\n", option);
+                configuration_error("[Error] Invalid configuration setting for option: %s\n", option);
+                break;
             }
 
-            char* value_string = allocate_memory(strlen(value));
+            char* value_string = allocate_configuration_memory(configuration_options, strlen(value) + 1);
             strcpy(value_string, value);
 
             /** @todo Validate configuration options */
-            if (strcmp(option, "User") == 0) {
+            if (strcmp(option, "VirtualHost") == 0) {
+                if (virtual_host || location) {
+                    configuration_error("[Error] %s\n", "VirtualHost blocks cannot be nested");
+                }
+
+                virtual_host = parse_virtual_host(configuration_options, value_string);
+            } else if (strcmp(option, "Location") == 0) {
+                if (virtual_host || location) {
+                    configuration_error("[Error] %s\n", "Location blocks cannot be nested");
+                }
+
+                location = parse_location(configuration_options, value_string);
+            } else if (virtual_host) {
+                parse_virtual_host_option(virtual_host, option, value_string);
+            } else if (location) {
+                parse_location_option(location, option, value_string);
+            } else if (strcmp(option, "User") == 0) {
                 /** @todo Implement run as user */
             } else if (strcmp(option, "Group") == 0) {
                 /** @todo Implement run as group */
@@ -547,11 +1623,88 @@ static void parse_configuration_file_options(struct configuration_options_t* con
                 configuration_options->port = value_string;
             } else if (strcmp(option, "DocumentRoot") == 0) {
                 configuration_options->document_root_directory = value_string;
+            } else if (strcmp(option, "MimeType") == 0) {
+                parse_mime_type_override(configuration_options, value_string);
+            } else if (strcmp(option, "LogLevel") == 0) {
+                configuration_options->log_level = parse_log_level_option(option, value_string);
+            } else if (strcmp(option, "FileIoThreads") == 0) {
+                configuration_options->file_io_thread_count = parse_size_option(option, value_string);
+            } else if (strcmp(option, "MemoryArenaPerThread") == 0) {
+                configuration_options->memory_arena_per_thread = parse_boolean_option(option, value_string);
+            } else if (strcmp(option, "MemoryThreadCache") == 0) {
+                configuration_options->memory_thread_cache = parse_boolean_option(option, value_string);
+            } else if (strcmp(option, "MemoryDirtyDecay") == 0) {
+                configuration_options->memory_dirty_decay = parse_size_option(option, value_string);
+            } else if (strcmp(option, "MemoryMuzzyDecay") == 0) {
+                configuration_options->memory_muzzy_decay = parse_size_option(option, value_string);
+            } else if (strcmp(option, "MemorySoftLimit") == 0) {
+                configuration_options->memory_soft_limit = parse_byte_size_option(option, value_string);
+            } else if (strcmp(option, "MemoryHardLimit") == 0) {
+                configuration_options->memory_hard_limit = parse_byte_size_option(option, value_string);
+            } else if (strcmp(option, "DirectoryListing") == 0) {
+                configuration_options->directory_listing_enabled = parse_boolean_option(option, value_string);
+            } else if (strcmp(option, "DirectoryListingCacheEntries") == 0) {
+                configuration_options->directory_listing_cache_entries = parse_size_option(option, value_string);
+            } else if (strcmp(option, "FileCacheEntries") == 0) {
+                configuration_options->file_cache_entries = parse_size_option(option, value_string);
+            } else if (strcmp(option, "FileCacheValidity") == 0) {
+                configuration_options->file_cache_validity = parse_size_option(option, value_string);
+            } else if (strcmp(option, "NegativeCacheEntries") == 0) {
+                configuration_options->negative_cache_entries = parse_size_option(option, value_string);
+            } else if (strcmp(option, "NegativeCacheBloomFilter") == 0) {
+                configuration_options->negative_cache_bloom_filter = parse_boolean_option(option, value_string);
+            } else if (strcmp(option, "ContentCacheSize") == 0) {
+                configuration_options->content_cache_size = parse_byte_size_option(option, value_string);
+            } else if (strcmp(option, "ContentCachePageSize") == 0) {
+                configuration_options->content_cache_page_size = parse_byte_size_option(option, value_string);
+            } else if (strcmp(option, "ContentCacheMaxFileSize") == 0) {
+                configuration_options->content_cache_max_file_size = parse_byte_size_option(option, value_string);
+            } else if (strcmp(option, "StreamingThreshold") == 0) {
+                configuration_options->streaming_threshold = parse_byte_size_option(option, value_string);
+            } else if (strcmp(option, "StreamingBufferSize") == 0) {
+                configuration_options->streaming_buffer_size = parse_byte_size_option(option, value_string);
+            } else if (strcmp(option, "StreamingDropCache") == 0) {
+                configuration_options->streaming_drop_cache = parse_boolean_option(option, value_string);
+            } else if (strcmp(option, "ReadaheadWindow") == 0) {
+                configuration_options->readahead_window = parse_byte_size_option(option, value_string);
+            } else if (strcmp(option, "WarmupBudget") == 0) {
+                configuration_options->warmup_budget = parse_byte_size_option(option, value_string);
+            } else if (strcmp(option, "WarmupManifest") == 0) {
+                configuration_options->warmup_manifest = value_string;
+            } else if (strcmp(option, "PopularitySnapshot") == 0) {
+                configuration_options->popularity_snapshot = value_string;
+            } else if (strcmp(option, "PopularitySnapshotInterval") == 0) {
+                configuration_options->popularity_snapshot_interval = parse_size_option(option, value_string);
+            } else if (strcmp(option, "StatisticsInterval") == 0) {
+                configuration_options->statistics_interval = parse_size_option(option, value_string);
+            } else if (strcmp(option, "SitePack") == 0) {
+                configuration_options->site_pack = value_string;
+            } else if (strcmp(option, "Rewrite") == 0) {
+                parse_rewrite_rule(configuration_options, option, value_string, FALSE);
+            } else if (strcmp(option, "RedirectMatch") == 0) {
+                parse_rewrite_rule(configuration_options, option, value_string, TRUE);
             } else {
-                free(value_string);
-                fatal_error("[Error] %s: %s\n", "Unrecognized option", option);
+                configuration_error("[Error] %s: %s\n", "Unrecognized option", option);
             }
         }
+
+        /**
+         * While reloading, there is no point in reading any
+         * further once the configuration is known to be
+         * invalid.
+         *
+         */
+        if (configuration_error_count) {
+            break;
+        }
+    }
+
+    if (virtual_host && (configuration_error_count == 0)) {
+        configuration_error("[Error] %s\n", "VirtualHost block is missing its EndVirtualHost");
+    }
+
+    if (location && (configuration_error_count == 0)) {
+        configuration_error("[Error] %s\n", "Location block is missing its EndLocation");
     }
 
     /**
@@ -574,6 +1727,9 @@ static void parse_configuration_file_options(struct configuration_options_t* con
  *
  */
 struct configuration_options_t* initialize_server_configuration(int argc, char *argv[]) {
+    command_line_argc = argc;
+    command_line_argv = argv;
+
     /**
      * Initialize the server configuration options by setting
      * all options to their defined defaults.
@@ -606,9 +1762,253 @@ struct configuration_options_t* initialize_server_configuration(int argc, char *
      */
     parse_configuration_file_options(configuration_options);
 
+    /**
+     * With every option known, the virtual hosts can inherit
+     * whatever they did not set themselves.
+     *
+     */
+    finalize_virtual_hosts(configuration_options);
+    finalize_locations(configuration_options);
+    finalize_rewrite_rules(configuration_options);
+
+    /**
+     * Publish the configuration, so that workers can pick it
+     * up through current_server_configuration().
+     *
+     */
+    publish_configuration(configuration_options);
+
     /**
      * Return the configured server options.
      *
      */
     return configuration_options;
 }
+
+/**
+ * Carry a startup-only option over from the running
+ * configuration, warning if the new one tried to change it.
+ *
+ */
+#define KEEP_STARTUP_OPTION(next, current, field, option)                                           \
+    if ((next)->field != (current)->field) {                                                        \
+        syslog(LOG_WARNING, "[Warning] %s only takes effect when the server is restarted", option); \
+        (next)->field = (current)->field;                                                           \
+    }
+
+/**
+ * Carry a startup-only string option over from the running
+ * configuration.
+ *
+ * @details The string is copied, since the running
+ * configuration, and everything it owns, is freed once the
+ * new one has been adopted.
+ *
+ */
+__attribute__((nonnull(1,2)))
+static void keep_startup_string_option(struct configuration_options_t* next, const char** field, const char* current, const char* option) {
+    if ((*field != current) && ((*field == NULL) || (current == NULL) || (strcmp(*field, current) != 0))) {
+        syslog(LOG_WARNING, "[Warning] %s only takes effect when the server is restarted", option);
+    }
+
+    *field = copy_configuration_string(next, current);
+}
+
+/**
+ * Keep every option that is only read at startup as it is.
+ *
+ * @details These size the listening socket, the file I/O
+ * pool, the allocator and the caches, none of which can be
+ * rebuilt without dropping connections or cached files.
+ *
+ */
+static void keep_startup_options(struct configuration_options_t* next, const struct configuration_options_t* current) {
+    keep_startup_string_option(next, &next->hostname, current->hostname, "Hostname");
+    keep_startup_string_option(next, &next->port, current->port, "Port");
+
+    KEEP_STARTUP_OPTION(next, current, file_io_thread_count, "FileIoThreads");
+    KEEP_STARTUP_OPTION(next, current, memory_arena_per_thread, "MemoryArenaPerThread");
+    KEEP_STARTUP_OPTION(next, current, memory_thread_cache, "MemoryThreadCache");
+    KEEP_STARTUP_OPTION(next, current, memory_dirty_decay, "MemoryDirtyDecay");
+    KEEP_STARTUP_OPTION(next, current, memory_muzzy_decay, "MemoryMuzzyDecay");
+    KEEP_STARTUP_OPTION(next, current, directory_listing_cache_entries, "DirectoryListingCacheEntries");
+    KEEP_STARTUP_OPTION(next, current, file_cache_entries, "FileCacheEntries");
+    KEEP_STARTUP_OPTION(next, current, file_cache_validity, "FileCacheValidity");
+    KEEP_STARTUP_OPTION(next, current, negative_cache_entries, "NegativeCacheEntries");
+    KEEP_STARTUP_OPTION(next, current, negative_cache_bloom_filter, "NegativeCacheBloomFilter");
+    KEEP_STARTUP_OPTION(next, current, content_cache_size, "ContentCacheSize");
+    KEEP_STARTUP_OPTION(next, current, content_cache_page_size, "ContentCachePageSize");
+    KEEP_STARTUP_OPTION(next, current, streaming_buffer_size, "StreamingBufferSize");
+}
+
+/**
+ * Whether two configurations declare the same virtual
+ * hosts, by name, in the same order.
+ *
+ */
+__attribute__((nonnull(1,2)))
+static int same_virtual_hosts(const struct configuration_options_t* next, const struct configuration_options_t* current) {
+    if (next->virtual_host_count != current->virtual_host_count) {
+        return FALSE;
+    }
+
+    for (size_t i = 1; i < next->virtual_host_count; ++i) {
+        const struct virtual_host_t* a = &next->virtual_hosts[i];
+        const struct virtual_host_t* b = &current->virtual_hosts[i];
+
+        if (a->name_count != b->name_count) {
+            return FALSE;
+        }
+
+        for (size_t n = 0; n < a->name_count; ++n) {
+            if (strcmp(a->names[n], b->names[n]) != 0) {
+                return FALSE;
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * Keep the set of virtual hosts, and their cache sizes, as
+ * they are.
+ *
+ * @details Every virtual host has its own caches in every
+ * worker, sized when the server starts, and requests refer
+ * to virtual hosts by their position. A reload can change a
+ * virtual host's document root and limits, but not add,
+ * remove or rename virtual hosts.
+ *
+ */
+static void keep_startup_virtual_hosts(struct configuration_options_t* next, const struct configuration_options_t* current) {
+    if (!same_virtual_hosts(next, current)) {
+        syslog(LOG_WARNING, "[Warning] %s only take effect when the server is restarted", "VirtualHost blocks");
+
+        struct virtual_host_t* virtual_hosts = allocate_configuration_memory(next, sizeof (struct virtual_host_t) * current->virtual_host_count);
+
+        for (size_t i = 1; i < current->virtual_host_count; ++i) {
+            const struct virtual_host_t* virtual_host = &current->virtual_hosts[i];
+            const char** names = allocate_configuration_memory(next, sizeof (const char*) * virtual_host->name_count);
+
+            for (size_t n = 0; n < virtual_host->name_count; ++n) {
+                names[n] = copy_configuration_string(next, virtual_host->names[n]);
+            }
+
+            virtual_hosts[i] = *virtual_host;
+            virtual_hosts[i].names = names;
+            virtual_hosts[i].document_root_directory = copy_configuration_string(next, virtual_host->document_root_directory);
+        }
+
+        const char* duplicate = NULL;
+
+        free_virtual_host_router(next->virtual_host_router);
+        next->virtual_hosts = virtual_hosts;
+        next->virtual_host_count = current->virtual_host_count;
+        next->virtual_host_router = build_virtual_host_router(virtual_hosts, current->virtual_host_count, &duplicate);
+    }
+
+    /**
+     * The default virtual host mirrors the global options,
+     * some of which have just been put back.
+     *
+     */
+    default_virtual_host(next, &next->virtual_hosts[0]);
+
+    for (size_t i = 1; i < next->virtual_host_count; ++i) {
+        struct virtual_host_t* virtual_host = &next->virtual_hosts[i];
+
+        KEEP_STARTUP_OPTION(virtual_host, &current->virtual_hosts[i], directory_listing_cache_entries, "DirectoryListingCacheEntries");
+        KEEP_STARTUP_OPTION(virtual_host, &current->virtual_hosts[i], file_cache_entries, "FileCacheEntries");
+        KEEP_STARTUP_OPTION(virtual_host, &current->virtual_hosts[i], file_cache_validity, "FileCacheValidity");
+        KEEP_STARTUP_OPTION(virtual_host, &current->virtual_hosts[i], negative_cache_entries, "NegativeCacheEntries");
+    }
+}
+
+/**
+ * Parse the configuration again and publish the result.
+ *
+ */
+const struct configuration_options_t* reload_server_configuration(void) {
+    const struct configuration_options_t* current = current_server_configuration();
+
+    reloading_configuration = TRUE;
+    configuration_error_count = 0;
+
+    /**
+     * Setting optind to zero, rather than one, makes
+     * getopt_long(3) reinitialize itself completely.
+     *
+     */
+    optind = 0;
+
+    struct configuration_options_t* configuration_options = initialize_default_configuration();
+    parse_command_line_configuration_options(configuration_options, command_line_argc, command_line_argv);
+    parse_configuration_file_options(configuration_options);
+
+    if (configuration_error_count == 0) {
+        finalize_virtual_hosts(configuration_options);
+        finalize_locations(configuration_options);
+        finalize_rewrite_rules(configuration_options);
+    }
+
+    reloading_configuration = FALSE;
+
+    if (configuration_error_count) {
+        free_configuration(configuration_options);
+        return NULL;
+    }
+
+    keep_startup_options(configuration_options, current);
+    keep_startup_virtual_hosts(configuration_options, current);
+    publish_configuration(configuration_options);
+
+    return configuration_options;
+}
+
+/**
+ * Return the current configuration.
+ *
+ */
+const struct configuration_options_t* current_server_configuration(void) {
+    return atomic_load_explicit(&published_configuration, memory_order_acquire);
+}
+
+/**
+ * Register a thread that reads the configuration.
+ *
+ */
+size_t register_configuration_reader(void) {
+    pthread_mutex_lock(&configuration_lock);
+
+    if (configuration_reader_count == CONFIGURATION_MAX_READERS) {
+        fatal_error("[Error] %s\n", "Too many configuration readers");
+    }
+
+    size_t reader = configuration_reader_count++;
+    atomic_store_explicit(&configuration_reader_epochs[reader], current_server_configuration()->epoch, memory_order_release);
+
+    pthread_mutex_unlock(&configuration_lock);
+
+    return reader;
+}
+
+/**
+ * Report that a reader is done with every configuration
+ * older than the one given.
+ *
+ * @details This is called on every pass through an event
+ * loop, and costs a single load and comparison unless the
+ * reader has just moved on to a new configuration.
+ *
+ */
+void configuration_quiescent_state(size_t reader, const struct configuration_options_t* configuration_options) {
+    if (atomic_load_explicit(&configuration_reader_epochs[reader], memory_order_relaxed) == configuration_options->epoch) {
+        return;
+    }
+
+    pthread_mutex_lock(&configuration_lock);
+    atomic_store_explicit(&configuration_reader_epochs[reader], configuration_options->epoch, memory_order_release);
+    reclaim_retired_configurations();
+    pthread_mutex_unlock(&configuration_lock);
+}
@@ -0,0 +1,156 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <unistd.h>
+
+#include "serverd.h"
+#include "connection.h"
+#include "error.h"
+#include "memory.h"
+
+/**
+ * Create an empty connection pool.
+ *
+ */
+struct connection_slab_t* create_connection_slab(void) {
+    struct connection_slab_t* slab = allocate_tagged_memory(MEMORY_TAG_CONNECTIONS, sizeof (struct connection_slab_t));
+
+    slab->free_list = NULL;
+    slab->registry = NULL;
+    slab->registry_size = 0;
+    slab->open_count = 0;
+    slab->next_generation = 0;
+
+    return slab;
+}
+
+/**
+ * Carve a new slab of connections onto the free list.
+ *
+ */
+static void grow_connection_slab(struct connection_slab_t* slab) {
+    struct connection_t* connections = NULL;
+
+    if (posix_memalign((void **) &connections, _Alignof (struct connection_t), sizeof (struct connection_t) * CONNECTION_SLAB_SIZE) != 0) {
+        fatal_error("[Error] %s\n", "Memory allocation failure in call to posix_memalign()");
+    }
+
+    account_memory(MEMORY_TAG_CONNECTIONS, (long long) (sizeof (struct connection_t) * CONNECTION_SLAB_SIZE));
+
+    memset(connections, 0, sizeof (struct connection_t) * CONNECTION_SLAB_SIZE);
+
+    for (size_t i = CONNECTION_SLAB_SIZE; i > 0; --i) {
+        connections[i - 1].fd = -1;
+        connections[i - 1].next_free = slab->free_list;
+        slab->free_list = &connections[i - 1];
+    }
+}
+
+/**
+ * Make sure the registry has a slot for a descriptor.
+ *
+ */
+static void grow_connection_registry(struct connection_slab_t* slab, int fd) {
+    size_t size = slab->registry_size ? slab->registry_size : CONNECTION_SLAB_SIZE;
+
+    while (size <= (size_t) fd) {
+        size *= 2;
+    }
+
+    struct connection_t** registry = allocate_tagged_memory(MEMORY_TAG_CONNECTIONS, sizeof (struct connection_t *) * size);
+    memset(registry, 0, sizeof (struct connection_t *) * size);
+
+    if (slab->registry) {
+        memcpy(registry, slab->registry, sizeof (struct connection_t *) * slab->registry_size);
+        FREE(slab->registry);
+    }
+
+    slab->registry = registry;
+    slab->registry_size = size;
+}
+
+/**
+ * Take a connection for a newly accepted socket, and
+ * register it under the socket's descriptor.
+ *
+ */
+struct connection_t* open_connection(struct connection_slab_t* slab, int fd) {
+    if (slab->free_list == NULL) {
+        grow_connection_slab(slab);
+    }
+
+    if ((size_t) fd >= slab->registry_size) {
+        grow_connection_registry(slab, fd);
+    }
+
+    struct connection_t* connection = slab->free_list;
+    slab->free_list = connection->next_free;
+
+    connection->fd = fd;
+    connection->generation = slab->next_generation++;
+    connection->next_free = NULL;
+
+    slab->registry[fd] = connection;
+    slab->open_count++;
+
+    return connection;
+}
+
+/**
+ * Close a connection's socket and return the connection to
+ * the pool.
+ *
+ */
+void close_connection(struct connection_slab_t* slab, struct connection_t* connection) {
+    slab->registry[connection->fd] = NULL;
+    slab->open_count--;
+
+    close(connection->fd);
+
+    connection->fd = -1;
+    connection->next_free = slab->free_list;
+    slab->free_list = connection;
+}
+
+/**
+ * Find the connection an event token refers to.
+ *
+ */
+struct connection_t* lookup_connection(const struct connection_slab_t* slab, uint64_t token) {
+    uint32_t fd = (uint32_t) token;
+
+    if (fd >= slab->registry_size) {
+        return NULL;
+    }
+
+    struct connection_t* connection = slab->registry[fd];
+
+    if ((connection == NULL) || (connection->generation != (uint32_t) (token >> 32))) {
+        return NULL;
+    }
+
+    return connection;
+}
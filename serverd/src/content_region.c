@@ -0,0 +1,316 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include <unistd.h>
+#include <syslog.h>
+
+#include <sys/mman.h>
+
+#include "serverd.h"
+#include "config.h"
+#include "content_region.h"
+#include "error.h"
+#include "memory.h"
+
+/**
+ * @def CONTENT_REGION_MAX_ORDERS
+ * @brief Number of block sizes the buddy allocator tracks.
+ *
+ */
+#ifndef CONTENT_REGION_MAX_ORDERS
+#define CONTENT_REGION_MAX_ORDERS (48)
+#endif
+
+/**
+ * Markers in the block order map.
+ *
+ * @details The map holds one byte per minimum-sized block.
+ * The byte for the first minimum block of every block holds
+ * its order, with CONTENT_BLOCK_FREE set while the block is
+ * on a free list. All other bytes are CONTENT_BLOCK_INTERIOR.
+ *
+ */
+#define CONTENT_BLOCK_FREE     (0x80)
+#define CONTENT_BLOCK_INTERIOR (0xFF)
+
+/**
+ * A free block.
+ *
+ * @details Free blocks are linked through their own first
+ * bytes, so the free lists cost no memory of their own.
+ *
+ */
+struct content_block_t {
+    struct content_block_t* next;
+    struct content_block_t* prev;
+};
+
+struct content_region_t {
+    unsigned char* base;
+    size_t capacity;
+    size_t mapping_size;
+    size_t used;
+    enum content_region_backing_t backing;
+
+    uint8_t* orders;
+    struct content_block_t* free_lists[CONTENT_REGION_MAX_ORDERS];
+};
+
+static size_t content_block_size(unsigned order) {
+    return (size_t) 1 << (CONTENT_REGION_MIN_BLOCK_SHIFT + order);
+}
+
+static size_t content_block_index(const struct content_region_t* region, const void* block) {
+    return (size_t) ((const unsigned char *) block - region->base) >> CONTENT_REGION_MIN_BLOCK_SHIFT;
+}
+
+static void push_free_block(struct content_region_t* region, void* memory, unsigned order) {
+    struct content_block_t* block = memory;
+
+    block->prev = NULL;
+    block->next = region->free_lists[order];
+
+    if (block->next) {
+        block->next->prev = block;
+    }
+
+    region->free_lists[order] = block;
+    region->orders[content_block_index(region, block)] = (uint8_t) (CONTENT_BLOCK_FREE | order);
+}
+
+static void unlink_free_block(struct content_region_t* region, struct content_block_t* block, unsigned order) {
+    if (block->prev) {
+        block->prev->next = block->next;
+    } else {
+        region->free_lists[order] = block->next;
+    }
+
+    if (block->next) {
+        block->next->prev = block->prev;
+    }
+}
+
+/**
+ * Map the region's memory.
+ *
+ */
+static void* map_content_region(size_t mapping_size, size_t page_size, enum content_region_backing_t* backing) {
+    size_t base_page_size = (size_t) sysconf(_SC_PAGESIZE);
+
+    if (page_size > base_page_size) {
+        int page_shift = __builtin_ctzll(page_size);
+        void* memory = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (page_shift << MAP_HUGE_SHIFT), -1, 0);
+
+        if (memory != MAP_FAILED) {
+            *backing = CONTENT_REGION_HUGETLB;
+            return memory;
+        }
+
+        syslog(LOG_NOTICE, "No reserved huge pages for the content cache (%s), falling back to transparent huge pages", strerror(errno));
+    }
+
+    void* memory = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+    if (memory == MAP_FAILED) {
+        fatal_error("[Error] %s: %s\n", "Could not map content cache", strerror(errno));
+    }
+
+    *backing = CONTENT_REGION_SMALL_PAGES;
+
+    if ((page_size > base_page_size) && (madvise(memory, mapping_size, MADV_HUGEPAGE) == 0)) {
+        *backing = CONTENT_REGION_TRANSPARENT_HUGEPAGES;
+    }
+
+    return memory;
+}
+
+/**
+ * Map a region for cached file contents.
+ *
+ */
+struct content_region_t* create_content_region(size_t capacity, size_t page_size) {
+    struct content_region_t* region = allocate_tagged_memory(MEMORY_TAG_CACHES, sizeof (struct content_region_t));
+    memset(region, 0, sizeof (struct content_region_t));
+
+    region->backing = CONTENT_REGION_DISABLED;
+
+    if (capacity < content_block_size(0)) {
+        return region;
+    }
+
+    if ((page_size == 0) || (page_size & (page_size - 1))) {
+        fatal_error("[Error] %s\n", "The content cache page size must be a power of two");
+    }
+
+    region->mapping_size = (capacity + page_size - 1) & ~(page_size - 1);
+    region->base = map_content_region(region->mapping_size, page_size, &region->backing);
+    region->capacity = region->mapping_size & ~(content_block_size(0) - 1);
+
+    size_t block_count = region->capacity >> CONTENT_REGION_MIN_BLOCK_SHIFT;
+    region->orders = allocate_tagged_memory(MEMORY_TAG_CACHES, block_count);
+    memset(region->orders, CONTENT_BLOCK_INTERIOR, block_count);
+
+    /**
+     * Carve the region into the largest naturally aligned
+     * blocks that fit, so a capacity that is not a power of
+     * two loses nothing.
+     *
+     */
+    size_t offset = 0;
+
+    while (offset + content_block_size(0) <= region->capacity) {
+        unsigned order = 0;
+
+        while ((order + 1 < CONTENT_REGION_MAX_ORDERS) && ((offset & (content_block_size(order + 1) - 1)) == 0) && (offset + content_block_size(order + 1) <= region->capacity)) {
+            ++order;
+        }
+
+        push_free_block(region, region->base + offset, order);
+        offset += content_block_size(order);
+    }
+
+    static const char* const backing_names[] = {
+        [CONTENT_REGION_DISABLED]              = "disabled",
+        [CONTENT_REGION_HUGETLB]               = "huge pages",
+        [CONTENT_REGION_TRANSPARENT_HUGEPAGES] = "transparent huge pages",
+        [CONTENT_REGION_SMALL_PAGES]           = "small pages"
+    };
+
+    syslog(LOG_NOTICE, "Content cache: %zu bytes backed by %s", region->capacity, backing_names[region->backing]);
+
+    return region;
+}
+
+/**
+ * Allocate a block of the content region.
+ *
+ */
+void* allocate_content(struct content_region_t* region, size_t size) {
+    if (region->base == NULL) {
+        return NULL;
+    }
+
+    unsigned order = 0;
+
+    while ((order < CONTENT_REGION_MAX_ORDERS) && (content_block_size(order) < size)) {
+        ++order;
+    }
+
+    unsigned available = order;
+
+    while ((available < CONTENT_REGION_MAX_ORDERS) && (region->free_lists[available] == NULL)) {
+        ++available;
+    }
+
+    if (available >= CONTENT_REGION_MAX_ORDERS) {
+        return NULL;
+    }
+
+    struct content_block_t* block = region->free_lists[available];
+    unlink_free_block(region, block, available);
+
+    /**
+     * Split the block down to the requested size, putting
+     * the upper halves back on the free lists.
+     *
+     */
+    while (available > order) {
+        --available;
+        push_free_block(region, (unsigned char *) block + content_block_size(available), available);
+    }
+
+    region->orders[content_block_index(region, block)] = (uint8_t) order;
+    region->used += content_block_size(order);
+    account_memory(MEMORY_TAG_CACHES, (long long) content_block_size(order));
+
+    return block;
+}
+
+/**
+ * Return a block to the content region.
+ *
+ */
+void free_content(struct content_region_t* region, void* block) {
+    if (block == NULL) {
+        return;
+    }
+
+    size_t index = content_block_index(region, block);
+    unsigned order = region->orders[index];
+    size_t offset = (size_t) ((unsigned char *) block - region->base);
+
+    region->used -= content_block_size(order);
+    account_memory(MEMORY_TAG_CACHES, -(long long) content_block_size(order));
+    region->orders[index] = CONTENT_BLOCK_INTERIOR;
+
+    /**
+     * Merge the block with its buddy for as long as the
+     * buddy is free and whole.
+     *
+     */
+    while (order + 1 < CONTENT_REGION_MAX_ORDERS) {
+        size_t buddy_offset = offset ^ content_block_size(order);
+
+        if (buddy_offset + content_block_size(order) > region->capacity) {
+            break;
+        }
+
+        size_t buddy_index = buddy_offset >> CONTENT_REGION_MIN_BLOCK_SHIFT;
+
+        if (region->orders[buddy_index] != (CONTENT_BLOCK_FREE | order)) {
+            break;
+        }
+
+        unlink_free_block(region, (struct content_block_t *) (region->base + buddy_offset), order);
+        region->orders[buddy_index] = CONTENT_BLOCK_INTERIOR;
+
+        offset &= ~content_block_size(order);
+        ++order;
+    }
+
+    push_free_block(region, region->base + offset, order);
+}
+
+/**
+ * Return how the region's memory is backed.
+ *
+ */
+enum content_region_backing_t content_region_backing(const struct content_region_t* region) {
+    return region->backing;
+}
+
+/**
+ * Return the bytes allocated from the region, and its
+ * capacity.
+ *
+ */
+void content_region_usage(const struct content_region_t* region, size_t* used, size_t* capacity) {
+    *used = region->used;
+    *capacity = region->capacity;
+}
@@ -0,0 +1,173 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "serverd.h"
+#include "content_region.h"
+#include "content_store.h"
+#include "memory.h"
+#include "perfect_hash.h"
+
+#define CONTENT_HASH_PRIME_1 (0x9E3779B185EBCA87ULL)
+#define CONTENT_HASH_PRIME_2 (0xC2B2AE3D27D4EB4FULL)
+#define CONTENT_HASH_PRIME_3 (0x165667B19E3779F9ULL)
+
+static inline uint64_t rotate_left(uint64_t x, unsigned bits) {
+    return (x << bits) | (x >> (64 - bits));
+}
+
+static inline uint64_t read_word(const unsigned char* data) {
+    uint64_t word;
+    memcpy(&word, data, sizeof (word));
+    return word;
+}
+
+static inline uint64_t content_hash_round(uint64_t lane, uint64_t word) {
+    return rotate_left(lane + word * CONTENT_HASH_PRIME_2, 31) * CONTENT_HASH_PRIME_1;
+}
+
+/**
+ * Hash a body.
+ *
+ */
+uint64_t hash_content(const void* data, size_t length) {
+    const unsigned char* bytes = data;
+    const unsigned char* end = bytes + length;
+
+    uint64_t lanes[4] = {
+        CONTENT_HASH_PRIME_1 + CONTENT_HASH_PRIME_2,
+        CONTENT_HASH_PRIME_2,
+        0,
+        -CONTENT_HASH_PRIME_1
+    };
+
+    while (end - bytes >= 32) {
+        for (unsigned i = 0; i < 4; ++i) {
+            lanes[i] = content_hash_round(lanes[i], read_word(bytes + i * 8));
+        }
+
+        bytes += 32;
+    }
+
+    uint64_t hash = rotate_left(lanes[0], 1) + rotate_left(lanes[1], 7) + rotate_left(lanes[2], 12) + rotate_left(lanes[3], 18);
+    hash += (uint64_t) length;
+
+    while (end - bytes >= 8) {
+        hash = rotate_left(hash ^ content_hash_round(0, read_word(bytes)), 27) * CONTENT_HASH_PRIME_1 + CONTENT_HASH_PRIME_3;
+        bytes += 8;
+    }
+
+    while (bytes < end) {
+        hash = rotate_left(hash ^ (*bytes++ * CONTENT_HASH_PRIME_3), 11) * CONTENT_HASH_PRIME_1;
+    }
+
+    return perfect_hash_mix(hash);
+}
+
+/**
+ * Create a store for bodies allocated from a content region.
+ *
+ */
+struct content_store_t* create_content_store(struct content_region_t* region, size_t expected_bodies) {
+    size_t bucket_count = 1;
+
+    while (bucket_count < expected_bodies) {
+        bucket_count <<= 1;
+    }
+
+    struct content_store_t* store = allocate_tagged_memory(MEMORY_TAG_CACHES, sizeof (struct content_store_t));
+    store->region = region;
+    store->buckets = allocate_tagged_memory(MEMORY_TAG_CACHES, sizeof (struct content_body_t *) * bucket_count);
+    store->bucket_mask = bucket_count - 1;
+    store->body_count = 0;
+    store->stored_bytes = 0;
+    store->referenced_bytes = 0;
+
+    memset(store->buckets, 0, sizeof (struct content_body_t *) * bucket_count);
+
+    return store;
+}
+
+/**
+ * Add a body to the store.
+ *
+ */
+struct content_body_t* intern_content(struct content_store_t* store, void* data, size_t length, uint64_t hash) {
+    struct content_body_t** bucket = &store->buckets[hash & store->bucket_mask];
+
+    store->referenced_bytes += length;
+
+    for (struct content_body_t* body = *bucket; body; body = body->hash_next) {
+        if ((body->hash == hash) && (body->length == length) && (memcmp(body->data, data, length) == 0)) {
+            free_content(store->region, data);
+            body->references++;
+            return body;
+        }
+    }
+
+    struct content_body_t* body = allocate_tagged_memory(MEMORY_TAG_CACHES, sizeof (struct content_body_t));
+    body->data = data;
+    body->length = length;
+    body->hash = hash;
+    body->references = 1;
+    body->hash_next = *bucket;
+    *bucket = body;
+
+    store->body_count++;
+    store->stored_bytes += length;
+
+    return body;
+}
+
+/**
+ * Drop one reference to a body.
+ *
+ */
+void release_content(struct content_store_t* store, struct content_body_t* body) {
+    if (body == NULL) {
+        return;
+    }
+
+    store->referenced_bytes -= body->length;
+
+    if (--body->references > 0) {
+        return;
+    }
+
+    struct content_body_t** link = &store->buckets[body->hash & store->bucket_mask];
+
+    while (*link != body) {
+        link = &(*link)->hash_next;
+    }
+
+    *link = body->hash_next;
+
+    store->body_count--;
+    store->stored_bytes -= body->length;
+
+    free_content(store->region, body->data);
+    FREE(body);
+}
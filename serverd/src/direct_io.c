@@ -0,0 +1,154 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "serverd.h"
+#include "direct_io.h"
+#include "error.h"
+#include "memory.h"
+
+/**
+ * Create a pool of up to capacity idle buffers.
+ *
+ */
+struct direct_buffer_pool_t* create_direct_buffer_pool(size_t capacity, size_t buffer_size) {
+    struct direct_buffer_pool_t* pool = allocate_tagged_memory(MEMORY_TAG_BUFFERS, sizeof (struct direct_buffer_pool_t));
+
+    if (buffer_size == 0) {
+        buffer_size = DIRECT_IO_ALIGNMENT;
+    }
+
+    pool->free_list = NULL;
+    pool->free_count = 0;
+    pool->capacity = capacity;
+    pool->buffer_size = (buffer_size + DIRECT_IO_ALIGNMENT - 1) & ~((size_t) DIRECT_IO_ALIGNMENT - 1);
+
+    return pool;
+}
+
+/**
+ * Take a buffer from the pool, allocating one if necessary.
+ *
+ * @details Idle buffers are kept on a free list threaded
+ * through their first bytes.
+ *
+ */
+void* acquire_direct_buffer(struct direct_buffer_pool_t* pool) {
+    void* buffer = pool->free_list;
+
+    if (buffer) {
+        memcpy(&pool->free_list, buffer, sizeof (void *));
+        pool->free_count--;
+        return buffer;
+    }
+
+    if (posix_memalign(&buffer, DIRECT_IO_ALIGNMENT, pool->buffer_size) != 0) {
+        fatal_error("[Error] %s\n", "Memory allocation failure in call to posix_memalign()");
+    }
+
+    account_memory(MEMORY_TAG_BUFFERS, (long long) pool->buffer_size);
+
+    return buffer;
+}
+
+/**
+ * Return a buffer to the pool.
+ *
+ */
+void release_direct_buffer(struct direct_buffer_pool_t* pool, void* buffer) {
+    if (buffer == NULL) {
+        return;
+    }
+
+    if (pool->free_count < pool->capacity) {
+        memcpy(buffer, &pool->free_list, sizeof (void *));
+        pool->free_list = buffer;
+        pool->free_count++;
+        return;
+    }
+
+    account_memory(MEMORY_TAG_BUFFERS, -(long long) pool->buffer_size);
+
+    free(buffer);
+}
+
+/**
+ * Switch an open file to direct I/O.
+ *
+ */
+int enable_direct_io(int fd) {
+    int flags = fcntl(fd, F_GETFL);
+
+    if (flags == -1) {
+        return FALSE;
+    }
+
+    return fcntl(fd, F_SETFL, flags | O_DIRECT) == 0;
+}
+
+/**
+ * Read a chunk of a file that bypasses the page cache.
+ *
+ */
+ssize_t read_file_chunk(int fd, void* buffer, off_t offset, size_t length, int direct, int drop_cache) {
+    size_t total = 0;
+
+    while (total < length) {
+        ssize_t bytes_read = pread(fd, (char *) buffer + total, length - total, offset + (off_t) total);
+
+        if (bytes_read == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return (total == 0) ? -1 : (ssize_t) total;
+        }
+
+        if (bytes_read == 0) {
+            break;
+        }
+
+        total += (size_t) bytes_read;
+
+        /**
+         * A direct read only comes up short at end of file,
+         * and the next read would be misaligned anyway.
+         *
+         */
+        if (direct && (((size_t) bytes_read % DIRECT_IO_ALIGNMENT) != 0)) {
+            break;
+        }
+    }
+
+    if (!direct && drop_cache && (total > 0)) {
+        posix_fadvise(fd, offset, (off_t) total, POSIX_FADV_DONTNEED);
+    }
+
+    return (ssize_t) total;
+}
@@ -0,0 +1,479 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <unistd.h>
+#include <dirent.h>
+
+#include "serverd.h"
+#include "io_buffer.h"
+#include "memory.h"
+#include "perfect_hash.h"
+#include "directory_listing.h"
+
+/**
+ * @def DIRECTORY_LISTING_READ_BUFFER_SIZE
+ * @brief Size of the getdents64(2) buffer, in bytes.
+ *
+ * @details A larger buffer means fewer system calls for
+ * very large directories. At roughly 32 bytes per entry,
+ * this reads around two thousand entries per call.
+ *
+ */
+#ifndef DIRECTORY_LISTING_READ_BUFFER_SIZE
+#define DIRECTORY_LISTING_READ_BUFFER_SIZE (64 * 1024)
+#endif
+
+/**
+ * @def DIRECTORY_LISTING_CACHE_WAYS
+ * @brief Associativity of the rendered listing cache.
+ *
+ */
+#ifndef DIRECTORY_LISTING_CACHE_WAYS
+#define DIRECTORY_LISTING_CACHE_WAYS (4)
+#endif
+
+/**
+ * A growable byte buffer used while rendering.
+ *
+ */
+struct listing_buffer_t {
+    char* data;
+    size_t length;
+    size_t capacity;
+};
+
+static void reserve_listing_buffer(struct listing_buffer_t* buffer, size_t additional) {
+    if (buffer->length + additional <= buffer->capacity) {
+        return;
+    }
+
+    size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+
+    while (capacity < buffer->length + additional) {
+        capacity *= 2;
+    }
+
+    char* data = allocate_tagged_memory(MEMORY_TAG_CACHES, capacity);
+
+    if (buffer->data) {
+        memcpy(data, buffer->data, buffer->length);
+        FREE(buffer->data);
+    }
+
+    buffer->data = data;
+    buffer->capacity = capacity;
+}
+
+static void append_bytes(struct listing_buffer_t* buffer, const char* data, size_t length) {
+    reserve_listing_buffer(buffer, length);
+    memcpy(buffer->data + buffer->length, data, length);
+    buffer->length += length;
+}
+
+static void append_string(struct listing_buffer_t* buffer, const char* string) {
+    append_bytes(buffer, string, strlen(string));
+}
+
+/**
+ * Append text with the HTML special characters escaped.
+ *
+ */
+static void append_html_escaped(struct listing_buffer_t* buffer, const char* text, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        switch (text[i]) {
+            case '&': append_string(buffer, "&amp;"); break;
+            case '<': append_string(buffer, "&lt;"); break;
+            case '>': append_string(buffer, "&gt;"); break;
+            case '"': append_string(buffer, "&quot;"); break;
+            case '\'': append_string(buffer, "&#39;"); break;
+            default: append_bytes(buffer, &text[i], 1); break;
+        }
+    }
+}
+
+/**
+ * Append a file name percent-encoded for use in a URL.
+ *
+ */
+static void append_url_encoded(struct listing_buffer_t* buffer, const char* text, size_t length) {
+    static const char hex[] = "0123456789ABCDEF";
+
+    for (size_t i = 0; i < length; ++i) {
+        unsigned char c = (unsigned char) text[i];
+
+        if (((c >= 'A') && (c <= 'Z')) || ((c >= 'a') && (c <= 'z')) || ((c >= '0') && (c <= '9')) || (c == '-') || (c == '_') || (c == '.') || (c == '~')) {
+            append_bytes(buffer, (const char *) &c, 1);
+        } else {
+            char encoded[3] = { '%', hex[c >> 4], hex[c & 0x0F] };
+            append_bytes(buffer, encoded, 3);
+        }
+    }
+}
+
+/**
+ * Append text escaped for use inside a JSON string.
+ *
+ */
+static void append_json_escaped(struct listing_buffer_t* buffer, const char* text, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        unsigned char c = (unsigned char) text[i];
+
+        if ((c == '"') || (c == '\\')) {
+            char escaped[2] = { '\\', (char) c };
+            append_bytes(buffer, escaped, 2);
+        } else if (c < 0x20) {
+            char escaped[8];
+            int n = snprintf(escaped, sizeof (escaped), "\\u%04x", c);
+            append_bytes(buffer, escaped, (size_t) n);
+        } else {
+            append_bytes(buffer, (const char *) &c, 1);
+        }
+    }
+}
+
+/**
+ * A single directory entry collected from getdents64(2).
+ *
+ * @details Entry names are stored back to back in a single
+ * name buffer, and each entry refers to its name by offset,
+ * so collecting tens of thousands of entries costs a
+ * handful of allocations rather than one per entry.
+ *
+ */
+struct listing_entry_t {
+    size_t name_offset;
+    size_t name_length;
+    int is_directory;
+};
+
+/**
+ * The name buffer the sort comparator reads from.
+ *
+ * @details qsort(3) has no context argument, and the
+ * rendering runs on the file I/O pool, so this is
+ * thread-local rather than a plain static.
+ *
+ */
+static _Thread_local const char* listing_names;
+
+static int compare_listing_entries(const void* a, const void* b) {
+    const struct listing_entry_t* x = a;
+    const struct listing_entry_t* y = b;
+
+    if (x->is_directory != y->is_directory) {
+        return y->is_directory - x->is_directory;
+    }
+
+    return strcmp(listing_names + x->name_offset, listing_names + y->name_offset);
+}
+
+/**
+ * Render a complete directory listing response.
+ *
+ */
+char* render_directory_listing(int directory_fd, const char* request_path, enum directory_listing_format_t format, size_t* length) {
+    if (lseek(directory_fd, 0, SEEK_SET) == -1) {
+        return NULL;
+    }
+
+    char* read_buffer = acquire_io_buffer(DIRECTORY_LISTING_READ_BUFFER_SIZE);
+    struct listing_buffer_t names = { NULL, 0, 0 };
+
+    size_t entry_count = 0;
+    size_t entry_capacity = 256;
+    struct listing_entry_t* entries = allocate_tagged_memory(MEMORY_TAG_CACHES, sizeof (struct listing_entry_t) * entry_capacity);
+
+    /**
+     * Collect every visible entry in a single pass over
+     * the directory. We deliberately do not stat(2) each
+     * entry; the file type reported by getdents64(2) is
+     * enough to tell subdirectories apart.
+     *
+     */
+    while (TRUE) {
+        ssize_t bytes_read = getdents64(directory_fd, read_buffer, DIRECTORY_LISTING_READ_BUFFER_SIZE);
+
+        if (bytes_read == -1) {
+            int error = errno;
+            FREE(entries);
+            FREE(names.data);
+            release_io_buffer(read_buffer, DIRECTORY_LISTING_READ_BUFFER_SIZE);
+            errno = error;
+            return NULL;
+        }
+
+        if (bytes_read == 0) {
+            break;
+        }
+
+        for (ssize_t offset = 0; offset < bytes_read; ) {
+            const struct dirent64* entry = (const struct dirent64 *) (read_buffer + offset);
+            offset += entry->d_reclen;
+
+            if (entry->d_name[0] == '.') {
+                continue;
+            }
+
+            if (entry_count == entry_capacity) {
+                struct listing_entry_t* grown = allocate_tagged_memory(MEMORY_TAG_CACHES, sizeof (struct listing_entry_t) * entry_capacity * 2);
+                memcpy(grown, entries, sizeof (struct listing_entry_t) * entry_capacity);
+                FREE(entries);
+                entries = grown;
+                entry_capacity *= 2;
+            }
+
+            size_t name_length = strlen(entry->d_name);
+
+            entries[entry_count].name_offset = names.length;
+            entries[entry_count].name_length = name_length;
+            entries[entry_count].is_directory = (entry->d_type == DT_DIR);
+            ++entry_count;
+
+            append_bytes(&names, entry->d_name, name_length + 1);
+        }
+    }
+
+    release_io_buffer(read_buffer, DIRECTORY_LISTING_READ_BUFFER_SIZE);
+
+    listing_names = names.data;
+    qsort(entries, entry_count, sizeof (struct listing_entry_t), compare_listing_entries);
+
+    struct listing_buffer_t body = { NULL, 0, 0 };
+    size_t path_length = strlen(request_path);
+
+    if (format == DIRECTORY_LISTING_JSON) {
+        append_string(&body, "[");
+
+        for (size_t i = 0; i < entry_count; ++i) {
+            append_string(&body, (i == 0) ? "\n  {\"name\":\"" : ",\n  {\"name\":\"");
+            append_json_escaped(&body, names.data + entries[i].name_offset, entries[i].name_length);
+            append_string(&body, entries[i].is_directory ? "\",\"type\":\"directory\"}" : "\",\"type\":\"file\"}");
+        }
+
+        append_string(&body, "\n]\n");
+    } else {
+        append_string(&body, "<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"utf-8\">\n<title>Index of ");
+        append_html_escaped(&body, request_path, path_length);
+        append_string(&body, "</title>\n</head>\n<body>\n<h1>Index of ");
+        append_html_escaped(&body, request_path, path_length);
+        append_string(&body, "</h1>\n<hr>\n<ul>\n");
+
+        if (strcmp(request_path, "/") != 0) {
+            append_string(&body, "<li><a href=\"../\">../</a></li>\n");
+        }
+
+        for (size_t i = 0; i < entry_count; ++i) {
+            const char* name = names.data + entries[i].name_offset;
+            const char* suffix = entries[i].is_directory ? "/" : "";
+
+            append_string(&body, "<li><a href=\"");
+            append_url_encoded(&body, name, entries[i].name_length);
+            append_string(&body, suffix);
+            append_string(&body, "\">");
+            append_html_escaped(&body, name, entries[i].name_length);
+            append_string(&body, suffix);
+            append_string(&body, "</a></li>\n");
+        }
+
+        append_string(&body, "</ul>\n<hr>\n</body>\n</html>\n");
+    }
+
+    FREE(entries);
+    FREE(names.data);
+
+    /**
+     * Prepend the response headers, so that a cached listing
+     * can be sent with a single write.
+     *
+     */
+    char headers[256];
+    int headers_length = snprintf(headers, sizeof (headers),
+        "HTTP/1.1 200 OK\r\n"
+        "Connection: Close\r\n"
+        "Content-Type: %s\r\n"
+        "Content-Length: %zu\r\n"
+        "\r\n",
+        (format == DIRECTORY_LISTING_JSON) ? "application/json" : "text/html; charset=utf-8",
+        body.length);
+
+    struct listing_buffer_t response = { NULL, 0, 0 };
+    reserve_listing_buffer(&response, (size_t) headers_length + body.length);
+    append_bytes(&response, headers, (size_t) headers_length);
+    append_bytes(&response, body.data, body.length);
+
+    FREE(body.data);
+
+    *length = response.length;
+    return response.data;
+}
+
+/**
+ * A cached rendered listing.
+ *
+ */
+struct directory_listing_cache_entry_t {
+    struct directory_listing_key_t key;
+    char* rendered;
+    size_t length;
+    uint64_t last_used;
+};
+
+/**
+ * A set-associative cache of rendered listings.
+ *
+ * @details Each directory maps to one set, and within a set
+ * the least recently used entry is replaced. This bounds
+ * both the lookup cost and the number of listings held.
+ *
+ */
+struct directory_listing_cache_t {
+    struct directory_listing_cache_entry_t* entries;
+    size_t set_mask;
+    uint64_t clock;
+};
+
+/**
+ * Create a directory listing cache.
+ *
+ */
+struct directory_listing_cache_t* create_directory_listing_cache(size_t capacity) {
+    size_t set_count = 1;
+
+    while (set_count * DIRECTORY_LISTING_CACHE_WAYS < capacity) {
+        set_count <<= 1;
+    }
+
+    size_t entry_count = set_count * DIRECTORY_LISTING_CACHE_WAYS;
+
+    struct directory_listing_cache_t* cache = allocate_tagged_memory(MEMORY_TAG_CACHES, sizeof (struct directory_listing_cache_t));
+    cache->entries = allocate_tagged_memory(MEMORY_TAG_CACHES, sizeof (struct directory_listing_cache_entry_t) * entry_count);
+    cache->set_mask = set_count - 1;
+    cache->clock = 0;
+
+    memset(cache->entries, 0, sizeof (struct directory_listing_cache_entry_t) * entry_count);
+
+    return cache;
+}
+
+/**
+ * Return the first entry of the set a directory maps to.
+ *
+ */
+static struct directory_listing_cache_entry_t* directory_listing_set(struct directory_listing_cache_t* cache, const struct directory_listing_key_t* key) {
+    uint64_t hash = perfect_hash_mix(key->inode ^ perfect_hash_mix(key->device + (uint64_t) key->format));
+    return &cache->entries[(hash & cache->set_mask) * DIRECTORY_LISTING_CACHE_WAYS];
+}
+
+/**
+ * Check whether a cache entry was rendered for this directory
+ * and format, regardless of its modification time.
+ *
+ */
+static int is_same_directory_listing(const struct directory_listing_key_t* a, const struct directory_listing_key_t* b) {
+    return (a->inode == b->inode) && (a->device == b->device) && (a->format == b->format) && (strcmp(a->request_path, b->request_path) == 0);
+}
+
+/**
+ * Look up a rendered listing.
+ *
+ */
+const char* lookup_directory_listing(struct directory_listing_cache_t* cache, const struct directory_listing_key_t* key, size_t* length) {
+    struct directory_listing_cache_entry_t* set = directory_listing_set(cache, key);
+
+    for (size_t way = 0; way < DIRECTORY_LISTING_CACHE_WAYS; ++way) {
+        struct directory_listing_cache_entry_t* entry = &set[way];
+
+        if ((entry->rendered == NULL) || !is_same_directory_listing(&entry->key, key)) {
+            continue;
+        }
+
+        if ((entry->key.mtime_seconds != key->mtime_seconds) || (entry->key.mtime_nanoseconds != key->mtime_nanoseconds)) {
+            return NULL;
+        }
+
+        entry->last_used = ++cache->clock;
+        *length = entry->length;
+        return entry->rendered;
+    }
+
+    return NULL;
+}
+
+/**
+ * Store a rendered listing in the cache.
+ *
+ */
+void insert_directory_listing(struct directory_listing_cache_t* cache, const struct directory_listing_key_t* key, char* rendered, size_t length) {
+    struct directory_listing_cache_entry_t* set = directory_listing_set(cache, key);
+    struct directory_listing_cache_entry_t* victim = &set[0];
+
+    for (size_t way = 0; way < DIRECTORY_LISTING_CACHE_WAYS; ++way) {
+        struct directory_listing_cache_entry_t* entry = &set[way];
+
+        if ((entry->rendered != NULL) && is_same_directory_listing(&entry->key, key)) {
+            victim = entry;
+            break;
+        }
+
+        if ((entry->rendered == NULL) || ((victim->rendered != NULL) && (entry->last_used < victim->last_used))) {
+            victim = entry;
+        }
+    }
+
+    if (victim->rendered) {
+        FREE(victim->rendered);
+        safe_free((void **) &victim->key.request_path);
+    }
+
+    size_t path_length = strlen(key->request_path);
+    char* request_path = allocate_tagged_memory(MEMORY_TAG_CACHES, path_length + 1);
+    memcpy(request_path, key->request_path, path_length + 1);
+
+    victim->key = *key;
+    victim->key.request_path = request_path;
+    victim->rendered = rendered;
+    victim->length = length;
+    victim->last_used = ++cache->clock;
+}
+
+/**
+ * Drop every cached listing.
+ *
+ */
+void clear_directory_listing_cache(struct directory_listing_cache_t* cache) {
+    size_t entry_count = (cache->set_mask + 1) * DIRECTORY_LISTING_CACHE_WAYS;
+
+    for (size_t i = 0; i < entry_count; ++i) {
+        struct directory_listing_cache_entry_t* entry = &cache->entries[i];
+
+        if (entry->rendered) {
+            FREE(entry->rendered);
+            safe_free((void **) &entry->key.request_path);
+        }
+    }
+}
@@ -40,6 +40,15 @@ void fatal_error(const char* format, ...) {
     va_list ap;
     va_start(ap, format);
 
+    vfatal_error(format, ap);
+}
+
+/**
+ * Exit with an error status and message, taking the format
+ * arguments as a va_list.
+ *
+ */
+void vfatal_error(const char* format, va_list ap) {
     for (const char* p = format; *p; ++p) {
         if (*p != '%') {
             putc(*p, stderr);
@@ -68,7 +77,5 @@ void fatal_error(const char* format, ...) {
         }
     }
 
-    va_end(ap);
-
     exit(EXIT_FAILURE);
 }
@@ -0,0 +1,538 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <unistd.h>
+
+#include <sys/stat.h>
+
+#include "serverd.h"
+#include "content_store.h"
+#include "file_cache.h"
+#include "frequency_sketch.h"
+#include "memory.h"
+#include "mime.h"
+#include "perfect_hash.h"
+
+/**
+ * The two queues of the cache.
+ *
+ * @details New entries go on the small queue, unless they
+ * have been requested before; entries that are hit while on
+ * it are promoted to the main queue when they reach its
+ * tail, and the rest are evicted. A crawler's one-off
+ * requests therefore only ever churn the small queue.
+ *
+ */
+enum file_cache_queue_t {
+    FILE_CACHE_SMALL_QUEUE,
+    FILE_CACHE_MAIN_QUEUE
+};
+
+/**
+ * @def FILE_CACHE_SMALL_QUEUE_PERCENT
+ * @brief Share of the cache's entries on the small queue.
+ *
+ */
+#ifndef FILE_CACHE_SMALL_QUEUE_PERCENT
+#define FILE_CACHE_SMALL_QUEUE_PERCENT (10)
+#endif
+
+/**
+ * @def FILE_CACHE_MAX_FREQUENCY
+ * @brief Saturation point of an entry's hit counter.
+ *
+ */
+#ifndef FILE_CACHE_MAX_FREQUENCY
+#define FILE_CACHE_MAX_FREQUENCY (3)
+#endif
+
+/**
+ * A FIFO queue of cache entries.
+ *
+ */
+struct file_cache_queue_list_t {
+    struct file_cache_entry_t* head;
+    struct file_cache_entry_t* tail;
+    size_t count;
+};
+
+/**
+ * The static file cache.
+ *
+ * @details Entries are found through a chained hash table
+ * on the request path, and evicted with S3-FIFO: a small
+ * FIFO queue for new entries in front of a main FIFO queue,
+ * with a two-bit hit counter per entry in place of any list
+ * manipulation on a hit.
+ *
+ * A TinyLFU admission filter sits in front of the queues.
+ * Every lookup, hit or miss, is recorded in a frequency
+ * sketch, and once the cache is full a new file is only
+ * admitted if it has been requested more often than the
+ * entry it would replace. The sketch also stands in for
+ * S3-FIFO's ghost queue: a file that was requested before it
+ * was inserted goes straight onto the main queue.
+ *
+ * The cache belongs to a single event loop, so none of this
+ * needs a lock, and a hit only touches the entry and one
+ * cache line of the sketch.
+ *
+ */
+struct file_cache_t {
+    struct file_cache_entry_t** buckets;
+    size_t bucket_mask;
+
+    struct file_cache_queue_list_t queues[2];
+    struct frequency_sketch_t* sketch;
+
+    size_t entry_count;
+    size_t max_entries;
+    size_t small_queue_target;
+    uint64_t cached_bytes;
+    time_t validity;
+
+    struct content_store_t* content_store;
+};
+
+/**
+ * Return the current time in whole seconds.
+ *
+ * @details The coarse monotonic clock is read from the vDSO
+ * without entering the kernel, and one-second resolution is
+ * all the validity check needs.
+ *
+ */
+static time_t file_cache_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+    return now.tv_sec;
+}
+
+/**
+ * Create a static file cache.
+ *
+ */
+struct file_cache_t* create_file_cache(size_t max_entries, time_t validity, struct content_store_t* content_store) {
+    size_t bucket_count = 1;
+
+    while (bucket_count < max_entries * 2) {
+        bucket_count <<= 1;
+    }
+
+    struct file_cache_t* cache = allocate_tagged_memory(MEMORY_TAG_CACHES, sizeof (struct file_cache_t));
+    cache->buckets = allocate_tagged_memory(MEMORY_TAG_CACHES, sizeof (struct file_cache_entry_t *) * bucket_count);
+    cache->bucket_mask = bucket_count - 1;
+    memset(cache->queues, 0, sizeof (cache->queues));
+    cache->sketch = create_frequency_sketch(max_entries);
+    cache->entry_count = 0;
+    cache->max_entries = max_entries;
+    cache->small_queue_target = (max_entries * FILE_CACHE_SMALL_QUEUE_PERCENT + 99) / 100;
+    cache->cached_bytes = 0;
+    cache->validity = validity;
+    cache->content_store = content_store;
+
+    memset(cache->buckets, 0, sizeof (struct file_cache_entry_t *) * bucket_count);
+
+    return cache;
+}
+
+/**
+ * Format the response headers for a regular file.
+ *
+ */
+size_t build_file_response_header(char* buffer, size_t buffer_size, const char* filename, uint64_t size) {
+    const struct mime_type_t* mime_type = lookup_mime_type(filename);
+
+    int length = snprintf(buffer, buffer_size,
+        "HTTP/1.1 200 OK\r\n"
+        "Connection: Close\r\n"
+        "%s"
+        "Content-Length: %llu\r\n"
+        "\r\n",
+        mime_type->content_type_header,
+        (unsigned long long) size);
+
+    if ((length < 0) || ((size_t) length >= buffer_size)) {
+        return 0;
+    }
+
+    return (size_t) length;
+}
+
+static void unlink_queue_entry(struct file_cache_t* cache, struct file_cache_entry_t* entry) {
+    struct file_cache_queue_list_t* queue = &cache->queues[entry->queue];
+
+    if (entry->queue_prev) {
+        entry->queue_prev->queue_next = entry->queue_next;
+    } else {
+        queue->head = entry->queue_next;
+    }
+
+    if (entry->queue_next) {
+        entry->queue_next->queue_prev = entry->queue_prev;
+    } else {
+        queue->tail = entry->queue_prev;
+    }
+
+    entry->queue_prev = NULL;
+    entry->queue_next = NULL;
+    queue->count--;
+}
+
+static void push_queue_entry(struct file_cache_t* cache, struct file_cache_entry_t* entry, enum file_cache_queue_t queue_index) {
+    struct file_cache_queue_list_t* queue = &cache->queues[queue_index];
+
+    entry->queue = (uint8_t) queue_index;
+    entry->queue_prev = NULL;
+    entry->queue_next = queue->head;
+
+    if (queue->head) {
+        queue->head->queue_prev = entry;
+    } else {
+        queue->tail = entry;
+    }
+
+    queue->head = entry;
+    queue->count++;
+}
+
+/**
+ * Remove an entry from the cache and release it.
+ *
+ */
+static void remove_file_cache_entry(struct file_cache_t* cache, struct file_cache_entry_t* entry) {
+    struct file_cache_entry_t** link = &cache->buckets[entry->path_hash & cache->bucket_mask];
+
+    while (*link != entry) {
+        link = &(*link)->hash_next;
+    }
+
+    *link = entry->hash_next;
+    unlink_queue_entry(cache, entry);
+
+    cache->entry_count--;
+    cache->cached_bytes -= entry->size;
+
+    if (entry->fd != -1) {
+        close(entry->fd);
+    }
+
+    release_content(cache->content_store, entry->content);
+    FREE(entry->header);
+    FREE(entry->path);
+    FREE(entry);
+}
+
+/**
+ * Check whether an entry's file was changed in place since
+ * it was opened.
+ *
+ * @details An entry whose contents are not held in memory is
+ * sent from its descriptor, so the body is whatever the file
+ * holds at that moment, while the Content-Length in the
+ * cached headers is its size at the time it was opened. A
+ * file rewritten in place keeps its inode, so only its size
+ * and modification time give it away. fstat(2) on an open
+ * descriptor never touches the disk, so checking on every
+ * hit is cheap. If it fails, the entry is treated as
+ * changed.
+ *
+ */
+static int file_changed_in_place(const struct file_cache_entry_t* entry) {
+    struct stat status;
+
+    if (fstat(entry->fd, &status) == -1) {
+        return TRUE;
+    }
+
+    return ((uint64_t) status.st_size != entry->size)
+        || (status.st_mtim.tv_sec != entry->mtime.tv_sec)
+        || (status.st_mtim.tv_nsec != (long) entry->mtime.tv_nsec);
+}
+
+/**
+ * Look up a request path.
+ *
+ */
+struct file_cache_entry_t* lookup_file_cache(struct file_cache_t* cache, const char* path, size_t path_length) {
+    if (cache->max_entries == 0) {
+        return NULL;
+    }
+
+    uint64_t hash = perfect_hash_string(path, path_length);
+    record_frequency(cache->sketch, hash);
+
+    struct file_cache_entry_t* entry = cache->buckets[hash & cache->bucket_mask];
+
+    while (entry && ((entry->path_hash != hash) || (entry->path_length != path_length) || (memcmp(entry->path, path, path_length) != 0))) {
+        entry = entry->hash_next;
+    }
+
+    if (entry == NULL) {
+        return NULL;
+    }
+
+    if (file_cache_now() - entry->validated_at > cache->validity) {
+        remove_file_cache_entry(cache, entry);
+        return NULL;
+    }
+
+    if ((entry->fd != -1) && file_changed_in_place(entry)) {
+        remove_file_cache_entry(cache, entry);
+        return NULL;
+    }
+
+    entry->hits++;
+
+    if (entry->frequency < FILE_CACHE_MAX_FREQUENCY) {
+        entry->frequency++;
+    }
+
+    return entry;
+}
+
+/**
+ * Evict one entry.
+ *
+ * @details This is the S3-FIFO eviction loop. While the
+ * small queue is over its share, its tail is either promoted
+ * to the main queue, if it was hit, or evicted. Otherwise
+ * the main queue's tail is evicted if it has not been hit
+ * since it last went round, or is given another round with
+ * one less hit to its name.
+ *
+ */
+static void evict_file_cache_entry(struct file_cache_t* cache) {
+    while (TRUE) {
+        struct file_cache_queue_list_t* small_queue = &cache->queues[FILE_CACHE_SMALL_QUEUE];
+        struct file_cache_queue_list_t* main_queue = &cache->queues[FILE_CACHE_MAIN_QUEUE];
+
+        if (small_queue->tail && ((small_queue->count > cache->small_queue_target) || (main_queue->tail == NULL))) {
+            struct file_cache_entry_t* entry = small_queue->tail;
+
+            if (entry->frequency == 0) {
+                remove_file_cache_entry(cache, entry);
+                return;
+            }
+
+            unlink_queue_entry(cache, entry);
+            entry->frequency = 0;
+            push_queue_entry(cache, entry, FILE_CACHE_MAIN_QUEUE);
+            continue;
+        }
+
+        struct file_cache_entry_t* entry = main_queue->tail;
+
+        if (entry->frequency == 0) {
+            remove_file_cache_entry(cache, entry);
+            return;
+        }
+
+        unlink_queue_entry(cache, entry);
+        entry->frequency--;
+        push_queue_entry(cache, entry, FILE_CACHE_MAIN_QUEUE);
+    }
+}
+
+/**
+ * Evict entries until at most max_entries remain.
+ *
+ */
+void shrink_file_cache(struct file_cache_t* cache, size_t max_entries) {
+    while (cache->entry_count > max_entries) {
+        evict_file_cache_entry(cache);
+    }
+}
+
+/**
+ * Return the entry the next eviction is most likely to hit.
+ *
+ */
+static const struct file_cache_entry_t* file_cache_victim(const struct file_cache_t* cache) {
+    const struct file_cache_entry_t* small_tail = cache->queues[FILE_CACHE_SMALL_QUEUE].tail;
+
+    return small_tail ? small_tail : cache->queues[FILE_CACHE_MAIN_QUEUE].tail;
+}
+
+/**
+ * Check whether the cache would admit a request path.
+ *
+ */
+int file_cache_admits(const struct file_cache_t* cache, const char* path, size_t path_length) {
+    if (cache->max_entries == 0) {
+        return FALSE;
+    }
+
+    if (cache->entry_count < cache->max_entries) {
+        return TRUE;
+    }
+
+    const struct file_cache_entry_t* victim = file_cache_victim(cache);
+    uint64_t hash = perfect_hash_string(path, path_length);
+
+    return estimate_frequency(cache->sketch, hash) > estimate_frequency(cache->sketch, victim->path_hash);
+}
+
+/**
+ * Credit a request path with past requests.
+ *
+ */
+void seed_file_cache_frequency(struct file_cache_t* cache, const char* path, size_t path_length, uint64_t requests) {
+    if (cache->max_entries == 0) {
+        return;
+    }
+
+    uint64_t hash = perfect_hash_string(path, path_length);
+
+    for (uint64_t i = 0; (i < requests) && (estimate_frequency(cache->sketch, hash) < 15); ++i) {
+        record_frequency(cache->sketch, hash);
+    }
+}
+
+/**
+ * Add an open file to the cache.
+ *
+ */
+struct file_cache_entry_t* insert_file_cache(struct file_cache_t* cache, const char* path, size_t path_length, const char* filename, int fd, const struct statx* status, struct content_body_t* content) {
+    if (cache->max_entries == 0) {
+        return NULL;
+    }
+
+    char header[512];
+    size_t header_length = build_file_response_header(header, sizeof (header), filename, status->stx_size);
+
+    if (header_length == 0) {
+        return NULL;
+    }
+
+    uint64_t hash = perfect_hash_string(path, path_length);
+
+    /**
+     * Replace any existing entry for the same path. A
+     * replacement takes over its queue position, since the
+     * path's popularity has not changed with its contents.
+     *
+     */
+    enum file_cache_queue_t queue = FILE_CACHE_SMALL_QUEUE;
+    int replaced = FALSE;
+
+    for (struct file_cache_entry_t* existing = cache->buckets[hash & cache->bucket_mask]; existing; existing = existing->hash_next) {
+        if ((existing->path_hash == hash) && (existing->path_length == path_length) && (memcmp(existing->path, path, path_length) == 0)) {
+            queue = existing->queue;
+            replaced = TRUE;
+            remove_file_cache_entry(cache, existing);
+            break;
+        }
+    }
+
+    /**
+     * Make room for the new entry if the cache is full, but
+     * only if it is more popular than what it would evict.
+     *
+     */
+    if (!replaced && !file_cache_admits(cache, path, path_length)) {
+        return NULL;
+    }
+
+    while (cache->entry_count >= cache->max_entries) {
+        evict_file_cache_entry(cache);
+    }
+
+    if (!replaced && (estimate_frequency(cache->sketch, hash) > 1)) {
+        queue = FILE_CACHE_MAIN_QUEUE;
+    }
+
+    struct file_cache_entry_t* entry = allocate_tagged_memory(MEMORY_TAG_CACHES, sizeof (struct file_cache_entry_t));
+
+    entry->path = allocate_tagged_memory(MEMORY_TAG_CACHES, path_length + 1);
+    memcpy(entry->path, path, path_length);
+    entry->path[path_length] = '\0';
+    entry->path_length = path_length;
+    entry->path_hash = hash;
+
+    /**
+     * A file whose contents are in memory is never read
+     * from disk again, so there is no need to hold on to
+     * its descriptor.
+     *
+     */
+    if (content) {
+        close(fd);
+        fd = -1;
+    }
+
+    entry->fd = fd;
+    entry->content = content;
+    entry->size = status->stx_size;
+    entry->device = ((uint64_t) status->stx_dev_major << 32) | status->stx_dev_minor;
+    entry->inode = status->stx_ino;
+    entry->mtime = status->stx_mtime;
+
+    entry->header = allocate_tagged_memory(MEMORY_TAG_CACHES, header_length + 1);
+    memcpy(entry->header, header, header_length + 1);
+    entry->header_length = header_length;
+
+    entry->hits = 0;
+    entry->frequency = 0;
+    entry->validated_at = file_cache_now();
+
+    struct file_cache_entry_t** bucket = &cache->buckets[hash & cache->bucket_mask];
+    entry->hash_next = *bucket;
+    *bucket = entry;
+
+    push_queue_entry(cache, entry, queue);
+
+    cache->entry_count++;
+    cache->cached_bytes += entry->size;
+
+    return entry;
+}
+
+/**
+ * Return the number of entries and the total file size
+ * currently cached.
+ *
+ */
+void file_cache_usage(const struct file_cache_t* cache, size_t* entries, uint64_t* bytes) {
+    *entries = cache->entry_count;
+    *bytes = cache->cached_bytes;
+}
+
+/**
+ * Call a function on every cached entry, main queue first.
+ *
+ */
+void visit_file_cache_entries(const struct file_cache_t* cache, void (*visitor)(const struct file_cache_entry_t* entry, void* context), void* context) {
+    for (const struct file_cache_entry_t* entry = cache->queues[FILE_CACHE_MAIN_QUEUE].head; entry; entry = entry->queue_next) {
+        visitor(entry, context);
+    }
+
+    for (const struct file_cache_entry_t* entry = cache->queues[FILE_CACHE_SMALL_QUEUE].head; entry; entry = entry->queue_next) {
+        visitor(entry, context);
+    }
+}
@@ -0,0 +1,338 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include "serverd.h"
+#include "error.h"
+#include "memory.h"
+#include "file_io.h"
+
+/**
+ * A FIFO of jobs linked through their next pointers.
+ *
+ */
+struct file_io_queue_t {
+    struct file_io_job_t* head;
+    struct file_io_job_t* tail;
+};
+
+/**
+ * The file I/O thread pool.
+ *
+ * @details Submissions and completions live in two separate
+ * queues under two separate locks, so that a worker posting
+ * a completion never contends with the event loop handing
+ * out new work.
+ *
+ */
+struct file_io_pool_t {
+    pthread_mutex_t submission_lock;
+    pthread_cond_t submission_ready;
+    struct file_io_queue_t submissions;
+
+    pthread_mutex_t completion_lock;
+    struct file_io_queue_t completions;
+
+    int eventfd;
+    size_t thread_count;
+    pthread_t* threads;
+};
+
+static void push_file_io_job(struct file_io_queue_t* queue, struct file_io_job_t* job) {
+    job->next = NULL;
+
+    if (queue->tail) {
+        queue->tail->next = job;
+    } else {
+        queue->head = job;
+    }
+
+    queue->tail = job;
+}
+
+static struct file_io_job_t* pop_file_io_job(struct file_io_queue_t* queue) {
+    struct file_io_job_t* job = queue->head;
+
+    if (job) {
+        queue->head = job->next;
+
+        if (queue->head == NULL) {
+            queue->tail = NULL;
+        }
+    }
+
+    return job;
+}
+
+/**
+ * Read a range of an open file, blocking.
+ *
+ */
+ssize_t read_file_range(int fd, void* buffer, off_t offset, size_t length) {
+    size_t total = 0;
+
+    while (total < length) {
+        ssize_t bytes_read = pread(fd, (char *) buffer + total, length - total, offset + (off_t) total);
+
+        if (bytes_read == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return (total == 0) ? -1 : (ssize_t) total;
+        }
+
+        if (bytes_read == 0) {
+            break;
+        }
+
+        total += (size_t) bytes_read;
+    }
+
+    return (ssize_t) total;
+}
+
+/**
+ * Check whether the page at an offset of an open file is in
+ * the page cache.
+ *
+ */
+int file_page_is_cached(int fd, off_t offset) {
+    char byte;
+    struct iovec vector = { &byte, 1 };
+
+    while (TRUE) {
+        ssize_t bytes_read = preadv2(fd, &vector, 1, offset, RWF_NOWAIT);
+
+        if ((bytes_read == -1) && (errno == EINTR)) {
+            continue;
+        }
+
+        return (bytes_read != -1) || (errno != EAGAIN);
+    }
+}
+
+/**
+ * Carry out the blocking operation a job describes.
+ *
+ * @details Failures are never fatal here. The result field
+ * is set to -1 and the error field to the value of errno,
+ * and it is up to the completion callback to decide what
+ * that means for the request.
+ *
+ */
+static void execute_file_io_job(struct file_io_job_t* job) {
+    job->error = 0;
+
+    switch (job->operation) {
+        case FILE_IO_OPEN: {
+            job->result = open(job->path, job->flags);
+
+            if (job->result == -1) {
+                break;
+            }
+
+            job->fd = (int) job->result;
+
+            if (statx(job->fd, "", AT_EMPTY_PATH, STATX_BASIC_STATS, &job->status) == -1) {
+                job->error = errno;
+                close(job->fd);
+                job->fd = -1;
+                job->result = -1;
+                return;
+            }
+        } break;
+
+        case FILE_IO_STATX: {
+            job->result = statx(AT_FDCWD, job->path, job->flags, STATX_BASIC_STATS, &job->status);
+        } break;
+
+        case FILE_IO_READAHEAD: {
+            job->result = readahead(job->fd, job->offset, job->length);
+        } break;
+
+        case FILE_IO_READ: {
+            job->result = read_file_range(job->fd, job->buffer, job->offset, job->length);
+        } break;
+
+        case FILE_IO_CALL: {
+            /**
+             * The function reports its own outcome through
+             * the result and error fields.
+             *
+             */
+            job->function(job);
+            return;
+        } break;
+    }
+
+    if (job->result == -1) {
+        job->error = errno;
+    }
+}
+
+/**
+ * Hand a finished job back to the owning event loop.
+ *
+ */
+static void post_file_io_completion(struct file_io_pool_t* pool, struct file_io_job_t* job) {
+    pthread_mutex_lock(&pool->completion_lock);
+    push_file_io_job(&pool->completions, job);
+    pthread_mutex_unlock(&pool->completion_lock);
+
+    /**
+     * Wake the event loop. The eventfd counter simply
+     * accumulates if the loop has not drained it yet, so
+     * there is no need to coalesce signals here.
+     *
+     */
+    uint64_t signal = 1;
+
+    while ((write(pool->eventfd, &signal, sizeof (signal)) == -1) && (errno == EINTR)) {
+        continue;
+    }
+}
+
+/**
+ * File I/O worker thread.
+ *
+ */
+static void* file_io_worker(void* argument) {
+    struct file_io_pool_t* pool = argument;
+
+    initialize_thread_memory();
+
+    while (TRUE) {
+        pthread_mutex_lock(&pool->submission_lock);
+
+        while (pool->submissions.head == NULL) {
+            pthread_cond_wait(&pool->submission_ready, &pool->submission_lock);
+        }
+
+        struct file_io_job_t* job = pop_file_io_job(&pool->submissions);
+        pthread_mutex_unlock(&pool->submission_lock);
+
+        execute_file_io_job(job);
+        post_file_io_completion(pool, job);
+    }
+
+    return NULL;
+}
+
+/**
+ * Create a file I/O pool with the given number of threads.
+ *
+ */
+struct file_io_pool_t* create_file_io_pool(size_t thread_count) {
+    struct file_io_pool_t* pool = allocate_memory(sizeof (struct file_io_pool_t));
+    memset(pool, 0, sizeof (struct file_io_pool_t));
+
+    pthread_mutex_init(&pool->submission_lock, NULL);
+    pthread_cond_init(&pool->submission_ready, NULL);
+    pthread_mutex_init(&pool->completion_lock, NULL);
+
+    pool->eventfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (pool->eventfd == -1) {
+        fatal_error("[Error] %s: %s\n", "Could not create file I/O eventfd", strerror(errno));
+    }
+
+    pool->thread_count = thread_count;
+    pool->threads = allocate_memory(sizeof (pthread_t) * (thread_count + 1));
+
+    for (size_t i = 0; i < thread_count; ++i) {
+        int error = pthread_create(&pool->threads[i], NULL, file_io_worker, pool);
+
+        if (error) {
+            fatal_error("[Error] %s: %s\n", "Could not create file I/O thread", strerror(error));
+        }
+    }
+
+    return pool;
+}
+
+/**
+ * Return the eventfd the pool signals completions through.
+ *
+ */
+int file_io_pool_eventfd(const struct file_io_pool_t* pool) {
+    return pool->eventfd;
+}
+
+/**
+ * Queue a job for execution on the pool.
+ *
+ */
+void submit_file_io_job(struct file_io_pool_t* pool, struct file_io_job_t* job) {
+    if (pool->thread_count == 0) {
+        execute_file_io_job(job);
+        post_file_io_completion(pool, job);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->submission_lock);
+    push_file_io_job(&pool->submissions, job);
+    pthread_cond_signal(&pool->submission_ready);
+    pthread_mutex_unlock(&pool->submission_lock);
+}
+
+/**
+ * Run the completion callbacks of all finished jobs.
+ *
+ * @details The whole completion queue is detached under the
+ * lock in one step and the callbacks are then run without
+ * holding it, so that callbacks are free to submit follow-up
+ * jobs.
+ *
+ */
+void complete_file_io_jobs(struct file_io_pool_t* pool) {
+    uint64_t signals;
+
+    if ((read(pool->eventfd, &signals, sizeof (signals)) == -1) && (errno != EAGAIN)) {
+        fatal_error("[Error] %s: %s\n", "Could not read file I/O eventfd", strerror(errno));
+    }
+
+    pthread_mutex_lock(&pool->completion_lock);
+    struct file_io_queue_t completions = pool->completions;
+    pool->completions.head = NULL;
+    pool->completions.tail = NULL;
+    pthread_mutex_unlock(&pool->completion_lock);
+
+    struct file_io_job_t* job;
+
+    while ((job = pop_file_io_job(&completions))) {
+        job->completion(job);
+    }
+}
@@ -0,0 +1,153 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "serverd.h"
+#include "error.h"
+#include "frequency_sketch.h"
+#include "memory.h"
+
+/**
+ * @def FREQUENCY_SKETCH_BLOCK_WORDS
+ * @brief Words per 64-byte block of the sketch.
+ *
+ */
+#define FREQUENCY_SKETCH_BLOCK_WORDS (8)
+
+/**
+ * Create a sketch sized for the given number of keys.
+ *
+ * @details There are at least four counters per key in each
+ * of the four rows, rounded up to a power of two number of
+ * blocks, so that picking a block is a mask.
+ *
+ */
+struct frequency_sketch_t* create_frequency_sketch(size_t capacity) {
+    size_t block_count = 1;
+
+    while (block_count * FREQUENCY_SKETCH_BLOCK_WORDS * 16 < capacity * 16) {
+        block_count <<= 1;
+    }
+
+    struct frequency_sketch_t* sketch = allocate_tagged_memory(MEMORY_TAG_CACHES, sizeof (struct frequency_sketch_t));
+    size_t table_size = sizeof (uint64_t) * FREQUENCY_SKETCH_BLOCK_WORDS * block_count;
+
+    /**
+     * Align the table to a cache line, so that each block
+     * really is a single line.
+     *
+     */
+    if (posix_memalign((void **) &sketch->table, 64, table_size) != 0) {
+        fatal_error("[Error] %s\n", "Memory allocation failure in call to posix_memalign()");
+    }
+
+    account_memory(MEMORY_TAG_CACHES, (long long) table_size);
+
+    memset(sketch->table, 0, table_size);
+
+    sketch->block_mask = block_count - 1;
+    sketch->additions = 0;
+    sketch->sample_size = (capacity ? capacity : 1) * 10;
+
+    return sketch;
+}
+
+/**
+ * Locate the four counters of a key.
+ *
+ * @details Row i uses one of the two words 2i and 2i + 1 of
+ * the key's block, and one of the sixteen counters in that
+ * word, each picked by a different byte of the key.
+ *
+ */
+static void locate_counters(const struct frequency_sketch_t* sketch, uint64_t key, size_t words[4], unsigned shifts[4]) {
+    size_t block = ((size_t) (key >> 32) & sketch->block_mask) * FREQUENCY_SKETCH_BLOCK_WORDS;
+
+    for (unsigned i = 0; i < 4; ++i) {
+        unsigned byte = (unsigned) (key >> (i * 8)) & 0xFF;
+        words[i] = block + (i * 2) + (byte & 1);
+        shifts[i] = ((byte >> 1) & 15) * 4;
+    }
+}
+
+/**
+ * Halve every counter in the sketch.
+ *
+ */
+static void age_frequency_sketch(struct frequency_sketch_t* sketch) {
+    size_t word_count = (sketch->block_mask + 1) * FREQUENCY_SKETCH_BLOCK_WORDS;
+
+    for (size_t i = 0; i < word_count; ++i) {
+        sketch->table[i] = (sketch->table[i] >> 1) & 0x7777777777777777ULL;
+    }
+
+    sketch->additions /= 2;
+}
+
+/**
+ * Record one access to a key.
+ *
+ */
+void record_frequency(struct frequency_sketch_t* sketch, uint64_t key) {
+    size_t words[4];
+    unsigned shifts[4];
+    locate_counters(sketch, key, words, shifts);
+
+    int incremented = FALSE;
+
+    for (unsigned i = 0; i < 4; ++i) {
+        if (((sketch->table[words[i]] >> shifts[i]) & 15) < 15) {
+            sketch->table[words[i]] += (uint64_t) 1 << shifts[i];
+            incremented = TRUE;
+        }
+    }
+
+    if (incremented && (++sketch->additions >= sketch->sample_size)) {
+        age_frequency_sketch(sketch);
+    }
+}
+
+/**
+ * Estimate how often a key has been seen, from 0 to 15.
+ *
+ */
+unsigned estimate_frequency(const struct frequency_sketch_t* sketch, uint64_t key) {
+    size_t words[4];
+    unsigned shifts[4];
+    locate_counters(sketch, key, words, shifts);
+
+    unsigned estimate = 15;
+
+    for (unsigned i = 0; i < 4; ++i) {
+        unsigned count = (unsigned) (sketch->table[words[i]] >> shifts[i]) & 15;
+
+        if (count < estimate) {
+            estimate = count;
+        }
+    }
+
+    return estimate;
+}
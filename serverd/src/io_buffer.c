@@ -0,0 +1,287 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include <syslog.h>
+
+#include "serverd.h"
+#include "error.h"
+#include "io_buffer.h"
+#include "memory.h"
+
+/**
+ * The capacities of the size classes.
+ *
+ */
+static const size_t io_buffer_class_sizes[IO_BUFFER_CLASS_COUNT] = {
+    4 * 1024,
+    16 * 1024,
+    64 * 1024
+};
+
+/**
+ * A stack of idle buffers of one size class.
+ *
+ */
+struct io_buffer_magazine_t {
+    struct io_buffer_magazine_t* next;
+    size_t count;
+    void* buffers[IO_BUFFER_MAGAZINE_SIZE];
+};
+
+/**
+ * A thread's cache of idle buffers.
+ *
+ * @details Following Bonwick's magazine allocator, each
+ * class has a loaded magazine, which buffers are taken from
+ * and returned to, and the previously loaded one. Swapping
+ * the two absorbs a burst of either up to a whole magazine
+ * before the thread needs the depot.
+ *
+ */
+struct io_buffer_cache_t {
+    struct io_buffer_magazine_t* loaded[IO_BUFFER_CLASS_COUNT];
+    struct io_buffer_magazine_t* previous[IO_BUFFER_CLASS_COUNT];
+};
+
+/**
+ * The global depot of full and empty magazines.
+ *
+ * @details At most IO_BUFFER_DEPOT_CAPACITY full magazines
+ * are kept per class. Beyond that, idle buffers are given
+ * back to the allocator.
+ *
+ */
+struct io_buffer_depot_t {
+    pthread_mutex_t lock;
+    struct io_buffer_magazine_t* full[IO_BUFFER_CLASS_COUNT];
+    size_t full_count[IO_BUFFER_CLASS_COUNT];
+    struct io_buffer_magazine_t* empty[IO_BUFFER_CLASS_COUNT];
+};
+
+static struct io_buffer_depot_t depot = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static _Thread_local struct io_buffer_cache_t thread_cache;
+
+/**
+ * Per-class occupancy, for the statistics.
+ *
+ */
+static atomic_size_t buffers_allocated[IO_BUFFER_CLASS_COUNT];
+static atomic_size_t buffers_in_use[IO_BUFFER_CLASS_COUNT];
+
+/**
+ * Return the size class for a size, or -1 if it is too
+ * large for any.
+ *
+ */
+static int io_buffer_class(size_t size) {
+    for (int class = 0; class < IO_BUFFER_CLASS_COUNT; ++class) {
+        if (size <= io_buffer_class_sizes[class]) {
+            return class;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Return the capacity of the buffer that acquire_io_buffer()
+ * hands out for a given size.
+ *
+ */
+size_t io_buffer_capacity(size_t size) {
+    int class = io_buffer_class(size);
+    return (class == -1) ? size : io_buffer_class_sizes[class];
+}
+
+/**
+ * Take an empty magazine from the depot, or allocate one.
+ *
+ * @details The depot lock must be held.
+ *
+ */
+static struct io_buffer_magazine_t* take_empty_magazine(int class) {
+    struct io_buffer_magazine_t* magazine = depot.empty[class];
+
+    if (magazine) {
+        depot.empty[class] = magazine->next;
+    } else {
+        magazine = allocate_tagged_memory(MEMORY_TAG_BUFFERS, sizeof (struct io_buffer_magazine_t));
+    }
+
+    magazine->next = NULL;
+    magazine->count = 0;
+
+    return magazine;
+}
+
+/**
+ * Take an I/O buffer of at least size bytes.
+ *
+ */
+void* acquire_io_buffer(size_t size) {
+    int class = io_buffer_class(size);
+
+    if (class == -1) {
+        return allocate_tagged_memory(MEMORY_TAG_BUFFERS, size);
+    }
+
+    struct io_buffer_cache_t* cache = &thread_cache;
+    struct io_buffer_magazine_t* loaded = cache->loaded[class];
+
+    if ((loaded == NULL) || (loaded->count == 0)) {
+        struct io_buffer_magazine_t* previous = cache->previous[class];
+
+        if (previous && (previous->count > 0)) {
+            cache->previous[class] = loaded;
+            cache->loaded[class] = loaded = previous;
+        } else {
+            /**
+             * Both magazines are empty, so trade the loaded
+             * one for a full one from the depot, if it has
+             * any.
+             *
+             */
+            pthread_mutex_lock(&depot.lock);
+
+            struct io_buffer_magazine_t* full = depot.full[class];
+
+            if (full) {
+                depot.full[class] = full->next;
+                depot.full_count[class]--;
+
+                if (loaded) {
+                    loaded->next = depot.empty[class];
+                    depot.empty[class] = loaded;
+                }
+
+                cache->loaded[class] = loaded = full;
+            }
+
+            pthread_mutex_unlock(&depot.lock);
+        }
+    }
+
+    atomic_fetch_add_explicit(&buffers_in_use[class], 1, memory_order_relaxed);
+
+    if (loaded && (loaded->count > 0)) {
+        return loaded->buffers[--loaded->count];
+    }
+
+    void* buffer = NULL;
+
+    if (posix_memalign(&buffer, 4096, io_buffer_class_sizes[class]) != 0) {
+        fatal_error("[Error] %s\n", "Memory allocation failure in call to posix_memalign()");
+    }
+
+    atomic_fetch_add_explicit(&buffers_allocated[class], 1, memory_order_relaxed);
+    account_memory(MEMORY_TAG_BUFFERS, (long long) io_buffer_class_sizes[class]);
+
+    return buffer;
+}
+
+/**
+ * Return an I/O buffer.
+ *
+ */
+void release_io_buffer(void* buffer, size_t size) {
+    if (buffer == NULL) {
+        return;
+    }
+
+    int class = io_buffer_class(size);
+
+    if (class == -1) {
+        FREE(buffer);
+        return;
+    }
+
+    atomic_fetch_sub_explicit(&buffers_in_use[class], 1, memory_order_relaxed);
+
+    struct io_buffer_cache_t* cache = &thread_cache;
+    struct io_buffer_magazine_t* loaded = cache->loaded[class];
+
+    if ((loaded == NULL) || (loaded->count == IO_BUFFER_MAGAZINE_SIZE)) {
+        struct io_buffer_magazine_t* previous = cache->previous[class];
+
+        if (previous && (previous->count < IO_BUFFER_MAGAZINE_SIZE)) {
+            cache->previous[class] = loaded;
+            cache->loaded[class] = loaded = previous;
+        } else {
+            /**
+             * Both magazines are full, or there are none
+             * yet. Hand the full one over to the depot, or
+             * free its buffers if the depot already has as
+             * many as it keeps, and load an empty one.
+             *
+             */
+            pthread_mutex_lock(&depot.lock);
+
+            if (previous) {
+                if (depot.full_count[class] < IO_BUFFER_DEPOT_CAPACITY) {
+                    previous->next = depot.full[class];
+                    depot.full[class] = previous;
+                    depot.full_count[class]++;
+                } else {
+                    for (size_t i = 0; i < previous->count; ++i) {
+                        free(previous->buffers[i]);
+                    }
+
+                    account_memory(MEMORY_TAG_BUFFERS, -(long long) (io_buffer_class_sizes[class] * previous->count));
+
+                    atomic_fetch_sub_explicit(&buffers_allocated[class], previous->count, memory_order_relaxed);
+
+                    previous->count = 0;
+                    previous->next = depot.empty[class];
+                    depot.empty[class] = previous;
+                }
+            }
+
+            cache->previous[class] = loaded;
+            cache->loaded[class] = loaded = take_empty_magazine(class);
+
+            pthread_mutex_unlock(&depot.lock);
+        }
+    }
+
+    loaded->buffers[loaded->count++] = buffer;
+}
+
+/**
+ * Log how many buffers of each size class are in use and
+ * how many are sitting idle in thread caches and the depot.
+ *
+ */
+void log_io_buffer_statistics(void) {
+    for (int class = 0; class < IO_BUFFER_CLASS_COUNT; ++class) {
+        size_t allocated = atomic_load_explicit(&buffers_allocated[class], memory_order_relaxed);
+        size_t in_use = atomic_load_explicit(&buffers_in_use[class], memory_order_relaxed);
+
+        syslog(LOG_INFO, "I/O buffers of %zu KiB: %zu in use, %zu idle", io_buffer_class_sizes[class] / 1024, in_use, allocated - in_use);
+    }
+}
@@ -0,0 +1,242 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "serverd.h"
+#include "configuration.h"
+#include "location.h"
+#include "memory.h"
+
+/**
+ * A node of the location tree.
+ *
+ * @details The label is the run of path bytes on the edge
+ * into the node, so the path to a node is the labels from
+ * the root down. A node's children occupy consecutive
+ * slots, ordered by the first byte of their labels, and no
+ * two of them share that first byte.
+ *
+ */
+struct location_node_t {
+    const char* label;
+    size_t label_length;
+    uint32_t first_child;
+    uint32_t child_count;
+    const struct location_t* exact;
+    const struct location_t* prefix;
+};
+
+struct location_tree_t {
+    struct location_node_t* nodes;
+    size_t node_count;
+};
+
+static int compare_location_paths(const void* a, const void* b) {
+    return strcmp((*(const struct location_t* const*) a)->path, (*(const struct location_t* const*) b)->path);
+}
+
+/**
+ * Build the subtree for a run of locations, sorted by
+ * path, that all share their first depth bytes.
+ *
+ * @details Locations whose path ends right here belong to
+ * this node. The rest are split up by their next byte, and
+ * each group gets a child whose label runs as far as every
+ * path in the group agrees, which, since they are sorted, is
+ * as far as the first and last of them agree.
+ *
+ */
+static int build_location_node(struct location_tree_t* tree, size_t node_index, const struct location_t** sorted, size_t first, size_t last, size_t depth, const char** duplicate) {
+    struct location_node_t* node = &tree->nodes[node_index];
+
+    for (; (first < last) && (sorted[first]->path_length == depth); ++first) {
+        const struct location_t** slot = sorted[first]->exact ? &node->exact : &node->prefix;
+
+        if (*slot) {
+            *duplicate = sorted[first]->path;
+            return FALSE;
+        }
+
+        *slot = sorted[first];
+    }
+
+    size_t child_count = 0;
+
+    for (size_t i = first; i < last; ++child_count) {
+        char c = sorted[i]->path[depth];
+
+        while ((i < last) && (sorted[i]->path[depth] == c)) {
+            ++i;
+        }
+    }
+
+    node->first_child = (uint32_t) tree->node_count;
+    node->child_count = (uint32_t) child_count;
+    tree->node_count += child_count;
+
+    size_t child = node->first_child;
+
+    for (size_t i = first; i < last; ++child) {
+        char c = sorted[i]->path[depth];
+        size_t end = i;
+
+        while ((end < last) && (sorted[end]->path[depth] == c)) {
+            ++end;
+        }
+
+        const char* low = sorted[i]->path;
+        const char* high = sorted[end - 1]->path;
+        size_t label_end = depth + 1;
+
+        while ((low[label_end] != '\0') && (low[label_end] == high[label_end])) {
+            ++label_end;
+        }
+
+        struct location_node_t* child_node = &tree->nodes[child];
+        child_node->label = low + depth;
+        child_node->label_length = label_end - depth;
+        child_node->exact = NULL;
+        child_node->prefix = NULL;
+
+        if (!build_location_node(tree, child, sorted, i, end, label_end, duplicate)) {
+            return FALSE;
+        }
+
+        i = end;
+    }
+
+    return TRUE;
+}
+
+/**
+ * Build the location tree for a set of locations.
+ *
+ */
+struct location_tree_t* build_location_tree(const struct location_t* locations, size_t count, const char** duplicate) {
+    *duplicate = NULL;
+
+    struct location_tree_t* tree = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (struct location_tree_t));
+
+    /**
+     * Every node but the root either ends a path or has at
+     * least two children, so there are at most two nodes per
+     * location, plus the root.
+     *
+     */
+    tree->nodes = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (struct location_node_t) * (2 * count + 1));
+    tree->node_count = 1;
+
+    memset(&tree->nodes[0], 0, sizeof (struct location_node_t));
+
+    if (count == 0) {
+        return tree;
+    }
+
+    const struct location_t** sorted = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (const struct location_t*) * count);
+
+    for (size_t i = 0; i < count; ++i) {
+        sorted[i] = &locations[i];
+    }
+
+    qsort(sorted, count, sizeof (const struct location_t*), compare_location_paths);
+
+    int built = build_location_node(tree, 0, sorted, 0, count, 0, duplicate);
+
+    FREE(sorted);
+
+    if (!built) {
+        free_location_tree(tree);
+        return NULL;
+    }
+
+    return tree;
+}
+
+/**
+ * Release a location tree.
+ *
+ */
+void free_location_tree(struct location_tree_t* tree) {
+    if (tree == NULL) {
+        return;
+    }
+
+    FREE(tree->nodes);
+    FREE(tree);
+}
+
+/**
+ * Find the child of a node whose label starts with a byte.
+ *
+ */
+static const struct location_node_t* find_location_child(const struct location_tree_t* tree, const struct location_node_t* node, unsigned char c) {
+    size_t low = node->first_child;
+    size_t high = low + node->child_count;
+
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        unsigned char label = (unsigned char) tree->nodes[middle].label[0];
+
+        if (label == c) {
+            return &tree->nodes[middle];
+        }
+
+        if (label < c) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Find the location that handles a normalized request
+ * path.
+ *
+ */
+const struct location_t* match_location(const struct location_tree_t* tree, const char* path, size_t length) {
+    const struct location_node_t* node = &tree->nodes[0];
+    const struct location_t* match = node->prefix;
+    size_t depth = 0;
+
+    while (depth < length) {
+        node = find_location_child(tree, node, (unsigned char) path[depth]);
+
+        if ((node == NULL) || (node->label_length > length - depth) || (memcmp(node->label, path + depth, node->label_length) != 0)) {
+            return match;
+        }
+
+        depth += node->label_length;
+
+        if (node->prefix) {
+            match = node->prefix;
+        }
+    }
+
+    return node->exact ? node->exact : match;
+}
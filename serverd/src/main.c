@@ -37,8 +37,10 @@
 #include <sys/resource.h>
 #include <sys/select.h>
 #include <sys/sendfile.h>
+#include <sys/signalfd.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/timerfd.h>
 #include <sys/types.h>
 
 #include <fcntl.h>
@@ -53,8 +55,25 @@
 
 #include "serverd.h"
 #include "configuration.h"
+#include "connection.h"
+#include "content_region.h"
+#include "content_store.h"
 #include "error.h"
+#include "direct_io.h"
+#include "directory_listing.h"
+#include "file_cache.h"
+#include "file_io.h"
+#include "io_buffer.h"
 #include "memory.h"
+#include "mime.h"
+#include "negative_cache.h"
+#include "popularity.h"
+#include "site_pack.h"
+#include "static_file.h"
+#include "virtual_host.h"
+#include "warmup.h"
+#include "worker.h"
+#include "zero_copy.h"
 
 /**
  * Functions that handle socket initialization, binding, and
@@ -169,7 +188,7 @@ enum http_status_code_t {
     HTTP_STATUS_CODE_CONTINUE = 100,
     HTTP_STATUS_CODE_SWITCHING_PROTOCOL = 101,
     HTTP_STATUS_CODE_PROCESSING = 102,
-    HTTP_STATUS_CODE_EARLY_HINTS = 103.
+    HTTP_STATUS_CODE_EARLY_HINTS = 103,
     HTTP_STATUS_CODE_OK = 200,
     HTTP_STATUS_CODE_CREATED = 201,
     HTTP_STATUS_CODE_ACCEPTED = 202,
@@ -244,7 +263,7 @@ void free_uri(struct uri_t* uri) {
 }
 
 void print_uri(struct uri_t* uri) {
-    printf("URL: %s://%s%s%s\n", uri->protocol, uri->hostname, uri->portnum, uri->doc_path);
+    printf("URL: %s://%s%s%s\n", uri->protocol, uri->hostname, uri->port_num, uri->doc_path);
     printf("  - Protocol: %s\n", uri->protocol);
     printf("  - Hostname: %s\n", uri->hostname);
     printf("  - Port Num: %s\n", uri->port_num);
@@ -252,6 +271,224 @@ void print_uri(struct uri_t* uri) {
     printf("\n");
 }
 
+/**
+ * Give back as much memory as can be given back without
+ * affecting requests in flight.
+ *
+ * @details The file cache is halved, and the negative and
+ * directory listing caches, which are cheap to rebuild, are
+ * emptied, as are the idle request arena chunks.
+ *
+ */
+static void relieve_memory_pressure(struct worker_t* worker) {
+    size_t entries = 0;
+    uint64_t bytes = 0;
+
+    for (size_t i = 0; i < worker->host_count; ++i) {
+        struct worker_host_t* host = &worker->hosts[i];
+
+        file_cache_usage(host->file_cache, &entries, &bytes);
+        shrink_file_cache(host->file_cache, entries / 2);
+        clear_negative_cache(host->negative_cache);
+        clear_directory_listing_cache(host->directory_listing_cache);
+    }
+
+    trim_arena_chunk_pool(worker->arena_chunk_pool);
+}
+
+/**
+ * Whether a configuration has any periodic work for the
+ * housekeeping timer to do.
+ *
+ */
+static int needs_housekeeping(const struct configuration_options_t* configuration_options) {
+    return configuration_options->site_pack
+        || (configuration_options->popularity_snapshot && configuration_options->popularity_snapshot_interval)
+        || configuration_options->statistics_interval
+        || configuration_options->memory_soft_limit
+        || configuration_options->memory_hard_limit;
+}
+
+/**
+ * Start the housekeeping timer, which ticks once a second,
+ * and return its descriptor.
+ *
+ */
+static int start_housekeeping_timer(int epfd) {
+    int timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+    if (timerfd == -1) {
+        fatal_error("[Error] %s\n", strerror(errno));
+    }
+
+    struct itimerspec interval = { { 1, 0 }, { 1, 0 } };
+
+    if (timerfd_settime(timerfd, 0, &interval, NULL) == -1) {
+        fatal_error("[Error] %s\n", strerror(errno));
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = timerfd;
+
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, timerfd, &ev) == -1) {
+        fatal_error("[Error] %s\n", strerror(errno));
+    }
+
+    return timerfd;
+}
+
+/**
+ * Compare two optional string options.
+ *
+ */
+static int same_option_string(const char* a, const char* b) {
+    return (a == b) || (a && b && (strcmp(a, b) == 0));
+}
+
+/**
+ * Compare two lists of MIME type overrides, in order.
+ *
+ */
+static int same_mime_type_overrides(const struct mime_type_override_t* a, const struct mime_type_override_t* b) {
+    while (a && b) {
+        if ((strcmp(a->extension, b->extension) != 0) || (strcmp(a->content_type, b->content_type) != 0)) {
+            return FALSE;
+        }
+
+        a = a->next;
+        b = b->next;
+    }
+
+    return a == b;
+}
+
+/**
+ * Compare two sets of locations, as far as which file a
+ * request path maps onto is concerned.
+ *
+ */
+static int same_locations(const struct configuration_options_t* a, const struct configuration_options_t* b) {
+    if (a->location_count != b->location_count) {
+        return FALSE;
+    }
+
+    for (size_t i = 0; i < a->location_count; ++i) {
+        const struct location_t* x = &a->locations[i];
+        const struct location_t* y = &b->locations[i];
+
+        if ((strcmp(x->path, y->path) != 0) || (x->exact != y->exact) || (x->handler != y->handler) || (x->directory_listing_enabled != y->directory_listing_enabled) || !same_option_string(x->document_root_directory, y->document_root_directory)) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * Compare two sets of rewrite rules, in order.
+ *
+ */
+static int same_rewrite_rules(const struct configuration_options_t* a, const struct configuration_options_t* b) {
+    if (a->rewrite_rule_count != b->rewrite_rule_count) {
+        return FALSE;
+    }
+
+    for (size_t i = 0; i < a->rewrite_rule_count; ++i) {
+        const struct rewrite_rule_t* x = &a->rewrite_rules[i];
+        const struct rewrite_rule_t* y = &b->rewrite_rules[i];
+
+        if ((strcmp(x->pattern, y->pattern) != 0) || (strcmp(x->target, y->target) != 0) || (x->status != y->status)) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * Switch a worker over to a newly published configuration.
+ *
+ * @details This runs between passes through the event
+ * loop, so no response is halfway through reading the
+ * configuration. Connections are left alone, and so are the
+ * caches, except for whatever the change of configuration
+ * made stale: a new document root invalidates every cached
+ * path, and a new MIME type mapping every cached header.
+ *
+ */
+static void adopt_configuration(struct worker_t* worker, const struct configuration_options_t* next) {
+    const struct configuration_options_t* current = worker->configuration_options;
+    int flush_file_caches = FALSE;
+
+    if (!same_mime_type_overrides(current->mime_type_overrides, next->mime_type_overrides)) {
+        if (initialize_mime_types(next)) {
+            flush_file_caches = TRUE;
+        } else {
+            syslog(LOG_WARNING, "[Warning] %s", "Could not rebuild the MIME type table, keeping the previous one");
+        }
+    }
+
+    /**
+     * Cached paths may map onto different files under the
+     * new locations or rewrite rules, so if those changed at
+     * all, every cache starts over.
+     *
+     */
+    int new_locations = !same_locations(current, next) || !same_rewrite_rules(current, next);
+
+    /**
+     * The set of virtual hosts never changes on a reload,
+     * so the caches line up one for one with both
+     * configurations' virtual hosts.
+     *
+     */
+    for (size_t i = 0; i < worker->host_count; ++i) {
+        const struct virtual_host_t* current_host = &current->virtual_hosts[i];
+        const struct virtual_host_t* next_host = &next->virtual_hosts[i];
+        struct worker_host_t* host = &worker->hosts[i];
+        int flush_file_cache = flush_file_caches;
+
+        if (new_locations || !same_option_string(current_host->document_root_directory, next_host->document_root_directory)) {
+            clear_negative_cache(host->negative_cache);
+            clear_directory_listing_cache(host->directory_listing_cache);
+            flush_file_cache = TRUE;
+        }
+
+        if (flush_file_cache) {
+            shrink_file_cache(host->file_cache, 0);
+        }
+
+        if (current_host->directory_listing_enabled && !next_host->directory_listing_enabled) {
+            clear_directory_listing_cache(host->directory_listing_cache);
+        }
+    }
+
+    /**
+     * Every response from a site pack is sent in full before
+     * the event loop gets here, so the old pack can be
+     * released right away. If the new one cannot be loaded,
+     * the old one is kept, and the housekeeping timer keeps
+     * trying.
+     *
+     */
+    if (!same_option_string(current->site_pack, next->site_pack)) {
+        if (next->site_pack == NULL) {
+            free_site_pack(worker->site_pack);
+            worker->site_pack = NULL;
+        } else if (worker->site_pack) {
+            worker->site_pack = reload_site_pack_if_changed(worker->site_pack, next->site_pack);
+        } else if ((worker->site_pack = load_site_pack(next->site_pack)) == NULL) {
+            syslog(LOG_WARNING, "[Warning] Could not load site pack: %s", next->site_pack);
+        }
+    }
+
+    setlogmask(LOG_UPTO(next->log_level));
+    set_memory_budget(next->memory_soft_limit, next->memory_hard_limit);
+
+    worker->configuration_options = next;
+}
+
 /**
  * This is the entry point of the server.
  * 
@@ -262,20 +499,6 @@ void print_uri(struct uri_t* uri) {
  */
 int main(int argc, char *argv[])
 {
-    if (argc == 1) {
-        fprintf(stderr, "No input(s).\n");
-        return EXIT_FAILURE;
-    }
-
-    while (*++argv) {
-        printf("%s\n", *argv);
-        struct uri_t* uri = parse_uri(*argv);
-        print_uri(uri);
-        free_uri(uri);
-    }
-
-    return EXIT_SUCCESS;
-
     /**
      * Initialize the configuration options container.
      *
@@ -284,7 +507,16 @@ int main(int argc, char *argv[])
      * this function, the server is ready to rock and roll.
      *
      */
-    struct configuration_options_t* configuration_options = initialize_server_configuration(argc, argv);
+    const struct configuration_options_t* configuration_options = initialize_server_configuration(argc, argv);
+
+    /**
+     * Merge any MimeType directives from the configuration
+     * file into the built-in MIME type table.
+     *
+     */
+    if (initialize_mime_types(configuration_options) == FALSE) {
+        fatal_error("[Error] %s\n", "Could not build MIME type table");
+    }
 
     /**
      * Call umask to set the file mode creation mask to a
@@ -328,12 +560,18 @@ int main(int argc, char *argv[])
      */
     setsid();
 
-    struct sigaction signal_action;
-    signal_action.sa_handler = SIG_IGN;
-    sigemptyset(&signal_action.sa_mask);
-    signal_action.sa_flags = 0;
+    /**
+     * SIGHUP asks the server to reload its configuration.
+     * It is blocked here, before any other thread exists, so
+     * that every thread inherits the mask, and the event loop
+     * reads it from a signalfd instead.
+     *
+     */
+    sigset_t reload_signals;
+    sigemptyset(&reload_signals);
+    sigaddset(&reload_signals, SIGHUP);
 
-    if (sigaction(SIGHUP, &signal_action, NULL) == -1) {
+    if (sigprocmask(SIG_BLOCK, &reload_signals, NULL) == -1) {
         fatal_error("[Error] %s\n", strerror(errno));
     }
 
@@ -344,6 +582,7 @@ int main(int argc, char *argv[])
     // }
 
     printf("%u\n", getpid());
+    fflush(stdout);
 
     // if (chdir("/") == -1) {
     //    fatal_error("[Error] %s\n", strerror(errno));
@@ -361,6 +600,7 @@ int main(int argc, char *argv[])
     }
 
     openlog("serverd", LOG_CONS, LOG_DAEMON);
+    setlogmask(LOG_UPTO(configuration_options->log_level));
 
     // printf("Configuration filename: %s\n", configuration_options->configuration_filename);
     // printf("Hostname: %s\n", configuration_options->hostname);
@@ -384,11 +624,197 @@ int main(int argc, char *argv[])
         fatal_error("[Error] %s\n", strerror(errno));
     }
 
+    int reload_signalfd = signalfd(-1, &reload_signals, SFD_NONBLOCK | SFD_CLOEXEC);
+
+    if (reload_signalfd == -1) {
+        fatal_error("[Error] %s\n", strerror(errno));
+    }
+
+    ev.events = EPOLLIN;
+    ev.data.fd = reload_signalfd;
+
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, reload_signalfd, &ev) == -1) {
+        fatal_error("[Error] %s\n", strerror(errno));
+    }
+
+    /**
+     * Tune the allocator before any worker thread starts, so
+     * that the event loop and every file I/O thread are set
+     * up with their own arenas.
+     *
+     */
+    struct memory_tuning_t memory_tuning = {
+        configuration_options->memory_arena_per_thread,
+        configuration_options->memory_thread_cache,
+        (long) configuration_options->memory_dirty_decay,
+        (long) configuration_options->memory_muzzy_decay
+    };
+
+    syslog(LOG_NOTICE, "Using the %s memory allocator", memory_allocator_name());
+
+    configure_memory_allocator(&memory_tuning);
+    initialize_thread_memory();
+    set_memory_budget(configuration_options->memory_soft_limit, configuration_options->memory_hard_limit);
+
+    /**
+     * Set up the worker state: the file I/O pool, the
+     * connection, kernel pipe, request arena and streaming
+     * buffer pools, the directory listing, static file and
+     * negative caches, and the content cache region and the
+     * store of distinct bodies within it.
+     *
+     * This has to happen after the process has daemonized,
+     * since neither the pool's threads nor its eventfd would
+     * survive the fork(2) and the file descriptor sweep above.
+     *
+     */
+    struct worker_t worker;
+    worker.configuration_options = configuration_options;
+    worker.configuration_reader = register_configuration_reader();
+    worker.file_io_pool = create_file_io_pool(configuration_options->file_io_thread_count);
+    worker.connection_slab = create_connection_slab();
+    worker.pipe_pool = create_pipe_pool(PIPE_POOL_CAPACITY, KERNEL_PIPE_SIZE);
+    worker.arena_chunk_pool = create_arena_chunk_pool(ARENA_CHUNK_SIZE, ARENA_CHUNK_POOL_CAPACITY);
+    worker.direct_buffer_pool = create_direct_buffer_pool(DIRECT_BUFFER_POOL_CAPACITY, configuration_options->streaming_buffer_size);
+    worker.content_region = create_content_region(configuration_options->content_cache_size, configuration_options->content_cache_page_size);
+    worker.popularity_snapshot = NULL;
+    memset(&worker.page_cache_statistics, 0, sizeof (worker.page_cache_statistics));
+    worker.popularity_snapshot_pending = FALSE;
+
+    int file_io_eventfd = file_io_pool_eventfd(worker.file_io_pool);
+
+    ev.events = EPOLLIN;
+    ev.data.fd = file_io_eventfd;
+
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, file_io_eventfd, &ev) == -1) {
+        fatal_error("[Error] %s\n", strerror(errno));
+    }
+
+    /**
+     * Every virtual host gets caches of its own. The content
+     * store is shared, so that a file served by several
+     * virtual hosts is only held in memory once, and has to
+     * have room for every file cache entry of every one of
+     * them.
+     *
+     * The negative caches learn about new files in their
+     * document roots through a single inotify descriptor,
+     * that of the first one that has any use for it.
+     *
+     */
+    size_t content_store_entries = 0;
+
+    for (size_t i = 0; i < configuration_options->virtual_host_count; ++i) {
+        content_store_entries += configuration_options->virtual_hosts[i].file_cache_entries;
+    }
+
+    worker.content_store = create_content_store(worker.content_region, content_store_entries);
+    worker.host_count = configuration_options->virtual_host_count;
+    worker.hosts = allocate_tagged_memory(MEMORY_TAG_CACHES, sizeof (struct worker_host_t) * worker.host_count);
+
+    int negative_cache_fd = -1;
+    struct negative_cache_t* watching_negative_cache = NULL;
+
+    for (size_t i = 0; i < worker.host_count; ++i) {
+        const struct virtual_host_t* virtual_host = &configuration_options->virtual_hosts[i];
+        struct worker_host_t* host = &worker.hosts[i];
+
+        host->directory_listing_cache = create_directory_listing_cache(virtual_host->directory_listing_cache_entries);
+        host->file_cache = create_file_cache(virtual_host->file_cache_entries, (time_t) virtual_host->file_cache_validity, worker.content_store);
+        host->negative_cache = create_negative_cache(virtual_host->negative_cache_entries, configuration_options->negative_cache_bloom_filter, (time_t) virtual_host->file_cache_validity, negative_cache_fd);
+
+        if (negative_cache_fd == -1) {
+            negative_cache_fd = negative_cache_inotify_fd(host->negative_cache);
+            watching_negative_cache = host->negative_cache;
+        }
+    }
+
+    if (negative_cache_fd != -1) {
+        ev.events = EPOLLIN;
+        ev.data.fd = negative_cache_fd;
+
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, negative_cache_fd, &ev) == -1) {
+            fatal_error("[Error] %s\n", strerror(errno));
+        }
+    }
+
+    /**
+     * Map the site pack, if one is configured. It replaces
+     * the document root, so there is no point in starting
+     * without it.
+     *
+     */
+    worker.site_pack = NULL;
+
+    if (configuration_options->site_pack) {
+        worker.site_pack = load_site_pack(configuration_options->site_pack);
+
+        if (worker.site_pack == NULL) {
+            fatal_error("[Error] %s: %s\n", "Could not load site pack", configuration_options->site_pack);
+        }
+    }
+
+    /**
+     * If popularity snapshots are enabled, load the one left
+     * behind by the previous run.
+     *
+     */
+    if (configuration_options->popularity_snapshot) {
+        worker.popularity_snapshot = load_popularity_snapshot(configuration_options->popularity_snapshot);
+
+        if (worker.popularity_snapshot) {
+            syslog(LOG_NOTICE, "Loaded %zu paths from popularity snapshot %s", worker.popularity_snapshot->count, configuration_options->popularity_snapshot);
+        }
+    }
+
+    /**
+     * Periodic work, such as picking up a new site pack or
+     * writing the popularity snapshot, runs off a timer that
+     * ticks once a second, which is only armed if there is
+     * any such work to do. With a memory budget, this is
+     * also where accepting connections resumes once usage
+     * has come back down.
+     *
+     */
+    int housekeeping_timerfd = -1;
+    uint64_t housekeeping_ticks = 0;
+    int accepting_connections = TRUE;
+
+    if (needs_housekeeping(configuration_options)) {
+        housekeeping_timerfd = start_housekeeping_timer(epfd);
+    }
+
+    /**
+     * Preload the file cache, if a warm-up budget is
+     * configured, so that the first requests after a restart
+     * are already cache hits.
+     *
+     */
+    warm_up_file_cache(&worker);
+
     struct epoll_event events[EPOLL_MAX_EVENTS];
 
     syslog(LOG_NOTICE, "Listening for new connections on port %s...", configuration_options->port);
 
     while (TRUE) {
+        /**
+         * Pick up a reloaded configuration between passes,
+         * then report that nothing from before it is in use
+         * any more, so that the configuration it replaces
+         * can be freed.
+         *
+         */
+        if (current_server_configuration() != worker.configuration_options) {
+            adopt_configuration(&worker, current_server_configuration());
+
+            if ((housekeeping_timerfd == -1) && needs_housekeeping(worker.configuration_options)) {
+                housekeeping_timerfd = start_housekeeping_timer(epfd);
+            }
+        }
+
+        configuration_quiescent_state(worker.configuration_reader, worker.configuration_options);
+        configuration_options = worker.configuration_options;
+
         int nfds = epoll_wait(epfd, events, EPOLL_MAX_EVENTS, -1);
 
         if (nfds == -1) {
@@ -396,7 +822,101 @@ int main(int argc, char *argv[])
         }
 
         for (int i = 0; i < nfds; ++i) {
-            if (events[i].data.fd == socket_listen) {
+            if (events[i].data.fd == file_io_eventfd) {
+                complete_file_io_jobs(worker.file_io_pool);
+            } else if ((negative_cache_fd != -1) && (events[i].data.fd == negative_cache_fd)) {
+                if (process_negative_cache_events(watching_negative_cache)) {
+                    for (size_t host = 0; host < worker.host_count; ++host) {
+                        if (worker.hosts[host].negative_cache != watching_negative_cache) {
+                            clear_negative_cache(worker.hosts[host].negative_cache);
+                        }
+                    }
+                }
+            } else if (events[i].data.fd == reload_signalfd) {
+                struct signalfd_siginfo signal_info;
+
+                while (read(reload_signalfd, &signal_info, sizeof (signal_info)) == sizeof (signal_info)) {
+                    continue;
+                }
+
+                /**
+                 * The new configuration is only published
+                 * here. The worker switches over to it at
+                 * the top of the loop, once the events in
+                 * hand have been dealt with.
+                 *
+                 */
+                if (reload_server_configuration()) {
+                    syslog(LOG_NOTICE, "Reloaded configuration from %s", configuration_options->configuration_filename);
+                } else {
+                    syslog(LOG_ERR, "[Error] %s", "Could not reload configuration, keeping the current one");
+                }
+            } else if ((housekeeping_timerfd != -1) && (events[i].data.fd == housekeeping_timerfd)) {
+                uint64_t expirations;
+
+                if (read(housekeeping_timerfd, &expirations, sizeof (expirations)) != sizeof (expirations)) {
+                    continue;
+                }
+
+                housekeeping_ticks += expirations;
+
+                /**
+                 * Every response from a site pack is sent in
+                 * full before the event loop gets here, so
+                 * the old pack can be released right away.
+                 *
+                 */
+                if (worker.site_pack) {
+                    worker.site_pack = reload_site_pack_if_changed(worker.site_pack, configuration_options->site_pack);
+                }
+
+                if (configuration_options->popularity_snapshot && configuration_options->popularity_snapshot_interval && ((housekeeping_ticks % configuration_options->popularity_snapshot_interval) < expirations)) {
+                    save_popularity_snapshot(&worker);
+                }
+
+                if (configuration_options->statistics_interval && ((housekeeping_ticks % configuration_options->statistics_interval) < expirations)) {
+                    log_page_cache_statistics(&worker);
+                    log_io_buffer_statistics();
+                    log_memory_statistics();
+                }
+
+                if (memory_pressure() != MEMORY_PRESSURE_NONE) {
+                    relieve_memory_pressure(&worker);
+                }
+
+                if (!accepting_connections && (memory_pressure() == MEMORY_PRESSURE_NONE)) {
+                    ev.events = EPOLLIN;
+                    ev.data.fd = socket_listen;
+
+                    if (epoll_ctl(epfd, EPOLL_CTL_ADD, socket_listen, &ev) == -1) {
+                        fatal_error("[Error] %s\n", strerror(errno));
+                    }
+
+                    accepting_connections = TRUE;
+                    syslog(LOG_NOTICE, "Memory usage is back within budget, accepting connections again");
+                }
+            } else if (events[i].data.fd == socket_listen) {
+                /**
+                 * Past the soft memory budget, shrink the
+                 * caches, and if that is not enough, stop
+                 * watching the listening socket. New
+                 * connections wait in the backlog until the
+                 * housekeeping timer finds usage back within
+                 * budget. With only a hard budget, they are
+                 * still accepted, and get the 503 below.
+                 *
+                 */
+                if (configuration_options->memory_soft_limit && (memory_pressure() != MEMORY_PRESSURE_NONE)) {
+                    relieve_memory_pressure(&worker);
+
+                    if (memory_pressure() != MEMORY_PRESSURE_NONE) {
+                        epoll_ctl(epfd, EPOLL_CTL_DEL, socket_listen, NULL);
+                        accepting_connections = FALSE;
+                        syslog(LOG_WARNING, "[Warning] %s", "Memory budget exceeded, no longer accepting connections");
+                        continue;
+                    }
+                }
+
                 struct sockaddr_storage client_address;
                 socklen_t client_len = sizeof (client_address);
 
@@ -406,9 +926,23 @@ int main(int argc, char *argv[])
                     fatal_error("[Error] %s\n", strerror(errno));
                 }
 
+                struct connection_t* connection = open_connection(worker.connection_slab, new_connection_socket);
+                connection->accepted_at = time(NULL);
+                connection->address_length = client_len;
+                memcpy(&connection->address, &client_address, sizeof (client_address));
+
+                /**
+                 * The event carries the connection's token
+                 * rather than its bare descriptor, so that
+                 * events for a connection that is closed
+                 * before they are handled can be told apart
+                 * from events for a new connection that
+                 * happens to reuse the descriptor.
+                 *
+                 */
                 // setnonblocking(conn_sock)
                 ev.events = EPOLLIN | EPOLLET | EPOLLRDHUP | EPOLLOUT | EPOLLERR;
-                ev.data.fd = new_connection_socket;
+                ev.data.u64 = connection_token(connection);
 
                 if (epoll_ctl(epfd, EPOLL_CTL_ADD, new_connection_socket, &ev) == -1) {
                     fatal_error("[Error] %s\n", strerror(errno));
@@ -428,42 +962,56 @@ int main(int argc, char *argv[])
                 /** Log the new connection request */
                 syslog(LOG_INFO, "New connection from %s...", address_buffer);
             } else {
+                struct connection_t* connection = lookup_connection(worker.connection_slab, events[i].data.u64);
+
+                if (connection == NULL) {
+                    continue;
+                }
+
                 if (events[i].events & EPOLLIN) {
-                    
-                    /** Allocate a stack buffer for the request data */
-                    char request[1024] = { 0 };
+                    /**
+                     * Take a pooled buffer for the request
+                     * data. It only lives until the request
+                     * has been handed off below, so a
+                     * connection that is waiting for its
+                     * request holds no buffer at all.
+                     *
+                     */
+                    char* request = acquire_io_buffer(REQUEST_BUFFER_SIZE);
 
                     /** Read the client request into the buffer */
-                    ssize_t bytes_received = read(events[i].data.fd, request, 1024);
+                    ssize_t bytes_received = read(connection->fd, request, REQUEST_BUFFER_SIZE - 1);
 
                     if (bytes_received == -1) {
                         /** @todo Actually handle this error */
                         fatal_error("[Error] %s\n", strerror(errno));
                     }
 
-                    /** Log the buffer to stdout for now */
-                    //printf("%s\n", request);
+                    request[bytes_received] = '\0';
 
                     /**
-                     * Stack-allocate a buffer to preserve
-                     * the contents of the original request.
+                     * Past the hard memory budget, the
+                     * request is turned away with a prebuilt
+                     * 503, which needs no memory to send.
                      *
                      */
-                    char original_request[1024] = { 0 };
+                    if (memory_pressure() == MEMORY_PRESSURE_HARD) {
+                        release_io_buffer(request, REQUEST_BUFFER_SIZE);
+                        send_service_unavailable_response(&worker, connection);
+                        continue;
+                    }
+
+                    /** Log the buffer to stdout for now */
+                    //printf("%s\n", request);
 
                     /**
-                     * If the source string is less than n
-                     * bytes long, strncpy(3) pads the destination
-                     * string with NUL bytes to ensure that
-                     * n bytes are always written. It might
-                     * be a good idea to either use a macro
-                     * to specify a size of the minimum
-                     * between n or strlen(request), or just
-                     * not bother zeroing the original_request
-                     * buffer when stack-allocating it.
+                     * Take a second buffer to preserve the
+                     * contents of the original request,
+                     * since tokenizing modifies the first.
                      *
                      */
-                    strncpy(original_request, request, 1024);
+                    char* original_request = acquire_io_buffer(REQUEST_BUFFER_SIZE);
+                    memcpy(original_request, request, (size_t) bytes_received + 1);
 
                     /**
                      * Begin tokenizing the HTTP request
@@ -491,62 +1039,43 @@ int main(int argc, char *argv[])
                         fatal_error("[Error] %s\n", "Invalid request version.");
                     }
 
-                    const char* response =
-                        "HTTP/1.1 200 OK\r\n"
-                        "Connection: Close\r\n"
-                        "Content-Type: text/html\r\n"
-                        "\r\n";
-                    
-                    char filename_buffer[1024] = { 0 };
-                    snprintf(filename_buffer, 1024, "%s%s", configuration_options->document_root_directory, "index.html");
-                    syslog(LOG_DEBUG, "Filename buffer: %s", filename_buffer);
-
-
-                    send(events[i].data.fd, response, strlen(response), 0);
-                    //int f = open(filename_buffer, O_RDONLY | O_NONBLOCK);
-                    //int f = open("samples/site/index.html", O_RDONLY | O_NONBLOCK);
-
-                    //const char* filename = "/home/jflopezfernandez/projects/c/serverd/serverd/samples/site/index.html";
-
-                    int f = open(filename_buffer, O_RDONLY | O_NONBLOCK);
-
-                    if (f == -1) {
-                        syslog(LOG_ERR, "[Error] Could not open file: %s (%s)", filename_buffer, strerror(errno));
-                        return EXIT_FAILURE;
-                    }
-
-                    struct stat status;
-
-                    if (fstat(f, &status) == -1) {
-                        syslog(LOG_ERR, "%s: %s", "Could not check file status", strerror(errno));
-                        return EXIT_FAILURE;
-                    }
-
-                    ssize_t bytes_sent = sendfile(events[i].data.fd, f, NULL, status.st_size);
-
-                    if (bytes_sent == -1) {
-                        syslog(LOG_ERR, "[Error] sendfile(2) failed: %s", strerror(errno));
-                        return EXIT_FAILURE;
-                    }
+                    /**
+                     * Every connection carries a single
+                     * request, so stop watching the socket
+                     * now. A response may take many passes
+                     * through the loop, e.g. while a large
+                     * file is streamed, and the client
+                     * hanging up in the meantime must not be
+                     * mistaken for a new request.
+                     *
+                     */
+                    epoll_ctl(epfd, EPOLL_CTL_DEL, connection->fd, NULL);
 
-                    close(f);
+                    /**
+                     * Route the request to the virtual host
+                     * its Host header names. Requests with
+                     * no Host header, or a name that is not
+                     * configured, go to the default one.
+                     *
+                     */
+                    size_t host_length = 0;
+                    const char* host = request_host(original_request, &host_length);
+                    size_t virtual_host = host ? route_virtual_host(configuration_options->virtual_host_router, host, host_length) : 0;
 
                     /**
-                     * At the moment, the server listens for
-                     * incoming connections, accepts them,
-                     * and returns a 200 OK status with the
-                     * default page regardless of the HTTP
-                     * request type or options. For this
-                     * reason, we are simply closing all
-                     * client connections after the initial
-                     * response is sent, while including the
-                     * appropriate 'Connection: Close' HTTP
-                     * header in the response, as well.
+                     * Hand the request to the location it
+                     * falls in, which redirects it, answers
+                     * it outright, or serves it from the
+                     * site pack or the document root. In
+                     * the last case, the response is
+                     * finished asynchronously, once the
+                     * file I/O pool has opened the file.
                      *
                      */
-                    int current_socket = events[i].data.fd;
-                    epoll_ctl(epfd, EPOLL_CTL_DEL, events[i].data.fd, NULL);
-                    close(current_socket);
+                    serve_request(&worker, virtual_host, connection, request_uri, request_accepts_gzip(original_request));
+
+                    release_io_buffer(original_request, REQUEST_BUFFER_SIZE);
+                    release_io_buffer(request, REQUEST_BUFFER_SIZE);
                 }
             }
         }
@@ -21,23 +21,170 @@
  *
  */
 
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <pthread.h>
+
+#include <syslog.h>
 
 /**
- * Allow for the use of the jemalloc memory allocator instead
- * of the standard library malloc.
+ * Select the memory allocator backend.
+ *
+ * @details The Makefile defines at most one of these,
+ * according to its ALLOCATOR variable; with none, the C
+ * standard library malloc is used. jemalloc replaces
+ * malloc(3) outright, mimalloc is called through its own
+ * interface, and the pool backend serves every block from
+ * serverd's own size-classed pools.
  *
  */
+#if defined(ENABLE_JEMALLOC) + defined(ENABLE_MIMALLOC) + defined(ENABLE_POOL_ALLOCATOR) > 1
+#error "At most one memory allocator backend may be enabled"
+#endif
+
 #if defined(ENABLE_JEMALLOC)
+#include <stdbool.h>
 #include <jemalloc/jemalloc.h>
+#elif defined(ENABLE_MIMALLOC)
+#include <mimalloc.h>
+#elif defined(ENABLE_POOL_ALLOCATOR)
+#include <sys/mman.h>
 #endif
 
 #include "serverd.h"
 #include "error.h"
 #include "memory.h"
 
+/**
+ * @def MEMORY_MAX_THREAD_ARENAS
+ * @brief Maximum number of per-thread arenas whose
+ * statistics are reported.
+ *
+ */
+#ifndef MEMORY_MAX_THREAD_ARENAS
+#define MEMORY_MAX_THREAD_ARENAS (64)
+#endif
+
+/**
+ * The allocator tuning, and the arenas created under it.
+ *
+ */
+static struct memory_tuning_t memory_tuning = { FALSE, TRUE, -1, -1 };
+
+/**
+ * The header in front of every block handed out by this
+ * module, recording what to refund when it is freed. It is
+ * as large as max_align_t, so the block after it is aligned
+ * for any type.
+ *
+ */
+union memory_header_t {
+    struct {
+        size_t size;
+        enum memory_tag_t tag;
+    } block;
+    max_align_t alignment;
+};
+
+/**
+ * The bytes charged to each tag, and the budgets.
+ *
+ */
+static atomic_size_t tagged_usage[MEMORY_TAG_COUNT];
+static size_t soft_memory_limit = 0;
+static size_t hard_memory_limit = 0;
+
+#if defined(ENABLE_JEMALLOC)
+static pthread_mutex_t thread_arena_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned thread_arenas[MEMORY_MAX_THREAD_ARENAS];
+static size_t thread_arena_count = 0;
+#endif
+
+#if defined(ENABLE_POOL_ALLOCATOR)
+/**
+ * @def POOL_ALLOCATOR_MIN_SHIFT
+ * @brief log2 of the smallest pooled block.
+ *
+ */
+#ifndef POOL_ALLOCATOR_MIN_SHIFT
+#define POOL_ALLOCATOR_MIN_SHIFT (5)
+#endif
+
+/**
+ * @def POOL_ALLOCATOR_MAX_SHIFT
+ * @brief log2 of the largest pooled block. Anything larger
+ * is mapped on its own.
+ *
+ */
+#ifndef POOL_ALLOCATOR_MAX_SHIFT
+#define POOL_ALLOCATOR_MAX_SHIFT (20)
+#endif
+
+#define POOL_ALLOCATOR_CLASS_COUNT (POOL_ALLOCATOR_MAX_SHIFT - POOL_ALLOCATOR_MIN_SHIFT + 1)
+
+/**
+ * @def POOL_ALLOCATOR_SLAB_SIZE
+ * @brief Size of the mappings pooled blocks are carved from.
+ * It must be at least as large as the largest pooled block.
+ *
+ */
+#ifndef POOL_ALLOCATOR_SLAB_SIZE
+#define POOL_ALLOCATOR_SLAB_SIZE (1 << 20)
+#endif
+
+#if (1 << POOL_ALLOCATOR_MAX_SHIFT) > POOL_ALLOCATOR_SLAB_SIZE
+#error "POOL_ALLOCATOR_SLAB_SIZE must hold the largest pooled block"
+#endif
+
+/**
+ * @def POOL_ALLOCATOR_THREAD_CACHE
+ * @brief Maximum free blocks of each size a thread keeps to
+ * itself before handing half of them back. For large blocks
+ * the limit is lower, so that a thread never holds more
+ * than half a slab's worth of any size.
+ *
+ */
+#ifndef POOL_ALLOCATOR_THREAD_CACHE
+#define POOL_ALLOCATOR_THREAD_CACHE (64)
+#endif
+
+/**
+ * The pool backend.
+ *
+ * @details Blocks are powers of two. Each thread frees to
+ * and allocates from its own lists without locking, and
+ * trades blocks in batches with the shared lists, which are
+ * refilled by carving up fresh slabs. Slabs are never
+ * returned to the kernel; a thread's cached blocks go back
+ * to the shared lists when it exits.
+ *
+ */
+struct pool_block_t {
+    struct pool_block_t* next;
+};
+
+struct pool_thread_cache_t {
+    struct pool_block_t* free_lists[POOL_ALLOCATOR_CLASS_COUNT];
+    size_t counts[POOL_ALLOCATOR_CLASS_COUNT];
+};
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct pool_block_t* pool_free_lists[POOL_ALLOCATOR_CLASS_COUNT];
+static char* pool_slab_cursors[POOL_ALLOCATOR_CLASS_COUNT];
+static char* pool_slab_limits[POOL_ALLOCATOR_CLASS_COUNT];
+
+static _Thread_local struct pool_thread_cache_t pool_thread_cache;
+static pthread_once_t pool_thread_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t pool_thread_key;
+
+static atomic_size_t pool_slab_bytes;
+static atomic_size_t pool_large_bytes;
+#endif
+
 /**
  * Allocate number of bytes specified by size argument.
  *
@@ -53,17 +200,288 @@
  *
  */
 void* allocate_memory(size_t size) {
+    return allocate_tagged_memory(MEMORY_TAG_OTHER, size);
+}
+
+#if defined(ENABLE_POOL_ALLOCATOR)
+/**
+ * Return the pool class of a block size, or -1 if it is too
+ * large to be pooled.
+ *
+ */
+static int pool_class(size_t size) {
+    int shift = POOL_ALLOCATOR_MIN_SHIFT;
+
+    while (((size_t) 1 << shift) < size) {
+        if (++shift > POOL_ALLOCATOR_MAX_SHIFT) {
+            return -1;
+        }
+    }
+
+    return shift - POOL_ALLOCATOR_MIN_SHIFT;
+}
+
+/**
+ * Return how many blocks of a class a thread takes from, or
+ * hands back to, the shared list at a time.
+ *
+ */
+static size_t pool_batch_size(int class) {
+    size_t batch = (POOL_ALLOCATOR_SLAB_SIZE >> (class + POOL_ALLOCATOR_MIN_SHIFT)) / 4;
+
+    if (batch > POOL_ALLOCATOR_THREAD_CACHE / 2) {
+        return POOL_ALLOCATOR_THREAD_CACHE / 2;
+    }
+
+    return batch ? batch : 1;
+}
+
+/**
+ * Move count blocks of a class from one list to another.
+ *
+ */
+static size_t move_pool_blocks(struct pool_block_t** from, struct pool_block_t** to, size_t count) {
+    size_t moved = 0;
+
+    while (*from && (moved < count)) {
+        struct pool_block_t* block = *from;
+        *from = block->next;
+        block->next = *to;
+        *to = block;
+        ++moved;
+    }
+
+    return moved;
+}
+
+/**
+ * Hand all of an exiting thread's cached blocks back to the
+ * shared lists.
+ *
+ */
+static void flush_pool_thread_cache(void* unused) {
+    (void) unused;
+
+    struct pool_thread_cache_t* cache = &pool_thread_cache;
+
+    pthread_mutex_lock(&pool_lock);
+
+    for (int class = 0; class < POOL_ALLOCATOR_CLASS_COUNT; ++class) {
+        move_pool_blocks(&cache->free_lists[class], &pool_free_lists[class], cache->counts[class]);
+        cache->counts[class] = 0;
+    }
+
+    pthread_mutex_unlock(&pool_lock);
+}
+
+static void create_pool_thread_key(void) {
+    pthread_key_create(&pool_thread_key, flush_pool_thread_cache);
+}
+
+/**
+ * Fill a thread's list for a class with a batch of blocks,
+ * from the shared list if it has any and from the current
+ * slab otherwise.
+ *
+ */
+static int refill_pool_thread_cache(struct pool_thread_cache_t* cache, int class) {
+    size_t block_size = (size_t) 1 << (class + POOL_ALLOCATOR_MIN_SHIFT);
+    size_t wanted = pool_batch_size(class);
+
     /**
-     * Allocate the memory block of requested size.
+     * Registering the thread-specific value is only for its
+     * destructor, which flushes the cache when the thread
+     * exits.
      *
-     * @note If jemalloc is enabled, this call to malloc is
-     * transparently replaced to a call to je_malloc via a
-     * preprocessor macro definition. This can be disabled
-     * by defining JEMALLOC_NO_RENAME, but the default is
-     * probably both simpler and preferable.
+     */
+    pthread_once(&pool_thread_key_once, create_pool_thread_key);
+    pthread_setspecific(pool_thread_key, cache);
+
+    pthread_mutex_lock(&pool_lock);
+
+    size_t moved = move_pool_blocks(&pool_free_lists[class], &cache->free_lists[class], wanted);
+
+    while (moved < wanted) {
+        if (pool_slab_cursors[class] == pool_slab_limits[class]) {
+            void* slab = mmap(NULL, POOL_ALLOCATOR_SLAB_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+            if (slab == MAP_FAILED) {
+                break;
+            }
+
+            atomic_fetch_add_explicit(&pool_slab_bytes, POOL_ALLOCATOR_SLAB_SIZE, memory_order_relaxed);
+
+            pool_slab_cursors[class] = slab;
+            pool_slab_limits[class] = (char *) slab + POOL_ALLOCATOR_SLAB_SIZE;
+        }
+
+        struct pool_block_t* block = (struct pool_block_t *) pool_slab_cursors[class];
+        pool_slab_cursors[class] += block_size;
+
+        block->next = cache->free_lists[class];
+        cache->free_lists[class] = block;
+        ++moved;
+    }
+
+    pthread_mutex_unlock(&pool_lock);
+
+    cache->counts[class] += moved;
+
+    return moved > 0;
+}
+
+/**
+ * Allocate a block from the pools, or map it on its own if
+ * it is too large for them.
+ *
+ */
+static void* pool_allocate(size_t size) {
+    int class = pool_class(size);
+
+    if (class == -1) {
+        void* memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (memory == MAP_FAILED) {
+            return NULL;
+        }
+
+        atomic_fetch_add_explicit(&pool_large_bytes, size, memory_order_relaxed);
+
+        return memory;
+    }
+
+    struct pool_thread_cache_t* cache = &pool_thread_cache;
+
+    if ((cache->free_lists[class] == NULL) && !refill_pool_thread_cache(cache, class)) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    struct pool_block_t* block = cache->free_lists[class];
+    cache->free_lists[class] = block->next;
+    cache->counts[class]--;
+
+    return block;
+}
+
+/**
+ * Return a block to the calling thread's list, handing half
+ * of the list back to the shared one if it is full.
+ *
+ */
+static void pool_free(void* memory, size_t size) {
+    int class = pool_class(size);
+
+    if (class == -1) {
+        munmap(memory, size);
+        atomic_fetch_sub_explicit(&pool_large_bytes, size, memory_order_relaxed);
+        return;
+    }
+
+    struct pool_thread_cache_t* cache = &pool_thread_cache;
+    struct pool_block_t* block = memory;
+
+    block->next = cache->free_lists[class];
+    cache->free_lists[class] = block;
+
+    size_t batch = pool_batch_size(class);
+
+    if (++cache->counts[class] > 2 * batch) {
+        pthread_mutex_lock(&pool_lock);
+        cache->counts[class] -= move_pool_blocks(&cache->free_lists[class], &pool_free_lists[class], batch);
+        pthread_mutex_unlock(&pool_lock);
+    }
+}
+#endif
+
+/**
+ * Allocate size bytes from the configured backend, or return
+ * NULL.
+ *
+ * @note If jemalloc is enabled, this call to malloc is
+ * transparently replaced to a call to je_malloc via a
+ * preprocessor macro definition. This can be disabled
+ * by defining JEMALLOC_NO_RENAME, but the default is
+ * probably both simpler and preferable.
+ *
+ */
+static void* backend_allocate(size_t size) {
+#if defined(ENABLE_MIMALLOC)
+    return mi_malloc(size);
+#elif defined(ENABLE_POOL_ALLOCATOR)
+    return pool_allocate(size);
+#else
+    return malloc(size);
+#endif
+}
+
+/**
+ * Free a block of the given size to the configured backend.
+ *
+ */
+static void backend_free(void* memory, size_t size) {
+#if defined(ENABLE_MIMALLOC)
+    (void) size;
+    mi_free(memory);
+#elif defined(ENABLE_POOL_ALLOCATOR)
+    pool_free(memory, size);
+#else
+    (void) size;
+    free(memory);
+#endif
+}
+
+/**
+ * Return the name of the memory allocator backend.
+ *
+ */
+const char* memory_allocator_name(void) {
+#if defined(ENABLE_JEMALLOC)
+    return "jemalloc";
+#elif defined(ENABLE_MIMALLOC)
+    return "mimalloc";
+#elif defined(ENABLE_POOL_ALLOCATOR)
+    return "pool";
+#else
+    return "glibc";
+#endif
+}
+
+/**
+ * Allocate a block with its accounting header, and charge it
+ * to its tag, or return NULL.
+ *
+ */
+static void* allocate_memory_block(enum memory_tag_t tag, size_t size) {
+    if (size > SIZE_MAX - sizeof (union memory_header_t)) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    union memory_header_t* header = backend_allocate(sizeof (union memory_header_t) + size);
+
+    if (header == NULL) {
+        return NULL;
+    }
+
+    header->block.size = size;
+    header->block.tag = tag;
+
+    atomic_fetch_add_explicit(&tagged_usage[tag], size, memory_order_relaxed);
+
+    return header + 1;
+}
+
+/**
+ * Allocate memory charged to the given tag.
+ *
+ */
+void* allocate_tagged_memory(enum memory_tag_t tag, size_t size) {
+    /**
+     * Allocate the memory block of requested size.
      *
      */
-    void* memory_block = malloc(size);
+    void* memory_block = allocate_memory_block(tag, size);
 
     /**
      * Ensure that pointer returned by the call to malloc
@@ -133,11 +551,15 @@ void safe_free(void** ptr) {
     }
 
     /**
-     * Free the memory pointed to by *ptr. There is no
-     * return value from a call to free(3).
+     * Refund the block to its tag, and free it along with
+     * its header to the backend it came from.
      *
      */
-    free(*ptr);
+    union memory_header_t* header = (union memory_header_t *) *ptr - 1;
+
+    atomic_fetch_sub_explicit(&tagged_usage[header->block.tag], header->block.size, memory_order_relaxed);
+
+    backend_free(header, sizeof (union memory_header_t) + header->block.size);
 
     /**
      * Calling free(3) on the same memory block twice
@@ -154,3 +576,410 @@ void safe_free(void** ptr) {
      */
     *ptr = NULL;
 }
+
+/**
+ * The total bytes charged across all tags.
+ *
+ */
+static size_t total_memory_usage(void) {
+    size_t total = 0;
+
+    for (int tag = 0; tag < MEMORY_TAG_COUNT; ++tag) {
+        total += atomic_load_explicit(&tagged_usage[tag], memory_order_relaxed);
+    }
+
+    return total;
+}
+
+/**
+ * Allocate memory charged to the given tag, or return NULL.
+ *
+ */
+void* try_allocate_memory(enum memory_tag_t tag, size_t size) {
+    if (hard_memory_limit && (total_memory_usage() + size > hard_memory_limit)) {
+        return NULL;
+    }
+
+    return allocate_memory_block(tag, size);
+}
+
+/**
+ * Charge or refund memory that was not allocated by this
+ * module.
+ *
+ */
+void account_memory(enum memory_tag_t tag, long long delta) {
+    if (delta < 0) {
+        atomic_fetch_sub_explicit(&tagged_usage[tag], (size_t) -delta, memory_order_relaxed);
+    } else {
+        atomic_fetch_add_explicit(&tagged_usage[tag], (size_t) delta, memory_order_relaxed);
+    }
+}
+
+/**
+ * The number of bytes currently charged to a tag.
+ *
+ */
+size_t memory_usage(enum memory_tag_t tag) {
+    return atomic_load_explicit(&tagged_usage[tag], memory_order_relaxed);
+}
+
+/**
+ * Set the soft and hard memory budgets, in bytes.
+ *
+ */
+void set_memory_budget(size_t soft_limit, size_t hard_limit) {
+    soft_memory_limit = soft_limit;
+    hard_memory_limit = hard_limit;
+}
+
+/**
+ * Compare the total usage across all tags to the budgets.
+ *
+ */
+enum memory_pressure_t memory_pressure(void) {
+    if ((soft_memory_limit == 0) && (hard_memory_limit == 0)) {
+        return MEMORY_PRESSURE_NONE;
+    }
+
+    size_t total = total_memory_usage();
+
+    if (hard_memory_limit && (total >= hard_memory_limit)) {
+        return MEMORY_PRESSURE_HARD;
+    }
+
+    if (soft_memory_limit && (total >= soft_memory_limit)) {
+        return MEMORY_PRESSURE_SOFT;
+    }
+
+    return MEMORY_PRESSURE_NONE;
+}
+
+/**
+ * Set the allocator tuning.
+ *
+ * @details The decay times become the defaults for arenas
+ * created from here on, and are applied to the arenas that
+ * already exist, including the automatic ones.
+ *
+ */
+void configure_memory_allocator(const struct memory_tuning_t* tuning) {
+    memory_tuning = *tuning;
+
+#if defined(ENABLE_JEMALLOC)
+    unsigned arena_count = 0;
+    size_t length = sizeof (arena_count);
+
+    if (mallctl("arenas.narenas", &arena_count, &length, NULL, 0) != 0) {
+        return;
+    }
+
+    const char* settings[2] = { "dirty_decay_ms", "muzzy_decay_ms" };
+    ssize_t values[2] = { (ssize_t) tuning->dirty_decay_ms, (ssize_t) tuning->muzzy_decay_ms };
+
+    for (int i = 0; i < 2; ++i) {
+        if (values[i] < 0) {
+            continue;
+        }
+
+        char name[64];
+        snprintf(name, sizeof (name), "arenas.%s", settings[i]);
+        mallctl(name, NULL, NULL, &values[i], sizeof (values[i]));
+
+        for (unsigned arena = 0; arena < arena_count; ++arena) {
+            snprintf(name, sizeof (name), "arena.%u.%s", arena, settings[i]);
+            mallctl(name, NULL, NULL, &values[i], sizeof (values[i]));
+        }
+    }
+#endif
+}
+
+/**
+ * Set up the calling thread's allocator state.
+ *
+ */
+void initialize_thread_memory(void) {
+#if defined(ENABLE_JEMALLOC)
+    bool thread_cache = memory_tuning.thread_cache ? true : false;
+    mallctl("thread.tcache.enabled", NULL, NULL, &thread_cache, sizeof (thread_cache));
+
+    if (!memory_tuning.per_thread_arenas) {
+        return;
+    }
+
+    unsigned arena = 0;
+    size_t length = sizeof (arena);
+
+    if (mallctl("arenas.create", &arena, &length, NULL, 0) != 0) {
+        syslog(LOG_WARNING, "[Warning] %s", "Could not create a jemalloc arena for this thread");
+        return;
+    }
+
+    if (mallctl("thread.arena", NULL, NULL, &arena, sizeof (arena)) != 0) {
+        syslog(LOG_WARNING, "[Warning] %s", "Could not bind this thread to its jemalloc arena");
+        return;
+    }
+
+    pthread_mutex_lock(&thread_arena_lock);
+
+    if (thread_arena_count < MEMORY_MAX_THREAD_ARENAS) {
+        thread_arenas[thread_arena_count++] = arena;
+    }
+
+    pthread_mutex_unlock(&thread_arena_lock);
+#endif
+}
+
+#if defined(ENABLE_JEMALLOC)
+/**
+ * Read one size_t statistic, or 0 if it is unavailable.
+ *
+ */
+static size_t read_memory_statistic(const char* name) {
+    size_t value = 0;
+    size_t length = sizeof (value);
+
+    if (mallctl(name, &value, &length, NULL, 0) != 0) {
+        return 0;
+    }
+
+    return value;
+}
+#endif
+
+/**
+ * Log the allocator's statistics.
+ *
+ * @details jemalloc only refreshes its statistics when the
+ * epoch is advanced, so that comes first.
+ *
+ */
+void log_memory_statistics(void) {
+    syslog(LOG_INFO, "Memory usage: %zu connections, %zu buffers, %zu caches, %zu configuration, %zu other",
+        memory_usage(MEMORY_TAG_CONNECTIONS),
+        memory_usage(MEMORY_TAG_BUFFERS),
+        memory_usage(MEMORY_TAG_CACHES),
+        memory_usage(MEMORY_TAG_CONFIGURATION),
+        memory_usage(MEMORY_TAG_OTHER));
+
+#if defined(ENABLE_JEMALLOC)
+    uint64_t epoch = 1;
+    size_t length = sizeof (epoch);
+    mallctl("epoch", &epoch, &length, &epoch, length);
+
+    syslog(LOG_INFO, "Memory: %zu allocated, %zu active, %zu resident, %zu retained",
+        read_memory_statistic("stats.allocated"),
+        read_memory_statistic("stats.active"),
+        read_memory_statistic("stats.resident"),
+        read_memory_statistic("stats.retained"));
+
+    size_t page_size = read_memory_statistic("arenas.page");
+
+    pthread_mutex_lock(&thread_arena_lock);
+
+    for (size_t i = 0; i < thread_arena_count; ++i) {
+        char name[64];
+        size_t allocated;
+        size_t active;
+        size_t resident;
+        size_t retained;
+
+        snprintf(name, sizeof (name), "stats.arenas.%u.small.allocated", thread_arenas[i]);
+        allocated = read_memory_statistic(name);
+        snprintf(name, sizeof (name), "stats.arenas.%u.large.allocated", thread_arenas[i]);
+        allocated += read_memory_statistic(name);
+        snprintf(name, sizeof (name), "stats.arenas.%u.pactive", thread_arenas[i]);
+        active = read_memory_statistic(name) * page_size;
+        snprintf(name, sizeof (name), "stats.arenas.%u.resident", thread_arenas[i]);
+        resident = read_memory_statistic(name);
+        snprintf(name, sizeof (name), "stats.arenas.%u.retained", thread_arenas[i]);
+        retained = read_memory_statistic(name);
+
+        syslog(LOG_INFO, "Memory arena %u: %zu allocated, %zu active, %zu resident, %zu retained", thread_arenas[i], allocated, active, resident, retained);
+    }
+
+    pthread_mutex_unlock(&thread_arena_lock);
+#elif defined(ENABLE_MIMALLOC)
+    size_t resident = 0;
+    size_t peak_resident = 0;
+    size_t committed = 0;
+
+    mi_process_info(NULL, NULL, NULL, &resident, &peak_resident, &committed, NULL, NULL);
+
+    syslog(LOG_INFO, "Memory: %zu resident, %zu peak resident, %zu committed", resident, peak_resident, committed);
+#elif defined(ENABLE_POOL_ALLOCATOR)
+    syslog(LOG_INFO, "Memory: %zu in pool slabs, %zu in large mappings",
+        atomic_load_explicit(&pool_slab_bytes, memory_order_relaxed),
+        atomic_load_explicit(&pool_large_bytes, memory_order_relaxed));
+#endif
+}
+
+/**
+ * Round a size up to the alignment of arena allocations.
+ *
+ */
+static size_t align_arena_size(size_t size) {
+    return (size + sizeof (max_align_t) - 1) & ~(sizeof (max_align_t) - 1);
+}
+
+/**
+ * Create a pool of up to capacity idle arena chunks.
+ *
+ */
+struct arena_chunk_pool_t* create_arena_chunk_pool(size_t chunk_size, size_t capacity) {
+    struct arena_chunk_pool_t* pool = allocate_memory(sizeof (struct arena_chunk_pool_t));
+
+    pool->free_list = NULL;
+    pool->free_count = 0;
+    pool->capacity = capacity;
+    pool->chunk_size = (chunk_size > sizeof (struct arena_chunk_t)) ? chunk_size : sizeof (struct arena_chunk_t) + sizeof (struct memory_arena_t);
+
+    return pool;
+}
+
+/**
+ * Return every idle chunk in the pool to the allocator.
+ *
+ */
+void trim_arena_chunk_pool(struct arena_chunk_pool_t* pool) {
+    while (pool->free_list) {
+        struct arena_chunk_t* chunk = pool->free_list;
+        pool->free_list = chunk->next;
+        FREE(chunk);
+    }
+
+    pool->free_count = 0;
+}
+
+/**
+ * Take a chunk with room for at least size bytes.
+ *
+ * @details Requests that fit in a pooled chunk are served
+ * from the free list when possible; anything larger gets a
+ * chunk sized just for it. This returns NULL if a new chunk
+ * could not be allocated.
+ *
+ */
+static struct arena_chunk_t* acquire_arena_chunk(struct arena_chunk_pool_t* pool, size_t size) {
+    size_t capacity = pool->chunk_size - sizeof (struct arena_chunk_t);
+    struct arena_chunk_t* chunk = NULL;
+
+    if (size <= capacity) {
+        chunk = pool->free_list;
+
+        if (chunk) {
+            pool->free_list = chunk->next;
+            pool->free_count--;
+        } else {
+            chunk = try_allocate_memory(MEMORY_TAG_CONNECTIONS, pool->chunk_size);
+
+            if (chunk == NULL) {
+                return NULL;
+            }
+
+            chunk->size = capacity;
+        }
+    } else {
+        chunk = try_allocate_memory(MEMORY_TAG_CONNECTIONS, sizeof (struct arena_chunk_t) + size);
+
+        if (chunk == NULL) {
+            return NULL;
+        }
+
+        chunk->size = size;
+    }
+
+    chunk->next = NULL;
+    chunk->used = 0;
+
+    return chunk;
+}
+
+/**
+ * Create an arena on a chunk from the pool.
+ *
+ */
+struct memory_arena_t* create_memory_arena(struct arena_chunk_pool_t* pool) {
+    struct arena_chunk_t* chunk = acquire_arena_chunk(pool, align_arena_size(sizeof (struct memory_arena_t)));
+
+    if (chunk == NULL) {
+        return NULL;
+    }
+
+    struct memory_arena_t* arena = (struct memory_arena_t *) chunk->data;
+
+    chunk->used = align_arena_size(sizeof (struct memory_arena_t));
+    arena->chunks = chunk;
+    arena->pool = pool;
+
+    return arena;
+}
+
+/**
+ * Allocate memory from an arena.
+ *
+ */
+void* arena_allocate(struct memory_arena_t* arena, size_t size) {
+    size = align_arena_size(size ? size : 1);
+
+    struct arena_chunk_t* chunk = arena->chunks;
+
+    if (chunk->size - chunk->used < size) {
+        struct arena_chunk_t* fresh = acquire_arena_chunk(arena->pool, size);
+
+        if (fresh == NULL) {
+            return NULL;
+        }
+
+        /**
+         * A new pooled chunk becomes the current one, since
+         * the old one is nearly full. An oversized chunk is
+         * full from the start, so it goes behind the current
+         * chunk, which keeps serving small allocations.
+         *
+         */
+        if (fresh->size == arena->pool->chunk_size - sizeof (struct arena_chunk_t)) {
+            fresh->next = chunk;
+            arena->chunks = fresh;
+        } else {
+            fresh->next = chunk->next;
+            chunk->next = fresh;
+        }
+
+        chunk = fresh;
+    }
+
+    void* memory = (char *) chunk->data + chunk->used;
+    chunk->used += size;
+
+    return memory;
+}
+
+/**
+ * Release an arena and everything allocated from it.
+ *
+ */
+void release_memory_arena(struct memory_arena_t* arena) {
+    struct arena_chunk_pool_t* pool = arena->pool;
+    struct arena_chunk_t* chunk = arena->chunks;
+    size_t pooled_size = pool->chunk_size - sizeof (struct arena_chunk_t);
+
+    /**
+     * The arena lives inside one of these chunks, so it must
+     * not be touched from here on.
+     *
+     */
+    while (chunk) {
+        struct arena_chunk_t* next = chunk->next;
+
+        if ((chunk->size == pooled_size) && (pool->free_count < pool->capacity)) {
+            chunk->next = pool->free_list;
+            pool->free_list = chunk;
+            pool->free_count++;
+        } else {
+            FREE(chunk);
+        }
+
+        chunk = next;
+    }
+}
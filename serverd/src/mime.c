@@ -0,0 +1,248 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "serverd.h"
+#include "configuration.h"
+#include "error.h"
+#include "memory.h"
+#include "perfect_hash.h"
+#include "mime.h"
+
+/**
+ * The generated MIME table.
+ *
+ * @details This header is produced at build time by
+ * tools/generate_mime_table from data/mime.types and is
+ * never checked in. It defines the perfect hash masks,
+ * the displacement array and the slot table.
+ *
+ */
+#include "mime_table.h"
+
+/**
+ * The MIME type reported for files whose extension is
+ * missing or not in the table.
+ *
+ */
+static const struct mime_type_t default_mime_type = {
+    { 0, 0 },
+    "Content-Type: application/octet-stream\r\n",
+    sizeof ("Content-Type: application/octet-stream\r\n") - 1
+};
+
+/**
+ * The perfect hash currently in use.
+ *
+ * @details Until initialize_mime_types() merges in any user
+ * overrides, these point straight at the generated table,
+ * so a server without MimeType directives never copies it.
+ *
+ */
+static struct perfect_hash_t mime_hash = {
+    mime_table_displacements,
+    MIME_TABLE_BUCKET_MASK,
+    MIME_TABLE_SLOT_MASK
+};
+
+static const struct mime_type_t* mime_entries = mime_table_entries;
+
+/**
+ * The memory behind a merged table, or NULL while the
+ * generated table is in use.
+ *
+ * @details The Content-Type header lines of every override
+ * share a single block, so that a table can be released
+ * with two calls to the allocator when it is replaced.
+ *
+ */
+static struct mime_type_t* merged_entries = NULL;
+static char* merged_headers = NULL;
+
+/**
+ * Release the merged table, if there is one. Its
+ * displacement array belongs to the current hash.
+ *
+ */
+static void release_merged_mime_table(void) {
+    if (merged_entries == NULL) {
+        return;
+    }
+
+    FREE(mime_hash.displacements);
+    FREE(merged_entries);
+    FREE(merged_headers);
+}
+
+/**
+ * Merge the user's MIME type overrides into the table.
+ *
+ * @details Overrides replace built-in entries with the same
+ * extension, and new extensions are simply added. The
+ * combined set is then run through the same perfect hash
+ * construction the build-time generator uses.
+ *
+ * Calling this again, after a configuration reload, builds
+ * the table from scratch and releases the previous one, so
+ * the caller must make sure no header from it is in use.
+ *
+ */
+int initialize_mime_types(const struct configuration_options_t* configuration_options) {
+    if (configuration_options->mime_type_overrides == NULL) {
+        release_merged_mime_table();
+
+        mime_hash = (struct perfect_hash_t) { mime_table_displacements, MIME_TABLE_BUCKET_MASK, MIME_TABLE_SLOT_MASK };
+        mime_entries = mime_table_entries;
+
+        return TRUE;
+    }
+
+    size_t override_count = 0;
+    size_t headers_length = 0;
+
+    for (const struct mime_type_override_t* o = configuration_options->mime_type_overrides; o; o = o->next) {
+        ++override_count;
+        headers_length += strlen("Content-Type: \r\n") + strlen(o->content_type) + 1;
+    }
+
+    size_t capacity = MIME_TABLE_ENTRIES + override_count;
+    struct mime_type_t* merged = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (struct mime_type_t) * capacity);
+    char* headers = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, headers_length);
+    size_t count = 0;
+
+    for (uint32_t slot = 0; slot <= MIME_TABLE_SLOT_MASK; ++slot) {
+        if (mime_table_entries[slot].content_type_header) {
+            merged[count++] = mime_table_entries[slot];
+        }
+    }
+
+    char* header = headers;
+
+    for (const struct mime_type_override_t* o = configuration_options->mime_type_overrides; o; o = o->next) {
+        struct mime_type_t entry;
+        pack_mime_extension(o->extension, strlen(o->extension), entry.extension);
+        entry.content_type_header = header;
+        entry.content_type_header_length = (size_t) sprintf(header, "Content-Type: %s\r\n", o->content_type);
+
+        header += entry.content_type_header_length + 1;
+
+        /**
+         * Replace the existing mapping for this extension,
+         * if there is one. This is a linear scan, but it
+         * only runs at startup and on a reload.
+         *
+         */
+        size_t i = 0;
+
+        while ((i < count) && ((merged[i].extension[0] != entry.extension[0]) || (merged[i].extension[1] != entry.extension[1]))) {
+            ++i;
+        }
+
+        merged[i] = entry;
+
+        if (i == count) {
+            ++count;
+        }
+    }
+
+    uint64_t* keys = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (uint64_t) * count);
+    uint32_t* slots = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (uint32_t) * count);
+
+    for (size_t i = 0; i < count; ++i) {
+        keys[i] = mime_extension_fingerprint(merged[i].extension);
+    }
+
+    struct perfect_hash_t hash;
+
+    if (build_perfect_hash(keys, count, &hash, slots) == FALSE) {
+        FREE(slots);
+        FREE(keys);
+        FREE(merged);
+        FREE(headers);
+
+        return FALSE;
+    }
+
+    struct mime_type_t* entries = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (struct mime_type_t) * (hash.slot_mask + 1));
+    memset(entries, 0, sizeof (struct mime_type_t) * (hash.slot_mask + 1));
+
+    for (size_t i = 0; i < count; ++i) {
+        entries[slots[i]] = merged[i];
+    }
+
+    FREE(slots);
+    FREE(keys);
+    FREE(merged);
+
+    release_merged_mime_table();
+
+    mime_hash = hash;
+    mime_entries = entries;
+    merged_entries = entries;
+    merged_headers = headers;
+
+    return TRUE;
+}
+
+/**
+ * Look up the MIME type of a file by its extension.
+ *
+ * @details The extension is found by scanning backwards
+ * from the end of the filename, packed into its two-word
+ * key, and hashed. The lookup itself is then one load from
+ * the displacement array, one load from the slot table,
+ * and two integer comparisons.
+ *
+ */
+const struct mime_type_t* lookup_mime_type(const char* filename) {
+    size_t length = strlen(filename);
+    size_t extension_length = 0;
+
+    while ((extension_length < length) && (extension_length <= MIME_EXTENSION_MAX_LENGTH)) {
+        char c = filename[length - extension_length - 1];
+
+        if ((c == '.') || (c == '/')) {
+            break;
+        }
+
+        ++extension_length;
+    }
+
+    if ((extension_length == 0) || (extension_length > MIME_EXTENSION_MAX_LENGTH) || (extension_length == length) || (filename[length - extension_length - 1] != '.')) {
+        return &default_mime_type;
+    }
+
+    uint64_t packed[2];
+    pack_mime_extension(filename + length - extension_length, extension_length, packed);
+
+    const struct mime_type_t* entry = &mime_entries[perfect_hash_slot(&mime_hash, mime_extension_fingerprint(packed))];
+
+    if ((entry->extension[0] != packed[0]) || (entry->extension[1] != packed[1]) || (entry->content_type_header == NULL)) {
+        return &default_mime_type;
+    }
+
+    return entry;
+}
@@ -0,0 +1,473 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+
+#include <unistd.h>
+#include <syslog.h>
+
+#include <sys/inotify.h>
+
+#include "serverd.h"
+#include "memory.h"
+#include "negative_cache.h"
+#include "perfect_hash.h"
+
+/**
+ * @def NEGATIVE_CACHE_BLOOM_BITS_PER_ENTRY
+ * @brief Size of the Bloom filter, in bits per entry.
+ *
+ * @details Together with four probes per path, ten bits per
+ * entry keeps the false positive rate at around one percent.
+ *
+ */
+#ifndef NEGATIVE_CACHE_BLOOM_BITS_PER_ENTRY
+#define NEGATIVE_CACHE_BLOOM_BITS_PER_ENTRY (10)
+#endif
+
+/**
+ * @def NEGATIVE_CACHE_BLOOM_PROBES
+ * @brief Number of bits set in the Bloom filter per path.
+ *
+ */
+#ifndef NEGATIVE_CACHE_BLOOM_PROBES
+#define NEGATIVE_CACHE_BLOOM_PROBES (4)
+#endif
+
+/**
+ * The directory events that can make a missing file appear.
+ *
+ * @details A file appears when it, or any directory above
+ * it, is created or moved into place. A watched directory
+ * being moved or deleted itself also changes what its old
+ * path resolves to.
+ *
+ */
+#define NEGATIVE_CACHE_WATCH_EVENTS (IN_CREATE | IN_MOVED_TO | IN_MOVE_SELF | IN_DELETE_SELF)
+
+/**
+ * A request path known not to exist.
+ *
+ */
+struct negative_cache_entry_t {
+    char* path;
+    size_t path_length;
+    uint64_t path_hash;
+    time_t cached_at;
+    int watched;
+
+    struct negative_cache_entry_t* hash_next;
+};
+
+/**
+ * The negative cache.
+ *
+ * @details Entries live in a fixed ring, which is also the
+ * eviction order, and are found through a chained hash
+ * table on the request path.
+ *
+ * A Bloom filter cannot forget a path, so evicted paths
+ * leave stale bits behind. Those only ever cost a table
+ * lookup, and the filter is rebuilt from the ring once as
+ * many entries have been evicted as the ring holds.
+ *
+ */
+struct negative_cache_t {
+    struct negative_cache_entry_t* entries;
+    size_t max_entries;
+    size_t next_entry;
+    size_t evictions;
+
+    struct negative_cache_entry_t** buckets;
+    size_t bucket_mask;
+
+    uint64_t* bloom_filter;
+    size_t bloom_mask;
+
+    uint64_t generation;
+    time_t validity;
+    int inotify_fd;
+};
+
+/**
+ * Return the current time in whole seconds.
+ *
+ */
+static time_t negative_cache_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+    return now.tv_sec;
+}
+
+/**
+ * Create a negative cache.
+ *
+ */
+struct negative_cache_t* create_negative_cache(size_t max_entries, int bloom_filter_enabled, time_t validity, int inotify_fd) {
+    struct negative_cache_t* cache = allocate_tagged_memory(MEMORY_TAG_CACHES, sizeof (struct negative_cache_t));
+    memset(cache, 0, sizeof (struct negative_cache_t));
+
+    cache->max_entries = max_entries;
+    cache->validity = validity;
+    cache->inotify_fd = -1;
+
+    if (max_entries == 0) {
+        return cache;
+    }
+
+    size_t bucket_count = 1;
+
+    while (bucket_count < max_entries * 2) {
+        bucket_count <<= 1;
+    }
+
+    cache->entries = allocate_tagged_memory(MEMORY_TAG_CACHES, sizeof (struct negative_cache_entry_t) * max_entries);
+    memset(cache->entries, 0, sizeof (struct negative_cache_entry_t) * max_entries);
+
+    cache->buckets = allocate_tagged_memory(MEMORY_TAG_CACHES, sizeof (struct negative_cache_entry_t *) * bucket_count);
+    memset(cache->buckets, 0, sizeof (struct negative_cache_entry_t *) * bucket_count);
+    cache->bucket_mask = bucket_count - 1;
+
+    if (bloom_filter_enabled) {
+        size_t bloom_bits = 64;
+
+        while (bloom_bits < max_entries * NEGATIVE_CACHE_BLOOM_BITS_PER_ENTRY) {
+            bloom_bits <<= 1;
+        }
+
+        cache->bloom_filter = allocate_tagged_memory(MEMORY_TAG_CACHES, bloom_bits / 8);
+        memset(cache->bloom_filter, 0, bloom_bits / 8);
+        cache->bloom_mask = bloom_bits - 1;
+    }
+
+    if (inotify_fd != -1) {
+        cache->inotify_fd = inotify_fd;
+        return cache;
+    }
+
+    cache->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (cache->inotify_fd == -1) {
+        syslog(LOG_WARNING, "[Warning] Could not watch the document root (%s); missing files are only cached for %lld seconds", strerror(errno), (long long) validity);
+    }
+
+    return cache;
+}
+
+/**
+ * Set a path's bits in the Bloom filter.
+ *
+ */
+static void add_to_bloom_filter(struct negative_cache_t* cache, uint64_t hash) {
+    uint64_t step = (hash >> 32) | 1;
+
+    for (int probe = 0; probe < NEGATIVE_CACHE_BLOOM_PROBES; ++probe, hash += step) {
+        cache->bloom_filter[(hash & cache->bloom_mask) / 64] |= (uint64_t) 1 << (hash & 63);
+    }
+}
+
+/**
+ * Check whether all of a path's bits are set in the Bloom
+ * filter.
+ *
+ */
+static int bloom_filter_contains(const struct negative_cache_t* cache, uint64_t hash) {
+    uint64_t step = (hash >> 32) | 1;
+
+    for (int probe = 0; probe < NEGATIVE_CACHE_BLOOM_PROBES; ++probe, hash += step) {
+        if ((cache->bloom_filter[(hash & cache->bloom_mask) / 64] & ((uint64_t) 1 << (hash & 63))) == 0) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * Rebuild the Bloom filter from the entries in the ring.
+ *
+ */
+static void rebuild_bloom_filter(struct negative_cache_t* cache) {
+    cache->evictions = 0;
+
+    if (cache->bloom_filter == NULL) {
+        return;
+    }
+
+    memset(cache->bloom_filter, 0, (cache->bloom_mask + 1) / 8);
+
+    for (size_t i = 0; i < cache->max_entries; ++i) {
+        if (cache->entries[i].path) {
+            add_to_bloom_filter(cache, cache->entries[i].path_hash);
+        }
+    }
+}
+
+/**
+ * Find the entry for a request path.
+ *
+ */
+static struct negative_cache_entry_t* find_negative_cache_entry(const struct negative_cache_t* cache, const char* path, size_t path_length, uint64_t hash) {
+    for (struct negative_cache_entry_t* entry = cache->buckets[hash & cache->bucket_mask]; entry; entry = entry->hash_next) {
+        if ((entry->path_hash == hash) && (entry->path_length == path_length) && (memcmp(entry->path, path, path_length) == 0)) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Check whether a request path is known not to exist.
+ *
+ */
+int lookup_negative_cache(const struct negative_cache_t* cache, const char* path, size_t path_length) {
+    if (cache->max_entries == 0) {
+        return FALSE;
+    }
+
+    uint64_t hash = perfect_hash_string(path, path_length);
+
+    if (cache->bloom_filter && !bloom_filter_contains(cache, hash)) {
+        return FALSE;
+    }
+
+    const struct negative_cache_entry_t* entry = find_negative_cache_entry(cache, path, path_length, hash);
+
+    if (entry == NULL) {
+        return FALSE;
+    }
+
+    return entry->watched || ((negative_cache_now() - entry->cached_at) < cache->validity);
+}
+
+/**
+ * Return the cache's current generation.
+ *
+ */
+uint64_t negative_cache_generation(const struct negative_cache_t* cache) {
+    return cache->generation;
+}
+
+/**
+ * Watch the directories leading to a missing file.
+ *
+ */
+int watch_missing_file(const struct negative_cache_t* cache, const char* filename, size_t root_length, int* watched) {
+    *watched = FALSE;
+
+    if (cache->inotify_fd == -1) {
+        return TRUE;
+    }
+
+    char directory[PATH_MAX];
+    size_t length = strlen(filename);
+
+    if (length >= sizeof (directory)) {
+        return TRUE;
+    }
+
+    memcpy(directory, filename, length + 1);
+
+    /**
+     * Walk up the file name one directory at a time. The
+     * directories below the deepest one that exists are
+     * expected to be missing too, but everything from there
+     * up to the document root has to be watched.
+     *
+     */
+    int found = FALSE;
+
+    while (length > root_length) {
+        while ((length > 0) && (directory[length - 1] != '/')) {
+            --length;
+        }
+
+        if ((length == 0) || (--length < root_length)) {
+            break;
+        }
+
+        directory[length] = '\0';
+
+        if (inotify_add_watch(cache->inotify_fd, (length == 0) ? "/" : directory, NEGATIVE_CACHE_WATCH_EVENTS | IN_ONLYDIR) != -1) {
+            found = TRUE;
+        } else if (found || ((errno != ENOENT) && (errno != ENOTDIR))) {
+            return TRUE;
+        }
+    }
+
+    /**
+     * The file may have been created between the failed
+     * open(2) and the watches going up, in which case no
+     * event will ever arrive for it.
+     *
+     */
+    if (access(filename, F_OK) == 0) {
+        return FALSE;
+    }
+
+    *watched = found;
+
+    return TRUE;
+}
+
+/**
+ * Remember that a request path does not exist.
+ *
+ */
+void insert_negative_cache(struct negative_cache_t* cache, const char* path, size_t path_length, int watched, uint64_t generation) {
+    if ((cache->max_entries == 0) || (generation != cache->generation)) {
+        return;
+    }
+
+    uint64_t hash = perfect_hash_string(path, path_length);
+    struct negative_cache_entry_t* entry = find_negative_cache_entry(cache, path, path_length, hash);
+
+    if (entry) {
+        entry->cached_at = negative_cache_now();
+        entry->watched = watched;
+        return;
+    }
+
+    /**
+     * Take the oldest slot in the ring, evicting whatever
+     * path is still in it.
+     *
+     */
+    entry = &cache->entries[cache->next_entry];
+    cache->next_entry = (cache->next_entry + 1) % cache->max_entries;
+
+    if (entry->path) {
+        struct negative_cache_entry_t** link = &cache->buckets[entry->path_hash & cache->bucket_mask];
+
+        while (*link != entry) {
+            link = &(*link)->hash_next;
+        }
+
+        *link = entry->hash_next;
+        FREE(entry->path);
+        cache->evictions++;
+    }
+
+    entry->path = allocate_tagged_memory(MEMORY_TAG_CACHES, path_length + 1);
+    memcpy(entry->path, path, path_length);
+    entry->path[path_length] = '\0';
+    entry->path_length = path_length;
+    entry->path_hash = hash;
+    entry->cached_at = negative_cache_now();
+    entry->watched = watched;
+
+    struct negative_cache_entry_t** bucket = &cache->buckets[hash & cache->bucket_mask];
+    entry->hash_next = *bucket;
+    *bucket = entry;
+
+    if (cache->evictions >= cache->max_entries) {
+        rebuild_bloom_filter(cache);
+    } else if (cache->bloom_filter) {
+        add_to_bloom_filter(cache, hash);
+    }
+}
+
+/**
+ * Return the cache's inotify descriptor, or -1 if it has
+ * none.
+ *
+ */
+int negative_cache_inotify_fd(const struct negative_cache_t* cache) {
+    return cache->inotify_fd;
+}
+
+/**
+ * Forget every cached path.
+ *
+ * @details A disabled cache has no entries or buckets to
+ * clear, and never inserts anything, so there is nothing to
+ * do.
+ *
+ */
+void clear_negative_cache(struct negative_cache_t* cache) {
+    if (cache->max_entries == 0) {
+        return;
+    }
+
+    for (size_t i = 0; i < cache->max_entries; ++i) {
+        FREE(cache->entries[i].path);
+        cache->entries[i].hash_next = NULL;
+    }
+
+    memset(cache->buckets, 0, sizeof (struct negative_cache_entry_t *) * (cache->bucket_mask + 1));
+    cache->next_entry = 0;
+    cache->generation++;
+
+    rebuild_bloom_filter(cache);
+}
+
+/**
+ * Drain the inotify descriptor, and invalidate the cache if
+ * any watched directory changed.
+ *
+ * @details Any change at all throws the whole cache away.
+ * Directories are only created or renamed in the document
+ * root when a site is deployed, which is precisely when
+ * every remembered 404 is suspect anyway, and it spares the
+ * cache from having to know which paths lie below which
+ * directory.
+ *
+ */
+int process_negative_cache_events(struct negative_cache_t* cache) {
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    int changed = FALSE;
+
+    while (TRUE) {
+        ssize_t length = read(cache->inotify_fd, buffer, sizeof (buffer));
+
+        if (length == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            break;
+        }
+
+        if (length <= 0) {
+            break;
+        }
+
+        for (char* event = buffer; event < buffer + length; event += sizeof (struct inotify_event) + ((struct inotify_event *) event)->len) {
+            if ((((struct inotify_event *) event)->mask & IN_IGNORED) == 0) {
+                changed = TRUE;
+            }
+        }
+    }
+
+    if (changed) {
+        clear_negative_cache(cache);
+    }
+
+    return changed;
+}
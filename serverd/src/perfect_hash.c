@@ -0,0 +1,280 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "serverd.h"
+#include "memory.h"
+#include "perfect_hash.h"
+
+/**
+ * @def PERFECT_HASH_MAX_DISPLACEMENT
+ * @brief Displacement attempts per bucket before growing.
+ *
+ * @details If some bucket cannot be placed after this many
+ * attempts, the table is doubled in size and the whole
+ * search starts over. With the load factors used below this
+ * essentially never happens, but it bounds the build time.
+ *
+ */
+#ifndef PERFECT_HASH_MAX_DISPLACEMENT
+#define PERFECT_HASH_MAX_DISPLACEMENT (1u << 20)
+#endif
+
+/**
+ * Round a value up to the next power of two.
+ *
+ */
+static uint32_t round_up_to_power_of_two(size_t value) {
+    uint32_t result = 1;
+
+    while (result < value) {
+        result <<= 1;
+    }
+
+    return result;
+}
+
+/**
+ * qsort(3) comparator for 64-bit fingerprints.
+ *
+ */
+static int compare_fingerprints(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t *) a;
+    uint64_t y = *(const uint64_t *) b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * Check whether any fingerprint appears more than once.
+ *
+ */
+static int contains_duplicate_fingerprints(const uint64_t* keys, size_t key_count) {
+    uint64_t* sorted = allocate_memory(sizeof (uint64_t) * (key_count + 1));
+    memcpy(sorted, keys, sizeof (uint64_t) * key_count);
+    qsort(sorted, key_count, sizeof (uint64_t), compare_fingerprints);
+
+    int duplicate = FALSE;
+
+    for (size_t i = 1; i < key_count; ++i) {
+        if (sorted[i] == sorted[i - 1]) {
+            duplicate = TRUE;
+            break;
+        }
+    }
+
+    FREE(sorted);
+    return duplicate;
+}
+
+/**
+ * Bucket bookkeeping used only during construction.
+ *
+ */
+struct perfect_hash_bucket_t {
+    uint32_t index;
+    uint32_t first;
+    uint32_t count;
+};
+
+/**
+ * Order buckets from the most to the least populated.
+ *
+ * @details Placing the largest buckets first, while most
+ * slots are still free, is what makes the displacement
+ * search converge quickly.
+ *
+ */
+static int compare_buckets_by_size(const void* a, const void* b) {
+    const struct perfect_hash_bucket_t* x = a;
+    const struct perfect_hash_bucket_t* y = b;
+
+    if (x->count != y->count) {
+        return (x->count < y->count) ? 1 : -1;
+    }
+
+    return (x->index > y->index) - (x->index < y->index);
+}
+
+/**
+ * Attempt to build the perfect hash with a fixed table size.
+ *
+ * @details Returns FALSE if some bucket could not be placed,
+ * in which case the caller retries with a larger table.
+ *
+ */
+static int try_build_perfect_hash(const uint64_t* keys, size_t key_count, struct perfect_hash_t* hash, uint32_t* displacements, uint32_t* slots) {
+    uint32_t bucket_count = hash->bucket_mask + 1;
+    uint32_t slot_count = hash->slot_mask + 1;
+
+    struct perfect_hash_bucket_t* buckets = allocate_memory(sizeof (struct perfect_hash_bucket_t) * bucket_count);
+    uint32_t* members = allocate_memory(sizeof (uint32_t) * (key_count + 1));
+    uint32_t* candidate = allocate_memory(sizeof (uint32_t) * (key_count + 1));
+    unsigned char* occupied = allocate_memory(slot_count);
+
+    memset(buckets, 0, sizeof (struct perfect_hash_bucket_t) * bucket_count);
+    memset(occupied, 0, slot_count);
+
+    /**
+     * Count the keys in each bucket, turn the counts into
+     * offsets, and then scatter the key indices so that the
+     * members of every bucket are contiguous.
+     *
+     */
+    for (size_t i = 0; i < key_count; ++i) {
+        buckets[perfect_hash_bucket(hash->bucket_mask, keys[i])].count++;
+    }
+
+    for (uint32_t b = 0, offset = 0; b < bucket_count; ++b) {
+        buckets[b].index = b;
+        buckets[b].first = offset;
+        offset += buckets[b].count;
+        buckets[b].count = 0;
+    }
+
+    for (size_t i = 0; i < key_count; ++i) {
+        struct perfect_hash_bucket_t* bucket = &buckets[perfect_hash_bucket(hash->bucket_mask, keys[i])];
+        members[bucket->first + bucket->count++] = (uint32_t) i;
+    }
+
+    qsort(buckets, bucket_count, sizeof (struct perfect_hash_bucket_t), compare_buckets_by_size);
+
+    int success = TRUE;
+
+    for (uint32_t b = 0; (b < bucket_count) && success; ++b) {
+        const struct perfect_hash_bucket_t* bucket = &buckets[b];
+
+        displacements[bucket->index] = 0;
+
+        if (bucket->count == 0) {
+            /**
+             * The buckets are sorted by size, so every
+             * remaining bucket is empty as well.
+             *
+             */
+            for (uint32_t rest = b; rest < bucket_count; ++rest) {
+                displacements[buckets[rest].index] = 0;
+            }
+
+            break;
+        }
+
+        uint32_t displacement = 0;
+
+        for (; displacement < PERFECT_HASH_MAX_DISPLACEMENT; ++displacement) {
+            uint32_t placed = 0;
+
+            for (; placed < bucket->count; ++placed) {
+                uint32_t slot = perfect_hash_slot_with(displacement, hash->slot_mask, keys[members[bucket->first + placed]]);
+
+                if (occupied[slot]) {
+                    break;
+                }
+
+                /**
+                 * Tentatively claim the slot so that two
+                 * keys from the same bucket cannot collide
+                 * with each other.
+                 *
+                 */
+                occupied[slot] = TRUE;
+                candidate[placed] = slot;
+            }
+
+            if (placed == bucket->count) {
+                break;
+            }
+
+            /** Roll back the tentative claims and try again */
+            for (uint32_t k = 0; k < placed; ++k) {
+                occupied[candidate[k]] = FALSE;
+            }
+        }
+
+        if (displacement == PERFECT_HASH_MAX_DISPLACEMENT) {
+            success = FALSE;
+            break;
+        }
+
+        displacements[bucket->index] = displacement;
+
+        if (slots) {
+            for (uint32_t k = 0; k < bucket->count; ++k) {
+                slots[members[bucket->first + k]] = candidate[k];
+            }
+        }
+    }
+
+    FREE(occupied);
+    FREE(candidate);
+    FREE(members);
+    FREE(buckets);
+
+    return success;
+}
+
+/**
+ * Build a perfect hash for the given set of fingerprints.
+ *
+ * @details The slot table is sized to at least twice the
+ * number of keys, and there is one bucket for every four
+ * slots, so each bucket holds two keys on average.
+ *
+ */
+int build_perfect_hash(const uint64_t* keys, size_t key_count, struct perfect_hash_t* hash, uint32_t* slots) {
+    if (contains_duplicate_fingerprints(keys, key_count)) {
+        return FALSE;
+    }
+
+    uint32_t slot_count = round_up_to_power_of_two(key_count * 2);
+
+    if (slot_count < 4) {
+        slot_count = 4;
+    }
+
+    while (TRUE) {
+        hash->slot_mask = slot_count - 1;
+        hash->bucket_mask = (slot_count / 4) - 1;
+        uint32_t* displacements = allocate_memory(sizeof (uint32_t) * (hash->bucket_mask + 1));
+
+        if (try_build_perfect_hash(keys, key_count, hash, displacements, slots)) {
+            hash->displacements = displacements;
+            return TRUE;
+        }
+
+        FREE(displacements);
+        slot_count <<= 1;
+    }
+}
+
+/**
+ * Release the displacement array of a perfect hash.
+ *
+ */
+void free_perfect_hash(struct perfect_hash_t* hash) {
+    FREE(hash->displacements);
+    hash->bucket_mask = 0;
+    hash->slot_mask = 0;
+}
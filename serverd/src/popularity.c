@@ -0,0 +1,362 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <syslog.h>
+
+#include <sys/stat.h>
+
+#include "serverd.h"
+#include "configuration.h"
+#include "file_cache.h"
+#include "file_io.h"
+#include "memory.h"
+#include "perfect_hash.h"
+#include "popularity.h"
+#include "worker.h"
+
+/**
+ * Size of the fixed snapshot header: magic, record count and
+ * timestamp.
+ *
+ */
+#define POPULARITY_SNAPSHOT_HEADER_SIZE (8 + sizeof (uint32_t) + sizeof (uint64_t))
+
+static int compare_popularity_records(const void* a, const void* b) {
+    return strcmp(((const struct popularity_record_t *) a)->path, ((const struct popularity_record_t *) b)->path);
+}
+
+/**
+ * Load a popularity snapshot.
+ *
+ */
+struct popularity_snapshot_t* load_popularity_snapshot(const char* filename) {
+    int fd = open(filename, O_RDONLY | O_CLOEXEC);
+
+    if (fd == -1) {
+        if (errno != ENOENT) {
+            syslog(LOG_WARNING, "[Warning] Could not open popularity snapshot: %s (%s)", filename, strerror(errno));
+        }
+
+        return NULL;
+    }
+
+    struct stat status;
+
+    if ((fstat(fd, &status) == -1) || (status.st_size < (off_t) (POPULARITY_SNAPSHOT_HEADER_SIZE + sizeof (uint64_t)))) {
+        syslog(LOG_WARNING, "[Warning] Ignoring truncated popularity snapshot: %s", filename);
+        close(fd);
+        return NULL;
+    }
+
+    size_t length = (size_t) status.st_size;
+    unsigned char* data = allocate_memory(length);
+    size_t total = 0;
+
+    while (total < length) {
+        ssize_t bytes_read = read(fd, data + total, length - total);
+
+        if (bytes_read <= 0) {
+            if ((bytes_read == -1) && (errno == EINTR)) {
+                continue;
+            }
+
+            break;
+        }
+
+        total += (size_t) bytes_read;
+    }
+
+    close(fd);
+
+    /**
+     * Verify the magic and the trailing checksum before
+     * trusting any of the lengths inside.
+     *
+     */
+    uint64_t checksum;
+    memcpy(&checksum, data + length - sizeof (uint64_t), sizeof (uint64_t));
+
+    if ((total != length) || (memcmp(data, POPULARITY_SNAPSHOT_MAGIC, 8) != 0) || (checksum != perfect_hash_string((const char *) data, length - sizeof (uint64_t)))) {
+        syslog(LOG_WARNING, "[Warning] Ignoring corrupt popularity snapshot: %s", filename);
+        FREE(data);
+        return NULL;
+    }
+
+    uint32_t count;
+    uint64_t timestamp;
+    memcpy(&count, data + 8, sizeof (count));
+    memcpy(&timestamp, data + 8 + sizeof (count), sizeof (timestamp));
+
+    struct popularity_snapshot_t* snapshot = allocate_memory(sizeof (struct popularity_snapshot_t));
+    snapshot->records = allocate_memory(sizeof (struct popularity_record_t) * ((size_t) count + 1));
+    snapshot->count = 0;
+    snapshot->timestamp = timestamp;
+
+    size_t offset = POPULARITY_SNAPSHOT_HEADER_SIZE;
+    size_t end = length - sizeof (uint64_t);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        uint64_t hits;
+        uint16_t path_length;
+
+        if (offset + sizeof (hits) + sizeof (path_length) > end) {
+            break;
+        }
+
+        memcpy(&hits, data + offset, sizeof (hits));
+        memcpy(&path_length, data + offset + sizeof (hits), sizeof (path_length));
+        offset += sizeof (hits) + sizeof (path_length);
+
+        if (offset + path_length > end) {
+            break;
+        }
+
+        struct popularity_record_t* record = &snapshot->records[snapshot->count++];
+        record->path = allocate_memory((size_t) path_length + 1);
+        memcpy(record->path, data + offset, path_length);
+        record->path[path_length] = '\0';
+        record->hits = hits;
+
+        offset += path_length;
+    }
+
+    FREE(data);
+
+    qsort(snapshot->records, snapshot->count, sizeof (struct popularity_record_t), compare_popularity_records);
+
+    return snapshot;
+}
+
+/**
+ * Return the hit count recorded for a request path, or 0.
+ *
+ */
+uint64_t lookup_popularity(const struct popularity_snapshot_t* snapshot, const char* path) {
+    if (snapshot == NULL) {
+        return 0;
+    }
+
+    struct popularity_record_t key = { (char *) path, 0 };
+    const struct popularity_record_t* record = bsearch(&key, snapshot->records, snapshot->count, sizeof (struct popularity_record_t), compare_popularity_records);
+
+    return record ? record->hits : 0;
+}
+
+/**
+ * A snapshot buffer being serialized.
+ *
+ */
+struct popularity_buffer_t {
+    char* data;
+    size_t length;
+    size_t capacity;
+    uint32_t count;
+};
+
+static void append_popularity_bytes(struct popularity_buffer_t* buffer, const void* data, size_t length) {
+    if (buffer->length + length > buffer->capacity) {
+        size_t capacity = buffer->capacity * 2;
+
+        while (capacity < buffer->length + length) {
+            capacity *= 2;
+        }
+
+        char* grown = allocate_memory(capacity);
+        memcpy(grown, buffer->data, buffer->length);
+        FREE(buffer->data);
+        buffer->data = grown;
+        buffer->capacity = capacity;
+    }
+
+    memcpy(buffer->data + buffer->length, data, length);
+    buffer->length += length;
+}
+
+/**
+ * Append one cache entry's hit count to the snapshot.
+ *
+ * @details Entries that were never hit carry no information
+ * and are left out, which keeps the snapshot small.
+ *
+ */
+static void append_popularity_record(const struct file_cache_entry_t* entry, void* context) {
+    struct popularity_buffer_t* buffer = context;
+
+    if ((entry->hits == 0) || (entry->path_length > UINT16_MAX)) {
+        return;
+    }
+
+    uint16_t path_length = (uint16_t) entry->path_length;
+
+    append_popularity_bytes(buffer, &entry->hits, sizeof (entry->hits));
+    append_popularity_bytes(buffer, &path_length, sizeof (path_length));
+    append_popularity_bytes(buffer, entry->path, entry->path_length);
+    buffer->count++;
+}
+
+/**
+ * A snapshot waiting to be written on the file I/O pool.
+ *
+ */
+struct popularity_write_t {
+    struct file_io_job_t job;
+    struct worker_t* worker;
+    char* data;
+    size_t length;
+    char* filename;
+    char* temporary_filename;
+};
+
+/**
+ * Write the snapshot to disk, on the file I/O pool.
+ *
+ */
+static void write_popularity_snapshot_job(struct file_io_job_t* job) {
+    struct popularity_write_t* write_request = job->context;
+
+    job->result = -1;
+
+    int fd = open(write_request->temporary_filename, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+    if (fd == -1) {
+        job->error = errno;
+        return;
+    }
+
+    size_t total = 0;
+
+    while (total < write_request->length) {
+        ssize_t written = write(fd, write_request->data + total, write_request->length - total);
+
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            job->error = errno;
+            close(fd);
+            unlink(write_request->temporary_filename);
+            return;
+        }
+
+        total += (size_t) written;
+    }
+
+    if ((fdatasync(fd) == -1) || (close(fd) == -1) || (rename(write_request->temporary_filename, write_request->filename) == -1)) {
+        job->error = errno;
+        unlink(write_request->temporary_filename);
+        return;
+    }
+
+    job->result = 0;
+}
+
+static void on_popularity_snapshot_written(struct file_io_job_t* job) {
+    struct popularity_write_t* write_request = job->context;
+
+    if (job->result == -1) {
+        syslog(LOG_WARNING, "[Warning] Could not write popularity snapshot: %s (%s)", write_request->filename, strerror(job->error));
+    }
+
+    write_request->worker->popularity_snapshot_pending = FALSE;
+
+    FREE(write_request->temporary_filename);
+    FREE(write_request->filename);
+    FREE(write_request->data);
+    FREE(write_request);
+}
+
+/**
+ * Write a snapshot of the worker's hit counts.
+ *
+ */
+void save_popularity_snapshot(struct worker_t* worker) {
+    const char* filename = worker->configuration_options->popularity_snapshot;
+
+    if ((filename == NULL) || worker->popularity_snapshot_pending) {
+        return;
+    }
+
+    struct popularity_buffer_t buffer = { allocate_memory(4096), 0, 4096, 0 };
+
+    uint32_t count = 0;
+    uint64_t timestamp = (uint64_t) time(NULL);
+
+    append_popularity_bytes(&buffer, POPULARITY_SNAPSHOT_MAGIC, 8);
+    append_popularity_bytes(&buffer, &count, sizeof (count));
+    append_popularity_bytes(&buffer, &timestamp, sizeof (timestamp));
+
+    /**
+     * Only the default virtual host is warmed up at startup,
+     * so only its file cache is worth remembering.
+     *
+     */
+    visit_file_cache_entries(worker->hosts[0].file_cache, append_popularity_record, &buffer);
+
+    /**
+     * Patch in the final record count, then seal the
+     * snapshot with its checksum.
+     *
+     */
+    memcpy(buffer.data + 8, &buffer.count, sizeof (buffer.count));
+
+    uint64_t checksum = perfect_hash_string(buffer.data, buffer.length);
+    append_popularity_bytes(&buffer, &checksum, sizeof (checksum));
+
+    struct popularity_write_t* write_request = allocate_memory(sizeof (struct popularity_write_t));
+    memset(write_request, 0, sizeof (struct popularity_write_t));
+
+    /**
+     * The filename is copied, rather than read from the
+     * configuration on the file I/O pool, since the
+     * configuration may be reloaded before the job runs.
+     *
+     */
+    size_t filename_length = strlen(filename);
+    write_request->filename = allocate_memory(filename_length + 1);
+    memcpy(write_request->filename, filename, filename_length + 1);
+
+    write_request->temporary_filename = allocate_memory(filename_length + sizeof (".tmp"));
+    memcpy(write_request->temporary_filename, filename, filename_length);
+    memcpy(write_request->temporary_filename + filename_length, ".tmp", sizeof (".tmp"));
+
+    write_request->worker = worker;
+    write_request->data = buffer.data;
+    write_request->length = buffer.length;
+    write_request->job.operation = FILE_IO_CALL;
+    write_request->job.function = write_popularity_snapshot_job;
+    write_request->job.fd = -1;
+    write_request->job.completion = on_popularity_snapshot_written;
+    write_request->job.context = write_request;
+
+    worker->popularity_snapshot_pending = TRUE;
+    submit_file_io_job(worker->file_io_pool, &write_request->job);
+}
@@ -0,0 +1,544 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "serverd.h"
+#include "config.h"
+#include "configuration.h"
+#include "memory.h"
+#include "perfect_hash.h"
+#include "rewrite.h"
+
+struct rewrite_engine_t {
+    const struct rewrite_rule_t* rules;
+    size_t rule_count;
+
+    /**
+     * Bytes that no pattern mentions behave identically, so
+     * they share class zero, and every byte that does
+     * appear in a pattern gets a class of its own. This
+     * keeps the transition table down to a few dozen
+     * columns instead of 256.
+     *
+     */
+    uint8_t byte_classes[256];
+    size_t class_count;
+
+    /**
+     * The transition table, class_count entries per state,
+     * and the rule each state accepts, plus one, or zero.
+     * State zero is the dead state, and state one the start.
+     *
+     */
+    uint32_t* transitions;
+    uint32_t* accepting_rules;
+    size_t state_count;
+};
+
+/**
+ * The automaton under construction.
+ *
+ * @details The positions of every pattern are numbered one
+ * after the other. A position holds the byte a pattern
+ * expects next, '*' for a wildcard, or NUL once the whole
+ * pattern has been matched. Each state of the automaton is
+ * the sorted set of positions the patterns could be at, and
+ * the sets are kept one after the other in a single pool.
+ *
+ */
+struct rewrite_builder_t {
+    char* positions;
+    uint32_t* position_rules;
+    size_t position_count;
+
+    uint32_t* set_pool;
+    size_t set_pool_length;
+    size_t set_pool_capacity;
+    size_t* set_offsets;
+
+    uint32_t* state_index;
+    size_t state_index_mask;
+
+    uint32_t* scratch;
+    uint32_t* marks;
+    uint32_t mark;
+};
+
+/**
+ * Count the wildcards in a rewrite pattern.
+ *
+ */
+size_t count_rewrite_wildcards(const char* pattern) {
+    size_t count = 0;
+
+    for (const char* c = pattern; *c; ++c) {
+        count += (c[0] == '*') && (c[1] != '*');
+    }
+
+    return count;
+}
+
+/**
+ * Grow an array built up with allocate_tagged_memory().
+ *
+ */
+static void* grow_rewrite_array(void* array, size_t length, size_t capacity) {
+    void* grown = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, capacity);
+
+    if (array) {
+        memcpy(grown, array, length);
+        FREE(array);
+    }
+
+    return grown;
+}
+
+static int compare_positions(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*) a;
+    uint32_t y = *(const uint32_t*) b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * Add a position to the set being built, along with the
+ * one after it if it is a wildcard, which may match nothing
+ * at all.
+ *
+ */
+static void add_position(struct rewrite_builder_t* builder, size_t* count, uint32_t position) {
+    while (builder->marks[position] != builder->mark) {
+        builder->marks[position] = builder->mark;
+        builder->scratch[(*count)++] = position;
+
+        if (builder->positions[position] != '*') {
+            break;
+        }
+
+        ++position;
+    }
+}
+
+/**
+ * Find the state for the set of positions in the scratch
+ * list, adding it if it is new.
+ *
+ */
+static uint32_t intern_state(struct rewrite_builder_t* builder, struct rewrite_engine_t* engine, size_t count) {
+    if (count == 0) {
+        return 0;
+    }
+
+    qsort(builder->scratch, count, sizeof (uint32_t), compare_positions);
+
+    size_t bytes = count * sizeof (uint32_t);
+    size_t slot = (size_t) perfect_hash_string((const char*) builder->scratch, bytes) & builder->state_index_mask;
+
+    while (builder->state_index[slot]) {
+        uint32_t state = builder->state_index[slot];
+        size_t offset = builder->set_offsets[state];
+
+        if ((builder->set_offsets[state + 1] - offset == count) && (memcmp(&builder->set_pool[offset], builder->scratch, bytes) == 0)) {
+            return state;
+        }
+
+        slot = (slot + 1) & builder->state_index_mask;
+    }
+
+    if (engine->state_count == REWRITE_MAX_DFA_STATES) {
+        return UINT32_MAX;
+    }
+
+    uint32_t state = (uint32_t) engine->state_count++;
+    builder->state_index[slot] = state;
+
+    if (builder->set_pool_length + count > builder->set_pool_capacity) {
+        size_t capacity = (builder->set_pool_capacity + count) * 2;
+        builder->set_pool = grow_rewrite_array(builder->set_pool, builder->set_pool_length * sizeof (uint32_t), capacity * sizeof (uint32_t));
+        builder->set_pool_capacity = capacity;
+    }
+
+    memcpy(&builder->set_pool[builder->set_pool_length], builder->scratch, bytes);
+    builder->set_pool_length += count;
+    builder->set_offsets[state + 1] = builder->set_pool_length;
+
+    return state;
+}
+
+/**
+ * Compile a set of rewrite rules.
+ *
+ */
+struct rewrite_engine_t* build_rewrite_engine(const struct rewrite_rule_t* rules, size_t count) {
+    struct rewrite_engine_t* engine = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (struct rewrite_engine_t));
+    memset(engine, 0, sizeof (struct rewrite_engine_t));
+
+    engine->rules = rules;
+    engine->rule_count = count;
+
+    if (count == 0) {
+        return engine;
+    }
+
+    struct rewrite_builder_t builder;
+    memset(&builder, 0, sizeof (builder));
+
+    /**
+     * Lay out every pattern's positions, collapsing runs of
+     * wildcards, and give every byte that any of them
+     * mentions a class of its own.
+     *
+     */
+    for (size_t i = 0; i < count; ++i) {
+        builder.position_count += strlen(rules[i].pattern) + 1;
+    }
+
+    builder.positions = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, builder.position_count);
+    builder.position_rules = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (uint32_t) * builder.position_count);
+    builder.position_count = 0;
+
+    int used_bytes[256] = { 0 };
+    uint8_t class_bytes[256] = { 0 };
+
+    engine->class_count = 1;
+
+    for (size_t i = 0; i < count; ++i) {
+        for (const char* c = rules[i].pattern; ; ++c) {
+            if ((c[0] == '*') && (c[1] == '*')) {
+                continue;
+            }
+
+            builder.position_rules[builder.position_count] = (uint32_t) i;
+            builder.positions[builder.position_count++] = *c;
+
+            if (*c == '\0') {
+                break;
+            }
+
+            if ((*c != '*') && !used_bytes[(uint8_t) *c]) {
+                used_bytes[(uint8_t) *c] = TRUE;
+                class_bytes[engine->class_count] = (uint8_t) *c;
+                engine->byte_classes[(uint8_t) *c] = (uint8_t) engine->class_count++;
+            }
+        }
+    }
+
+    /**
+     * Class zero stands for some byte no pattern mentions,
+     * if there is one.
+     *
+     */
+    int class_zero_used = FALSE;
+
+    for (size_t b = 0; b < 256; ++b) {
+        if (!used_bytes[b]) {
+            class_bytes[0] = (uint8_t) b;
+            class_zero_used = TRUE;
+            break;
+        }
+    }
+
+    builder.marks = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (uint32_t) * builder.position_count);
+    memset(builder.marks, 0, sizeof (uint32_t) * builder.position_count);
+    builder.scratch = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (uint32_t) * builder.position_count);
+
+    builder.state_index_mask = 1023;
+    builder.state_index = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (uint32_t) * (builder.state_index_mask + 1));
+    memset(builder.state_index, 0, sizeof (uint32_t) * (builder.state_index_mask + 1));
+
+    size_t state_capacity = 512;
+    builder.set_offsets = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (size_t) * (state_capacity + 1));
+    engine->transitions = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (uint32_t) * state_capacity * engine->class_count);
+    engine->accepting_rules = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (uint32_t) * state_capacity);
+
+    /**
+     * The dead state has the empty set, and every pattern
+     * starts out at its first position.
+     *
+     */
+    engine->state_count = 1;
+    builder.set_offsets[0] = 0;
+    builder.set_offsets[1] = 0;
+
+    size_t scratch_count = 0;
+    ++builder.mark;
+
+    for (size_t i = 0; i < builder.position_count; ++i) {
+        if ((i == 0) || (builder.positions[i - 1] == '\0')) {
+            add_position(&builder, &scratch_count, (uint32_t) i);
+        }
+    }
+
+    intern_state(&builder, engine, scratch_count);
+
+    /**
+     * Work through the states in the order they turn up,
+     * following every byte class out of each, until no new
+     * ones appear.
+     *
+     */
+    int too_many_states = FALSE;
+
+    for (size_t state = 0; (state < engine->state_count) && !too_many_states; ++state) {
+        /**
+         * Make room for every state the ones so far could
+         * lead to, before any of them are added.
+         *
+         */
+        if (engine->state_count + engine->class_count >= state_capacity) {
+            size_t capacity = (state_capacity + engine->class_count) * 2;
+
+            builder.set_offsets = grow_rewrite_array(builder.set_offsets, sizeof (size_t) * (engine->state_count + 1), sizeof (size_t) * (capacity + 1));
+            engine->transitions = grow_rewrite_array(engine->transitions, sizeof (uint32_t) * engine->state_count * engine->class_count, sizeof (uint32_t) * capacity * engine->class_count);
+            engine->accepting_rules = grow_rewrite_array(engine->accepting_rules, sizeof (uint32_t) * engine->state_count, sizeof (uint32_t) * capacity);
+            state_capacity = capacity;
+        }
+
+        if (engine->state_count > (builder.state_index_mask + 1) / 2) {
+            size_t mask = (builder.state_index_mask << 1) | 1;
+            FREE(builder.state_index);
+            builder.state_index = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (uint32_t) * (mask + 1));
+            memset(builder.state_index, 0, sizeof (uint32_t) * (mask + 1));
+            builder.state_index_mask = mask;
+
+            for (uint32_t s = 1; s < engine->state_count; ++s) {
+                size_t offset = builder.set_offsets[s];
+                size_t slot = (size_t) perfect_hash_string((const char*) &builder.set_pool[offset], (builder.set_offsets[s + 1] - offset) * sizeof (uint32_t)) & mask;
+
+                while (builder.state_index[slot]) {
+                    slot = (slot + 1) & mask;
+                }
+
+                builder.state_index[slot] = s;
+            }
+        }
+
+        const uint32_t* set = &builder.set_pool[builder.set_offsets[state]];
+        size_t set_length = builder.set_offsets[state + 1] - builder.set_offsets[state];
+
+        engine->accepting_rules[state] = 0;
+
+        for (size_t i = 0; i < set_length; ++i) {
+            if (builder.positions[set[i]] == '\0') {
+                engine->accepting_rules[state] = builder.position_rules[set[i]] + 1;
+                break;
+            }
+        }
+
+        for (size_t byte_class = 0; byte_class < engine->class_count; ++byte_class) {
+            char c = (char) class_bytes[byte_class];
+
+            scratch_count = 0;
+            ++builder.mark;
+
+            if ((byte_class > 0) || class_zero_used) {
+                /**
+                 * The set pool may move while the state is
+                 * interned, so it is read afresh every time.
+                 *
+                 */
+                set = &builder.set_pool[builder.set_offsets[state]];
+
+                for (size_t i = 0; i < set_length; ++i) {
+                    char expected = builder.positions[set[i]];
+
+                    if (expected == '*') {
+                        add_position(&builder, &scratch_count, set[i]);
+                    } else if ((expected != '\0') && (expected == c) && (byte_class > 0)) {
+                        add_position(&builder, &scratch_count, set[i] + 1);
+                    }
+                }
+            }
+
+            uint32_t next = intern_state(&builder, engine, scratch_count);
+
+            if (next == UINT32_MAX) {
+                too_many_states = TRUE;
+                break;
+            }
+
+            engine->transitions[state * engine->class_count + byte_class] = next;
+        }
+    }
+
+    FREE(builder.positions);
+    FREE(builder.position_rules);
+    FREE(builder.set_pool);
+    FREE(builder.set_offsets);
+    FREE(builder.state_index);
+    FREE(builder.scratch);
+    FREE(builder.marks);
+
+    if (too_many_states) {
+        free_rewrite_engine(engine);
+        return NULL;
+    }
+
+    return engine;
+}
+
+/**
+ * Release a compiled set of rewrite rules.
+ *
+ */
+void free_rewrite_engine(struct rewrite_engine_t* engine) {
+    if (engine == NULL) {
+        return;
+    }
+
+    FREE(engine->transitions);
+    FREE(engine->accepting_rules);
+    FREE(engine);
+}
+
+/**
+ * Find the first rule whose pattern matches a path.
+ *
+ */
+const struct rewrite_rule_t* match_rewrite_rule(const struct rewrite_engine_t* engine, const char* path, size_t length) {
+    if ((engine->rule_count == 0) || (length > REWRITE_MAX_PATH_LENGTH)) {
+        return NULL;
+    }
+
+    uint32_t state = 1;
+
+    for (size_t i = 0; i < length; ++i) {
+        state = engine->transitions[state * engine->class_count + engine->byte_classes[(uint8_t) path[i]]];
+
+        if (state == 0) {
+            return NULL;
+        }
+    }
+
+    return engine->accepting_rules[state] ? &engine->rules[engine->accepting_rules[state] - 1] : NULL;
+}
+
+/**
+ * Match the rest of a pattern from a position in the path,
+ * recording captures on the way back out.
+ *
+ * @details Each wildcard tries the longest run first. The
+ * wildcard and the position it starts at determine
+ * everything that follows, so a combination that failed
+ * once is remembered in the failed bitmap and never tried
+ * again, which keeps this polynomial however the pattern is
+ * written.
+ *
+ */
+static int match_rewrite_pattern(const char* pattern, const char* path, size_t length, size_t position, size_t wildcard, struct rewrite_captures_t* captures, uint64_t* failed) {
+    while ((*pattern != '\0') && (*pattern != '*')) {
+        if ((position == length) || (path[position] != *pattern)) {
+            return FALSE;
+        }
+
+        ++pattern;
+        ++position;
+    }
+
+    if (*pattern == '\0') {
+        return position == length;
+    }
+
+    while (pattern[1] == '*') {
+        ++pattern;
+    }
+
+    size_t bit = (wildcard * (REWRITE_MAX_PATH_LENGTH + 1)) + position;
+
+    if (failed[bit / 64] & ((uint64_t) 1 << (bit % 64))) {
+        return FALSE;
+    }
+
+    for (size_t end = length + 1; end-- > position; ) {
+        if ((pattern[1] == '\0') ? (end != length) : ((end == length) || ((pattern[1] != '*') && (path[end] != pattern[1])))) {
+            continue;
+        }
+
+        if (match_rewrite_pattern(pattern + 1, path, length, end, wildcard + 1, captures, failed)) {
+            captures->spans[wildcard + 1][0] = position;
+            captures->spans[wildcard + 1][1] = end;
+            return TRUE;
+        }
+    }
+
+    failed[bit / 64] |= (uint64_t) 1 << (bit % 64);
+
+    return FALSE;
+}
+
+/**
+ * Work out what each wildcard of a rule's pattern captured.
+ *
+ */
+void capture_rewrite_rule(const struct rewrite_rule_t* rule, const char* path, size_t length, struct rewrite_captures_t* captures) {
+    uint64_t failed[((REWRITE_MAX_CAPTURES * (REWRITE_MAX_PATH_LENGTH + 1)) + 63) / 64] = { 0 };
+
+    memset(captures, 0, sizeof (struct rewrite_captures_t));
+    captures->spans[0][1] = length;
+
+    match_rewrite_pattern(rule->pattern, path, length, 0, 0, captures, failed);
+}
+
+/**
+ * Substitute the captures into a rule's target.
+ *
+ */
+size_t expand_rewrite_target(const struct rewrite_rule_t* rule, const char* path, const struct rewrite_captures_t* captures, int encode, char* output, size_t size) {
+    static const char hexadecimal_digits[] = "0123456789ABCDEF";
+
+    size_t length = 0;
+
+#define APPEND_REWRITE_BYTE(byte) do { if (length + 1 < size) { output[length] = (byte); } ++length; } while (0)
+
+    for (const char* c = rule->target; *c; ++c) {
+        if ((c[0] != '$') || (c[1] < '0') || (c[1] > '9')) {
+            APPEND_REWRITE_BYTE(*c);
+            continue;
+        }
+
+        size_t capture = (size_t) (*++c - '0');
+
+        for (size_t i = captures->spans[capture][0]; i < captures->spans[capture][1]; ++i) {
+            unsigned char byte = (unsigned char) path[i];
+
+            if (!encode || ((byte >= 'a') && (byte <= 'z')) || ((byte >= 'A') && (byte <= 'Z')) || ((byte >= '0') && (byte <= '9')) || strchr("-._~/!$&'()*+,;=:@", byte)) {
+                APPEND_REWRITE_BYTE((char) byte);
+            } else {
+                APPEND_REWRITE_BYTE('%');
+                APPEND_REWRITE_BYTE(hexadecimal_digits[byte >> 4]);
+                APPEND_REWRITE_BYTE(hexadecimal_digits[byte & 15]);
+            }
+        }
+    }
+
+#undef APPEND_REWRITE_BYTE
+
+    if (size > 0) {
+        output[(length < size) ? length : size - 1] = '\0';
+    }
+
+    return length;
+}
@@ -0,0 +1,254 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <syslog.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "serverd.h"
+#include "memory.h"
+#include "perfect_hash.h"
+#include "site_pack.h"
+
+/**
+ * Check that a region lies entirely within the pack.
+ *
+ */
+static int site_pack_contains(size_t size, uint64_t offset, uint64_t length) {
+    return (offset <= size) && (length <= size - offset);
+}
+
+static int is_power_of_two(uint32_t x) {
+    return (x != 0) && ((x & (x - 1)) == 0);
+}
+
+/**
+ * Validate the index of a mapped site pack.
+ *
+ * @details Besides the table bounds, every entry's path,
+ * headers and bodies are checked against the file size, and
+ * every slot against the entry count, which is what lets
+ * lookup_site_pack() and the response path use the index
+ * without any further checks.
+ *
+ */
+static int validate_site_pack(const unsigned char* base, size_t size) {
+    if (size < sizeof (struct site_pack_header_t)) {
+        return FALSE;
+    }
+
+    const struct site_pack_header_t* header = (const struct site_pack_header_t *) base;
+
+    if ((memcmp(header->magic, SITE_PACK_MAGIC, sizeof (header->magic)) != 0) || (header->file_size != size)) {
+        return FALSE;
+    }
+
+    if (!is_power_of_two(header->bucket_count) || !is_power_of_two(header->slot_count)) {
+        return FALSE;
+    }
+
+    if ((header->displacements_offset % sizeof (uint32_t)) || (header->slots_offset % sizeof (uint32_t)) || (header->entries_offset % sizeof (uint64_t))) {
+        return FALSE;
+    }
+
+    if (!site_pack_contains(size, header->displacements_offset, (uint64_t) header->bucket_count * sizeof (uint32_t))
+        || !site_pack_contains(size, header->slots_offset, (uint64_t) header->slot_count * sizeof (uint32_t))
+        || !site_pack_contains(size, header->entries_offset, (uint64_t) header->entry_count * sizeof (struct site_pack_entry_t))) {
+        return FALSE;
+    }
+
+    const uint32_t* slots = (const uint32_t *) (base + header->slots_offset);
+
+    for (uint32_t i = 0; i < header->slot_count; ++i) {
+        if ((slots[i] != SITE_PACK_EMPTY_SLOT) && (slots[i] >= header->entry_count)) {
+            return FALSE;
+        }
+    }
+
+    const struct site_pack_entry_t* entries = (const struct site_pack_entry_t *) (base + header->entries_offset);
+
+    for (uint32_t i = 0; i < header->entry_count; ++i) {
+        const struct site_pack_entry_t* entry = &entries[i];
+
+        if (!site_pack_contains(size, entry->path_offset, entry->path_length)
+            || !site_pack_contains(size, entry->identity.header_offset, entry->identity.header_length)
+            || !site_pack_contains(size, entry->identity.body_offset, entry->identity.body_length)) {
+            return FALSE;
+        }
+
+        if ((entry->flags & SITE_PACK_ENTRY_GZIP)
+            && (!site_pack_contains(size, entry->gzip.header_offset, entry->gzip.header_length)
+                || !site_pack_contains(size, entry->gzip.body_offset, entry->gzip.body_length))) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * Map a site pack into memory.
+ *
+ */
+struct site_pack_t* load_site_pack(const char* filename) {
+    int fd = open(filename, O_RDONLY | O_CLOEXEC);
+
+    if (fd == -1) {
+        syslog(LOG_ERR, "[Error] Could not open site pack: %s (%s)", filename, strerror(errno));
+        return NULL;
+    }
+
+    struct stat status;
+
+    if ((fstat(fd, &status) == -1) || (status.st_size <= 0)) {
+        syslog(LOG_ERR, "[Error] Invalid site pack: %s", filename);
+        close(fd);
+        return NULL;
+    }
+
+    size_t size = (size_t) status.st_size;
+    void* base = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+
+    if (base == MAP_FAILED) {
+        syslog(LOG_ERR, "[Error] Could not map site pack: %s (%s)", filename, strerror(errno));
+        close(fd);
+        return NULL;
+    }
+
+    if (!validate_site_pack(base, size)) {
+        syslog(LOG_ERR, "[Error] Invalid site pack: %s", filename);
+        munmap(base, size);
+        close(fd);
+        return NULL;
+    }
+
+    const struct site_pack_header_t* header = base;
+
+    struct site_pack_t* pack = allocate_memory(sizeof (struct site_pack_t));
+    pack->fd = fd;
+    pack->base = base;
+    pack->size = size;
+    pack->hash.displacements = (const uint32_t *) (pack->base + header->displacements_offset);
+    pack->hash.bucket_mask = header->bucket_count - 1;
+    pack->hash.slot_mask = header->slot_count - 1;
+    pack->slots = (const uint32_t *) (pack->base + header->slots_offset);
+    pack->entries = (const struct site_pack_entry_t *) (pack->base + header->entries_offset);
+    pack->entry_count = header->entry_count;
+    pack->device = (uint64_t) status.st_dev;
+    pack->inode = (uint64_t) status.st_ino;
+    pack->mtime_seconds = (int64_t) status.st_mtim.tv_sec;
+    pack->mtime_nanoseconds = (int64_t) status.st_mtim.tv_nsec;
+
+    /**
+     * The bodies are paged in on demand by sendfile(2), but
+     * the index is touched by every request, so ask for it
+     * to be read in right away.
+     *
+     */
+    madvise(base, header->entries_offset + (uint64_t) header->entry_count * sizeof (struct site_pack_entry_t), MADV_WILLNEED);
+
+    syslog(LOG_NOTICE, "Loaded site pack %s (%u paths, %zu bytes)", filename, pack->entry_count, pack->size);
+
+    return pack;
+}
+
+/**
+ * Unmap a site pack and close its file descriptor.
+ *
+ */
+void free_site_pack(struct site_pack_t* pack) {
+    if (pack == NULL) {
+        return;
+    }
+
+    munmap((void *) pack->base, pack->size);
+    close(pack->fd);
+    FREE(pack);
+}
+
+/**
+ * Swap in a new site pack if the file has been replaced.
+ *
+ */
+struct site_pack_t* reload_site_pack_if_changed(struct site_pack_t* pack, const char* filename) {
+    struct stat status;
+
+    if (stat(filename, &status) == -1) {
+        return pack;
+    }
+
+    if (((uint64_t) status.st_dev == pack->device)
+        && ((uint64_t) status.st_ino == pack->inode)
+        && ((int64_t) status.st_mtim.tv_sec == pack->mtime_seconds)
+        && ((int64_t) status.st_mtim.tv_nsec == pack->mtime_nanoseconds)) {
+        return pack;
+    }
+
+    struct site_pack_t* replacement = load_site_pack(filename);
+
+    if (replacement == NULL) {
+        /**
+         * Remember the broken file's identity, so we do not
+         * try to load it again every time we are called.
+         *
+         */
+        pack->device = (uint64_t) status.st_dev;
+        pack->inode = (uint64_t) status.st_ino;
+        pack->mtime_seconds = (int64_t) status.st_mtim.tv_sec;
+        pack->mtime_nanoseconds = (int64_t) status.st_mtim.tv_nsec;
+        return pack;
+    }
+
+    free_site_pack(pack);
+
+    return replacement;
+}
+
+/**
+ * Look up a request path in a site pack.
+ *
+ */
+const struct site_pack_entry_t* lookup_site_pack(const struct site_pack_t* pack, const char* path, size_t path_length) {
+    uint64_t hash = perfect_hash_string(path, path_length);
+    uint32_t index = pack->slots[perfect_hash_slot(&pack->hash, hash)];
+
+    if (index == SITE_PACK_EMPTY_SLOT) {
+        return NULL;
+    }
+
+    const struct site_pack_entry_t* entry = &pack->entries[index];
+
+    if ((entry->path_hash != hash) || (entry->path_length != path_length) || (memcmp(site_pack_data(pack, entry->path_offset), path, path_length) != 0)) {
+        return NULL;
+    }
+
+    return entry;
+}
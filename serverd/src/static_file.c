@@ -0,0 +1,1583 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <limits.h>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <syslog.h>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include "serverd.h"
+#include "configuration.h"
+#include "connection.h"
+#include "content_region.h"
+#include "content_store.h"
+#include "direct_io.h"
+#include "directory_listing.h"
+#include "file_cache.h"
+#include "file_io.h"
+#include "io_buffer.h"
+#include "location.h"
+#include "memory.h"
+#include "negative_cache.h"
+#include "rewrite.h"
+#include "site_pack.h"
+#include "static_file.h"
+#include "worker.h"
+#include "zero_copy.h"
+
+/**
+ * Prebuilt error responses.
+ *
+ * @details These never change, so there is no reason to
+ * format them per request.
+ *
+ */
+static const char bad_request_response[] =
+    "HTTP/1.1 400 Bad Request\r\n"
+    "Connection: Close\r\n"
+    "Content-Length: 0\r\n"
+    "\r\n";
+
+static const char forbidden_response[] =
+    "HTTP/1.1 403 Forbidden\r\n"
+    "Connection: Close\r\n"
+    "Content-Length: 0\r\n"
+    "\r\n";
+
+static const char not_found_response[] =
+    "HTTP/1.1 404 Not Found\r\n"
+    "Connection: Close\r\n"
+    "Content-Length: 0\r\n"
+    "\r\n";
+
+static const char internal_server_error_response[] =
+    "HTTP/1.1 500 Internal Server Error\r\n"
+    "Connection: Close\r\n"
+    "Content-Length: 0\r\n"
+    "\r\n";
+
+static const char service_unavailable_response[] =
+    "HTTP/1.1 503 Service Unavailable\r\n"
+    "Connection: Close\r\n"
+    "Retry-After: 1\r\n"
+    "Content-Length: 0\r\n"
+    "\r\n";
+
+/**
+ * @def RESPONSE_HEADER_BUFFER_SIZE
+ * @brief Size of the I/O buffer response headers are built
+ * in.
+ *
+ */
+#ifndef RESPONSE_HEADER_BUFFER_SIZE
+#define RESPONSE_HEADER_BUFFER_SIZE (4 * 1024)
+#endif
+
+/**
+ * The stages of a static file response.
+ *
+ * @details STATIC_FILE_OPEN_TARGET opens whatever the
+ * request path maps to. If that turns out to be a
+ * directory, STATIC_FILE_OPEN_INDEX tries its index.html,
+ * and if there is none, STATIC_FILE_RENDER_LISTING renders
+ * a directory listing on the file I/O pool. Small regular
+ * files go through STATIC_FILE_READ_CONTENT, which reads
+ * them into the content cache, before being sent. Files sent
+ * from their descriptors whose pages are not yet cached go
+ * through STATIC_FILE_READAHEAD first, and very
+ * large ones are streamed chunk by chunk through
+ * STATIC_FILE_STREAM. When the
+ * target does not exist, STATIC_FILE_WATCH_MISSING watches
+ * its directories so the miss can be remembered.
+ *
+ */
+enum static_file_stage_t {
+    STATIC_FILE_OPEN_TARGET,
+    STATIC_FILE_OPEN_INDEX,
+    STATIC_FILE_RENDER_LISTING,
+    STATIC_FILE_READ_CONTENT,
+    STATIC_FILE_READAHEAD,
+    STATIC_FILE_STREAM,
+    STATIC_FILE_WATCH_MISSING
+};
+
+/**
+ * A static file response in progress.
+ *
+ * @details The file I/O job is embedded in the request so
+ * that the completion callback can recover the request from
+ * the job's context pointer.
+ *
+ * The request is allocated from its own arena, along with
+ * anything else that lives exactly as long as it does, so
+ * that serving a request makes no allocator calls in the
+ * steady state.
+ *
+ */
+struct static_file_request_t {
+    struct file_io_job_t job;
+    struct memory_arena_t* arena;
+    struct worker_t* worker;
+    struct worker_host_t* host;
+    size_t virtual_host;
+    struct connection_t* connection;
+    int client_socket;
+    enum static_file_stage_t stage;
+
+    int directory_fd;
+    struct statx directory_status;
+    enum directory_listing_format_t listing_format;
+    char* listing;
+    size_t listing_length;
+    void* content;
+    uint64_t content_hash;
+    struct content_body_t* content_body;
+    uint64_t negative_cache_generation;
+
+    void* stream_buffers[2];
+    int stream_buffer_index;
+    int stream_direct;
+    int stream_drop_cache;
+    int stream_failed;
+    uint64_t stream_read_offset;
+    char* stream_header;
+    size_t stream_header_length;
+    int missing_file_watched;
+    int directory_listing_enabled;
+    size_t document_root_length;
+
+    char request_path[1024];
+    char filename[PATH_MAX];
+};
+
+/**
+ * Return the configuration of the virtual host a request is
+ * for.
+ *
+ * @details This is looked up afresh every time, rather than
+ * kept with the request, since a reload may replace the
+ * configuration while the response is in flight. Virtual
+ * hosts keep their positions across reloads.
+ *
+ */
+static const struct virtual_host_t* request_virtual_host(const struct static_file_request_t* request) {
+    return &request->worker->configuration_options->virtual_hosts[request->virtual_host];
+}
+
+/**
+ * Cork or uncork a TCP socket.
+ *
+ * @details While a socket is corked the kernel only sends
+ * full segments, so headers written with send(2) and a body
+ * written with sendfile(2) are coalesced instead of the
+ * headers going out in a tiny packet of their own.
+ * Uncorking flushes whatever partial segment is left.
+ *
+ * Failure is harmless, e.g. on a non-TCP socket, since this
+ * only affects how the response is packetized, so errors
+ * are deliberately ignored.
+ *
+ */
+static void set_socket_cork(int socket, int cork) {
+    setsockopt(socket, IPPROTO_TCP, TCP_CORK, &cork, sizeof (cork));
+}
+
+/**
+ * Write an entire buffer to a socket.
+ *
+ */
+static int send_all(int socket, const char* data, size_t length, int flags) {
+    while (length > 0) {
+        ssize_t sent = send(socket, data, length, flags | MSG_NOSIGNAL);
+
+        if (sent == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return FALSE;
+        }
+
+        data += sent;
+        length -= (size_t) sent;
+    }
+
+    return TRUE;
+}
+
+/**
+ * Finish a response and release the request.
+ *
+ * @details At the moment every response is sent with a
+ * 'Connection: Close' header, so the connection is closed
+ * here as well. The event loop stopped watching the socket
+ * once the request was read.
+ *
+ */
+static void finish_static_file_request(struct static_file_request_t* request) {
+    if (request->directory_fd != -1) {
+        close(request->directory_fd);
+    }
+
+    if (request->job.fd != -1) {
+        close(request->job.fd);
+    }
+
+    close_connection(request->worker->connection_slab, request->connection);
+    free_content(request->worker->content_region, request->content);
+    release_content(request->worker->content_store, request->content_body);
+    release_io_buffer(request->stream_header, RESPONSE_HEADER_BUFFER_SIZE);
+    release_direct_buffer(request->worker->direct_buffer_pool, request->stream_buffers[0]);
+    release_direct_buffer(request->worker->direct_buffer_pool, request->stream_buffers[1]);
+    FREE(request->listing);
+    release_memory_arena(request->arena);
+}
+
+/**
+ * Send one of the prebuilt responses and finish.
+ *
+ */
+static void send_prebuilt_response(struct static_file_request_t* request, const char* response, size_t length) {
+    send_all(request->client_socket, response, length, 0);
+    finish_static_file_request(request);
+}
+
+#define SEND_PREBUILT_RESPONSE(request, response) send_prebuilt_response((request), (response), sizeof (response) - 1)
+
+/**
+ * Map a failed open(2) onto the matching error response.
+ *
+ */
+static void send_open_error_response(struct static_file_request_t* request) {
+    switch (request->job.error) {
+        case ENOENT:
+        case ENOTDIR:
+        case ENAMETOOLONG: {
+            SEND_PREBUILT_RESPONSE(request, not_found_response);
+        } break;
+
+        case EACCES:
+        case EPERM: {
+            SEND_PREBUILT_RESPONSE(request, forbidden_response);
+        } break;
+
+        default: {
+            syslog(LOG_ERR, "[Error] Could not open file: %s (%s)", request->filename, strerror(request->job.error));
+            SEND_PREBUILT_RESPONSE(request, internal_server_error_response);
+        } break;
+    }
+}
+
+/**
+ * Send a regular file's headers and body.
+ *
+ * @details The body is the given range of the file, which
+ * for a site pack is one response among many.
+ *
+ * send_file_range() can come back short, e.g. when the file
+ * was truncated after its size was taken, so it is called
+ * again for the rest for as long as it makes progress. If
+ * the body still cannot be sent in full, the headers have
+ * already promised its length, so the only thing left to do
+ * is to close the connection, which the caller does anyway,
+ * and let the client see the response cut short.
+ *
+ */
+static void transmit_file(struct static_file_request_t* request, const char* header, size_t header_length, int fd, off_t offset, uint64_t size) {
+    /**
+     * Cork the socket around the headers and the body, so
+     * that a small response goes out in as few full-sized
+     * segments as possible. MSG_MORE gives the same hint for
+     * the headers in case corking is unavailable.
+     *
+     */
+    set_socket_cork(request->client_socket, TRUE);
+
+    if (send_all(request->client_socket, header, header_length, MSG_MORE)) {
+        /**
+         * Send the body without it ever passing through a
+         * user-space buffer, through sendfile(2) where
+         * possible and through the worker's pooled pipes
+         * otherwise.
+         *
+         */
+        uint64_t remaining = size;
+        ssize_t bytes_sent = 0;
+
+        while (remaining > 0) {
+            bytes_sent = send_file_range(request->worker->pipe_pool, request->client_socket, fd, &offset, remaining);
+
+            if (bytes_sent <= 0) {
+                break;
+            }
+
+            remaining -= (uint64_t) bytes_sent;
+        }
+
+        if (bytes_sent == -1) {
+            syslog(LOG_ERR, "[Error] Could not send file: %s (%s)", request->request_path, strerror(errno));
+        } else if (remaining > 0) {
+            syslog(LOG_ERR, "[Error] Could not send file: %s (%llu of %llu bytes missing)", request->request_path, (unsigned long long) remaining, (unsigned long long) size);
+        }
+    }
+
+    set_socket_cork(request->client_socket, FALSE);
+}
+
+/**
+ * Send a file's headers and its contents from memory.
+ *
+ */
+static void transmit_content(struct static_file_request_t* request, const char* header, size_t header_length, const void* content, uint64_t size) {
+    set_socket_cork(request->client_socket, TRUE);
+
+    if (send_all(request->client_socket, header, header_length, MSG_MORE)) {
+        if (!send_all(request->client_socket, content, size, 0)) {
+            syslog(LOG_ERR, "[Error] Could not send file: %s (%s)", request->request_path, strerror(errno));
+        }
+    }
+
+    set_socket_cork(request->client_socket, FALSE);
+}
+
+/**
+ * Send a cached file, from memory if its contents are
+ * cached and from its descriptor otherwise.
+ *
+ */
+static void transmit_file_cache_entry(struct static_file_request_t* request, const struct file_cache_entry_t* entry) {
+    if (entry->content) {
+        transmit_content(request, entry->header, entry->header_length, entry->content->data, entry->size);
+    } else {
+        transmit_file(request, entry->header, entry->header_length, entry->fd, 0, entry->size);
+    }
+}
+
+/**
+ * Send the file the current job opened.
+ *
+ * @details The open file, and its contents if they were
+ * read into the content cache, are handed to the worker's
+ * file cache, so that the next request for the same path
+ * can be answered without going back to the file system. If
+ * the cache declines it, the headers are built just for
+ * this response.
+ *
+ */
+static void send_file_response(struct static_file_request_t* request) {
+    struct file_io_job_t* job = &request->job;
+    struct file_cache_entry_t* entry = insert_file_cache(request->host->file_cache, request->request_path, strlen(request->request_path), request->filename, job->fd, &job->status, request->content_body);
+
+    if (entry) {
+        job->fd = -1;
+        request->content_body = NULL;
+        transmit_file_cache_entry(request, entry);
+        finish_static_file_request(request);
+        return;
+    }
+
+    char* header = acquire_io_buffer(RESPONSE_HEADER_BUFFER_SIZE);
+    size_t header_length = build_file_response_header(header, RESPONSE_HEADER_BUFFER_SIZE, request->filename, job->status.stx_size);
+
+    if (header_length == 0) {
+        release_io_buffer(header, RESPONSE_HEADER_BUFFER_SIZE);
+        SEND_PREBUILT_RESPONSE(request, internal_server_error_response);
+        return;
+    }
+
+    transmit_file(request, header, header_length, job->fd, 0, job->status.stx_size);
+    release_io_buffer(header, RESPONSE_HEADER_BUFFER_SIZE);
+    finish_static_file_request(request);
+}
+
+/**
+ * Read a file into its content block and hash it, on the
+ * file I/O pool.
+ *
+ */
+static void read_file_content_job(struct file_io_job_t* job) {
+    struct static_file_request_t* request = job->context;
+
+    job->result = read_file_range(job->fd, job->buffer, job->offset, job->length);
+
+    if (job->result == -1) {
+        job->error = errno;
+        return;
+    }
+
+    request->content_hash = hash_content(job->buffer, (size_t) job->result);
+}
+
+/**
+ * Tell the kernel a file is about to be read sequentially,
+ * and read its first window in, on the file I/O pool.
+ *
+ */
+static void readahead_file_job(struct file_io_job_t* job) {
+    posix_fadvise(job->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    job->result = readahead(job->fd, job->offset, job->length);
+
+    if (job->result == -1) {
+        job->error = errno;
+    }
+}
+
+/**
+ * Send a file from its descriptor, without letting a cold
+ * file stall the event loop.
+ *
+ * @details sendfile(2) runs on the event loop, so if the
+ * file is not in the page cache, every other client waits
+ * for the disk. A non-blocking probe of the first page
+ * tells whether that would happen. If so, the file is
+ * marked sequential and its first readahead window is read
+ * in on the file I/O pool before the response is sent; the
+ * kernel's own readahead, which the sequential hint
+ * doubles, then keeps ahead of the rest of the transfer.
+ *
+ */
+static void send_file_from_descriptor(struct static_file_request_t* request) {
+    struct file_io_job_t* job = &request->job;
+    struct page_cache_statistics_t* statistics = &request->worker->page_cache_statistics;
+    uint64_t window = request->worker->configuration_options->readahead_window;
+
+    if ((window == 0) || (job->status.stx_size == 0) || file_page_is_cached(job->fd, 0)) {
+        statistics->hits++;
+        send_file_response(request);
+        return;
+    }
+
+    if (window > job->status.stx_size) {
+        window = job->status.stx_size;
+    }
+
+    statistics->misses++;
+    statistics->readahead_bytes += window;
+
+    request->stage = STATIC_FILE_READAHEAD;
+    job->operation = FILE_IO_CALL;
+    job->function = readahead_file_job;
+    job->offset = 0;
+    job->length = (size_t) window;
+
+    submit_file_io_job(request->worker->file_io_pool, job);
+}
+
+/**
+ * Turn a request away with the prebuilt 503, and close its
+ * connection.
+ *
+ */
+void send_service_unavailable_response(struct worker_t* worker, struct connection_t* connection) {
+    send_all(connection->fd, service_unavailable_response, sizeof (service_unavailable_response) - 1, 0);
+    close_connection(worker->connection_slab, connection);
+}
+
+/**
+ * Log the worker's page cache statistics.
+ *
+ */
+void log_page_cache_statistics(const struct worker_t* worker) {
+    const struct page_cache_statistics_t* statistics = &worker->page_cache_statistics;
+
+    syslog(LOG_INFO, "Page cache: %llu hits, %llu misses, %llu bytes read ahead",
+        (unsigned long long) statistics->hits,
+        (unsigned long long) statistics->misses,
+        (unsigned long long) statistics->readahead_bytes);
+}
+
+/**
+ * Read the next chunk of a streamed file, on the file I/O
+ * pool.
+ *
+ * @details The first chunk switches the file to O_DIRECT.
+ * If the file system does not support it, the file is read
+ * through the page cache instead, and if configured to, the
+ * pages are dropped again right after each chunk.
+ *
+ * This runs off the event loop, so it must not look at the
+ * configuration, which a reload may retire at any moment;
+ * what it needs was copied into the request when the stream
+ * started.
+ *
+ */
+static void read_stream_chunk_job(struct file_io_job_t* job) {
+    struct static_file_request_t* request = job->context;
+
+    if (job->offset == 0) {
+        request->stream_direct = enable_direct_io(job->fd);
+
+        if (!request->stream_direct && request->stream_drop_cache) {
+            posix_fadvise(job->fd, 0, 0, POSIX_FADV_NOREUSE);
+        }
+    }
+
+    job->result = read_file_chunk(job->fd, job->buffer, job->offset, job->length, request->stream_direct, request->stream_drop_cache);
+
+    if (job->result == -1) {
+        job->error = errno;
+    }
+}
+
+/**
+ * Queue the read of the next chunk of a streamed file into
+ * the current buffer.
+ *
+ * @details Direct reads have to cover whole blocks, so the
+ * last chunk is rounded up and simply comes back short.
+ *
+ */
+static void submit_stream_chunk_read(struct static_file_request_t* request) {
+    struct file_io_job_t* job = &request->job;
+    uint64_t remaining = job->status.stx_size - request->stream_read_offset;
+    size_t length = request->worker->direct_buffer_pool->buffer_size;
+
+    if (remaining < length) {
+        length = ((size_t) remaining + DIRECT_IO_ALIGNMENT - 1) & ~((size_t) DIRECT_IO_ALIGNMENT - 1);
+    }
+
+    job->operation = FILE_IO_CALL;
+    job->function = read_stream_chunk_job;
+    job->buffer = request->stream_buffers[request->stream_buffer_index];
+    job->offset = (off_t) request->stream_read_offset;
+    job->length = length;
+
+    submit_file_io_job(request->worker->file_io_pool, job);
+}
+
+/**
+ * Stream a very large file to the client.
+ *
+ * @details sendfile(2) would pull the whole file through the
+ * page cache, evicting the small, hot files that are
+ * actually worth keeping there. Instead, the file is read
+ * with O_DIRECT into two pooled buffers in turn: while one
+ * chunk is being sent, the file I/O pool is already reading
+ * the next one into the other buffer. Streamed files never
+ * go into the file cache.
+ *
+ */
+static void stream_large_file(struct static_file_request_t* request) {
+    request->stream_header = acquire_io_buffer(RESPONSE_HEADER_BUFFER_SIZE);
+    request->stream_header_length = build_file_response_header(request->stream_header, RESPONSE_HEADER_BUFFER_SIZE, request->filename, request->job.status.stx_size);
+
+    if (request->stream_header_length == 0) {
+        SEND_PREBUILT_RESPONSE(request, internal_server_error_response);
+        return;
+    }
+
+    request->stream_buffers[0] = acquire_direct_buffer(request->worker->direct_buffer_pool);
+    request->stream_buffers[1] = acquire_direct_buffer(request->worker->direct_buffer_pool);
+    request->stream_buffer_index = 0;
+    request->stream_read_offset = 0;
+    request->stream_drop_cache = request->worker->configuration_options->streaming_drop_cache;
+    request->stage = STATIC_FILE_STREAM;
+
+    submit_stream_chunk_read(request);
+}
+
+/**
+ * Send a chunk of a streamed file, and keep the stream
+ * going.
+ *
+ * @details The headers go out with the first chunk, so that
+ * a file that cannot be read at all still gets a proper
+ * error response. Once a chunk fails to send, the response
+ * is abandoned, but only after the read already in flight
+ * for the next chunk has come back.
+ *
+ */
+static void continue_stream(struct static_file_request_t* request) {
+    struct file_io_job_t* job = &request->job;
+    int first_chunk = (job->offset == 0);
+
+    if (request->stream_failed) {
+        finish_static_file_request(request);
+        return;
+    }
+
+    if (job->result <= 0) {
+        if (first_chunk) {
+            syslog(LOG_ERR, "[Error] Could not read file: %s (%s)", request->filename, strerror(job->error));
+            SEND_PREBUILT_RESPONSE(request, internal_server_error_response);
+            return;
+        }
+
+        set_socket_cork(request->client_socket, FALSE);
+        finish_static_file_request(request);
+        return;
+    }
+
+    uint64_t size = job->status.stx_size;
+    uint64_t length = (uint64_t) job->result;
+
+    if (length > size - request->stream_read_offset) {
+        length = size - request->stream_read_offset;
+    }
+
+    const char* chunk = request->stream_buffers[request->stream_buffer_index];
+    request->stream_read_offset += length;
+
+    /**
+     * Start reading the next chunk into the other buffer
+     * before sending this one.
+     *
+     */
+    int more = (request->stream_read_offset < size);
+
+    if (more) {
+        request->stream_buffer_index ^= 1;
+        submit_stream_chunk_read(request);
+    }
+
+    if (first_chunk) {
+        set_socket_cork(request->client_socket, TRUE);
+
+        if (!send_all(request->client_socket, request->stream_header, request->stream_header_length, MSG_MORE)) {
+            request->stream_failed = TRUE;
+        }
+    }
+
+    if (!request->stream_failed && !send_all(request->client_socket, chunk, (size_t) length, more ? MSG_MORE : 0)) {
+        syslog(LOG_ERR, "[Error] Could not send file: %s (%s)", request->request_path, strerror(errno));
+        request->stream_failed = TRUE;
+    }
+
+    if (!more) {
+        set_socket_cork(request->client_socket, FALSE);
+        finish_static_file_request(request);
+    }
+}
+
+/**
+ * Send a regular file, reading it into the content cache
+ * first if it is small enough.
+ *
+ * @details The read is done on the file I/O pool, straight
+ * into a block of the content region, so a file is read at
+ * most once no matter how often it is requested afterwards.
+ * If the file is too large, the file cache would not admit
+ * it, or the region is full, the file is sent from its
+ * descriptor as usual.
+ *
+ */
+static void serve_regular_file(struct static_file_request_t* request) {
+    const struct virtual_host_t* virtual_host = request_virtual_host(request);
+    struct file_io_job_t* job = &request->job;
+    uint64_t size = job->status.stx_size;
+
+    if (virtual_host->streaming_threshold && (size >= virtual_host->streaming_threshold)) {
+        stream_large_file(request);
+        return;
+    }
+
+    if ((size == 0) || (size > virtual_host->content_cache_max_file_size) || !file_cache_admits(request->host->file_cache, request->request_path, strlen(request->request_path))) {
+        send_file_from_descriptor(request);
+        return;
+    }
+
+    request->content = allocate_content(request->worker->content_region, size);
+
+    if (request->content == NULL) {
+        send_file_from_descriptor(request);
+        return;
+    }
+
+    request->stage = STATIC_FILE_READ_CONTENT;
+    job->operation = FILE_IO_CALL;
+    job->function = read_file_content_job;
+    job->buffer = request->content;
+    job->offset = 0;
+    job->length = size;
+
+    submit_file_io_job(request->worker->file_io_pool, job);
+}
+
+/**
+ * Percent-encode a decoded path for a Location header.
+ *
+ * @details Everything but unreserved characters, sub-
+ * delimiters, ':', '@' and '/' is encoded, which also keeps
+ * anything that might end the header, such as an encoded
+ * CR or LF in the request, out of it. The output must have
+ * room for three times the length of the path.
+ *
+ * @return The length of the encoded path.
+ *
+ */
+static size_t encode_location_path(char* output, const char* path) {
+    static const char hexadecimal_digits[] = "0123456789ABCDEF";
+
+    size_t length = 0;
+
+    for (const char* c = path; *c; ++c) {
+        unsigned char byte = (unsigned char) *c;
+
+        if (((byte >= 'a') && (byte <= 'z')) || ((byte >= 'A') && (byte <= 'Z')) || ((byte >= '0') && (byte <= '9')) || strchr("-._~/!$&'()*+,;=:@", byte)) {
+            output[length++] = (char) byte;
+        } else {
+            output[length++] = '%';
+            output[length++] = hexadecimal_digits[byte >> 4];
+            output[length++] = hexadecimal_digits[byte & 15];
+        }
+    }
+
+    return length;
+}
+
+/**
+ * Redirect a directory request that lacks a trailing slash.
+ *
+ * @details Without the trailing slash, relative links in the
+ * directory's index page or listing would resolve against
+ * the parent directory. The request path has been decoded,
+ * so it is encoded again for the Location header.
+ *
+ */
+static void send_directory_redirect(struct static_file_request_t* request) {
+    char response[(3 * sizeof (request->request_path)) + 128];
+    size_t length = (size_t) snprintf(response, sizeof (response), "HTTP/1.1 301 Moved Permanently\r\nConnection: Close\r\nLocation: ");
+
+    length += encode_location_path(response + length, request->request_path);
+    length += (size_t) snprintf(response + length, sizeof (response) - length, "/\r\nContent-Length: 0\r\n\r\n");
+
+    send_prebuilt_response(request, response, length);
+}
+
+/**
+ * Render the directory listing on the file I/O pool.
+ *
+ */
+static void render_directory_listing_job(struct file_io_job_t* job) {
+    struct static_file_request_t* request = job->context;
+
+    request->listing = render_directory_listing(request->directory_fd, request->request_path, request->listing_format, &request->listing_length);
+    job->result = (request->listing == NULL) ? -1 : 0;
+}
+
+/**
+ * Build the listing cache key for the request's directory.
+ *
+ */
+static void build_directory_listing_key(const struct static_file_request_t* request, struct directory_listing_key_t* key) {
+    key->device = ((uint64_t) request->directory_status.stx_dev_major << 32) | request->directory_status.stx_dev_minor;
+    key->inode = request->directory_status.stx_ino;
+    key->mtime_seconds = request->directory_status.stx_mtime.tv_sec;
+    key->mtime_nanoseconds = request->directory_status.stx_mtime.tv_nsec;
+    key->format = request->listing_format;
+    key->request_path = request->request_path;
+}
+
+static void on_static_file_job_complete(struct file_io_job_t* job);
+
+/**
+ * Serve a directory that has no index.html.
+ *
+ * @details A cached rendering is used if the directory has
+ * not changed since it was rendered. Otherwise the listing
+ * is rendered on the file I/O pool.
+ *
+ */
+static void serve_directory_listing(struct static_file_request_t* request) {
+    struct directory_listing_key_t key;
+    build_directory_listing_key(request, &key);
+
+    size_t length = 0;
+    const char* cached = lookup_directory_listing(request->host->directory_listing_cache, &key, &length);
+
+    if (cached) {
+        send_prebuilt_response(request, cached, length);
+        return;
+    }
+
+    request->stage = STATIC_FILE_RENDER_LISTING;
+    request->job.operation = FILE_IO_CALL;
+    request->job.function = render_directory_listing_job;
+    request->job.fd = -1;
+
+    submit_file_io_job(request->worker->file_io_pool, &request->job);
+}
+
+/**
+ * Return the length of a document root, without any
+ * trailing slash.
+ *
+ */
+static size_t document_root_length(const char* document_root) {
+    size_t root_length = strlen(document_root);
+
+    if ((root_length > 0) && (document_root[root_length - 1] == '/')) {
+        --root_length;
+    }
+
+    return root_length;
+}
+
+/**
+ * Watch the directories of a missing file, on the file I/O
+ * pool.
+ *
+ */
+static void watch_missing_file_job(struct file_io_job_t* job) {
+    struct static_file_request_t* request = job->context;
+
+    job->result = watch_missing_file(request->host->negative_cache, request->filename, request->document_root_length, &request->missing_file_watched) ? 0 : -1;
+}
+
+/**
+ * Send a 404 for a file that does not exist, and remember
+ * the miss in the negative cache.
+ *
+ */
+static void send_missing_file_response(struct static_file_request_t* request) {
+    if (request_virtual_host(request)->negative_cache_entries == 0) {
+        SEND_PREBUILT_RESPONSE(request, not_found_response);
+        return;
+    }
+
+    request->stage = STATIC_FILE_WATCH_MISSING;
+    request->job.operation = FILE_IO_CALL;
+    request->job.function = watch_missing_file_job;
+    request->job.fd = -1;
+
+    submit_file_io_job(request->worker->file_io_pool, &request->job);
+}
+
+/**
+ * Advance a static file response after a file I/O job.
+ *
+ */
+static void on_static_file_job_complete(struct file_io_job_t* job) {
+    struct static_file_request_t* request = job->context;
+
+    switch (request->stage) {
+        case STATIC_FILE_OPEN_TARGET: {
+            if (job->result == -1) {
+                job->fd = -1;
+
+                if ((job->error == ENOENT) || (job->error == ENOTDIR)) {
+                    send_missing_file_response(request);
+                    return;
+                }
+
+                send_open_error_response(request);
+                return;
+            }
+
+            if (S_ISREG(job->status.stx_mode)) {
+                serve_regular_file(request);
+                return;
+            }
+
+            if (!S_ISDIR(job->status.stx_mode)) {
+                SEND_PREBUILT_RESPONSE(request, forbidden_response);
+                return;
+            }
+
+            size_t path_length = strlen(request->request_path);
+
+            if (request->request_path[path_length - 1] != '/') {
+                send_directory_redirect(request);
+                return;
+            }
+
+            /**
+             * Keep the directory open in case we end up
+             * listing it, and try its index page next.
+             *
+             */
+            request->directory_fd = job->fd;
+            request->directory_status = job->status;
+            job->fd = -1;
+
+            size_t filename_length = strlen(request->filename);
+
+            if (filename_length + sizeof ("index.html") > sizeof (request->filename)) {
+                SEND_PREBUILT_RESPONSE(request, not_found_response);
+                return;
+            }
+
+            memcpy(request->filename + filename_length, "index.html", sizeof ("index.html"));
+
+            request->stage = STATIC_FILE_OPEN_INDEX;
+            submit_file_io_job(request->worker->file_io_pool, job);
+        } break;
+
+        case STATIC_FILE_OPEN_INDEX: {
+            if ((job->result != -1) && S_ISREG(job->status.stx_mode)) {
+                serve_regular_file(request);
+                return;
+            }
+
+            if (job->result != -1) {
+                close(job->fd);
+            }
+
+            job->fd = -1;
+
+            if ((job->result == -1) && (job->error == ENOENT) && request->directory_listing_enabled) {
+                serve_directory_listing(request);
+                return;
+            }
+
+            if (job->result == -1) {
+                send_open_error_response(request);
+                return;
+            }
+
+            SEND_PREBUILT_RESPONSE(request, forbidden_response);
+        } break;
+
+        case STATIC_FILE_RENDER_LISTING: {
+            if (job->result == -1) {
+                syslog(LOG_ERR, "[Error] Could not list directory: %s (%s)", request->request_path, strerror(job->error));
+                SEND_PREBUILT_RESPONSE(request, internal_server_error_response);
+                return;
+            }
+
+            send_all(request->client_socket, request->listing, request->listing_length, 0);
+
+            /**
+             * Hand the rendered listing over to the cache,
+             * which now owns it.
+             *
+             */
+            struct directory_listing_key_t key;
+            build_directory_listing_key(request, &key);
+            insert_directory_listing(request->host->directory_listing_cache, &key, request->listing, request->listing_length);
+            request->listing = NULL;
+
+            finish_static_file_request(request);
+        } break;
+
+        case STATIC_FILE_READ_CONTENT: {
+            /**
+             * Share the contents with any other cached file
+             * that has the same bytes. If the file changed
+             * size under us, forget the contents and send it
+             * from its descriptor.
+             *
+             */
+            if (job->result == (ssize_t) job->length) {
+                request->content_body = intern_content(request->worker->content_store, request->content, job->length, request->content_hash);
+            } else {
+                free_content(request->worker->content_region, request->content);
+            }
+
+            request->content = NULL;
+
+            send_file_response(request);
+        } break;
+
+        case STATIC_FILE_READAHEAD: {
+            /**
+             * Readahead is only a hint, so the file is sent
+             * whether or not it worked.
+             *
+             */
+            send_file_response(request);
+        } break;
+
+        case STATIC_FILE_STREAM: {
+            continue_stream(request);
+        } break;
+
+        case STATIC_FILE_WATCH_MISSING: {
+            /**
+             * The file was created after all if this
+             * failed, in which case the client still gets
+             * its 404, but the miss is not remembered.
+             *
+             */
+            if (job->result == 0) {
+                insert_negative_cache(request->host->negative_cache, request->request_path, strlen(request->request_path), request->missing_file_watched, request->negative_cache_generation);
+            }
+
+            SEND_PREBUILT_RESPONSE(request, not_found_response);
+        } break;
+    }
+}
+
+/**
+ * Convert a hexadecimal digit to its value, or -1.
+ *
+ */
+static int hex_digit_value(char c) {
+    if ((c >= '0') && (c <= '9')) {
+        return c - '0';
+    }
+
+    if ((c >= 'a') && (c <= 'f')) {
+        return c - 'a' + 10;
+    }
+
+    if ((c >= 'A') && (c <= 'F')) {
+        return c - 'A' + 10;
+    }
+
+    return -1;
+}
+
+/**
+ * Decode and normalize the path component of a request URI.
+ *
+ * @details Percent-encoded bytes are decoded, repeated
+ * slashes and "." segments are removed, and any request
+ * containing a ".." segment or an encoded NUL is rejected,
+ * so the resulting path can never escape the document root.
+ *
+ * The query string is not part of the path, but a
+ * "format=json" parameter selects the JSON format for
+ * directory listings.
+ *
+ * Returns FALSE if the URI is malformed.
+ *
+ */
+static int normalize_request_path(const char* request_uri, char* path, size_t path_size, enum directory_listing_format_t* format) {
+    if (request_uri[0] != '/') {
+        return FALSE;
+    }
+
+    size_t length = 0;
+    size_t segment_start = 0;
+
+    for (const char* p = request_uri; (*p != '\0') && (*p != '?') && (*p != '#'); ++p) {
+        char c = *p;
+
+        if (c == '%') {
+            int high = hex_digit_value(p[1]);
+            int low = (high == -1) ? -1 : hex_digit_value(p[2]);
+
+            if ((low == -1) || ((high == 0) && (low == 0))) {
+                return FALSE;
+            }
+
+            c = (char) ((high << 4) | low);
+            p += 2;
+        }
+
+        if (c == '/') {
+            /**
+             * A slash closes the current segment. Empty and
+             * "." segments are dropped, and ".." is refused
+             * outright.
+             *
+             */
+            size_t segment_length = length - segment_start;
+
+            if ((length > 0) && (segment_length == 0)) {
+                continue;
+            }
+
+            if ((segment_length == 1) && (path[segment_start] == '.')) {
+                length = segment_start;
+                continue;
+            }
+
+            if ((segment_length == 2) && (path[segment_start] == '.') && (path[segment_start + 1] == '.')) {
+                return FALSE;
+            }
+        }
+
+        if (length + 1 >= path_size) {
+            return FALSE;
+        }
+
+        path[length++] = c;
+
+        if (c == '/') {
+            segment_start = length;
+        }
+    }
+
+    /**
+     * Apply the same rules to the final segment, which has
+     * no slash after it.
+     *
+     */
+    size_t segment_length = length - segment_start;
+
+    if ((segment_length == 1) && (path[segment_start] == '.')) {
+        length = segment_start;
+    } else if ((segment_length == 2) && (path[segment_start] == '.') && (path[segment_start + 1] == '.')) {
+        return FALSE;
+    }
+
+    path[length] = '\0';
+
+    *format = DIRECTORY_LISTING_HTML;
+
+    const char* query = strchr(request_uri, '?');
+
+    if (query && (strstr(query, "format=json") != NULL)) {
+        *format = DIRECTORY_LISTING_JSON;
+    }
+
+    return TRUE;
+}
+
+/**
+ * Check whether a request accepts gzip content coding.
+ *
+ */
+int request_accepts_gzip(const char* request) {
+    const char* header = strcasestr(request, "\r\nAccept-Encoding:");
+
+    if (header == NULL) {
+        return FALSE;
+    }
+
+    header += strlen("\r\nAccept-Encoding:");
+    size_t header_length = strcspn(header, "\r\n");
+
+    /**
+     * Walk the comma-separated codings, honouring an
+     * explicit q=0, which means the client refuses gzip.
+     *
+     */
+    while (header_length > 0) {
+        size_t coding_length = strcspn(header, ",");
+
+        if (coding_length > header_length) {
+            coding_length = header_length;
+        }
+
+        const char* coding = header;
+        size_t length = coding_length;
+
+        while ((length > 0) && ((*coding == ' ') || (*coding == '\t'))) {
+            ++coding;
+            --length;
+        }
+
+        if ((length >= 4) && (strncasecmp(coding, "gzip", 4) == 0) && ((length == 4) || (coding[4] == ';') || (coding[4] == ' '))) {
+            const char* quality = memchr(coding, '=', length);
+
+            if ((quality == NULL) || (strtod(quality + 1, NULL) > 0.0)) {
+                return TRUE;
+            }
+        }
+
+        header += coding_length;
+        header_length -= coding_length;
+
+        if (header_length > 0) {
+            ++header;
+            --header_length;
+        }
+    }
+
+    return FALSE;
+}
+
+/**
+ * Find the Host header of a request.
+ *
+ */
+const char* request_host(const char* request, size_t* length) {
+    const char* header = strcasestr(request, "\r\nHost:");
+
+    if (header == NULL) {
+        return NULL;
+    }
+
+    header += strlen("\r\nHost:");
+    header += strspn(header, " \t");
+
+    size_t header_length = strcspn(header, "\r\n");
+
+    while ((header_length > 0) && ((header[header_length - 1] == ' ') || (header[header_length - 1] == '\t'))) {
+        --header_length;
+    }
+
+    *length = header_length;
+
+    return header;
+}
+
+/**
+ * Serve a request from the worker's site pack.
+ *
+ * @details This is nothing but a hash lookup, and a send(2)
+ * and sendfile(2) from the pack, so it is done right here on
+ * the event loop. Paths that are not in the pack do not
+ * exist, since the pack is the whole document root.
+ *
+ */
+static void serve_site_pack_request(struct static_file_request_t* request, int accepts_gzip) {
+    const struct site_pack_t* pack = request->worker->site_pack;
+    const struct site_pack_entry_t* entry = lookup_site_pack(pack, request->request_path, strlen(request->request_path));
+
+    if (entry == NULL) {
+        SEND_PREBUILT_RESPONSE(request, not_found_response);
+        return;
+    }
+
+    const struct site_pack_variant_t* variant = (accepts_gzip && (entry->flags & SITE_PACK_ENTRY_GZIP)) ? &entry->gzip : &entry->identity;
+
+    transmit_file(request, site_pack_data(pack, variant->header_offset), variant->header_length, pack->fd, (off_t) variant->body_offset, variant->body_length);
+    finish_static_file_request(request);
+}
+
+/**
+ * Return the reason phrase for a status code.
+ *
+ * @details HTTP/1.1 allows an empty reason phrase, which is
+ * what the less common codes get.
+ *
+ */
+static const char* status_reason(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 204: return "No Content";
+        case 301: return "Moved Permanently";
+        case 302: return "Found";
+        case 303: return "See Other";
+        case 307: return "Temporary Redirect";
+        case 308: return "Permanent Redirect";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 410: return "Gone";
+        case 429: return "Too Many Requests";
+        case 451: return "Unavailable For Legal Reasons";
+        case 500: return "Internal Server Error";
+        case 502: return "Bad Gateway";
+        case 503: return "Service Unavailable";
+        default: return "";
+    }
+}
+
+/**
+ * Answer a request with a location's bare status code.
+ *
+ */
+static void send_status_response(struct static_file_request_t* request, int status) {
+    char response[128];
+    int length = snprintf(response, sizeof (response), "HTTP/1.1 %d %s\r\nConnection: Close\r\nContent-Length: 0\r\n\r\n", status, status_reason(status));
+
+    send_prebuilt_response(request, response, (size_t) length);
+}
+
+/**
+ * Redirect a request to a location's target.
+ *
+ * @details The part of the request path the target takes
+ * over has been decoded, so it is encoded again on the way
+ * into the Location header, which also keeps anything that
+ * might end the header out of it.
+ *
+ */
+static void send_redirect_response(struct static_file_request_t* request, const struct location_t* location) {
+    size_t target_length = strlen(location->target);
+    const char* rest = "";
+
+    if (!location->exact && (target_length > 0) && (location->target[target_length - 1] == '/')) {
+        rest = request->request_path + location->path_length;
+
+        if ((*rest == '/') && (location->path[location->path_length - 1] != '/')) {
+            ++rest;
+        }
+    }
+
+    size_t size = target_length + (3 * strlen(rest)) + 128;
+    char* response = arena_allocate(request->arena, size);
+
+    if (response == NULL) {
+        SEND_PREBUILT_RESPONSE(request, service_unavailable_response);
+        return;
+    }
+
+    size_t length = (size_t) snprintf(response, size, "HTTP/1.1 %d %s\r\nLocation: %s", location->status, status_reason(location->status), location->target);
+    length += encode_location_path(response + length, rest);
+    length += (size_t) snprintf(response + length, size - length, "\r\nConnection: Close\r\nContent-Length: 0\r\n\r\n");
+
+    send_prebuilt_response(request, response, length);
+}
+
+/**
+ * Redirect a request to a redirect rule's target, with the
+ * captures substituted in.
+ *
+ */
+static void send_rewrite_redirect_response(struct static_file_request_t* request, const struct rewrite_rule_t* rule, const struct rewrite_captures_t* captures) {
+    size_t target_length = expand_rewrite_target(rule, request->request_path, captures, TRUE, NULL, 0);
+    size_t size = target_length + 128;
+    char* response = arena_allocate(request->arena, size);
+
+    if (response == NULL) {
+        SEND_PREBUILT_RESPONSE(request, service_unavailable_response);
+        return;
+    }
+
+    size_t length = (size_t) snprintf(response, size, "HTTP/1.1 %d %s\r\nLocation: ", rule->status, status_reason(rule->status));
+    length += expand_rewrite_target(rule, request->request_path, captures, TRUE, response + length, size - length);
+    length += (size_t) snprintf(response + length, size - length, "\r\nConnection: Close\r\nContent-Length: 0\r\n\r\n");
+
+    send_prebuilt_response(request, response, length);
+}
+
+/**
+ * Rewrite a request's path according to a rewrite rule.
+ *
+ * @details Captures come from a normalized path, but the
+ * target may still put them together into a ".." segment,
+ * so the result is checked for one. Returns FALSE if the
+ * rewritten path is unusable.
+ *
+ */
+static int rewrite_request_path(struct static_file_request_t* request, const struct rewrite_rule_t* rule, const struct rewrite_captures_t* captures) {
+    char path[sizeof (request->request_path)];
+
+    if (expand_rewrite_target(rule, request->request_path, captures, FALSE, path, sizeof (path)) >= sizeof (path)) {
+        return FALSE;
+    }
+
+    for (const char* segment = strstr(path, "/.."); segment; segment = strstr(segment + 1, "/..")) {
+        if ((segment[3] == '/') || (segment[3] == '\0')) {
+            return FALSE;
+        }
+    }
+
+    strcpy(request->request_path, path);
+
+    return TRUE;
+}
+
+/**
+ * Serve a file from the document root.
+ *
+ * @details A static files location may point the request
+ * at a document root of its own, and decide on directory
+ * listings, in place of the virtual host. Either way, this
+ * is settled here, once, so that a reload changing the
+ * locations cannot pull the rug out from under the request
+ * later on.
+ *
+ */
+static void serve_static_file(struct static_file_request_t* request, const struct location_t* location, int accepts_gzip) {
+    struct worker_t* worker = request->worker;
+    const struct virtual_host_t* virtual_host = request_virtual_host(request);
+    const char* document_root = virtual_host->document_root_directory;
+    const char* relative_path = request->request_path + 1;
+
+    request->directory_listing_enabled = virtual_host->directory_listing_enabled;
+
+    /**
+     * A location's own document root stands in for the
+     * location's path, rather than for the root of the site,
+     * so only the rest of the request path is looked up in it.
+     * As with redirects, a slash between the location's path
+     * and the rest is dropped.
+     *
+     */
+    if (location && location->document_root_directory) {
+        document_root = location->document_root_directory;
+        relative_path = request->request_path + location->path_length;
+
+        if (*relative_path == '/') {
+            ++relative_path;
+        }
+    }
+
+    if (location && (location->directory_listing_enabled != -1)) {
+        request->directory_listing_enabled = location->directory_listing_enabled;
+    }
+
+    if (worker->site_pack && (request->virtual_host == 0) && (document_root == virtual_host->document_root_directory)) {
+        serve_site_pack_request(request, accepts_gzip);
+        return;
+    }
+
+    /**
+     * Answer straight from the file cache if we can, with no
+     * file system access at all.
+     *
+     */
+    struct file_cache_entry_t* entry = lookup_file_cache(request->host->file_cache, request->request_path, strlen(request->request_path));
+
+    if (entry) {
+        transmit_file_cache_entry(request, entry);
+        finish_static_file_request(request);
+        return;
+    }
+
+    /**
+     * Paths that were recently found not to exist get the
+     * prebuilt 404 straight away. The generation is noted
+     * before going to the file system, so that a miss racing
+     * with the file being created is not remembered.
+     *
+     */
+    if (lookup_negative_cache(request->host->negative_cache, request->request_path, strlen(request->request_path))) {
+        SEND_PREBUILT_RESPONSE(request, not_found_response);
+        return;
+    }
+
+    request->negative_cache_generation = negative_cache_generation(request->host->negative_cache);
+
+    /**
+     * Map the request path onto the document root. The
+     * document root is conventionally configured with a
+     * trailing slash, but need not be, so it is dropped and
+     * the path joined on with exactly one.
+     *
+     * The length is kept with the request, since the file
+     * I/O pool needs it later on and must never read the
+     * configuration, which a reload may replace.
+     *
+     */
+    request->document_root_length = document_root_length(document_root);
+
+    int filename_length = snprintf(request->filename, sizeof (request->filename), "%.*s/%s", (int) request->document_root_length, document_root, relative_path);
+
+    if ((filename_length < 0) || ((size_t) filename_length >= sizeof (request->filename))) {
+        SEND_PREBUILT_RESPONSE(request, not_found_response);
+        return;
+    }
+
+    syslog(LOG_DEBUG, "Filename buffer: %s", request->filename);
+
+    /**
+     * Hand the blocking open(2) and statx(2) off to the file
+     * I/O pool. The connection simply waits for the
+     * completion to come back through the pool's eventfd,
+     * while the event loop goes on serving every other
+     * client.
+     *
+     */
+    struct file_io_job_t* job = &request->job;
+    job->operation = FILE_IO_OPEN;
+    job->path = request->filename;
+    job->flags = O_RDONLY | O_NONBLOCK | O_CLOEXEC;
+    job->completion = on_static_file_job_complete;
+    job->context = request;
+
+    submit_file_io_job(worker->file_io_pool, job);
+}
+
+/**
+ * Serve a request.
+ *
+ */
+void serve_request(struct worker_t* worker, size_t virtual_host, struct connection_t* connection, const char* request_uri, int accepts_gzip) {
+    struct memory_arena_t* arena = create_memory_arena(worker->arena_chunk_pool);
+    struct static_file_request_t* request = arena ? arena_allocate(arena, sizeof (struct static_file_request_t)) : NULL;
+
+    /**
+     * Without memory for the request, all that can be done
+     * is to tell the client to try again shortly.
+     *
+     */
+    if (request == NULL) {
+        if (arena) {
+            release_memory_arena(arena);
+        }
+
+        send_service_unavailable_response(worker, connection);
+        return;
+    }
+
+    request->arena = arena;
+    request->worker = worker;
+    request->host = &worker->hosts[virtual_host];
+    request->virtual_host = virtual_host;
+    request->connection = connection;
+    request->client_socket = connection->fd;
+    request->stage = STATIC_FILE_OPEN_TARGET;
+    request->directory_fd = -1;
+    request->listing = NULL;
+    request->listing_length = 0;
+    request->content = NULL;
+    request->content_body = NULL;
+    request->stream_header = NULL;
+    request->stream_buffers[0] = NULL;
+    request->stream_buffers[1] = NULL;
+    request->stream_failed = FALSE;
+    request->job.fd = -1;
+
+    if (!normalize_request_path(request_uri, request->request_path, sizeof (request->request_path), &request->listing_format)) {
+        SEND_PREBUILT_RESPONSE(request, bad_request_response);
+        return;
+    }
+
+    /**
+     * Apply the first rewrite or redirect rule that matches
+     * the path, if any. A rewritten path goes on to the
+     * locations like any other.
+     *
+     */
+    const struct rewrite_rule_t* rule = match_rewrite_rule(worker->configuration_options->rewrite_engine, request->request_path, strlen(request->request_path));
+
+    if (rule) {
+        struct rewrite_captures_t captures;
+        capture_rewrite_rule(rule, request->request_path, strlen(request->request_path), &captures);
+
+        if (rule->status) {
+            send_rewrite_redirect_response(request, rule, &captures);
+            return;
+        }
+
+        if (!rewrite_request_path(request, rule, &captures)) {
+            SEND_PREBUILT_RESPONSE(request, bad_request_response);
+            return;
+        }
+    }
+
+    /**
+     * Hand the request to whatever the location it falls in
+     * says should handle it, or to the document root if it
+     * falls in none.
+     *
+     */
+    const struct location_t* location = match_location(worker->configuration_options->location_tree, request->request_path, strlen(request->request_path));
+
+    switch (location ? location->handler : LOCATION_STATIC_FILES) {
+        case LOCATION_REDIRECT: {
+            send_redirect_response(request, location);
+        } break;
+
+        case LOCATION_RETURN: {
+            send_status_response(request, location->status);
+        } break;
+
+        case LOCATION_STATIC_FILES: {
+            serve_static_file(request, location, accepts_gzip);
+        } break;
+    }
+}
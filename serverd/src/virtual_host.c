@@ -0,0 +1,406 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "serverd.h"
+#include "configuration.h"
+#include "memory.h"
+#include "perfect_hash.h"
+#include "virtual_host.h"
+
+/**
+ * A slot in the exact name table.
+ *
+ */
+struct virtual_host_name_t {
+    const char* name;
+    size_t length;
+    uint32_t host;
+};
+
+/**
+ * A slot in the wildcard suffix trie's edge table.
+ *
+ * @details The edge from node parent labelled label leads
+ * to node child. Names are walked right to left, so the
+ * path from the root to the node for *.example.com is com,
+ * then example.
+ *
+ */
+struct virtual_host_label_t {
+    const char* label;
+    size_t length;
+    uint32_t parent;
+    uint32_t child;
+};
+
+struct virtual_host_router_t {
+    struct perfect_hash_t name_hash;
+    struct virtual_host_name_t* names;
+    size_t name_count;
+
+    struct perfect_hash_t label_hash;
+    struct virtual_host_label_t* labels;
+    size_t label_count;
+
+    /**
+     * The virtual host each trie node's wildcard routes to,
+     * or zero if the node has none. Node zero is the root.
+     *
+     */
+    uint32_t* wildcard_hosts;
+};
+
+/**
+ * Fingerprint an edge of the suffix trie.
+ *
+ */
+static uint64_t virtual_host_label_key(uint32_t parent, const char* label, size_t length) {
+    return perfect_hash_string(label, length) ^ perfect_hash_mix((uint64_t) parent + 0x9E3779B97F4A7C15ULL);
+}
+
+static int is_wildcard_name(const char* name, size_t length) {
+    return (length > 2) && (name[0] == '*') && (name[1] == '.');
+}
+
+/**
+ * Find the child of a trie node while the router is being
+ * built, through a temporary open addressing index over the
+ * edges added so far.
+ *
+ */
+static struct virtual_host_label_t* find_building_edge(struct virtual_host_label_t* labels, const uint32_t* index, size_t index_mask, uint32_t parent, const char* label, size_t length, size_t* position) {
+    size_t i = (size_t) virtual_host_label_key(parent, label, length) & index_mask;
+
+    while (index[i]) {
+        struct virtual_host_label_t* edge = &labels[index[i] - 1];
+
+        if ((edge->parent == parent) && (edge->length == length) && (memcmp(edge->label, label, length) == 0)) {
+            return edge;
+        }
+
+        i = (i + 1) & index_mask;
+    }
+
+    *position = i;
+
+    return NULL;
+}
+
+/**
+ * Add a wildcard name's suffix to the trie, and return the
+ * node it ends at.
+ *
+ */
+static uint32_t insert_wildcard_name(struct virtual_host_router_t* router, uint32_t* index, size_t index_mask, uint32_t* node_count, const char* name, size_t length) {
+    uint32_t node = 0;
+    size_t end = length;
+
+    while (end > 2) {
+        size_t start = end;
+
+        while ((start > 2) && (name[start - 1] != '.')) {
+            --start;
+        }
+
+        size_t position = 0;
+        struct virtual_host_label_t* edge = find_building_edge(router->labels, index, index_mask, node, name + start, end - start, &position);
+
+        if (edge == NULL) {
+            edge = &router->labels[router->label_count++];
+            edge->label = name + start;
+            edge->length = end - start;
+            edge->parent = node;
+            edge->child = (*node_count)++;
+            index[position] = (uint32_t) router->label_count;
+        }
+
+        node = edge->child;
+        end = start - 1;
+    }
+
+    return node;
+}
+
+/**
+ * Build the router for a set of virtual hosts.
+ *
+ */
+struct virtual_host_router_t* build_virtual_host_router(const struct virtual_host_t* virtual_hosts, size_t count, const char** duplicate) {
+    *duplicate = NULL;
+
+    struct virtual_host_router_t* router = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (struct virtual_host_router_t));
+    memset(router, 0, sizeof (struct virtual_host_router_t));
+
+    /**
+     * Size everything for the worst case, where no two
+     * wildcard names share a label.
+     *
+     */
+    size_t name_capacity = 1;
+    size_t label_capacity = 1;
+
+    for (size_t i = 1; i < count; ++i) {
+        for (size_t n = 0; n < virtual_hosts[i].name_count; ++n) {
+            const char* name = virtual_hosts[i].names[n];
+
+            if (is_wildcard_name(name, strlen(name))) {
+                for (const char* c = name + 1; *c; ++c) {
+                    label_capacity += (*c == '.');
+                }
+            } else {
+                ++name_capacity;
+            }
+        }
+    }
+
+    size_t index_mask = 1;
+
+    while (index_mask < label_capacity * 2) {
+        index_mask <<= 1;
+    }
+
+    index_mask -= 1;
+
+    struct virtual_host_name_t* names = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (struct virtual_host_name_t) * name_capacity);
+    uint64_t* keys = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (uint64_t) * ((name_capacity > label_capacity) ? name_capacity : label_capacity));
+    uint32_t* slots = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (uint32_t) * ((name_capacity > label_capacity) ? name_capacity : label_capacity));
+    uint32_t* index = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (uint32_t) * (index_mask + 1));
+    memset(index, 0, sizeof (uint32_t) * (index_mask + 1));
+
+    router->labels = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (struct virtual_host_label_t) * label_capacity);
+    router->wildcard_hosts = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (uint32_t) * label_capacity);
+    memset(router->wildcard_hosts, 0, sizeof (uint32_t) * label_capacity);
+
+    uint32_t node_count = 1;
+    size_t name_count = 0;
+
+    for (size_t i = 1; (i < count) && (*duplicate == NULL); ++i) {
+        for (size_t n = 0; n < virtual_hosts[i].name_count; ++n) {
+            const char* name = virtual_hosts[i].names[n];
+            size_t length = strlen(name);
+
+            if (!is_wildcard_name(name, length)) {
+                names[name_count].name = name;
+                names[name_count].length = length;
+                names[name_count].host = (uint32_t) i;
+                keys[name_count] = perfect_hash_string(name, length);
+                ++name_count;
+                continue;
+            }
+
+            uint32_t node = insert_wildcard_name(router, index, index_mask, &node_count, name, length);
+
+            if (router->wildcard_hosts[node]) {
+                *duplicate = name;
+                break;
+            }
+
+            router->wildcard_hosts[node] = (uint32_t) i;
+        }
+    }
+
+    /**
+     * Lay the exact names out in their perfect hash slots.
+     * Two identical names have the same fingerprint, which
+     * makes the construction fail, so that is the time to
+     * go looking for the culprit.
+     *
+     */
+    if ((*duplicate == NULL) && (name_count > 0)) {
+        if (build_perfect_hash(keys, name_count, &router->name_hash, slots)) {
+            router->names = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (struct virtual_host_name_t) * (router->name_hash.slot_mask + 1));
+            memset(router->names, 0, sizeof (struct virtual_host_name_t) * (router->name_hash.slot_mask + 1));
+
+            for (size_t i = 0; i < name_count; ++i) {
+                router->names[slots[i]] = names[i];
+            }
+
+            router->name_count = name_count;
+        } else {
+            for (size_t i = 0; (i < name_count) && (*duplicate == NULL); ++i) {
+                for (size_t j = i + 1; j < name_count; ++j) {
+                    if ((keys[i] == keys[j]) && (names[i].length == names[j].length) && (memcmp(names[i].name, names[j].name, names[i].length) == 0)) {
+                        *duplicate = names[i].name;
+                        break;
+                    }
+                }
+            }
+
+            if (*duplicate == NULL) {
+                *duplicate = names[0].name;
+            }
+        }
+    }
+
+    /**
+     * Then the trie's edges in theirs.
+     *
+     */
+    if ((*duplicate == NULL) && (router->label_count > 0)) {
+        struct virtual_host_label_t* labels = router->labels;
+
+        for (size_t i = 0; i < router->label_count; ++i) {
+            keys[i] = virtual_host_label_key(labels[i].parent, labels[i].label, labels[i].length);
+        }
+
+        if (build_perfect_hash(keys, router->label_count, &router->label_hash, slots)) {
+            router->labels = allocate_tagged_memory(MEMORY_TAG_CONFIGURATION, sizeof (struct virtual_host_label_t) * (router->label_hash.slot_mask + 1));
+            memset(router->labels, 0, sizeof (struct virtual_host_label_t) * (router->label_hash.slot_mask + 1));
+
+            for (size_t i = 0; i < router->label_count; ++i) {
+                router->labels[slots[i]] = labels[i];
+            }
+        } else {
+            router->labels = NULL;
+            router->label_count = 0;
+            *duplicate = labels[0].label;
+        }
+
+        FREE(labels);
+    }
+
+    FREE(index);
+    FREE(slots);
+    FREE(keys);
+    FREE(names);
+
+    if (*duplicate) {
+        free_virtual_host_router(router);
+        return NULL;
+    }
+
+    return router;
+}
+
+/**
+ * Release a router.
+ *
+ */
+void free_virtual_host_router(struct virtual_host_router_t* router) {
+    if (router == NULL) {
+        return;
+    }
+
+    if (router->name_count > 0) {
+        free_perfect_hash(&router->name_hash);
+    }
+
+    if (router->label_count > 0) {
+        free_perfect_hash(&router->label_hash);
+    }
+
+    FREE(router->names);
+    FREE(router->labels);
+    FREE(router->wildcard_hosts);
+    FREE(router);
+}
+
+/**
+ * Find the virtual host for a Host header value.
+ *
+ */
+size_t route_virtual_host(const struct virtual_host_router_t* router, const char* host, size_t length) {
+    /**
+     * Drop the port, taking care not to mistake the colons
+     * of an IPv6 literal for one, and the trailing dot of a
+     * fully qualified name.
+     *
+     */
+    if ((length > 0) && (host[0] == '[')) {
+        const char* close = memchr(host, ']', length);
+
+        if (close) {
+            length = (size_t) (close - host) + 1;
+        }
+    } else {
+        const char* colon = memchr(host, ':', length);
+
+        if (colon) {
+            length = (size_t) (colon - host);
+        }
+    }
+
+    if ((length > 0) && (host[length - 1] == '.')) {
+        --length;
+    }
+
+    if ((length == 0) || (length > VIRTUAL_HOST_NAME_MAX_LENGTH)) {
+        return 0;
+    }
+
+    char name[VIRTUAL_HOST_NAME_MAX_LENGTH];
+
+    for (size_t i = 0; i < length; ++i) {
+        unsigned char c = (unsigned char) host[i];
+        name[i] = (char) (c | ((unsigned char) ((unsigned char) (c - 'A') < 26u) << 5));
+    }
+
+    if (router->name_count > 0) {
+        const struct virtual_host_name_t* entry = &router->names[perfect_hash_slot(&router->name_hash, perfect_hash_string(name, length))];
+
+        if (entry->name && (entry->length == length) && (memcmp(entry->name, name, length) == 0)) {
+            return entry->host;
+        }
+    }
+
+    /**
+     * Walk the suffix trie one label at a time, from the
+     * right, remembering the deepest wildcard that still has
+     * a label to its left to match.
+     *
+     */
+    size_t virtual_host = 0;
+    uint32_t node = 0;
+    size_t end = length;
+
+    while (router->label_count > 0) {
+        size_t start = end;
+
+        while ((start > 0) && (name[start - 1] != '.')) {
+            --start;
+        }
+
+        const struct virtual_host_label_t* edge = &router->labels[perfect_hash_slot(&router->label_hash, virtual_host_label_key(node, name + start, end - start))];
+
+        if ((edge->label == NULL) || (edge->parent != node) || (edge->length != end - start) || (memcmp(edge->label, name + start, end - start) != 0)) {
+            break;
+        }
+
+        node = edge->child;
+
+        if (start == 0) {
+            break;
+        }
+
+        if (router->wildcard_hosts[node]) {
+            virtual_host = router->wildcard_hosts[node];
+        }
+
+        end = start - 1;
+    }
+
+    return virtual_host;
+}
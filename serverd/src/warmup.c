@@ -0,0 +1,699 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <poll.h>
+#include <syslog.h>
+
+#include <sys/stat.h>
+
+#include "serverd.h"
+#include "configuration.h"
+#include "content_region.h"
+#include "content_store.h"
+#include "error.h"
+#include "file_cache.h"
+#include "file_io.h"
+#include "location.h"
+#include "memory.h"
+#include "popularity.h"
+#include "warmup.h"
+#include "worker.h"
+
+/**
+ * @def WARMUP_MAX_OUTSTANDING_JOBS
+ * @brief Preload jobs in flight on the file I/O pool at once.
+ *
+ */
+#ifndef WARMUP_MAX_OUTSTANDING_JOBS
+#define WARMUP_MAX_OUTSTANDING_JOBS (64)
+#endif
+
+/**
+ * A file the warm-up phase may preload.
+ *
+ * @details The path is the request path the file would be
+ * served under, which for an index.html is its directory.
+ * The filename is where it lives on disk.
+ *
+ */
+struct warmup_candidate_t {
+    char* path;
+    char* filename;
+    uint64_t size;
+    uint64_t priority;
+    uint64_t hits;
+};
+
+struct warmup_candidates_t {
+    struct warmup_candidate_t* items;
+    size_t count;
+    size_t capacity;
+};
+
+static void append_warmup_candidate(struct warmup_candidates_t* candidates, const struct warmup_candidate_t* candidate) {
+    if (candidates->count == candidates->capacity) {
+        size_t capacity = candidates->capacity ? candidates->capacity * 2 : 256;
+        struct warmup_candidate_t* items = allocate_memory(sizeof (struct warmup_candidate_t) * capacity);
+
+        if (candidates->items) {
+            memcpy(items, candidates->items, sizeof (struct warmup_candidate_t) * candidates->count);
+            FREE(candidates->items);
+        }
+
+        candidates->items = items;
+        candidates->capacity = capacity;
+    }
+
+    candidates->items[candidates->count++] = *candidate;
+}
+
+/**
+ * Concatenate up to three strings into a new heap string.
+ *
+ */
+static char* concatenate(const char* a, const char* b, const char* c) {
+    size_t a_length = strlen(a);
+    size_t b_length = strlen(b);
+    size_t c_length = strlen(c);
+
+    char* result = allocate_memory(a_length + b_length + c_length + 1);
+    memcpy(result, a, a_length);
+    memcpy(result + a_length, b, b_length);
+    memcpy(result + a_length + b_length, c, c_length + 1);
+
+    return result;
+}
+
+/**
+ * Shared state of the parallel document root walk.
+ *
+ * @details Pending directories are kept on a stack shared
+ * by all walker threads. The walk is over once the stack is
+ * empty and no thread is still scanning a directory, since
+ * only a scanning thread can push new work.
+ *
+ */
+struct warmup_walk_t {
+    pthread_mutex_t lock;
+    pthread_cond_t work_available;
+
+    char** directories;
+    size_t directory_count;
+    size_t directory_capacity;
+    size_t busy_threads;
+
+    const char* document_root;
+    struct warmup_candidates_t candidates;
+};
+
+static void push_warmup_directory(struct warmup_walk_t* walk, char* directory) {
+    if (walk->directory_count == walk->directory_capacity) {
+        size_t capacity = walk->directory_capacity ? walk->directory_capacity * 2 : 64;
+        char** directories = allocate_memory(sizeof (char *) * capacity);
+
+        if (walk->directories) {
+            memcpy(directories, walk->directories, sizeof (char *) * walk->directory_count);
+            FREE(walk->directories);
+        }
+
+        walk->directories = directories;
+        walk->directory_capacity = capacity;
+    }
+
+    walk->directories[walk->directory_count++] = directory;
+}
+
+/**
+ * Scan a single directory of the document root.
+ *
+ * @details Regular files are added to the local candidate
+ * list and subdirectories to the local directory list; the
+ * caller merges both into the shared state in one step.
+ * Symbolic links to directories are not followed, which
+ * keeps the walk from looping.
+ *
+ */
+static void scan_warmup_directory(const char* document_root, const char* directory, struct warmup_candidates_t* candidates, struct warmup_walk_t* subdirectories) {
+    char* directory_filename = concatenate(document_root, directory, "");
+    int directory_fd = open(directory_filename, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    if (directory_fd == -1) {
+        syslog(LOG_WARNING, "[Warning] Warm-up could not open directory: %s (%s)", directory_filename, strerror(errno));
+        FREE(directory_filename);
+        return;
+    }
+
+    char buffer[16 * 1024];
+    ssize_t bytes_read;
+
+    while ((bytes_read = getdents64(directory_fd, buffer, sizeof (buffer))) > 0) {
+        for (ssize_t offset = 0; offset < bytes_read; ) {
+            const struct dirent64* entry = (const struct dirent64 *) (buffer + offset);
+            offset += entry->d_reclen;
+
+            if ((strcmp(entry->d_name, ".") == 0) || (strcmp(entry->d_name, "..") == 0)) {
+                continue;
+            }
+
+            if (entry->d_type == DT_DIR) {
+                push_warmup_directory(subdirectories, concatenate(directory, entry->d_name, "/"));
+                continue;
+            }
+
+            struct stat status;
+
+            if ((fstatat(directory_fd, entry->d_name, &status, 0) == -1) || !S_ISREG(status.st_mode)) {
+                continue;
+            }
+
+            struct warmup_candidate_t candidate;
+            candidate.path = (strcmp(entry->d_name, "index.html") == 0) ? concatenate(directory, "", "") : concatenate(directory, entry->d_name, "");
+            candidate.filename = concatenate(directory_filename, entry->d_name, "");
+            candidate.size = (uint64_t) status.st_size;
+            candidate.priority = 0;
+            candidate.hits = 0;
+
+            append_warmup_candidate(candidates, &candidate);
+        }
+    }
+
+    close(directory_fd);
+    FREE(directory_filename);
+}
+
+/**
+ * Document root walker thread.
+ *
+ */
+static void* warmup_walker(void* argument) {
+    struct warmup_walk_t* walk = argument;
+
+    while (TRUE) {
+        pthread_mutex_lock(&walk->lock);
+
+        while ((walk->directory_count == 0) && (walk->busy_threads > 0)) {
+            pthread_cond_wait(&walk->work_available, &walk->lock);
+        }
+
+        if (walk->directory_count == 0) {
+            pthread_cond_broadcast(&walk->work_available);
+            pthread_mutex_unlock(&walk->lock);
+            break;
+        }
+
+        char* directory = walk->directories[--walk->directory_count];
+        walk->busy_threads++;
+        pthread_mutex_unlock(&walk->lock);
+
+        struct warmup_candidates_t candidates = { NULL, 0, 0 };
+        struct warmup_walk_t subdirectories = { .directories = NULL, .directory_count = 0, .directory_capacity = 0 };
+
+        scan_warmup_directory(walk->document_root, directory, &candidates, &subdirectories);
+        FREE(directory);
+
+        pthread_mutex_lock(&walk->lock);
+
+        for (size_t i = 0; i < subdirectories.directory_count; ++i) {
+            push_warmup_directory(walk, subdirectories.directories[i]);
+        }
+
+        for (size_t i = 0; i < candidates.count; ++i) {
+            append_warmup_candidate(&walk->candidates, &candidates.items[i]);
+        }
+
+        walk->busy_threads--;
+        pthread_cond_broadcast(&walk->work_available);
+        pthread_mutex_unlock(&walk->lock);
+
+        FREE(subdirectories.directories);
+        FREE(candidates.items);
+    }
+
+    return NULL;
+}
+
+/**
+ * Walk the document root with the given number of threads.
+ *
+ */
+static void walk_document_root(const char* document_root, size_t thread_count, struct warmup_candidates_t* candidates) {
+    struct warmup_walk_t walk;
+    memset(&walk, 0, sizeof (walk));
+
+    pthread_mutex_init(&walk.lock, NULL);
+    pthread_cond_init(&walk.work_available, NULL);
+
+    /**
+     * Request paths start with a slash, so the walk works on
+     * the document root without its trailing slash.
+     *
+     */
+    size_t root_length = strlen(document_root);
+
+    while ((root_length > 0) && (document_root[root_length - 1] == '/')) {
+        --root_length;
+    }
+
+    char* root = allocate_memory(root_length + 1);
+    memcpy(root, document_root, root_length);
+    root[root_length] = '\0';
+
+    walk.document_root = root;
+    push_warmup_directory(&walk, concatenate("/", "", ""));
+
+    pthread_t* threads = allocate_memory(sizeof (pthread_t) * thread_count);
+
+    for (size_t i = 0; i < thread_count; ++i) {
+        int error = pthread_create(&threads[i], NULL, warmup_walker, &walk);
+
+        if (error) {
+            fatal_error("[Error] %s: %s\n", "Could not create warm-up thread", strerror(error));
+        }
+    }
+
+    for (size_t i = 0; i < thread_count; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+
+    FREE(threads);
+    FREE(walk.directories);
+    FREE(root);
+
+    pthread_cond_destroy(&walk.work_available);
+    pthread_mutex_destroy(&walk.lock);
+
+    *candidates = walk.candidates;
+}
+
+/**
+ * A prioritized path from the warm-up manifest.
+ *
+ */
+struct warmup_priority_t {
+    char* path;
+    uint64_t priority;
+};
+
+static int compare_warmup_priorities(const void* a, const void* b) {
+    return strcmp(((const struct warmup_priority_t *) a)->path, ((const struct warmup_priority_t *) b)->path);
+}
+
+/**
+ * Read the warm-up manifest.
+ *
+ * @details Each line of the manifest holds a request path,
+ * optionally followed by a numeric weight. Paths without a
+ * weight are ranked by their position in the file, first
+ * line first. Blank lines and lines starting with '#' are
+ * ignored. The result is sorted by path for bsearch(3).
+ *
+ */
+static struct warmup_priority_t* read_warmup_manifest(const char* manifest_filename, size_t* count) {
+    *count = 0;
+
+    FILE* manifest = fopen(manifest_filename, "r");
+
+    if (manifest == NULL) {
+        syslog(LOG_WARNING, "[Warning] Could not open warm-up manifest: %s (%s)", manifest_filename, strerror(errno));
+        return NULL;
+    }
+
+    size_t capacity = 256;
+    struct warmup_priority_t* priorities = allocate_memory(sizeof (struct warmup_priority_t) * capacity);
+    int* weighted = allocate_memory(sizeof (int) * capacity);
+
+    size_t buffer_size = 0;
+    char* line_buffer = NULL;
+
+    while (getline(&line_buffer, &buffer_size, manifest) > 0) {
+        char* path = strtok(line_buffer, " \t\r\n");
+
+        if ((path == NULL) || (path[0] == '#')) {
+            continue;
+        }
+
+        if (*count == capacity) {
+            struct warmup_priority_t* grown = allocate_memory(sizeof (struct warmup_priority_t) * capacity * 2);
+            int* grown_weighted = allocate_memory(sizeof (int) * capacity * 2);
+            memcpy(grown, priorities, sizeof (struct warmup_priority_t) * capacity);
+            memcpy(grown_weighted, weighted, sizeof (int) * capacity);
+            FREE(priorities);
+            FREE(weighted);
+            priorities = grown;
+            weighted = grown_weighted;
+            capacity *= 2;
+        }
+
+        char* weight = strtok(NULL, " \t\r\n");
+
+        priorities[*count].path = concatenate(path, "", "");
+        priorities[*count].priority = weight ? strtoull(weight, NULL, 10) : 0;
+        weighted[*count] = (weight != NULL);
+        ++*count;
+    }
+
+    for (size_t i = 0; i < *count; ++i) {
+        if (!weighted[i]) {
+            priorities[i].priority = *count - i;
+        }
+    }
+
+    free(line_buffer);
+    FREE(weighted);
+    fclose(manifest);
+
+    qsort(priorities, *count, sizeof (struct warmup_priority_t), compare_warmup_priorities);
+
+    return priorities;
+}
+
+/**
+ * Rank candidates by priority, then by past hits, then by
+ * size.
+ *
+ * @details The manifest always wins, since it is what the
+ * operator asked for. Among files of equal priority, the
+ * ones that were hit most before the last restart go first,
+ * and among those the smallest, since they buy the most
+ * cache hits per byte of budget.
+ *
+ */
+static int compare_warmup_candidates(const void* a, const void* b) {
+    const struct warmup_candidate_t* x = a;
+    const struct warmup_candidate_t* y = b;
+
+    if (x->priority != y->priority) {
+        return (x->priority < y->priority) ? 1 : -1;
+    }
+
+    if (x->hits != y->hits) {
+        return (x->hits < y->hits) ? 1 : -1;
+    }
+
+    return (x->size > y->size) - (x->size < y->size);
+}
+
+/**
+ * Shared state of the preload phase.
+ *
+ */
+struct warmup_preload_state_t {
+    struct worker_t* worker;
+    size_t outstanding;
+    size_t preloaded;
+    uint64_t preloaded_bytes;
+};
+
+/**
+ * A single file being preloaded on the file I/O pool.
+ *
+ */
+struct warmup_preload_t {
+    struct file_io_job_t job;
+    struct warmup_preload_state_t* state;
+    const struct warmup_candidate_t* candidate;
+    void* content;
+    uint64_t content_hash;
+};
+
+/**
+ * Read a file into its content block and hash it, on the
+ * file I/O pool.
+ *
+ */
+static void read_warmup_content_job(struct file_io_job_t* job) {
+    struct warmup_preload_t* preload = job->context;
+
+    job->result = read_file_range(job->fd, job->buffer, job->offset, job->length);
+
+    if (job->result == -1) {
+        job->error = errno;
+        return;
+    }
+
+    preload->content_hash = hash_content(job->buffer, (size_t) job->result);
+}
+
+/**
+ * Advance a preload after a file I/O job.
+ *
+ * @details Once the file is open, it is read into the
+ * content cache if it is small enough and there is room,
+ * and into the page cache otherwise. Once that is done, it
+ * is handed over to the file cache, which then owns the file
+ * descriptor and the contents.
+ *
+ */
+static void on_warmup_job_complete(struct file_io_job_t* job) {
+    struct warmup_preload_t* preload = job->context;
+    struct warmup_preload_state_t* state = preload->state;
+
+    if ((job->operation == FILE_IO_OPEN) && (job->result != -1)) {
+        if (!S_ISREG(job->status.stx_mode)) {
+            close(job->fd);
+        } else {
+            uint64_t size = job->status.stx_size;
+
+            if ((size > 0) && (size <= state->worker->configuration_options->content_cache_max_file_size)) {
+                preload->content = allocate_content(state->worker->content_region, size);
+            }
+
+            job->operation = preload->content ? FILE_IO_CALL : FILE_IO_READAHEAD;
+            job->function = read_warmup_content_job;
+            job->buffer = preload->content;
+            job->offset = 0;
+            job->length = size;
+            submit_file_io_job(state->worker->file_io_pool, job);
+            return;
+        }
+    } else if ((job->operation == FILE_IO_READAHEAD) || (job->operation == FILE_IO_CALL)) {
+        const struct warmup_candidate_t* candidate = preload->candidate;
+        struct content_body_t* body = NULL;
+
+        if ((job->operation == FILE_IO_CALL) && (job->result == (ssize_t) job->length)) {
+            body = intern_content(state->worker->content_store, preload->content, job->length, preload->content_hash);
+        } else {
+            free_content(state->worker->content_region, preload->content);
+        }
+
+        struct file_cache_entry_t* entry = insert_file_cache(state->worker->hosts[0].file_cache, candidate->path, strlen(candidate->path), candidate->filename, job->fd, &job->status, body);
+
+        if (entry) {
+            /**
+             * Carry half of the old hit count over, so
+             * popularity survives restarts but still
+             * decays when a file stops being requested.
+             *
+             */
+            entry->hits = candidate->hits / 2;
+            state->preloaded++;
+            state->preloaded_bytes += job->status.stx_size;
+        } else {
+            close(job->fd);
+            release_content(state->worker->content_store, body);
+        }
+    }
+
+    state->outstanding--;
+    FREE(preload);
+}
+
+/**
+ * Check whether a request path is served from the default
+ * document root.
+ *
+ * @details The file cache is keyed by request path, and
+ * consulted before a location's document root is applied,
+ * so a file preloaded under a path that a location serves
+ * from elsewhere, redirects or answers itself would be sent
+ * in place of the right response until its entry expired.
+ *
+ */
+static int served_from_document_root(const struct configuration_options_t* configuration_options, const char* path) {
+    const struct location_t* location = match_location(configuration_options->location_tree, path, strlen(path));
+
+    return (location == NULL) || ((location->handler == LOCATION_STATIC_FILES) && (location->document_root_directory == NULL));
+}
+
+/**
+ * Run file I/O completions until few enough jobs remain.
+ *
+ * @details The event loop has not started yet, so we wait
+ * on the pool's eventfd directly.
+ *
+ */
+static void drain_warmup_jobs(struct warmup_preload_state_t* state, size_t limit) {
+    struct pollfd descriptor = { file_io_pool_eventfd(state->worker->file_io_pool), POLLIN, 0 };
+
+    while (state->outstanding > limit) {
+        if ((poll(&descriptor, 1, -1) == -1) && (errno != EINTR)) {
+            fatal_error("[Error] %s\n", strerror(errno));
+        }
+
+        complete_file_io_jobs(state->worker->file_io_pool);
+    }
+}
+
+/**
+ * Preload the file cache before serving any requests.
+ *
+ */
+void warm_up_file_cache(struct worker_t* worker) {
+    const struct configuration_options_t* configuration_options = worker->configuration_options;
+
+    /**
+     * A site pack replaces the document root entirely, so
+     * there is nothing to warm up.
+     *
+     */
+    if ((configuration_options->warmup_budget == 0) || (configuration_options->file_cache_entries == 0) || worker->site_pack) {
+        return;
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    size_t thread_count = configuration_options->file_io_thread_count ? configuration_options->file_io_thread_count : 1;
+
+    struct warmup_candidates_t candidates;
+    walk_document_root(configuration_options->document_root_directory, thread_count, &candidates);
+
+    /**
+     * Assign priorities from the manifest, if there is one.
+     *
+     */
+    size_t priority_count = 0;
+    struct warmup_priority_t* priorities = NULL;
+
+    if (configuration_options->warmup_manifest) {
+        priorities = read_warmup_manifest(configuration_options->warmup_manifest, &priority_count);
+    }
+
+    for (size_t i = 0; (i < candidates.count) && priority_count; ++i) {
+        struct warmup_priority_t key = { candidates.items[i].path, 0 };
+        const struct warmup_priority_t* match = bsearch(&key, priorities, priority_count, sizeof (struct warmup_priority_t), compare_warmup_priorities);
+
+        if (match) {
+            candidates.items[i].priority = match->priority;
+        }
+    }
+
+    /**
+     * Rank the rest by how popular they were before the
+     * restart, if a snapshot was loaded.
+     *
+     */
+    for (size_t i = 0; (i < candidates.count) && worker->popularity_snapshot; ++i) {
+        candidates.items[i].hits = lookup_popularity(worker->popularity_snapshot, candidates.items[i].path);
+
+        /**
+         * Let the cache's admission filter know about the
+         * file's past popularity too, whether or not it
+         * fits in the warm-up budget.
+         *
+         */
+        seed_file_cache_frequency(worker->hosts[0].file_cache, candidates.items[i].path, strlen(candidates.items[i].path), candidates.items[i].hits);
+    }
+
+    qsort(candidates.items, candidates.count, sizeof (struct warmup_candidate_t), compare_warmup_candidates);
+
+    /**
+     * Preload the highest-ranked files that fit the budget.
+     * A file that does not fit is skipped rather than ending
+     * the phase, since a smaller, lower-ranked file may still
+     * fit. So are files under a location that does not serve
+     * them from the document root they were found in.
+     *
+     */
+    struct warmup_preload_state_t state = { worker, 0, 0, 0 };
+    uint64_t budget = configuration_options->warmup_budget;
+    size_t selected = 0;
+
+    for (size_t i = 0; (i < candidates.count) && (selected < configuration_options->file_cache_entries); ++i) {
+        const struct warmup_candidate_t* candidate = &candidates.items[i];
+
+        if ((candidate->size > budget) || !served_from_document_root(configuration_options, candidate->path)) {
+            continue;
+        }
+
+        budget -= candidate->size;
+        ++selected;
+
+        struct warmup_preload_t* preload = allocate_memory(sizeof (struct warmup_preload_t));
+        memset(preload, 0, sizeof (struct warmup_preload_t));
+
+        preload->state = &state;
+        preload->candidate = candidate;
+        preload->job.operation = FILE_IO_OPEN;
+        preload->job.path = candidate->filename;
+        preload->job.flags = O_RDONLY | O_NONBLOCK | O_CLOEXEC;
+        preload->job.fd = -1;
+        preload->job.completion = on_warmup_job_complete;
+        preload->job.context = preload;
+
+        state.outstanding++;
+        submit_file_io_job(worker->file_io_pool, &preload->job);
+
+        drain_warmup_jobs(&state, WARMUP_MAX_OUTSTANDING_JOBS);
+    }
+
+    drain_warmup_jobs(&state, 0);
+
+    for (size_t i = 0; i < candidates.count; ++i) {
+        FREE(candidates.items[i].path);
+        FREE(candidates.items[i].filename);
+    }
+
+    for (size_t i = 0; i < priority_count; ++i) {
+        FREE(priorities[i].path);
+    }
+
+    FREE(priorities);
+    FREE(candidates.items);
+
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double elapsed = (double) (end.tv_sec - start.tv_sec) + (double) (end.tv_nsec - start.tv_nsec) / 1e9;
+    /**
+     * The content cache lives outside the allocate_memory()
+     * heap, so its usage is reported on its own.
+     *
+     */
+    size_t content_used = 0;
+    size_t content_capacity = 0;
+    content_region_usage(worker->content_region, &content_used, &content_capacity);
+
+    syslog(LOG_NOTICE, "Warm-up preloaded %zu files (%llu bytes) in %.3f seconds, content cache %zu of %zu bytes in use", state.preloaded, (unsigned long long) state.preloaded_bytes, elapsed, content_used, content_capacity);
+    syslog(LOG_NOTICE, "Content store holds %zu distinct bodies, %llu bytes for %llu bytes of cached files", worker->content_store->body_count, (unsigned long long) worker->content_store->stored_bytes, (unsigned long long) worker->content_store->referenced_bytes);
+}
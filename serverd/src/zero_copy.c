@@ -0,0 +1,300 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+
+#include <sys/sendfile.h>
+
+#include "serverd.h"
+#include "memory.h"
+#include "zero_copy.h"
+
+/**
+ * Create a pool of up to capacity idle pipes.
+ *
+ */
+struct pipe_pool_t* create_pipe_pool(size_t capacity, size_t pipe_size) {
+    struct pipe_pool_t* pool = allocate_memory(sizeof (struct pipe_pool_t));
+
+    pool->free_list = NULL;
+    pool->free_count = 0;
+    pool->capacity = capacity;
+    pool->pipe_size = pipe_size;
+
+    return pool;
+}
+
+/**
+ * Take a pipe from the pool, creating one if necessary.
+ *
+ */
+struct kernel_pipe_t* acquire_kernel_pipe(struct pipe_pool_t* pool) {
+    struct kernel_pipe_t* pipe = pool->free_list;
+
+    if (pipe) {
+        pool->free_list = pipe->next;
+        pool->free_count--;
+        pipe->next = NULL;
+        return pipe;
+    }
+
+    int fds[2];
+
+    if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) == -1) {
+        return NULL;
+    }
+
+    /**
+     * Larger pipes mean fewer round trips through splice(2)
+     * per transfer. This is purely an optimization, so a
+     * failure here, e.g. because the size exceeds
+     * /proc/sys/fs/pipe-max-size, is deliberately ignored.
+     *
+     */
+    if (pool->pipe_size) {
+        fcntl(fds[1], F_SETPIPE_SZ, (int) pool->pipe_size);
+    }
+
+    pipe = allocate_memory(sizeof (struct kernel_pipe_t));
+    pipe->read_fd = fds[0];
+    pipe->write_fd = fds[1];
+    pipe->buffered = 0;
+    pipe->next = NULL;
+
+    return pipe;
+}
+
+/**
+ * Return a pipe to the pool.
+ *
+ */
+void release_kernel_pipe(struct pipe_pool_t* pool, struct kernel_pipe_t* pipe) {
+    if ((pipe->buffered == 0) && (pool->free_count < pool->capacity)) {
+        pipe->next = pool->free_list;
+        pool->free_list = pipe;
+        pool->free_count++;
+        return;
+    }
+
+    close(pipe->read_fd);
+    close(pipe->write_fd);
+    FREE(pipe);
+}
+
+/**
+ * Drain as much of a pipe into out_fd as possible.
+ *
+ * @details Returns the number of bytes written, or -1 on
+ * error. A return value less than what was buffered means
+ * the output side would block.
+ *
+ */
+static ssize_t drain_kernel_pipe(struct kernel_pipe_t* pipe, int out_fd, off_t* out_offset) {
+    ssize_t total = 0;
+
+    while (pipe->buffered > 0) {
+        ssize_t moved = splice(pipe->read_fd, NULL, out_fd, out_offset, pipe->buffered, SPLICE_F_MOVE | SPLICE_F_NONBLOCK | SPLICE_F_MORE);
+
+        if (moved == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            if (errno == EAGAIN) {
+                break;
+            }
+
+            return -1;
+        }
+
+        pipe->buffered -= (size_t) moved;
+        total += moved;
+    }
+
+    return total;
+}
+
+/**
+ * Move bytes between two file descriptors through a pipe.
+ *
+ * @details The length argument is the number of bytes the
+ * caller still wants delivered to out_fd, including any
+ * that are already sitting in the pipe from a previous
+ * call, so the caller can simply subtract the return value
+ * from its own count of outstanding bytes.
+ *
+ */
+ssize_t splice_transfer(struct kernel_pipe_t* pipe, int in_fd, off_t* in_offset, int out_fd, off_t* out_offset, size_t length) {
+    ssize_t total = drain_kernel_pipe(pipe, out_fd, out_offset);
+
+    if (total == -1) {
+        return -1;
+    }
+
+    if (pipe->buffered > 0) {
+        return total;
+    }
+
+    while ((size_t) total < length) {
+        ssize_t filled = splice(in_fd, in_offset, pipe->write_fd, NULL, length - (size_t) total, SPLICE_F_MOVE | SPLICE_F_NONBLOCK | SPLICE_F_MORE);
+
+        if (filled == 0) {
+            break;
+        }
+
+        if (filled == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            if (errno == EAGAIN) {
+                break;
+            }
+
+            return (total > 0) ? total : -1;
+        }
+
+        pipe->buffered += (size_t) filled;
+
+        ssize_t drained = drain_kernel_pipe(pipe, out_fd, out_offset);
+
+        if (drained == -1) {
+            return (total > 0) ? total : -1;
+        }
+
+        total += drained;
+
+        if (pipe->buffered > 0) {
+            break;
+        }
+    }
+
+    return total;
+}
+
+/**
+ * Duplicate the data buffered in one pipe into another.
+ *
+ */
+ssize_t splice_tee(struct kernel_pipe_t* source, struct kernel_pipe_t* destination, size_t length) {
+    if (length > source->buffered) {
+        length = source->buffered;
+    }
+
+    ssize_t duplicated;
+
+    do {
+        duplicated = tee(source->read_fd, destination->write_fd, length, SPLICE_F_NONBLOCK);
+    } while ((duplicated == -1) && (errno == EINTR));
+
+    if (duplicated > 0) {
+        destination->buffered += (size_t) duplicated;
+    }
+
+    return duplicated;
+}
+
+/**
+ * Send a range of a file to a socket without copying.
+ *
+ * @details The sendfile(2) path is tried first, as it is a
+ * single system call per chunk. It fails with EINVAL or
+ * ENOSYS for file types it cannot handle, and only then do
+ * we take a pipe from the pool and splice instead.
+ *
+ * The splices never block, and the file's offset advances
+ * as soon as its bytes are in the pipe, not once they have
+ * reached the socket. When the socket is full, we wait for
+ * room, just as a blocking sendfile(2) would, and if the
+ * transfer fails with bytes still in the pipe, the offset is
+ * moved back over them before the pipe is let go of, so
+ * that it only ever counts bytes actually sent.
+ *
+ */
+ssize_t send_file_range(struct pipe_pool_t* pool, int socket, int fd, off_t* offset, size_t length) {
+    size_t total = 0;
+
+    while (total < length) {
+        ssize_t sent = sendfile(socket, fd, offset, length - total);
+
+        if (sent > 0) {
+            total += (size_t) sent;
+            continue;
+        }
+
+        if (sent == 0) {
+            return (ssize_t) total;
+        }
+
+        if (errno == EINTR) {
+            continue;
+        }
+
+        if ((errno != EINVAL) && (errno != ENOSYS)) {
+            return ((total > 0) || (errno == EAGAIN)) ? (ssize_t) total : -1;
+        }
+
+        struct kernel_pipe_t* pipe = acquire_kernel_pipe(pool);
+
+        if (pipe == NULL) {
+            return (total > 0) ? (ssize_t) total : -1;
+        }
+
+        int failed = FALSE;
+
+        while (total < length) {
+            ssize_t spliced = splice_transfer(pipe, fd, offset, socket, NULL, length - total);
+
+            if (spliced == -1) {
+                failed = TRUE;
+                break;
+            }
+
+            total += (size_t) spliced;
+
+            if (pipe->buffered > 0) {
+                struct pollfd writable = { .fd = socket, .events = POLLOUT };
+
+                if ((poll(&writable, 1, -1) == -1) && (errno != EINTR)) {
+                    failed = TRUE;
+                    break;
+                }
+            } else if (spliced == 0) {
+                break;
+            }
+        }
+
+        *offset -= (off_t) pipe->buffered;
+        release_kernel_pipe(pool, pipe);
+
+        return ((total == 0) && failed) ? -1 : (ssize_t) total;
+    }
+
+    return (ssize_t) total;
+}
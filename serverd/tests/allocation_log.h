@@ -0,0 +1,81 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PROJECT_TESTS_ALLOCATION_LOG_H
+#define PROJECT_TESTS_ALLOCATION_LOG_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+/**
+ * @def ALLOCATION_LOG_ENVIRONMENT
+ * @brief The environment variable naming the file the
+ * interposer logs allocations to.
+ *
+ */
+#define ALLOCATION_LOG_ENVIRONMENT "SERVERD_ALLOCATION_LOG"
+
+/**
+ * @def ALLOCATION_LOG_SITES
+ * @brief Number of distinct call sites the log can hold.
+ * Must be a power of two.
+ *
+ */
+#define ALLOCATION_LOG_SITES (1024)
+
+/**
+ * One call site that allocated while the log was armed.
+ *
+ * @details The site is identified by the innermost return
+ * address inside the serverd executable, and the immediate
+ * caller of the allocation function, which differs when
+ * serverd allocated through a library function, e.g.
+ * syslog(3).
+ *
+ */
+struct allocation_site_t {
+    _Atomic uintptr_t program_address;
+    _Atomic uintptr_t caller_address;
+    _Atomic uint64_t count;
+    _Atomic uint64_t bytes;
+};
+
+/**
+ * The log the interposer shares with the test driver.
+ *
+ * @details The file is mapped shared by both, so it keeps
+ * working after serverd forks into the background and closes
+ * every descriptor it inherited. Allocations are only
+ * recorded while armed is set.
+ *
+ */
+struct allocation_log_t {
+    _Atomic int armed;
+    _Atomic int pid;
+    uintptr_t program_base;
+    _Atomic uint64_t allocations;
+    _Atomic uint64_t dropped;
+    struct allocation_site_t sites[ALLOCATION_LOG_SITES];
+};
+
+#endif /** PROJECT_TESTS_ALLOCATION_LOG_H */
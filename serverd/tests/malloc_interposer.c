@@ -0,0 +1,253 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include <execinfo.h>
+#include <fcntl.h>
+#include <link.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+
+#include "allocation_log.h"
+
+/**
+ * Allocation Interposer
+ *
+ * @details This library is preloaded into serverd by the
+ * zero-allocation test. It replaces malloc(3) and friends
+ * with wrappers that record every call made while the shared
+ * allocation log is armed, and then hand the call on to the
+ * C library's own allocator.
+ *
+ * Memory serverd obtains from mmap(2) directly, as with the
+ * pool allocator backend, or through an allocator called by
+ * its own interface, as with mimalloc, is not seen.
+ *
+ */
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* memory, size_t size);
+extern void* __libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void* memory);
+
+/**
+ * @def INTERPOSER_BACKTRACE_DEPTH
+ * @brief How many frames are searched for a return address
+ * in the serverd executable.
+ *
+ */
+#define INTERPOSER_BACKTRACE_DEPTH (16)
+
+static struct allocation_log_t* allocation_log = NULL;
+
+static uintptr_t program_start = 0;
+static uintptr_t program_end = 0;
+
+/**
+ * Guards against recording the allocations made while an
+ * allocation is being recorded.
+ *
+ */
+static _Thread_local int recording = 0;
+
+/**
+ * Find the address range of the executable's loaded
+ * segments. The executable is always the first object.
+ *
+ */
+static int find_program_range(struct dl_phdr_info* info, size_t size, void* data) {
+    (void) size;
+    (void) data;
+
+    program_start = UINTPTR_MAX;
+
+    for (int i = 0; i < info->dlpi_phnum; ++i) {
+        if (info->dlpi_phdr[i].p_type != PT_LOAD) {
+            continue;
+        }
+
+        uintptr_t start = info->dlpi_addr + info->dlpi_phdr[i].p_vaddr;
+        uintptr_t end = start + info->dlpi_phdr[i].p_memsz;
+
+        if (start < program_start) {
+            program_start = start;
+        }
+
+        if (end > program_end) {
+            program_end = end;
+        }
+    }
+
+    allocation_log->program_base = info->dlpi_addr;
+
+    return 1;
+}
+
+/**
+ * Record the child's process ID, so the driver knows which
+ * process is the daemon.
+ *
+ */
+static void record_child_pid(void) {
+    atomic_store(&allocation_log->pid, (int) getpid());
+}
+
+__attribute__((constructor))
+static void initialize_interposer(void) {
+    const char* filename = getenv(ALLOCATION_LOG_ENVIRONMENT);
+
+    if (filename == NULL) {
+        return;
+    }
+
+    int fd = open(filename, O_RDWR | O_CLOEXEC);
+
+    if (fd == -1) {
+        return;
+    }
+
+    void* log = mmap(NULL, sizeof (struct allocation_log_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (log == MAP_FAILED) {
+        return;
+    }
+
+    allocation_log = log;
+    atomic_store(&allocation_log->pid, (int) getpid());
+
+    dl_iterate_phdr(find_program_range, NULL);
+    pthread_atfork(NULL, NULL, record_child_pid);
+
+    /**
+     * The first backtrace(3) loads the unwinder, which
+     * allocates, so get that over with now.
+     *
+     */
+    void* frames[INTERPOSER_BACKTRACE_DEPTH];
+    backtrace(frames, INTERPOSER_BACKTRACE_DEPTH);
+}
+
+/**
+ * Record an allocation, if the log is armed.
+ *
+ */
+static void record_allocation(void* caller, size_t size) {
+    if ((allocation_log == NULL) || !atomic_load_explicit(&allocation_log->armed, memory_order_relaxed) || recording) {
+        return;
+    }
+
+    recording = 1;
+
+    void* frames[INTERPOSER_BACKTRACE_DEPTH];
+    int depth = backtrace(frames, INTERPOSER_BACKTRACE_DEPTH);
+    uintptr_t program_address = 0;
+
+    for (int i = 1; i < depth; ++i) {
+        if (((uintptr_t) frames[i] >= program_start) && ((uintptr_t) frames[i] < program_end)) {
+            program_address = (uintptr_t) frames[i];
+            break;
+        }
+    }
+
+    uintptr_t caller_address = (uintptr_t) caller;
+
+    atomic_fetch_add(&allocation_log->allocations, 1);
+
+    uintptr_t hash = (program_address ^ (caller_address * 0x9E3779B97F4A7C15ULL)) >> 4;
+
+    for (size_t probe = 0; probe < ALLOCATION_LOG_SITES; ++probe) {
+        struct allocation_site_t* site = &allocation_log->sites[(hash + probe) & (ALLOCATION_LOG_SITES - 1)];
+        uintptr_t expected = 0;
+
+        /**
+         * Claim an empty slot by its caller address; the
+         * program address is written straight after, so a
+         * racing thread may briefly see it as zero and probe
+         * on, which only costs a duplicate entry.
+         *
+         */
+        if (atomic_compare_exchange_strong(&site->caller_address, &expected, caller_address)) {
+            atomic_store(&site->program_address, program_address);
+        } else if ((expected != caller_address) || (atomic_load(&site->program_address) != program_address)) {
+            continue;
+        }
+
+        atomic_fetch_add(&site->count, 1);
+        atomic_fetch_add(&site->bytes, size);
+        recording = 0;
+        return;
+    }
+
+    atomic_fetch_add(&allocation_log->dropped, 1);
+    recording = 0;
+}
+
+void* malloc(size_t size) {
+    record_allocation(__builtin_return_address(0), size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    record_allocation(__builtin_return_address(0), count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* memory, size_t size) {
+    record_allocation(__builtin_return_address(0), size);
+    return __libc_realloc(memory, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+    record_allocation(__builtin_return_address(0), size);
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    record_allocation(__builtin_return_address(0), size);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** memory, size_t alignment, size_t size) {
+    record_allocation(__builtin_return_address(0), size);
+
+    void* block = __libc_memalign(alignment, size);
+
+    if (block == NULL) {
+        return ENOMEM;
+    }
+
+    *memory = block;
+    return 0;
+}
+
+void free(void* memory) {
+    __libc_free(memory);
+}
@@ -0,0 +1,579 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+/**
+ * Reload During Streaming Test
+ *
+ * @details This test starts serverd on loopback and begins
+ * downloading a file large enough to be streamed from the
+ * file I/O pool. While the download is in progress, it
+ * reloads the configuration several times, each time with a
+ * different StreamingDropCache setting, and waits until a
+ * probe request shows that the new configuration is in
+ * effect. The download must still arrive whole and intact,
+ * since a stream in flight must not depend on the
+ * configuration it started under.
+ *
+ * The negative cache is turned off, as serverd.conf says it
+ * can be, since a reload that changes the locations clears
+ * every cache, and a disabled one has nothing to clear.
+ *
+ * Usage: reload_stream_test [serverd]
+ *
+ */
+
+/**
+ * @def STREAMED_FILE_SIZE
+ * @brief Size of the streamed file.
+ *
+ */
+#ifndef STREAMED_FILE_SIZE
+#define STREAMED_FILE_SIZE (32 * 1024 * 1024)
+#endif
+
+/**
+ * @def RELOAD_COUNT
+ * @brief Number of reloads made while the file streams.
+ *
+ */
+#ifndef RELOAD_COUNT
+#define RELOAD_COUNT (4)
+#endif
+
+/**
+ * @def STREAM_READ_LIMIT
+ * @brief Most bytes of the stream read per poll interval
+ * while a reload is awaited.
+ *
+ * @details serverd sends on blocking sockets, so the event
+ * loop only gets round to the reload and the probe when the
+ * stream is read, but reading it at full speed could finish
+ * the download before the reload took effect.
+ *
+ */
+#ifndef STREAM_READ_LIMIT
+#define STREAM_READ_LIMIT (128 * 1024)
+#endif
+
+/**
+ * The daemon the test started, once it has reported its
+ * process ID.
+ *
+ */
+static pid_t serverd_pid = 0;
+
+/**
+ * Print an error message, stop the daemon if it is running,
+ * and exit with a failing status.
+ *
+ */
+__attribute__((noreturn, format(printf, 1, 2)))
+static void fail(const char* format, ...) {
+    va_list arguments;
+    va_start(arguments, format);
+    vfprintf(stderr, format, arguments);
+    va_end(arguments);
+
+    if (serverd_pid > 0) {
+        kill(serverd_pid, SIGTERM);
+    }
+
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * The byte expected at an offset of the streamed file.
+ *
+ * @details The pattern changes from one 4 KiB block to the
+ * next, so that a chunk sent twice, skipped, or sent out of
+ * order shows up as a mismatch.
+ *
+ */
+static unsigned char expected_byte(uint64_t offset) {
+    return (unsigned char) ((offset >> 12) * 131 + offset);
+}
+
+/**
+ * Write a file into the test directory.
+ *
+ */
+static void write_test_file(const char* directory, const char* name, const char* contents) {
+    char filename[4096];
+    snprintf(filename, sizeof (filename), "%s/%s", directory, name);
+
+    FILE* file = fopen(filename, "w");
+
+    if ((file == NULL) || (fputs(contents, file) == EOF) || (fclose(file) == EOF)) {
+        fail("Could not write %s: %s\n", filename, strerror(errno));
+    }
+}
+
+/**
+ * Write the file that is streamed.
+ *
+ */
+static void write_streamed_file(const char* filename) {
+    FILE* file = fopen(filename, "w");
+
+    if (file == NULL) {
+        fail("Could not write %s: %s\n", filename, strerror(errno));
+    }
+
+    for (uint64_t offset = 0; offset < STREAMED_FILE_SIZE; ++offset) {
+        putc(expected_byte(offset), file);
+    }
+
+    if (fclose(file) == EOF) {
+        fail("Could not write %s: %s\n", filename, strerror(errno));
+    }
+}
+
+/**
+ * Write the configuration for the given reload generation.
+ *
+ * @details Odd generations turn StreamingDropCache off and
+ * answer /reloaded with a 204, even ones turn it back on and
+ * leave /reloaded to 404, so every reload changes both what
+ * the stream would read from the configuration and what the
+ * probe sees.
+ *
+ */
+static void write_configuration(const char* directory, unsigned short port, int generation) {
+    char configuration[8192];
+    snprintf(configuration, sizeof (configuration),
+        "Hostname=127.0.0.1\n"
+        "Port=%u\n"
+        "DocumentRoot=%s/root/\n"
+        "LogLevel=Notice\n"
+        "NegativeCacheEntries=0\n"
+        "StreamingThreshold=1M\n"
+        "StreamingBufferSize=64K\n"
+        "StreamingDropCache=%s\n"
+        "%s",
+        port,
+        directory,
+        (generation % 2) ? "Off" : "On",
+        (generation % 2) ? "Location=exact /reloaded\nReturn=204\nEndLocation\n" : "");
+
+    write_test_file(directory, "serverd.conf", configuration);
+}
+
+/**
+ * Find a free loopback port.
+ *
+ */
+static unsigned short find_free_port(void) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in address = { .sin_family = AF_INET, .sin_port = 0, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t length = sizeof (address);
+
+    if ((fd == -1) || (bind(fd, (struct sockaddr *) &address, sizeof (address)) == -1) || (getsockname(fd, (struct sockaddr *) &address, &length) == -1)) {
+        fail("Could not find a free port: %s\n", strerror(errno));
+    }
+
+    close(fd);
+
+    return ntohs(address.sin_port);
+}
+
+/**
+ * Connect to the server and send it a request for a path,
+ * or return -1 if the server could not be reached.
+ *
+ */
+static int send_request(unsigned short port, const char* path) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_in address = { .sin_family = AF_INET, .sin_port = htons(port), .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+
+    if (connect(fd, (struct sockaddr *) &address, sizeof (address)) == -1) {
+        close(fd);
+        return -1;
+    }
+
+    char request[1024];
+    int length = snprintf(request, sizeof (request), "GET %s HTTP/1.1\r\nHost: localhost\r\n\r\n", path);
+
+    if (write(fd, request, (size_t) length) != length) {
+        fail("Could not send request: %s\n", strerror(errno));
+    }
+
+    return fd;
+}
+
+/**
+ * A download of the streamed file in progress.
+ *
+ * @details The response header is collected first; after
+ * that, the body is checked against the expected pattern as
+ * it arrives, rather than kept.
+ *
+ */
+struct download_t {
+    int fd;
+    int finished;
+    char header[4096];
+    size_t header_length;
+    size_t header_end;
+    uint64_t content_length;
+    uint64_t received;
+};
+
+/**
+ * Read up to a number of bytes of the download.
+ *
+ */
+static void read_download(struct download_t* download, size_t limit) {
+    char buffer[65536];
+
+    while (!download->finished && (limit > 0)) {
+        size_t size = (limit < sizeof (buffer)) ? limit : sizeof (buffer);
+        ssize_t bytes = recv(download->fd, buffer, size, MSG_DONTWAIT);
+
+        if (bytes == -1) {
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) {
+                return;
+            }
+
+            fail("Could not read the download: %s\n", strerror(errno));
+        }
+
+        if (bytes == 0) {
+            download->finished = 1;
+            return;
+        }
+
+        limit -= (size_t) bytes;
+
+        const char* body = buffer;
+        size_t body_length = (size_t) bytes;
+
+        if (download->header_end == 0) {
+            size_t copied = (body_length < sizeof (download->header) - 1 - download->header_length) ? body_length : sizeof (download->header) - 1 - download->header_length;
+            memcpy(download->header + download->header_length, body, copied);
+            download->header_length += copied;
+            download->header[download->header_length] = '\0';
+
+            const char* end = strstr(download->header, "\r\n\r\n");
+
+            if (end == NULL) {
+                if (download->header_length == sizeof (download->header) - 1) {
+                    fail("The response header is too long\n");
+                }
+
+                continue;
+            }
+
+            if (strncmp(download->header, "HTTP/1.1 200", 12) != 0) {
+                fail("Unexpected response to the download: %.40s\n", download->header);
+            }
+
+            const char* content_length = strstr(download->header, "Content-Length: ");
+
+            if ((content_length == NULL) || (content_length > end)) {
+                fail("The download has no Content-Length\n");
+            }
+
+            download->content_length = strtoull(content_length + strlen("Content-Length: "), NULL, 10);
+            download->header_end = (size_t) (end - download->header) + 4;
+
+            size_t header_in_buffer = download->header_end - (download->header_length - copied);
+            body += header_in_buffer;
+            body_length -= header_in_buffer;
+        }
+
+        for (size_t i = 0; i < body_length; ++i) {
+            if ((download->received >= STREAMED_FILE_SIZE) || ((unsigned char) body[i] != expected_byte(download->received))) {
+                fail("The download is corrupt at offset %llu\n", (unsigned long long) download->received);
+            }
+
+            download->received++;
+        }
+    }
+}
+
+/**
+ * Read a probe's response and return its status code, or 0
+ * if the response has not arrived yet.
+ *
+ */
+static int read_probe_status(int fd) {
+    char response[256];
+    ssize_t bytes = recv(fd, response, sizeof (response) - 1, MSG_DONTWAIT);
+
+    if (bytes == -1) {
+        if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) {
+            return 0;
+        }
+
+        fail("Could not read the probe response: %s\n", strerror(errno));
+    }
+
+    response[bytes] = '\0';
+
+    if ((bytes < 12) || (strncmp(response, "HTTP/1.1 ", 9) != 0)) {
+        fail("Unexpected response to the probe: %.40s\n", response);
+    }
+
+    return atoi(response + 9);
+}
+
+/**
+ * Keep the download going until a probe of /reloaded gets
+ * the given status, showing that the reload is in effect.
+ *
+ */
+static void await_reload(struct download_t* download, unsigned short port, int expected_status) {
+    for (int attempt = 0; attempt < 200; ++attempt) {
+        int probe = send_request(port, "/reloaded");
+
+        if (probe == -1) {
+            fail("Could not connect to serverd: %s\n", strerror(errno));
+        }
+
+        int status = 0;
+
+        while (status == 0) {
+            struct pollfd descriptors[2] = {
+                { .fd = probe, .events = POLLIN },
+                { .fd = download->fd, .events = POLLIN }
+            };
+
+            poll(descriptors, download->finished ? 1 : 2, 10);
+
+            status = read_probe_status(probe);
+            read_download(download, STREAM_READ_LIMIT);
+        }
+
+        close(probe);
+
+        if (status == expected_status) {
+            return;
+        }
+    }
+
+    fail("The reload did not take effect\n");
+}
+
+int main(int argc, char *argv[])
+{
+    const char* serverd = (argc > 1) ? argv[1] : "../serverd";
+    char serverd_path[4096];
+
+    if (realpath(serverd, serverd_path) == NULL) {
+        fail("Usage: %s [serverd]\n", argv[0]);
+    }
+
+    /**
+     * Lay out a document root with a small index page to
+     * check the server is up with, and the streamed file.
+     *
+     */
+    char directory[] = "/tmp/serverd-reload-stream.XXXXXX";
+
+    if (mkdtemp(directory) == NULL) {
+        fail("Could not create a temporary directory: %s\n", strerror(errno));
+    }
+
+    char path[4096];
+    snprintf(path, sizeof (path), "%s/root", directory);
+    mkdir(path, 0755);
+    write_test_file(path, "index.html", "<!DOCTYPE html><html><head><title>serverd</title></head><body>It works.</body></html>\n");
+
+    snprintf(path, sizeof (path), "%s/root/stream.bin", directory);
+    write_streamed_file(path);
+
+    unsigned short port = find_free_port();
+    write_configuration(directory, port, 0);
+
+    /**
+     * Start serverd. It forks into the background, and the
+     * process we started exits once it has. The daemon prints
+     * its process ID before closing its standard output,
+     * which is how the test knows where to send SIGHUP.
+     *
+     */
+    char configuration_argument[4200];
+    snprintf(configuration_argument, sizeof (configuration_argument), "--configuration-filename=%s/serverd.conf", directory);
+
+    int pid_pipe[2];
+
+    if (pipe(pid_pipe) == -1) {
+        fail("Could not create a pipe: %s\n", strerror(errno));
+    }
+
+    pid_t launcher = fork();
+
+    if (launcher == -1) {
+        fail("Could not fork: %s\n", strerror(errno));
+    }
+
+    if (launcher == 0) {
+        dup2(pid_pipe[1], STDOUT_FILENO);
+        close(pid_pipe[0]);
+        close(pid_pipe[1]);
+        execl(serverd_path, serverd_path, configuration_argument, (char *) NULL);
+        _exit(127);
+    }
+
+    close(pid_pipe[1]);
+
+    int status;
+    waitpid(launcher, &status, 0);
+
+    FILE* pid_output = fdopen(pid_pipe[0], "r");
+    int reported_pid = 0;
+
+    if ((pid_output == NULL) || (fscanf(pid_output, "%d", &reported_pid) != 1)) {
+        reported_pid = 0;
+    }
+
+    if (pid_output) {
+        fclose(pid_output);
+    }
+
+    serverd_pid = (pid_t) reported_pid;
+
+    if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0) || (serverd_pid <= 0)) {
+        fail("serverd did not start\n");
+    }
+
+    /**
+     * Wait for the server to come up.
+     *
+     */
+    int connected = 0;
+
+    for (int attempt = 0; (attempt < 100) && !connected; ++attempt) {
+        int fd = send_request(port, "/index.html");
+
+        if (fd == -1) {
+            usleep(50000);
+            continue;
+        }
+
+        char response[16] = "";
+
+        if (read(fd, response, sizeof (response) - 1) < 12) {
+            fail("serverd closed the connection without a response\n");
+        }
+
+        close(fd);
+        connected = 1;
+    }
+
+    if (!connected) {
+        fail("serverd is not accepting connections on port %u\n", port);
+    }
+
+    /**
+     * Start the download, and make sure it is under way
+     * before the first reload.
+     *
+     */
+    struct download_t download = { .fd = send_request(port, "/stream.bin") };
+
+    if (download.fd == -1) {
+        fail("Could not connect to serverd: %s\n", strerror(errno));
+    }
+
+    while (!download.finished && (download.received < 1024 * 1024)) {
+        struct pollfd descriptor = { .fd = download.fd, .events = POLLIN };
+        poll(&descriptor, 1, 100);
+        read_download(&download, STREAM_READ_LIMIT);
+    }
+
+    /**
+     * Reload with alternating configurations while the file
+     * streams, waiting each time until the reload is in
+     * effect.
+     *
+     */
+    for (int generation = 1; generation <= RELOAD_COUNT; ++generation) {
+        write_configuration(directory, port, generation);
+
+        if (kill(serverd_pid, SIGHUP) == -1) {
+            fail("Could not signal serverd: %s\n", strerror(errno));
+        }
+
+        await_reload(&download, port, (generation % 2) ? 204 : 404);
+
+        if (download.finished) {
+            fail("The download finished before reload %d took effect\n", generation);
+        }
+    }
+
+    /**
+     * Finish the download.
+     *
+     */
+    while (!download.finished) {
+        struct pollfd descriptor = { .fd = download.fd, .events = POLLIN };
+
+        if (poll(&descriptor, 1, 5000) == 0) {
+            fail("The download stalled after %llu bytes\n", (unsigned long long) download.received);
+        }
+
+        read_download(&download, SIZE_MAX);
+    }
+
+    close(download.fd);
+
+    printf("%llu of %llu bytes streamed across %d reloads\n",
+        (unsigned long long) download.received,
+        (unsigned long long) download.content_length,
+        RELOAD_COUNT);
+
+    if ((download.content_length != STREAMED_FILE_SIZE) || (download.received != download.content_length)) {
+        fail("FAIL: the download was cut short\n");
+    }
+
+    kill(serverd_pid, SIGTERM);
+
+    char command[4200];
+    snprintf(command, sizeof (command), "rm -rf %s", directory);
+
+    if (system(command) != 0) {
+        fprintf(stderr, "Could not remove %s\n", directory);
+    }
+
+    printf("PASS\n");
+    return EXIT_SUCCESS;
+}
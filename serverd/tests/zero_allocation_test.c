@@ -0,0 +1,517 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "allocation_log.h"
+
+/**
+ * Zero-Allocation Steady State Test
+ *
+ * @details This test starts serverd on loopback with the
+ * allocation interposer preloaded, warms it up with a fixed
+ * mix of requests, and then sends the same mix again with
+ * the allocation log armed. Once every cache and pool has
+ * warmed up, serving a request should not touch the heap at
+ * all, so the test fails if anything allocated, and reports
+ * how many allocations each call site made per request.
+ *
+ * Usage: zero_allocation_test [serverd] [interposer]
+ *
+ */
+
+/**
+ * @def WARMUP_ROUNDS
+ * @brief Number of times the request mix is sent before
+ * allocations are counted.
+ *
+ */
+#ifndef WARMUP_ROUNDS
+#define WARMUP_ROUNDS (20)
+#endif
+
+/**
+ * @def MEASURED_ROUNDS
+ * @brief Number of times the request mix is sent while
+ * allocations are counted.
+ *
+ */
+#ifndef MEASURED_ROUNDS
+#define MEASURED_ROUNDS (100)
+#endif
+
+/**
+ * A request in the mix, and the status line it must get.
+ *
+ */
+struct test_request_t {
+    const char* request;
+    const char* status;
+};
+
+static const struct test_request_t request_mix[] = {
+    { "GET /index.html HTTP/1.1\r\nHost: localhost\r\n\r\n", "HTTP/1.1 200" },
+    { "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n", "HTTP/1.1 200" },
+    { "GET /style.css HTTP/1.1\r\nHost: localhost\r\nAccept-Encoding: gzip\r\n\r\n", "HTTP/1.1 200" },
+    { "GET /missing.html HTTP/1.1\r\nHost: localhost\r\n\r\n", "HTTP/1.1 404" },
+    { "GET /docs/ HTTP/1.1\r\nHost: localhost\r\n\r\n", "HTTP/1.1 200" },
+    { "GET /docs HTTP/1.1\r\nHost: localhost\r\n\r\n", "HTTP/1.1 301" },
+};
+
+#define REQUEST_MIX_SIZE (sizeof (request_mix) / sizeof (request_mix[0]))
+
+/**
+ * The daemon the test started, once it has reported its
+ * process ID.
+ *
+ */
+static pid_t serverd_pid = 0;
+
+/**
+ * Print an error message, stop the daemon if it is running,
+ * and exit with a failing status.
+ *
+ */
+__attribute__((noreturn, format(printf, 1, 2)))
+static void fail(const char* format, ...) {
+    va_list arguments;
+    va_start(arguments, format);
+    vfprintf(stderr, format, arguments);
+    va_end(arguments);
+
+    if (serverd_pid > 0) {
+        kill(serverd_pid, SIGTERM);
+    }
+
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Write a file into the test's document root.
+ *
+ */
+static void write_test_file(const char* directory, const char* name, const char* contents) {
+    char filename[4096];
+    snprintf(filename, sizeof (filename), "%s/%s", directory, name);
+
+    FILE* file = fopen(filename, "w");
+
+    if ((file == NULL) || (fputs(contents, file) == EOF) || (fclose(file) == EOF)) {
+        fail("Could not write %s: %s\n", filename, strerror(errno));
+    }
+}
+
+/**
+ * Find a free loopback port.
+ *
+ */
+static unsigned short find_free_port(void) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in address = { .sin_family = AF_INET, .sin_port = 0, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t length = sizeof (address);
+
+    if ((fd == -1) || (bind(fd, (struct sockaddr *) &address, sizeof (address)) == -1) || (getsockname(fd, (struct sockaddr *) &address, &length) == -1)) {
+        fail("Could not find a free port: %s\n", strerror(errno));
+    }
+
+    close(fd);
+
+    return ntohs(address.sin_port);
+}
+
+/**
+ * Connect to the server, or return -1.
+ *
+ */
+static int connect_to_server(unsigned short port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_in address = { .sin_family = AF_INET, .sin_port = htons(port), .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+
+    if (connect(fd, (struct sockaddr *) &address, sizeof (address)) == -1) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/**
+ * Send one request and check its response's status line,
+ * or return 0 if the server could not be reached.
+ *
+ * @details serverd closes every connection after one
+ * response, so the response is read until end of file.
+ *
+ */
+static int try_test_request(unsigned short port, const struct test_request_t* request) {
+    int fd = connect_to_server(port);
+
+    if (fd == -1) {
+        return 0;
+    }
+
+    size_t length = strlen(request->request);
+
+    if (write(fd, request->request, length) != (ssize_t) length) {
+        fail("Could not send request: %s\n", strerror(errno));
+    }
+
+    char response[65536];
+    size_t received = 0;
+    ssize_t bytes;
+
+    while ((bytes = read(fd, response + received, sizeof (response) - 1 - received)) > 0) {
+        received += (size_t) bytes;
+
+        if (received == sizeof (response) - 1) {
+            received = strlen(request->status);
+        }
+    }
+
+    close(fd);
+    response[received] = '\0';
+
+    if (strncmp(response, request->status, strlen(request->status)) != 0) {
+        fail("Unexpected response to %.*s: %.40s\n", (int) strcspn(request->request, "\r"), request->request, response);
+    }
+
+    return 1;
+}
+
+/**
+ * Send one request and check its response's status line.
+ *
+ */
+static void send_test_request(unsigned short port, const struct test_request_t* request) {
+    if (!try_test_request(port, request)) {
+        fail("Could not connect to serverd: %s\n", strerror(errno));
+    }
+}
+
+/**
+ * Send the whole request mix a number of times.
+ *
+ */
+static void send_request_mix(unsigned short port, int rounds) {
+    for (int round = 0; round < rounds; ++round) {
+        for (size_t i = 0; i < REQUEST_MIX_SIZE; ++i) {
+            send_test_request(port, &request_mix[i]);
+        }
+    }
+}
+
+/**
+ * Describe an address in the daemon, as "function (file:line)"
+ * for the serverd executable, and as the mapped file and
+ * offset otherwise.
+ *
+ */
+static void describe_address(char* description, size_t size, const char* serverd, const struct allocation_log_t* log, int pid, uintptr_t address) {
+    char maps_filename[64];
+    snprintf(maps_filename, sizeof (maps_filename), "/proc/%d/maps", pid);
+
+    FILE* maps = fopen(maps_filename, "r");
+    char line[4096];
+
+    if (maps) {
+        while (fgets(line, sizeof (line), maps)) {
+            uintptr_t start;
+            uintptr_t end;
+            unsigned long offset;
+            char path[4096] = "";
+
+            if (sscanf(line, "%lx-%lx %*s %lx %*s %*s %4095s", &start, &end, &offset, path) < 3) {
+                continue;
+            }
+
+            if ((address < start) || (address >= end)) {
+                continue;
+            }
+
+            fclose(maps);
+
+            const char* name = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+
+            if (strcmp(name, strrchr(serverd, '/') ? strrchr(serverd, '/') + 1 : serverd) != 0) {
+                snprintf(description, size, "%s+0x%lx", name, (unsigned long) (address - start + offset));
+                return;
+            }
+
+            break;
+        }
+    }
+
+    /**
+     * The return address is just past the call, so look up
+     * the byte before it to get the call's own line. When the
+     * call was inlined, addr2line lists the inlined functions
+     * first, and the function they were inlined into last.
+     *
+     */
+    char command[8192];
+    snprintf(command, sizeof (command), "addr2line -f -i -s -e %s 0x%lx 2>/dev/null", serverd, (unsigned long) (address - log->program_base - 1));
+
+    FILE* symbolizer = popen(command, "r");
+    char function[512] = "??";
+    char location[512] = "??";
+
+    if (symbolizer) {
+        char next_function[512];
+        char next_location[512];
+
+        while (fgets(next_function, sizeof (next_function), symbolizer) && fgets(next_location, sizeof (next_location), symbolizer)) {
+            next_function[strcspn(next_function, "\n")] = '\0';
+            next_location[strcspn(next_location, " \n")] = '\0';
+            strcpy(function, next_function);
+            strcpy(location, next_location);
+        }
+
+        pclose(symbolizer);
+    }
+
+    snprintf(description, size, "%s (%s)", function, location);
+}
+
+int main(int argc, char *argv[])
+{
+    const char* serverd = (argc > 1) ? argv[1] : "../serverd";
+    const char* interposer = (argc > 2) ? argv[2] : "./malloc_interposer.so";
+
+    char serverd_path[4096];
+    char interposer_path[4096];
+
+    if ((realpath(serverd, serverd_path) == NULL) || (realpath(interposer, interposer_path) == NULL)) {
+        fail("Usage: %s [serverd] [interposer]\n", argv[0]);
+    }
+
+    /**
+     * Lay out a small document root, with an index page, a
+     * stylesheet and a directory without an index, whose
+     * listing is generated.
+     *
+     */
+    char directory[] = "/tmp/serverd-zero-allocation.XXXXXX";
+
+    if (mkdtemp(directory) == NULL) {
+        fail("Could not create a temporary directory: %s\n", strerror(errno));
+    }
+
+    char path[4096];
+    snprintf(path, sizeof (path), "%s/root", directory);
+    mkdir(path, 0755);
+    snprintf(path, sizeof (path), "%s/root/docs", directory);
+    mkdir(path, 0755);
+
+    snprintf(path, sizeof (path), "%s/root", directory);
+    write_test_file(path, "index.html", "<!DOCTYPE html><html><head><title>serverd</title></head><body>It works.</body></html>\n");
+    write_test_file(path, "style.css", "body { font-family: sans-serif; }\n");
+    write_test_file(path, "docs/readme.txt", "Nothing to see here.\n");
+
+    unsigned short port = find_free_port();
+
+    char configuration[8192];
+    snprintf(configuration, sizeof (configuration), "Hostname=127.0.0.1\nPort=%u\nDocumentRoot=%s/root/\nDirectoryListing=On\nLogLevel=Notice\n", port, directory);
+    write_test_file(directory, "serverd.conf", configuration);
+
+    /**
+     * Create the shared allocation log.
+     *
+     */
+    char log_filename[4096];
+    snprintf(log_filename, sizeof (log_filename), "%s/allocations", directory);
+
+    int log_fd = open(log_filename, O_RDWR | O_CREAT | O_TRUNC, 0600);
+
+    if ((log_fd == -1) || (ftruncate(log_fd, sizeof (struct allocation_log_t)) == -1)) {
+        fail("Could not create the allocation log: %s\n", strerror(errno));
+    }
+
+    struct allocation_log_t* log = mmap(NULL, sizeof (struct allocation_log_t), PROT_READ | PROT_WRITE, MAP_SHARED, log_fd, 0);
+    close(log_fd);
+
+    if (log == MAP_FAILED) {
+        fail("Could not map the allocation log: %s\n", strerror(errno));
+    }
+
+    /**
+     * Start serverd with the interposer preloaded. It forks
+     * into the background, and the process we started exits
+     * once it has. The daemon prints its process ID before
+     * closing its standard output, so that the test can stop
+     * it again.
+     *
+     */
+    char configuration_argument[4200];
+    snprintf(configuration_argument, sizeof (configuration_argument), "--configuration-filename=%s/serverd.conf", directory);
+
+    int pid_pipe[2];
+
+    if (pipe(pid_pipe) == -1) {
+        fail("Could not create a pipe: %s\n", strerror(errno));
+    }
+
+    pid_t launcher = fork();
+
+    if (launcher == -1) {
+        fail("Could not fork: %s\n", strerror(errno));
+    }
+
+    if (launcher == 0) {
+        dup2(pid_pipe[1], STDOUT_FILENO);
+        close(pid_pipe[0]);
+        close(pid_pipe[1]);
+        setenv("LD_PRELOAD", interposer_path, 1);
+        setenv(ALLOCATION_LOG_ENVIRONMENT, log_filename, 1);
+        execl(serverd_path, serverd_path, configuration_argument, (char *) NULL);
+        _exit(127);
+    }
+
+    close(pid_pipe[1]);
+
+    int status;
+    waitpid(launcher, &status, 0);
+
+    FILE* pid_output = fdopen(pid_pipe[0], "r");
+    int reported_pid = 0;
+
+    if ((pid_output == NULL) || (fscanf(pid_output, "%d", &reported_pid) != 1)) {
+        reported_pid = 0;
+    }
+
+    if (pid_output) {
+        fclose(pid_output);
+    }
+
+    serverd_pid = (pid_t) reported_pid;
+
+    if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0) || (serverd_pid <= 0)) {
+        fail("serverd did not start\n");
+    }
+
+    /**
+     * Wait for the server to come up. serverd treats a
+     * connection closed without a request as an error, so
+     * the probe has to be a proper request.
+     *
+     */
+    int connected = 0;
+
+    for (int attempt = 0; (attempt < 100) && !connected; ++attempt) {
+        connected = try_test_request(port, &request_mix[0]);
+
+        if (!connected) {
+            usleep(50000);
+        }
+    }
+
+    if (!connected) {
+        fail("serverd is not accepting connections on port %u\n", port);
+    }
+
+    /**
+     * Warm up every cache and pool, then count what the same
+     * requests allocate. The pause before disarming lets the
+     * server finish with the last connection, which it may
+     * still be doing after the client has seen it closed.
+     *
+     */
+    send_request_mix(port, WARMUP_ROUNDS);
+
+    atomic_store(&log->armed, 1);
+    send_request_mix(port, MEASURED_ROUNDS);
+    usleep(100000);
+    atomic_store(&log->armed, 0);
+
+    int pid = atomic_load(&log->pid);
+    uint64_t requests = (uint64_t) MEASURED_ROUNDS * REQUEST_MIX_SIZE;
+    uint64_t allocations = atomic_load(&log->allocations);
+
+    printf("%llu allocations in %llu requests (%.3f per request)\n",
+        (unsigned long long) allocations,
+        (unsigned long long) requests,
+        (double) allocations / (double) requests);
+
+    for (size_t i = 0; i < ALLOCATION_LOG_SITES; ++i) {
+        struct allocation_site_t* site = &log->sites[i];
+        uint64_t count = atomic_load(&site->count);
+
+        if (count == 0) {
+            continue;
+        }
+
+        char program_site[1024] = "(outside serverd)";
+        char caller_site[1024];
+
+        if (atomic_load(&site->program_address)) {
+            describe_address(program_site, sizeof (program_site), serverd_path, log, pid, atomic_load(&site->program_address));
+        }
+
+        describe_address(caller_site, sizeof (caller_site), serverd_path, log, pid, atomic_load(&site->caller_address));
+
+        printf("  %8.3f per request, %8.1f bytes each: %s", (double) count / (double) requests, (double) atomic_load(&site->bytes) / (double) count, program_site);
+
+        if (strcmp(program_site, caller_site) != 0) {
+            printf(" via %s", caller_site);
+        }
+
+        printf("\n");
+    }
+
+    if (atomic_load(&log->dropped)) {
+        printf("  %llu allocations from call sites that did not fit in the log\n", (unsigned long long) atomic_load(&log->dropped));
+    }
+
+    kill(serverd_pid, SIGTERM);
+
+    char command[4200];
+    snprintf(command, sizeof (command), "rm -rf %s", directory);
+
+    if (system(command) != 0) {
+        fprintf(stderr, "Could not remove %s\n", directory);
+    }
+
+    if (allocations) {
+        printf("FAIL: serving requests allocated in steady state\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("PASS\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,262 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include <sys/resource.h>
+
+#include "serverd.h"
+#include "error.h"
+#include "memory.h"
+
+/**
+ * Allocator Benchmark
+ *
+ * @details This tool runs the allocation pattern of serving
+ * static files against whichever allocator backend it was
+ * built with, and reports throughput, resident memory and
+ * fragmentation. The Makefile's benchmark target builds it
+ * once per backend and runs each build in turn.
+ *
+ * Every simulated request creates an arena and allocates
+ * its request state from it, and builds a response header
+ * on the heap. One request in eight inserts into a
+ * long-lived cache, evicting the oldest entry, and one in
+ * sixty-four renders a large directory listing. Each thread
+ * has its own arena chunk pool and cache, like a worker.
+ *
+ * Fragmentation is the growth in resident memory over the
+ * run, divided by the bytes still allocated at its end.
+ *
+ * Usage: allocator-benchmark [threads] [requests-per-thread]
+ *
+ */
+
+/**
+ * @def BENCHMARK_CACHE_ENTRIES
+ * @brief Number of long-lived cache entries each thread
+ * keeps.
+ *
+ */
+#ifndef BENCHMARK_CACHE_ENTRIES
+#define BENCHMARK_CACHE_ENTRIES (2048)
+#endif
+
+/**
+ * @def BENCHMARK_REQUEST_STATE_SIZE
+ * @brief Size of the per-request state allocated from each
+ * request's arena.
+ *
+ */
+#ifndef BENCHMARK_REQUEST_STATE_SIZE
+#define BENCHMARK_REQUEST_STATE_SIZE (4608)
+#endif
+
+/**
+ * A simulated file cache entry, and the allocations that
+ * hang off it.
+ *
+ */
+struct benchmark_cache_entry_t {
+    void* entry;
+    char* path;
+    char* header;
+};
+
+/**
+ * A benchmark thread's parameters and state.
+ *
+ */
+struct benchmark_thread_t {
+    pthread_t thread;
+    size_t requests;
+    uint64_t seed;
+    struct benchmark_cache_entry_t cache[BENCHMARK_CACHE_ENTRIES];
+};
+
+/**
+ * Return the next pseudo-random number from a thread's
+ * xorshift generator.
+ *
+ */
+static uint64_t next_random(uint64_t* state) {
+    uint64_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+
+    return *state = x;
+}
+
+/**
+ * Allocate memory and touch it, as its user would.
+ *
+ */
+static void* allocate_touched(size_t size) {
+    void* memory = allocate_memory(size);
+    memset(memory, 0xA5, size);
+    return memory;
+}
+
+/**
+ * Simulate a worker serving its share of the requests.
+ *
+ */
+static void* run_benchmark_thread(void* argument) {
+    struct benchmark_thread_t* benchmark_thread = argument;
+    struct arena_chunk_pool_t* pool = create_arena_chunk_pool(ARENA_CHUNK_SIZE, ARENA_CHUNK_POOL_CAPACITY);
+    size_t next_cache_entry = 0;
+
+    initialize_thread_memory();
+
+    for (size_t request = 0; request < benchmark_thread->requests; ++request) {
+        uint64_t random = next_random(&benchmark_thread->seed);
+
+        struct memory_arena_t* arena = create_memory_arena(pool);
+
+        if (arena == NULL) {
+            fatal_error("[Error] %s\n", "Could not create a request arena");
+        }
+
+        size_t path_length = 16 + (random & 0xFF);
+        void* state = arena_allocate(arena, BENCHMARK_REQUEST_STATE_SIZE);
+        void* path = arena_allocate(arena, path_length);
+
+        memset(state, 0, BENCHMARK_REQUEST_STATE_SIZE);
+        memset(path, '/', path_length);
+
+        char* header = allocate_touched(192 + ((random >> 8) & 0xFF));
+
+        if (((random >> 16) & 7) == 0) {
+            struct benchmark_cache_entry_t* cached = &benchmark_thread->cache[next_cache_entry];
+
+            FREE(cached->entry);
+            FREE(cached->path);
+            FREE(cached->header);
+
+            cached->entry = allocate_touched(96);
+            cached->path = allocate_touched(path_length);
+            cached->header = allocate_touched(128 + ((random >> 24) & 0xFF));
+
+            next_cache_entry = (next_cache_entry + 1) % BENCHMARK_CACHE_ENTRIES;
+        }
+
+        if (((random >> 32) & 63) == 0) {
+            char* listing = allocate_touched(16384 + ((random >> 40) & 0x7FFFF));
+            FREE(listing);
+        }
+
+        FREE(header);
+        release_memory_arena(arena);
+    }
+
+    return NULL;
+}
+
+/**
+ * Return the resident set size, in bytes.
+ *
+ */
+static size_t resident_memory(void) {
+    FILE* statm = fopen("/proc/self/statm", "r");
+    unsigned long pages = 0;
+
+    if (statm) {
+        if (fscanf(statm, "%*u %lu", &pages) != 1) {
+            pages = 0;
+        }
+
+        fclose(statm);
+    }
+
+    return (size_t) pages * (size_t) sysconf(_SC_PAGESIZE);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned thread_count = (argc > 1) ? (unsigned) strtoul(argv[1], NULL, 10) : 4;
+    size_t requests = (argc > 2) ? (size_t) strtoull(argv[2], NULL, 10) : 200000;
+
+    if ((thread_count == 0) || (requests == 0)) {
+        fatal_error("Usage: %s [threads] [requests-per-thread]\n", argv[0]);
+    }
+
+    struct benchmark_thread_t* threads = allocate_memory(sizeof (struct benchmark_thread_t) * thread_count);
+    memset(threads, 0, sizeof (struct benchmark_thread_t) * thread_count);
+
+    size_t resident_before = resident_memory();
+
+    struct timespec start;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (unsigned i = 0; i < thread_count; ++i) {
+        threads[i].requests = requests;
+        threads[i].seed = 0x9E3779B97F4A7C15ULL * (i + 1);
+
+        int error = pthread_create(&threads[i].thread, NULL, run_benchmark_thread, &threads[i]);
+
+        if (error) {
+            fatal_error("[Error] %s: %s\n", "Could not start benchmark thread", strerror(error));
+        }
+    }
+
+    for (unsigned i = 0; i < thread_count; ++i) {
+        pthread_join(threads[i].thread, NULL);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double seconds = (double) (end.tv_sec - start.tv_sec) + (double) (end.tv_nsec - start.tv_nsec) / 1e9;
+    size_t resident_growth = resident_memory() - resident_before;
+    size_t live = 0;
+
+    for (int tag = 0; tag < MEMORY_TAG_COUNT; ++tag) {
+        live += memory_usage((enum memory_tag_t) tag);
+    }
+
+    live -= sizeof (struct benchmark_thread_t) * thread_count;
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    printf("%-8s %2u threads %12.0f requests/s %10zu KiB resident %10ld KiB peak %10zu KiB live %6.2f fragmentation\n",
+        memory_allocator_name(),
+        thread_count,
+        (double) requests * thread_count / seconds,
+        resident_growth / 1024,
+        usage.ru_maxrss,
+        live / 1024,
+        live ? (double) resident_growth / (double) live : 0.0);
+
+    return EXIT_SUCCESS;
+}
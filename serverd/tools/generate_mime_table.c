@@ -0,0 +1,160 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "serverd.h"
+#include "error.h"
+#include "memory.h"
+#include "perfect_hash.h"
+#include "mime.h"
+
+/**
+ * MIME Table Generator
+ *
+ * @details This build-time tool reads a mime.types(5) style
+ * file, where each line lists a media type followed by the
+ * file extensions that map to it, and writes a C header
+ * containing the perfect hash displacements and the slot
+ * table used by src/mime.c.
+ *
+ * Usage: generate_mime_table <mime.types>
+ *
+ */
+
+/**
+ * A single extension to media type mapping.
+ *
+ */
+struct mime_mapping_t {
+    char* extension;
+    char* content_type;
+    uint64_t packed[2];
+};
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2) {
+        fatal_error("Usage: %s <mime.types>\n", argv[0]);
+    }
+
+    FILE* input = fopen(argv[1], "r");
+
+    if (input == NULL) {
+        fatal_error("[Error] %s: %s (%s)\n", "Could not open MIME types file", argv[1], strerror(errno));
+    }
+
+    size_t capacity = 512;
+    size_t count = 0;
+    struct mime_mapping_t* mappings = allocate_memory(sizeof (struct mime_mapping_t) * capacity);
+
+    size_t buffer_size = 512;
+    char* line_buffer = allocate_memory(buffer_size);
+
+    while (getline(&line_buffer, &buffer_size, input) > 0) {
+        char* comment = strchr(line_buffer, '#');
+
+        if (comment) {
+            *comment = '\0';
+        }
+
+        char* content_type = strtok(line_buffer, " \t\r\n");
+
+        if (content_type == NULL) {
+            continue;
+        }
+
+        for (char* extension = strtok(NULL, " \t\r\n"); extension; extension = strtok(NULL, " \t\r\n")) {
+            if (strlen(extension) > MIME_EXTENSION_MAX_LENGTH) {
+                fatal_error("[Error] %s: %s\n", "Extension too long", extension);
+            }
+
+            if (count == capacity) {
+                struct mime_mapping_t* grown = allocate_memory(sizeof (struct mime_mapping_t) * capacity * 2);
+                memcpy(grown, mappings, sizeof (struct mime_mapping_t) * capacity);
+                FREE(mappings);
+                mappings = grown;
+                capacity *= 2;
+            }
+
+            struct mime_mapping_t* mapping = &mappings[count++];
+            mapping->extension = strdup(extension);
+            mapping->content_type = strdup(content_type);
+            pack_mime_extension(extension, strlen(extension), mapping->packed);
+        }
+    }
+
+    FREE(line_buffer);
+    fclose(input);
+
+    uint64_t* keys = allocate_memory(sizeof (uint64_t) * (count + 1));
+    uint32_t* slots = allocate_memory(sizeof (uint32_t) * (count + 1));
+
+    for (size_t i = 0; i < count; ++i) {
+        keys[i] = mime_extension_fingerprint(mappings[i].packed);
+    }
+
+    struct perfect_hash_t hash;
+
+    if (build_perfect_hash(keys, count, &hash, slots) == FALSE) {
+        fatal_error("[Error] %s\n", "Duplicate extension in MIME types file");
+    }
+
+    printf("/**\n");
+    printf(" * Generated by tools/generate_mime_table from %s.\n", argv[1]);
+    printf(" * Do not edit this file by hand.\n");
+    printf(" *\n");
+    printf(" */\n\n");
+    printf("#ifndef PROJECT_GENERATED_MIME_TABLE_H\n");
+    printf("#define PROJECT_GENERATED_MIME_TABLE_H\n\n");
+    printf("#define MIME_TABLE_ENTRIES (%zu)\n", count);
+    printf("#define MIME_TABLE_BUCKET_MASK (%uu)\n", hash.bucket_mask);
+    printf("#define MIME_TABLE_SLOT_MASK (%uu)\n\n", hash.slot_mask);
+
+    printf("static const uint32_t mime_table_displacements[MIME_TABLE_BUCKET_MASK + 1] = {");
+
+    for (uint32_t b = 0; b <= hash.bucket_mask; ++b) {
+        printf("%s%u,", (b % 12) ? " " : "\n    ", hash.displacements[b]);
+    }
+
+    printf("\n};\n\n");
+    printf("static const struct mime_type_t mime_table_entries[MIME_TABLE_SLOT_MASK + 1] = {\n");
+
+    for (size_t i = 0; i < count; ++i) {
+        printf("    [%u] = { { 0x%016llXULL, 0x%016llXULL }, \"Content-Type: %s\\r\\n\", %zu }, /* %s */\n",
+            slots[i],
+            (unsigned long long) mappings[i].packed[0],
+            (unsigned long long) mappings[i].packed[1],
+            mappings[i].content_type,
+            strlen("Content-Type: \r\n") + strlen(mappings[i].content_type),
+            mappings[i].extension);
+    }
+
+    printf("};\n\n");
+    printf("#endif /** PROJECT_GENERATED_MIME_TABLE_H */\n");
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,554 @@
+/**
+ * serverd - Modern web server daemon
+ * Copyright (C) 2020 Jose Fernando Lopez Fernandez
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth
+ * Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+
+#include <sys/stat.h>
+
+#include "serverd.h"
+#include "error.h"
+#include "memory.h"
+#include "mime.h"
+#include "perfect_hash.h"
+#include "site_pack.h"
+
+/**
+ * Site Pack Compiler
+ *
+ * @details This tool compiles a document root into a single
+ * site pack file, which serverd can serve with the SitePack
+ * option without touching the document root at all.
+ *
+ * Every regular file becomes an entry under its request
+ * path. Each directory's index.html is additionally entered
+ * under the directory's own path, with a trailing slash, and
+ * a redirect to that path is entered under the directory's
+ * path without one. If a file has a precompressed sibling
+ * with a '.gz' suffix, the sibling becomes the entry's gzip
+ * variant, served to clients that accept it.
+ *
+ * The pack is written to a temporary file that is renamed
+ * over the output only once it is complete, so the output
+ * may be the pack a running server is using.
+ *
+ * Usage: serverd-pack <document-root> <output>
+ *
+ */
+
+/**
+ * A file whose contents go into the pack.
+ *
+ */
+struct pack_file_t {
+    char* filename;
+    char* gzip_filename;
+    uint64_t size;
+    uint64_t gzip_size;
+    struct site_pack_variant_t identity;
+    struct site_pack_variant_t gzip;
+};
+
+/**
+ * A request path in the pack.
+ *
+ * @details A path either serves one of the files, or, if
+ * file is SIZE_MAX, is a redirect to the same path with a
+ * trailing slash.
+ *
+ */
+struct pack_path_t {
+    char* path;
+    size_t file;
+    uint64_t redirect_offset;
+    uint32_t redirect_length;
+};
+
+struct pack_t {
+    struct pack_file_t* files;
+    size_t file_count;
+    size_t file_capacity;
+
+    struct pack_path_t* paths;
+    size_t path_count;
+    size_t path_capacity;
+};
+
+/**
+ * Concatenate up to three strings into a new heap string.
+ *
+ */
+static char* concatenate(const char* a, const char* b, const char* c) {
+    size_t a_length = strlen(a);
+    size_t b_length = strlen(b);
+    size_t c_length = strlen(c);
+
+    char* result = allocate_memory(a_length + b_length + c_length + 1);
+    memcpy(result, a, a_length);
+    memcpy(result + a_length, b, b_length);
+    memcpy(result + a_length + b_length, c, c_length + 1);
+
+    return result;
+}
+
+static size_t add_pack_file(struct pack_t* pack, char* filename, uint64_t size) {
+    if (pack->file_count == pack->file_capacity) {
+        size_t capacity = pack->file_capacity ? pack->file_capacity * 2 : 256;
+        struct pack_file_t* files = allocate_memory(sizeof (struct pack_file_t) * capacity);
+
+        if (pack->files) {
+            memcpy(files, pack->files, sizeof (struct pack_file_t) * pack->file_count);
+            FREE(pack->files);
+        }
+
+        pack->files = files;
+        pack->file_capacity = capacity;
+    }
+
+    struct pack_file_t* file = &pack->files[pack->file_count];
+    memset(file, 0, sizeof (struct pack_file_t));
+    file->filename = filename;
+    file->size = size;
+
+    /**
+     * Pick up a precompressed sibling, if there is one.
+     *
+     */
+    char* gzip_filename = concatenate(filename, ".gz", "");
+    struct stat status;
+
+    if ((stat(gzip_filename, &status) == 0) && S_ISREG(status.st_mode)) {
+        file->gzip_filename = gzip_filename;
+        file->gzip_size = (uint64_t) status.st_size;
+    } else {
+        FREE(gzip_filename);
+    }
+
+    return pack->file_count++;
+}
+
+static void add_pack_path(struct pack_t* pack, char* path, size_t file) {
+    if (pack->path_count == pack->path_capacity) {
+        size_t capacity = pack->path_capacity ? pack->path_capacity * 2 : 256;
+        struct pack_path_t* paths = allocate_memory(sizeof (struct pack_path_t) * capacity);
+
+        if (pack->paths) {
+            memcpy(paths, pack->paths, sizeof (struct pack_path_t) * pack->path_count);
+            FREE(pack->paths);
+        }
+
+        pack->paths = paths;
+        pack->path_capacity = capacity;
+    }
+
+    struct pack_path_t* entry = &pack->paths[pack->path_count++];
+    entry->path = path;
+    entry->file = file;
+    entry->redirect_offset = 0;
+    entry->redirect_length = 0;
+}
+
+/**
+ * Add a directory of the document root to the pack.
+ *
+ * @details The request path of the directory always ends in
+ * a slash. Symbolic links to directories are not followed,
+ * which keeps the walk from looping.
+ *
+ */
+static void add_pack_directory(struct pack_t* pack, const char* directory_filename, const char* directory_path) {
+    DIR* directory = opendir(directory_filename);
+
+    if (directory == NULL) {
+        fatal_error("[Error] %s: %s (%s)\n", "Could not open directory", directory_filename, strerror(errno));
+    }
+
+    struct dirent* entry;
+
+    while ((entry = readdir(directory))) {
+        if ((strcmp(entry->d_name, ".") == 0) || (strcmp(entry->d_name, "..") == 0)) {
+            continue;
+        }
+
+        char* filename = concatenate(directory_filename, "/", entry->d_name);
+        struct stat status;
+
+        if (lstat(filename, &status) == -1) {
+            fatal_error("[Error] %s: %s (%s)\n", "Could not stat file", filename, strerror(errno));
+        }
+
+        if (S_ISDIR(status.st_mode)) {
+            add_pack_directory(pack, filename, concatenate(directory_path, entry->d_name, "/"));
+            FREE(filename);
+            continue;
+        }
+
+        if ((stat(filename, &status) == -1) || !S_ISREG(status.st_mode)) {
+            FREE(filename);
+            continue;
+        }
+
+        size_t file = add_pack_file(pack, filename, (uint64_t) status.st_size);
+        add_pack_path(pack, concatenate(directory_path, entry->d_name, ""), file);
+
+        if (strcmp(entry->d_name, "index.html") == 0) {
+            add_pack_path(pack, concatenate(directory_path, "", ""), file);
+
+            if (strcmp(directory_path, "/") != 0) {
+                char* redirect_path = concatenate(directory_path, "", "");
+                redirect_path[strlen(redirect_path) - 1] = '\0';
+                add_pack_path(pack, redirect_path, SIZE_MAX);
+            }
+        }
+    }
+
+    closedir(directory);
+    FREE(directory_path);
+}
+
+static int compare_pack_paths(const void* a, const void* b) {
+    return strcmp(((const struct pack_path_t *) a)->path, ((const struct pack_path_t *) b)->path);
+}
+
+/**
+ * Format the response headers of one variant.
+ *
+ * @details The ETag is always sixteen hex digits, so the
+ * length of the headers does not depend on the body's hash,
+ * which is only known once the body has been copied.
+ *
+ */
+static size_t format_pack_header(char* buffer, size_t buffer_size, const char* filename, uint64_t size, uint64_t etag, int has_gzip, int is_gzip) {
+    const struct mime_type_t* mime_type = lookup_mime_type(filename);
+
+    int length = snprintf(buffer, buffer_size,
+        "HTTP/1.1 200 OK\r\n"
+        "Connection: Close\r\n"
+        "%s"
+        "%s"
+        "Content-Length: %llu\r\n"
+        "ETag: \"%016llx\"\r\n"
+        "%s"
+        "\r\n",
+        mime_type->content_type_header,
+        is_gzip ? "Content-Encoding: gzip\r\n" : "",
+        (unsigned long long) size,
+        (unsigned long long) etag,
+        has_gzip ? "Vary: Accept-Encoding\r\n" : "");
+
+    if ((length < 0) || ((size_t) length >= buffer_size)) {
+        fatal_error("[Error] %s: %s\n", "Response headers too long", filename);
+    }
+
+    return (size_t) length;
+}
+
+static size_t format_redirect_header(char* buffer, size_t buffer_size, const char* path) {
+    int length = snprintf(buffer, buffer_size,
+        "HTTP/1.1 301 Moved Permanently\r\n"
+        "Connection: Close\r\n"
+        "Location: %s/\r\n"
+        "Content-Length: 0\r\n"
+        "\r\n",
+        path);
+
+    if ((length < 0) || ((size_t) length >= buffer_size)) {
+        fatal_error("[Error] %s: %s\n", "Redirect too long", path);
+    }
+
+    return (size_t) length;
+}
+
+static void write_at(int fd, const void* data, size_t length, uint64_t offset) {
+    const char* bytes = data;
+
+    while (length > 0) {
+        ssize_t written = pwrite(fd, bytes, length, (off_t) offset);
+
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            fatal_error("[Error] %s: %s\n", "Could not write site pack", strerror(errno));
+        }
+
+        bytes += written;
+        length -= (size_t) written;
+        offset += (uint64_t) written;
+    }
+}
+
+/**
+ * Copy a file into the pack and return its hash.
+ *
+ * @details The hash is the same FNV-1a and finalizer as
+ * perfect_hash_string(), computed while streaming the file.
+ *
+ */
+static uint64_t copy_pack_body(int output_fd, const char* filename, uint64_t size, uint64_t offset) {
+    int fd = open(filename, O_RDONLY | O_CLOEXEC);
+
+    if (fd == -1) {
+        fatal_error("[Error] %s: %s (%s)\n", "Could not open file", filename, strerror(errno));
+    }
+
+    static char buffer[1 << 16];
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    uint64_t copied = 0;
+
+    while (copied < size) {
+        ssize_t bytes_read = read(fd, buffer, sizeof (buffer));
+
+        if (bytes_read == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            fatal_error("[Error] %s: %s (%s)\n", "Could not read file", filename, strerror(errno));
+        }
+
+        if (bytes_read == 0) {
+            fatal_error("[Error] %s: %s\n", "File changed while packing", filename);
+        }
+
+        size_t length = (size_t) bytes_read;
+
+        if (length > size - copied) {
+            length = (size_t) (size - copied);
+        }
+
+        for (size_t i = 0; i < length; ++i) {
+            hash ^= (unsigned char) buffer[i];
+            hash *= 0x100000001B3ULL;
+        }
+
+        write_at(output_fd, buffer, length, offset + copied);
+        copied += length;
+    }
+
+    close(fd);
+
+    return perfect_hash_mix(hash);
+}
+
+static uint64_t align_up(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3) {
+        fatal_error("Usage: %s <document-root> <output>\n", argv[0]);
+    }
+
+    struct pack_t pack;
+    memset(&pack, 0, sizeof (pack));
+
+    /**
+     * Request paths start with a slash, so walk the document
+     * root without its trailing slash.
+     *
+     */
+    char* document_root = concatenate(argv[1], "", "");
+    size_t root_length = strlen(document_root);
+
+    while ((root_length > 1) && (document_root[root_length - 1] == '/')) {
+        document_root[--root_length] = '\0';
+    }
+
+    add_pack_directory(&pack, document_root, concatenate("/", "", ""));
+
+    /**
+     * Sort the paths, so that the same document root always
+     * compiles to the same pack.
+     *
+     */
+    qsort(pack.paths, pack.path_count, sizeof (struct pack_path_t), compare_pack_paths);
+
+    uint64_t* keys = allocate_memory(sizeof (uint64_t) * (pack.path_count ? pack.path_count : 1));
+    uint32_t* key_slots = allocate_memory(sizeof (uint32_t) * (pack.path_count ? pack.path_count : 1));
+
+    for (size_t i = 0; i < pack.path_count; ++i) {
+        keys[i] = perfect_hash_string(pack.paths[i].path, strlen(pack.paths[i].path));
+    }
+
+    struct perfect_hash_t hash;
+
+    if (!build_perfect_hash(keys, pack.path_count, &hash, key_slots)) {
+        fatal_error("[Error] %s\n", "Two request paths share a fingerprint");
+    }
+
+    struct site_pack_header_t header;
+    memset(&header, 0, sizeof (header));
+    memcpy(header.magic, SITE_PACK_MAGIC, sizeof (header.magic));
+    header.entry_count = (uint32_t) pack.path_count;
+    header.bucket_count = hash.bucket_mask + 1;
+    header.slot_count = hash.slot_mask + 1;
+    header.displacements_offset = align_up(sizeof (header), sizeof (uint64_t));
+    header.slots_offset = header.displacements_offset + (uint64_t) header.bucket_count * sizeof (uint32_t);
+    header.entries_offset = align_up(header.slots_offset + (uint64_t) header.slot_count * sizeof (uint32_t), sizeof (uint64_t));
+
+    /**
+     * Lay out the paths and headers right after the entry
+     * table, and the bodies after those, each starting on a
+     * page boundary.
+     *
+     */
+    char header_buffer[1024];
+    uint64_t offset = header.entries_offset + (uint64_t) pack.path_count * sizeof (struct site_pack_entry_t);
+
+    struct site_pack_entry_t* entries = allocate_memory(sizeof (struct site_pack_entry_t) * (pack.path_count ? pack.path_count : 1));
+    memset(entries, 0, sizeof (struct site_pack_entry_t) * (pack.path_count ? pack.path_count : 1));
+
+    for (size_t i = 0; i < pack.path_count; ++i) {
+        entries[i].path_hash = keys[i];
+        entries[i].path_offset = offset;
+        entries[i].path_length = (uint32_t) strlen(pack.paths[i].path);
+        offset += entries[i].path_length;
+
+        if (pack.paths[i].file == SIZE_MAX) {
+            pack.paths[i].redirect_offset = offset;
+            pack.paths[i].redirect_length = (uint32_t) format_redirect_header(header_buffer, sizeof (header_buffer), pack.paths[i].path);
+            offset += pack.paths[i].redirect_length;
+        }
+    }
+
+    for (size_t i = 0; i < pack.file_count; ++i) {
+        struct pack_file_t* file = &pack.files[i];
+
+        file->identity.header_offset = offset;
+        file->identity.header_length = (uint32_t) format_pack_header(header_buffer, sizeof (header_buffer), file->filename, file->size, 0, file->gzip_filename != NULL, FALSE);
+        offset += file->identity.header_length;
+
+        if (file->gzip_filename) {
+            file->gzip.header_offset = offset;
+            file->gzip.header_length = (uint32_t) format_pack_header(header_buffer, sizeof (header_buffer), file->filename, file->gzip_size, 0, TRUE, TRUE);
+            offset += file->gzip.header_length;
+        }
+    }
+
+    for (size_t i = 0; i < pack.file_count; ++i) {
+        struct pack_file_t* file = &pack.files[i];
+
+        offset = align_up(offset, SITE_PACK_BODY_ALIGNMENT);
+        file->identity.body_offset = offset;
+        file->identity.body_length = file->size;
+        offset += file->size;
+
+        if (file->gzip_filename) {
+            offset = align_up(offset, SITE_PACK_BODY_ALIGNMENT);
+            file->gzip.body_offset = offset;
+            file->gzip.body_length = file->gzip_size;
+            offset += file->gzip_size;
+        }
+    }
+
+    header.file_size = offset;
+
+    /**
+     * Write everything out to a temporary file.
+     *
+     */
+    char* temporary_filename = concatenate(argv[2], ".tmp", "");
+    int output_fd = open(temporary_filename, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+    if (output_fd == -1) {
+        fatal_error("[Error] %s: %s (%s)\n", "Could not create site pack", temporary_filename, strerror(errno));
+    }
+
+    if (ftruncate(output_fd, (off_t) header.file_size) == -1) {
+        fatal_error("[Error] %s: %s\n", "Could not size site pack", strerror(errno));
+    }
+
+    for (size_t i = 0; i < pack.file_count; ++i) {
+        struct pack_file_t* file = &pack.files[i];
+
+        uint64_t etag = copy_pack_body(output_fd, file->filename, file->size, file->identity.body_offset);
+        format_pack_header(header_buffer, sizeof (header_buffer), file->filename, file->size, etag, file->gzip_filename != NULL, FALSE);
+        write_at(output_fd, header_buffer, file->identity.header_length, file->identity.header_offset);
+
+        if (file->gzip_filename) {
+            uint64_t gzip_etag = copy_pack_body(output_fd, file->gzip_filename, file->gzip_size, file->gzip.body_offset);
+            format_pack_header(header_buffer, sizeof (header_buffer), file->filename, file->gzip_size, gzip_etag, TRUE, TRUE);
+            write_at(output_fd, header_buffer, file->gzip.header_length, file->gzip.header_offset);
+        }
+    }
+
+    uint32_t* slots = allocate_memory(sizeof (uint32_t) * header.slot_count);
+
+    for (uint32_t i = 0; i < header.slot_count; ++i) {
+        slots[i] = SITE_PACK_EMPTY_SLOT;
+    }
+
+    for (size_t i = 0; i < pack.path_count; ++i) {
+        const struct pack_path_t* path = &pack.paths[i];
+        slots[key_slots[i]] = (uint32_t) i;
+
+        write_at(output_fd, path->path, entries[i].path_length, entries[i].path_offset);
+
+        if (path->file == SIZE_MAX) {
+            format_redirect_header(header_buffer, sizeof (header_buffer), path->path);
+            write_at(output_fd, header_buffer, path->redirect_length, path->redirect_offset);
+
+            entries[i].identity.header_offset = path->redirect_offset;
+            entries[i].identity.header_length = path->redirect_length;
+            continue;
+        }
+
+        const struct pack_file_t* file = &pack.files[path->file];
+        entries[i].identity = file->identity;
+
+        if (file->gzip_filename) {
+            entries[i].flags |= SITE_PACK_ENTRY_GZIP;
+            entries[i].gzip = file->gzip;
+        }
+    }
+
+    write_at(output_fd, hash.displacements, sizeof (uint32_t) * header.bucket_count, header.displacements_offset);
+    write_at(output_fd, slots, sizeof (uint32_t) * header.slot_count, header.slots_offset);
+    write_at(output_fd, entries, sizeof (struct site_pack_entry_t) * pack.path_count, header.entries_offset);
+    write_at(output_fd, &header, sizeof (header), 0);
+
+    if ((fsync(output_fd) == -1) || (close(output_fd) == -1)) {
+        fatal_error("[Error] %s: %s\n", "Could not write site pack", strerror(errno));
+    }
+
+    /**
+     * Swap the finished pack into place.
+     *
+     */
+    if (rename(temporary_filename, argv[2]) == -1) {
+        fatal_error("[Error] %s: %s (%s)\n", "Could not rename site pack", argv[2], strerror(errno));
+    }
+
+    fprintf(stderr, "Packed %zu paths from %zu files into %s (%llu bytes)\n", pack.path_count, pack.file_count, argv[2], (unsigned long long) header.file_size);
+
+    return EXIT_SUCCESS;
+}